@@ -44,6 +44,7 @@
 #include "playlists/PlayListFactory.h"
 #include "guilib/GUIFontManager.h"
 #include "guilib/GUIColorManager.h"
+#include "guilib/SkinXMLCache.h"
 #include "guilib/StereoscopicsManager.h"
 #include "guilib/GUITextLayout.h"
 #include "addons/Skin.h"
@@ -279,6 +280,7 @@
 #include "dialogs/GUIDialogMediaFilter.h"
 #include "video/dialogs/GUIDialogSubtitles.h"
 #include "utils/XMLUtils.h"
+#include "utils/Profiler.h"
 #include "addons/AddonInstaller.h"
 #include "CompileInfo.h"
 
@@ -792,6 +794,14 @@ bool CApplication::Create()
   }
   CSettings::Get().SetLoaded();
 
+  // switch the job manager to the configured worker mode before the GUI and services start queuing jobs
+  if (g_advancedSettings.m_jobManagerWorkStealing || g_advancedSettings.m_jobManagerWorkers > 0)
+  {
+    CJobManager::GetInstance().CancelJobs();
+    CJobManager::GetInstance().SetWorkStealing(g_advancedSettings.m_jobManagerWorkStealing, g_advancedSettings.m_jobManagerWorkers);
+    CJobManager::GetInstance().Restart();
+  }
+
   CLog::Log(LOGINFO, "creating subdirectories");
   CLog::Log(LOGINFO, "userdata folder: %s", CProfilesManager::Get().GetProfileUserDataFolder().c_str());
   CLog::Log(LOGINFO, "recording folder: %s", CSettings::Get().GetString("audiocds.recordingpath").c_str());
@@ -1960,6 +1970,14 @@ bool CApplication::LoadSkin(const SkinPtr& skin)
   g_SkinInfo = skin;
   g_SkinInfo->Start();
 
+  // parse the skin's xml files in the background while the fonts, strings and includes are loaded
+  if (g_advancedSettings.m_guiPreloadSkin)
+  {
+    std::vector<std::string> skinPaths;
+    g_SkinInfo->GetSkinPaths(skinPaths);
+    CSkinXMLCache::Get().Preload(skinPaths);
+  }
+
   CLog::Log(LOGINFO, "  load fonts for skin...");
   g_graphicsContext.SetMediaDir(skin->Path());
   g_directoryCache.ClearSubPaths(skin->Path());
@@ -2067,6 +2085,8 @@ void CApplication::UnloadSkin(bool forReload /* = false */)
 
   g_infoManager.Clear();
 
+  CSkinXMLCache::Get().Clear();
+
 //  The g_SkinInfo boost shared_ptr ought to be reset here
 // but there are too many places it's used without checking for NULL
 // and as a result a race condition on exit can cause a crash.
@@ -2161,6 +2181,7 @@ bool CApplication::LoadUserWindows()
 bool CApplication::RenderNoPresent()
 {
   MEASURE_FUNCTION;
+  PROFILE_SCOPE("GUI.Render");
 
 // DXMERGE: This may have been important?
 //  g_graphicsContext.AcquireCurrentContext();
@@ -2208,6 +2229,7 @@ void CApplication::Render()
     return;
 
   MEASURE_FUNCTION;
+  PROFILE_SCOPE("GUI.Frame");
 
   int vsync_mode = CSettings::Get().GetInt("videoscreen.vsync");
 
@@ -3595,6 +3617,9 @@ void CApplication::Stop(int exitCode)
     CLog::Log(LOGERROR, "Exception in CApplication::Stop()");
   }
 
+  // write out anything still queued by the asynchronous logger
+  CLog::SetAsync(false);
+
   // we may not get to finish the run cycle but exit immediately after a call to g_application.Stop()
   // so we may never get to Destroy() in CXBApplicationEx::Run(), we call it here.
   Destroy();
@@ -5036,6 +5061,7 @@ void CApplication::ShowAppMigrationMessage()
 void CApplication::Process()
 {
   MEASURE_FUNCTION;
+  PROFILE_SCOPE("Application.Process");
 
   // dispatch the messages generated by python or other threads to the current window
   g_windowManager.DispatchThreadMessages();
@@ -5086,6 +5112,9 @@ void CApplication::ProcessSlow()
 {
   g_powerManager.ProcessEvents();
 
+  // move the samples of the profiled sections out of the threads' rings
+  CProfiler::Get().Process();
+
 #if defined(TARGET_DARWIN_OSX)
   // There is an issue on OS X that several system services ask the cursor to become visible
   // during their startup routines.  Given that we can't control this, we hack it in by
@@ -20,6 +20,7 @@
 
 #include "ApplicationPlayer.h"
 #include "cores/IPlayer.h"
+#include "cores/DataCacheCore.h"
 #include "Application.h"
 #include "settings/MediaSettings.h"
 
@@ -256,7 +257,13 @@ int64_t CApplicationPlayer::GetTime() const
 {
   boost::shared_ptr<IPlayer> player = GetInternal();
   if (player)
+  {
+    // the state the player published doesn't need its locks
+    int64_t time;
+    if (g_dataCacheCore.GetPlayTime(time))
+      return time;
     return player->GetTime();
+  }
   else
     return 0;
 }
@@ -283,7 +290,12 @@ int CApplicationPlayer::GetCacheLevel() const
 {
   boost::shared_ptr<IPlayer> player = GetInternal();
   if (player)
+  {
+    CDataCacheCore::SPlayerInfo info;
+    if (g_dataCacheCore.GetPlayerInfo(info))
+      return info.cacheLevel;
     return player->GetCacheLevel();
+  }
   else
     return 0;
 }
@@ -366,7 +378,12 @@ int64_t CApplicationPlayer::GetTotalTime() const
 {
   boost::shared_ptr<IPlayer> player = GetInternal();
   if (player)
+  {
+    CDataCacheCore::SPlayerInfo info;
+    if (g_dataCacheCore.GetPlayerInfo(info))
+      return (int64_t)info.timeTotal;
     return player->GetTotalTime();
+  }
   else
     return 0;
 }
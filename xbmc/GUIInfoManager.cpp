@@ -4327,8 +4327,31 @@ void CGUIInfoManager::UpdateAVInfo()
       SPlayerVideoStreamInfo video;
       SPlayerAudioStreamInfo audio;
 
-      g_application.m_pPlayer->GetVideoStreamInfo(video);
-      g_application.m_pPlayer->GetAudioStreamInfo(g_application.m_pPlayer->GetAudioStream(), audio);
+      // use what the player published if it does, it's read without the player's locks
+      CDataCacheCore::SVideoInfo videoInfo;
+      if (g_dataCacheCore.GetVideoInfo(videoInfo))
+      {
+        video.bitrate          = videoInfo.bitrate;
+        video.videoAspectRatio = videoInfo.aspectRatio;
+        video.width            = videoInfo.width;
+        video.height           = videoInfo.height;
+        video.videoCodecName   = videoInfo.codec;
+        video.stereoMode       = videoInfo.stereoMode;
+      }
+      else
+        g_application.m_pPlayer->GetVideoStreamInfo(video);
+
+      CDataCacheCore::SAudioInfo audioInfo;
+      if (g_dataCacheCore.GetAudioInfo(audioInfo))
+      {
+        audio.bitrate        = audioInfo.bitrate;
+        audio.channels       = audioInfo.channels;
+        audio.samplerate     = audioInfo.sampleRate;
+        audio.bitspersample  = audioInfo.bitsPerSample;
+        audio.audioCodecName = audioInfo.codec;
+      }
+      else
+        g_application.m_pPlayer->GetAudioStreamInfo(g_application.m_pPlayer->GetAudioStream(), audio);
 
       m_videoInfo = video;
       m_audioInfo = audio;
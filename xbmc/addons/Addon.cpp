@@ -201,12 +201,12 @@ void AddonProps::Serialize(CVariant &variant) const
   variant["author"] = author;
   variant["source"] = source;
 
-  if (CURL::IsFullPath(icon))
-    variant["icon"] = icon;
-  else
-    variant["icon"] = URIUtils::AddFileToFolder(path, icon);
+  std::string iconPath = icon;
+  if (!CURL::IsFullPath(icon))
+    iconPath = URIUtils::AddFileToFolder(path, icon);
 
-  variant["thumbnail"] = variant["icon"];
+  variant["icon"] = iconPath;
+  variant["thumbnail"] = iconPath;
   variant["disclaimer"] = disclaimer;
   variant["changelog"] = changelog;
 
@@ -31,6 +31,7 @@ using namespace ActiveAE;
 #include "settings/AdvancedSettings.h"
 #include "windowing/WindowingFactory.h"
 
+#include "utils/Profiler.h"
 #include "utils/TimeUtils.h"
 
 #define MAX_CACHE_LEVEL 0.5   // total cache time of stream in seconds
@@ -1656,6 +1657,10 @@ bool CActiveAE::RunStages()
 {
   bool busy = false;
 
+  // only passes which had something to do are profiled
+  static const unsigned int profilerSection = CProfiler::Get().RegisterSection("ActiveAE.RunStages");
+  int64_t profilerStart = CProfiler::IsEnabled() ? CurrentHostCounter() : 0;
+
   // serve input streams
   std::list<CActiveAEStream*>::iterator it;
   for (it = m_streams.begin(); it != m_streams.end(); ++it)
@@ -1767,75 +1772,12 @@ bool CActiveAE::RunStages()
             out = (*it)->m_resampleBuffers->m_outputSamples.front();
             (*it)->m_resampleBuffers->m_outputSamples.pop_front();
 
-            int nb_floats = out->pkt->nb_samples * out->pkt->config.channels / out->pkt->planes;
-            int nb_loops = 1;
-            float fadingStep = 0.0f;
-
-            // fading
-            if ((*it)->m_fadingSamples == -1)
-            {
-              (*it)->m_fadingSamples = m_internalFormat.m_sampleRate * (float)(*it)->m_fadingTime / 1000.0f;
-              if ((*it)->m_fadingSamples > 0)
-                (*it)->m_volume = (*it)->m_fadingBase;
-              else
-              {
-                (*it)->m_volume = (*it)->m_fadingTarget;
-                CSingleLock lock((*it)->m_streamLock);
-                (*it)->m_streamFading = false;
-              }
-            }
-            if ((*it)->m_fadingSamples > 0)
-            {
-              nb_floats = out->pkt->config.channels / out->pkt->planes;
-              nb_loops = out->pkt->nb_samples;
-              float delta = (*it)->m_fadingTarget - (*it)->m_fadingBase;
-              int samples = m_internalFormat.m_sampleRate * (float)(*it)->m_fadingTime / 1000.0f;
-              fadingStep = delta / samples;
-            }
-
-            // for stream amplification, 
+            // for stream amplification,
             // turned off downmix normalization,
             // or if sink format is float (in order to prevent from clipping)
-            // we need to run on a per sample basis
-            if ((*it)->m_amplify != 1.0 || !(*it)->m_resampleBuffers->m_normalize || (m_sinkFormat.m_dataFormat == AE_FMT_FLOAT))
-            {
-              nb_floats = out->pkt->config.channels / out->pkt->planes;
-              nb_loops = out->pkt->nb_samples;
-            }
-
-            for(int i=0; i<nb_loops; i++)
-            {
-              if ((*it)->m_fadingSamples > 0)
-              {
-                (*it)->m_volume += fadingStep;
-                (*it)->m_fadingSamples--;
-
-                if ((*it)->m_fadingSamples == 0)
-                {
-                  // set variables being polled via stream interface
-                  CSingleLock lock((*it)->m_streamLock);
-                  (*it)->m_streamFading = false;
-                }
-              }
-
-              // volume for stream
-              float volume = (*it)->m_volume * (*it)->m_rgain;
-              if(nb_loops > 1)
-                volume *= (*it)->m_limiter.Run((float**)out->pkt->data, out->pkt->config.channels, i*nb_floats, out->pkt->planes > 1);
-
-              for(int j=0; j<out->pkt->planes; j++)
-              {
-#ifdef __SSE__
-                CAEUtil::SSEMulArray((float*)out->pkt->data[j]+i*nb_floats, volume, nb_floats);
-#else
-                float* fbuffer = (float*) out->pkt->data[j]+i*nb_floats;
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  fbuffer[k] *= volume;
-                }
-#endif
-              }
-            }
+            // we need to run the limiter
+            bool limit = (*it)->m_amplify != 1.0 || !(*it)->m_resampleBuffers->m_normalize || (m_sinkFormat.m_dataFormat == AE_FMT_FLOAT);
+            MixStream(*it, out, out, limit);
           }
           else
           {
@@ -1843,90 +1785,25 @@ bool CActiveAE::RunStages()
             mix = (*it)->m_resampleBuffers->m_outputSamples.front();
             (*it)->m_resampleBuffers->m_outputSamples.pop_front();
 
-            int nb_floats = mix->pkt->nb_samples * mix->pkt->config.channels / mix->pkt->planes;
-            int nb_loops = 1;
-            float fadingStep = 0.0f;
-
-            // fading
-            if ((*it)->m_fadingSamples == -1)
-            {
-              (*it)->m_fadingSamples = m_internalFormat.m_sampleRate * (float)(*it)->m_fadingTime / 1000.0f;
-              (*it)->m_volume = (*it)->m_fadingBase;
-            }
-            if ((*it)->m_fadingSamples > 0)
-            {
-              nb_floats = mix->pkt->config.channels / mix->pkt->planes;
-              nb_loops = mix->pkt->nb_samples;
-              float delta = (*it)->m_fadingTarget - (*it)->m_fadingBase;
-              int samples = m_internalFormat.m_sampleRate * (float)(*it)->m_fadingTime / 1000.0f;
-              fadingStep = delta / samples;
-            }
-
             // for streams amplification of turned off downmix normalization
-            // we need to run on a per sample basis
-            if ((*it)->m_amplify != 1.0 || !(*it)->m_resampleBuffers->m_normalize)
-            {
-              nb_floats = out->pkt->config.channels / out->pkt->planes;
-              nb_loops = out->pkt->nb_samples;
-            }
-
-            for(int i=0; i<nb_loops; i++)
-            {
-              if ((*it)->m_fadingSamples > 0)
-              {
-                (*it)->m_volume += fadingStep;
-                (*it)->m_fadingSamples--;
-
-                if ((*it)->m_fadingSamples == 0)
-                {
-                  // set variables being polled via stream interface
-                  CSingleLock lock((*it)->m_streamLock);
-                  (*it)->m_streamFading = false;
-                }
-              }
-
-              // volume for stream
-              float volume = (*it)->m_volume * (*it)->m_rgain;
-              if(nb_loops > 1)
-                volume *= (*it)->m_limiter.Run((float**)mix->pkt->data, mix->pkt->config.channels, i*nb_floats, mix->pkt->planes > 1);
-
-              for(int j=0; j<out->pkt->planes && j<mix->pkt->planes; j++)
-              {
-                float *dst = (float*)out->pkt->data[j]+i*nb_floats;
-                float *src = (float*)mix->pkt->data[j]+i*nb_floats;
-#ifdef __SSE__
-                CAEUtil::SSEMulAddArray(dst, src, volume, nb_floats);
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  if (fabs(dst[k]) > 1.0f)
-                  {
-                    needClamp = true;
-                    break;
-                  }
-                }
-#else
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  dst[k] += src[k] * volume;
-                  if (fabs(dst[k]) > 1.0f)
-                    needClamp = true;
-                }
-#endif
-              }
-            }
+            // we need to run the limiter
+            bool limit = (*it)->m_amplify != 1.0 || !(*it)->m_resampleBuffers->m_normalize;
+            MixStream(*it, out, mix, limit);
+            needClamp = true;
             mix->Return();
           }
           busy = true;
         }
       }// for
 
-      // finally clamp samples
+      // finally clamp samples, if mixing several streams made them clip
       if(out && needClamp)
       {
         int nb_floats = out->pkt->nb_samples * out->pkt->config.channels / out->pkt->planes;
         for(int i=0; i<out->pkt->planes; i++)
         {
-          CAEUtil::ClampArray((float*)out->pkt->data[i], nb_floats);
+          if (CAEUtil::NeedsClamp((float*)out->pkt->data[i], nb_floats))
+            CAEUtil::ClampArray((float*)out->pkt->data[i], nb_floats);
         }
       }
 
@@ -2044,6 +1921,9 @@ bool CActiveAE::RunStages()
     busy = true;
   }
 
+  if (busy && profilerStart != 0)
+    CProfiler::Get().AddSample(profilerSection, CurrentHostCounter() - profilerStart);
+
   return busy;
 }
 
@@ -2118,6 +1998,105 @@ void CActiveAE::MixSounds(CSoundPacket &dstSample)
   }
 }
 
+void CActiveAE::MixStream(CActiveAEStream *stream, CSampleBuffer *out, CSampleBuffer *mix, bool limit)
+{
+  int frames = mix->pkt->nb_samples;
+  int stride = mix->pkt->config.channels / mix->pkt->planes;
+  int nb_floats = frames * stride;
+
+  // fading
+  if (stream->m_fadingSamples == -1)
+  {
+    stream->m_fadingSamples = m_internalFormat.m_sampleRate * (float)stream->m_fadingTime / 1000.0f;
+    if (stream->m_fadingSamples > 0)
+      stream->m_volume = stream->m_fadingBase;
+    else
+    {
+      stream->m_volume = stream->m_fadingTarget;
+      CSingleLock lock(stream->m_streamLock);
+      stream->m_streamFading = false;
+    }
+  }
+
+  // constant volume for the whole buffer
+  if (stream->m_fadingSamples <= 0 && !limit)
+  {
+    float volume = stream->m_volume * stream->m_rgain;
+    for(int j=0; j<out->pkt->planes && j<mix->pkt->planes; j++)
+    {
+      float *dst = (float*)out->pkt->data[j];
+      float *src = (float*)mix->pkt->data[j];
+#ifdef __SSE__
+      if (out == mix)
+        CAEUtil::SSEMulArray(dst, volume, nb_floats);
+      else
+        CAEUtil::SSEMulAddArray(dst, src, volume, nb_floats);
+#else
+      if (out == mix)
+      {
+        for (int k = 0; k < nb_floats; ++k)
+          dst[k] *= volume;
+      }
+      else
+      {
+        for (int k = 0; k < nb_floats; ++k)
+          dst[k] += src[k] * volume;
+      }
+#endif
+    }
+    return;
+  }
+
+  // otherwise the gain of every frame is calculated up front and
+  // applied to the whole buffer at once
+  if ((int)m_mixGains.size() < frames)
+    m_mixGains.resize(frames);
+  float *gains = &m_mixGains[0];
+
+  // fading streams always run through the limiter
+  bool fading = stream->m_fadingSamples > 0;
+  if (fading)
+  {
+    float delta = stream->m_fadingTarget - stream->m_fadingBase;
+    int samples = m_internalFormat.m_sampleRate * (float)stream->m_fadingTime / 1000.0f;
+    float fadingStep = delta / samples;
+    int fading = std::min(frames, stream->m_fadingSamples);
+
+    float volume = stream->m_volume;
+    for (int i = 0; i < fading; i++)
+    {
+      volume += fadingStep;
+      gains[i] = volume * stream->m_rgain;
+    }
+    for (int i = fading; i < frames; i++)
+      gains[i] = volume * stream->m_rgain;
+
+    stream->m_volume = volume;
+    stream->m_fadingSamples -= fading;
+    if (stream->m_fadingSamples == 0)
+    {
+      // set variables being polled via stream interface
+      CSingleLock lock(stream->m_streamLock);
+      stream->m_streamFading = false;
+    }
+  }
+  else
+    std::fill(gains, gains + frames, stream->m_volume * stream->m_rgain);
+
+  if (limit || fading)
+    stream->m_limiter.RunBlock((float**)mix->pkt->data, mix->pkt->config.channels, frames, mix->pkt->planes > 1, gains);
+
+  for(int j=0; j<out->pkt->planes && j<mix->pkt->planes; j++)
+  {
+    float *dst = (float*)out->pkt->data[j];
+    float *src = (float*)mix->pkt->data[j];
+    if (out == mix)
+      CAEUtil::MulArrayGains(dst, gains, frames, stride);
+    else
+      CAEUtil::MulAddArrayGains(dst, src, gains, frames, stride);
+  }
+}
+
 void CActiveAE::Deamplify(CSoundPacket &dstSample)
 {
   if (m_volumeScaled < 1.0 || m_muted)
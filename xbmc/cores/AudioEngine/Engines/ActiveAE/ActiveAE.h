@@ -292,6 +292,7 @@ protected:
   void ResampleSounds();
   bool ResampleSound(CActiveAESound *sound);
   void MixSounds(CSoundPacket &dstSample);
+  void MixStream(CActiveAEStream *stream, CSampleBuffer *out, CSampleBuffer *mix, bool limit);
   void Deamplify(CSoundPacket &dstSample);
 
   bool CompareFormat(AEAudioFormat &lhs, AEAudioFormat &rhs);
@@ -337,6 +338,7 @@ protected:
 
   // streams
   std::list<CActiveAEStream*> m_streams;
+  std::vector<float> m_mixGains;  // gain of every frame of the stream being mixed
   std::list<CActiveAEBufferPool*> m_discardBufferPools;
 
   // gui sounds
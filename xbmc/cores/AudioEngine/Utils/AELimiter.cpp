@@ -20,6 +20,7 @@
 
 #include "system.h"
 #include "AELimiter.h"
+#include "AEUtil.h"
 #include "settings/AdvancedSettings.h"
 #include "utils/MathUtils.h"
 #include <algorithm>
@@ -52,6 +53,42 @@ float CAELimiter::Run(float* frame[AE_CH_MAX], int channels, int offset /*= 0*/,
     }
   }
 
+  return Envelope(highest);
+}
+
+void CAELimiter::RunBlock(float* frame[AE_CH_MAX], int channels, int frames, bool planar, float *gains)
+{
+  if (frames <= 0)
+    return;
+
+  if ((int)m_peaks.size() < frames)
+    m_peaks.resize(frames);
+  float *peaks = &m_peaks[0];
+  std::fill(peaks, peaks + frames, 0.0f);
+
+  if (!planar)
+    CAEUtil::MaxAbsFrames(frame[0], peaks, frames, channels);
+  else
+  {
+    for(int i=0; i<channels; i++)
+      CAEUtil::MaxAbsFrames(frame[i], peaks, frames, 1);
+  }
+
+  // nothing to do as long as the limiter is idle and no frame clips
+  if (m_attenuation == 1.0f && m_increase == 0.0f &&
+      *std::max_element(peaks, peaks + frames) * m_amplify <= 1.0f)
+  {
+    for(int i=0; i<frames; i++)
+      gains[i] *= m_amplify;
+    return;
+  }
+
+  for(int i=0; i<frames; i++)
+    gains[i] *= Envelope(peaks[i]);
+}
+
+float CAELimiter::Envelope(float highest)
+{
   float sample = highest * m_amplify;
   if (sample * m_attenuation > 1.0f)
   {
@@ -25,10 +25,58 @@
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
 
+#include <algorithm>
+
 extern "C" {
 #include "libavutil/channel_layout.h"
 }
 
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* 4 float vectors of the available instruction set for the block kernels */
+#if defined(__SSE__)
+  #define AE_HAS_VEC4
+  typedef __m128 AEVec4;
+  #define AEVEC4_LOAD(p)      _mm_loadu_ps(p)
+  #define AEVEC4_STORE(p, v)  _mm_storeu_ps(p, v)
+  #define AEVEC4_SET1(x)      _mm_set1_ps(x)
+  #define AEVEC4_MUL(a, b)    _mm_mul_ps(a, b)
+  #define AEVEC4_MULADD(a, b, c) _mm_add_ps(a, _mm_mul_ps(b, c))
+  #define AEVEC4_MAX(a, b)    _mm_max_ps(a, b)
+  #define AEVEC4_ABS(a)       _mm_andnot_ps(_mm_set1_ps(-0.0f), a)
+  static inline float AEVec4HMax(AEVec4 v)
+  {
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(v);
+  }
+  /* (a0, a1, b0, b1) -> (a0, a0, a1, a1), (b0, b0, b1, b1) */
+  #define AEVEC4_DUP2(v, lo, hi) { lo = _mm_unpacklo_ps(v, v); hi = _mm_unpackhi_ps(v, v); }
+  /* (a0, a1, b0, b1), (c0, c1, d0, d1) -> (a0, b0, c0, d0), (a1, b1, c1, d1) */
+  #define AEVEC4_UNZIP(a, b, even, odd) { even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)); \
+                                          odd  = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)); }
+#elif defined(__ARM_NEON__)
+  #define AE_HAS_VEC4
+  typedef float32x4_t AEVec4;
+  #define AEVEC4_LOAD(p)      vld1q_f32(p)
+  #define AEVEC4_STORE(p, v)  vst1q_f32(p, v)
+  #define AEVEC4_SET1(x)      vdupq_n_f32(x)
+  #define AEVEC4_MUL(a, b)    vmulq_f32(a, b)
+  #define AEVEC4_MULADD(a, b, c) vmlaq_f32(a, b, c)
+  #define AEVEC4_MAX(a, b)    vmaxq_f32(a, b)
+  #define AEVEC4_ABS(a)       vabsq_f32(a)
+  static inline float AEVec4HMax(AEVec4 v)
+  {
+    float32x2_t m = vpmax_f32(vget_low_f32(v), vget_high_f32(v));
+    m = vpmax_f32(m, m);
+    return vget_lane_f32(m, 0);
+  }
+  #define AEVEC4_DUP2(v, lo, hi) { float32x4x2_t z = vzipq_f32(v, v); lo = z.val[0]; hi = z.val[1]; }
+  #define AEVEC4_UNZIP(a, b, even, odd) { float32x4x2_t z = vuzpq_f32(a, b); even = z.val[0]; odd = z.val[1]; }
+#endif
+
 using namespace std;
 
 /* declare the rng seed and initialize it */
@@ -430,6 +478,171 @@ void CAEUtil::ClampArray(float *data, uint32_t count)
 #endif
 }
 
+void CAEUtil::MulArrayGains(float *data, const float *gains, uint32_t frames, uint32_t stride)
+{
+  uint32_t i = 0;
+  if (stride == 1)
+  {
+#ifdef AE_HAS_VEC4
+    for (; i + 4 <= frames; i += 4)
+      AEVEC4_STORE(data + i, AEVEC4_MUL(AEVEC4_LOAD(data + i), AEVEC4_LOAD(gains + i)));
+#endif
+    for (; i < frames; ++i)
+      data[i] *= gains[i];
+  }
+#ifdef AE_HAS_VEC4
+  else if (stride == 2)
+  {
+    for (; i + 4 <= frames; i += 4, data += 8)
+    {
+      AEVec4 lo, hi;
+      AEVEC4_DUP2(AEVEC4_LOAD(gains + i), lo, hi);
+      AEVEC4_STORE(data    , AEVEC4_MUL(AEVEC4_LOAD(data    ), lo));
+      AEVEC4_STORE(data + 4, AEVEC4_MUL(AEVEC4_LOAD(data + 4), hi));
+    }
+    for (; i < frames; ++i, data += 2)
+    {
+      data[0] *= gains[i];
+      data[1] *= gains[i];
+    }
+  }
+  else if (stride >= 4)
+  {
+    for (; i < frames; ++i, data += stride)
+    {
+      AEVec4 g = AEVEC4_SET1(gains[i]);
+      uint32_t c = 0;
+      for (; c + 4 <= stride; c += 4)
+        AEVEC4_STORE(data + c, AEVEC4_MUL(AEVEC4_LOAD(data + c), g));
+      for (; c < stride; ++c)
+        data[c] *= gains[i];
+    }
+  }
+#endif
+  else
+  {
+    for (; i < frames; ++i, data += stride)
+      for (uint32_t c = 0; c < stride; ++c)
+        data[c] *= gains[i];
+  }
+}
+
+void CAEUtil::MulAddArrayGains(float *data, const float *add, const float *gains, uint32_t frames, uint32_t stride)
+{
+  uint32_t i = 0;
+  if (stride == 1)
+  {
+#ifdef AE_HAS_VEC4
+    for (; i + 4 <= frames; i += 4)
+      AEVEC4_STORE(data + i, AEVEC4_MULADD(AEVEC4_LOAD(data + i), AEVEC4_LOAD(add + i), AEVEC4_LOAD(gains + i)));
+#endif
+    for (; i < frames; ++i)
+      data[i] += add[i] * gains[i];
+  }
+#ifdef AE_HAS_VEC4
+  else if (stride == 2)
+  {
+    for (; i + 4 <= frames; i += 4, data += 8, add += 8)
+    {
+      AEVec4 lo, hi;
+      AEVEC4_DUP2(AEVEC4_LOAD(gains + i), lo, hi);
+      AEVEC4_STORE(data    , AEVEC4_MULADD(AEVEC4_LOAD(data    ), AEVEC4_LOAD(add    ), lo));
+      AEVEC4_STORE(data + 4, AEVEC4_MULADD(AEVEC4_LOAD(data + 4), AEVEC4_LOAD(add + 4), hi));
+    }
+    for (; i < frames; ++i, data += 2, add += 2)
+    {
+      data[0] += add[0] * gains[i];
+      data[1] += add[1] * gains[i];
+    }
+  }
+  else if (stride >= 4)
+  {
+    for (; i < frames; ++i, data += stride, add += stride)
+    {
+      AEVec4 g = AEVEC4_SET1(gains[i]);
+      uint32_t c = 0;
+      for (; c + 4 <= stride; c += 4)
+        AEVEC4_STORE(data + c, AEVEC4_MULADD(AEVEC4_LOAD(data + c), AEVEC4_LOAD(add + c), g));
+      for (; c < stride; ++c)
+        data[c] += add[c] * gains[i];
+    }
+  }
+#endif
+  else
+  {
+    for (; i < frames; ++i, data += stride, add += stride)
+      for (uint32_t c = 0; c < stride; ++c)
+        data[c] += add[c] * gains[i];
+  }
+}
+
+void CAEUtil::MaxAbsFrames(const float *data, float *peaks, uint32_t frames, uint32_t stride)
+{
+  uint32_t i = 0;
+  if (stride == 1)
+  {
+#ifdef AE_HAS_VEC4
+    for (; i + 4 <= frames; i += 4)
+      AEVEC4_STORE(peaks + i, AEVEC4_MAX(AEVEC4_LOAD(peaks + i), AEVEC4_ABS(AEVEC4_LOAD(data + i))));
+#endif
+    for (; i < frames; ++i)
+      peaks[i] = std::max(peaks[i], fabsf(data[i]));
+  }
+#ifdef AE_HAS_VEC4
+  else if (stride == 2)
+  {
+    for (; i + 4 <= frames; i += 4, data += 8)
+    {
+      AEVec4 even, odd;
+      AEVEC4_UNZIP(AEVEC4_ABS(AEVEC4_LOAD(data)), AEVEC4_ABS(AEVEC4_LOAD(data + 4)), even, odd);
+      AEVEC4_STORE(peaks + i, AEVEC4_MAX(AEVEC4_LOAD(peaks + i), AEVEC4_MAX(even, odd)));
+    }
+    for (; i < frames; ++i, data += 2)
+      peaks[i] = std::max(peaks[i], std::max(fabsf(data[0]), fabsf(data[1])));
+  }
+  else if (stride >= 4)
+  {
+    for (; i < frames; ++i, data += stride)
+    {
+      AEVec4 m = AEVEC4_ABS(AEVEC4_LOAD(data));
+      uint32_t c = 4;
+      for (; c + 4 <= stride; c += 4)
+        m = AEVEC4_MAX(m, AEVEC4_ABS(AEVEC4_LOAD(data + c)));
+      float peak = AEVec4HMax(m);
+      for (; c < stride; ++c)
+        peak = std::max(peak, fabsf(data[c]));
+      peaks[i] = std::max(peaks[i], peak);
+    }
+  }
+#endif
+  else
+  {
+    for (; i < frames; ++i, data += stride)
+      for (uint32_t c = 0; c < stride; ++c)
+        peaks[i] = std::max(peaks[i], fabsf(data[c]));
+  }
+}
+
+bool CAEUtil::NeedsClamp(const float *data, uint32_t count)
+{
+  float peak = 0.0f;
+  uint32_t i = 0;
+#ifdef AE_HAS_VEC4
+  AEVec4 m = AEVEC4_SET1(0.0f);
+  for (; i + 16 <= count; i += 16)
+  {
+    m = AEVEC4_MAX(m, AEVEC4_MAX(AEVEC4_ABS(AEVEC4_LOAD(data + i     )), AEVEC4_ABS(AEVEC4_LOAD(data + i +  4))));
+    m = AEVEC4_MAX(m, AEVEC4_MAX(AEVEC4_ABS(AEVEC4_LOAD(data + i +  8)), AEVEC4_ABS(AEVEC4_LOAD(data + i + 12))));
+  }
+  for (; i + 4 <= count; i += 4)
+    m = AEVEC4_MAX(m, AEVEC4_ABS(AEVEC4_LOAD(data + i)));
+  peak = AEVec4HMax(m);
+#endif
+  for (; i < count; ++i)
+    peak = std::max(peak, fabsf(data[i]));
+  return peak > 1.0f;
+}
+
 /*
   Rand implementations based on:
   http://software.intel.com/en-us/articles/fast-random-number-generator-on-the-intel-pentiumr-4-processor/
@@ -215,6 +215,18 @@ public:
   #endif
   static void ClampArray(float *data, uint32_t count);
 
+  /*
+    Block kernels for mixing with a gain per sample frame, e.g. for fades
+    and the limiter. A frame consists of stride floats, all of them get the
+    same gain: data[i * stride + c] *= gains[i]
+  */
+  static void MulArrayGains   (float *data, const float *gains, uint32_t frames, uint32_t stride);
+  static void MulAddArrayGains(float *data, const float *add, const float *gains, uint32_t frames, uint32_t stride);
+  /* peaks[i] = max(peaks[i], |data[i * stride + c]|) */
+  static void MaxAbsFrames    (const float *data, float *peaks, uint32_t frames, uint32_t stride);
+  /* true if any of the samples is outside of [-1, 1] */
+  static bool NeedsClamp      (const float *data, uint32_t count);
+
   /*
     Rand implementations based on:
     http://software.intel.com/en-us/articles/fast-random-number-generator-on-the-intel-pentiumr-4-processor/
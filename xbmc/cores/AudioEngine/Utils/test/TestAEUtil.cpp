@@ -0,0 +1,203 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AELimiter.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static void FillRandom(std::vector<float> &data, float range)
+{
+  for (size_t i = 0; i < data.size(); i++)
+    data[i] = range * (2.0f * rand() / RAND_MAX - 1.0f);
+}
+
+TEST(TestAEUtil, MulArrayGains)
+{
+  const uint32_t frames = 1029;
+  for (uint32_t stride = 1; stride <= 8; stride++)
+  {
+    std::vector<float> data(frames * stride), add(frames * stride), gains(frames);
+    FillRandom(data, 1.0f);
+    FillRandom(add, 1.0f);
+    FillRandom(gains, 2.0f);
+
+    std::vector<float> mul(data), muladd(data);
+    CAEUtil::MulArrayGains(&mul[0], &gains[0], frames, stride);
+    CAEUtil::MulAddArrayGains(&muladd[0], &add[0], &gains[0], frames, stride);
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+      for (uint32_t c = 0; c < stride; c++)
+      {
+        uint32_t k = i * stride + c;
+        ASSERT_FLOAT_EQ(data[k] * gains[i], mul[k]) << "stride " << stride << " frame " << i;
+        ASSERT_FLOAT_EQ(data[k] + add[k] * gains[i], muladd[k]) << "stride " << stride << " frame " << i;
+      }
+    }
+  }
+}
+
+TEST(TestAEUtil, MaxAbsFrames)
+{
+  const uint32_t frames = 1029;
+  for (uint32_t stride = 1; stride <= 8; stride++)
+  {
+    std::vector<float> data(frames * stride), peaks(frames, 0.5f);
+    FillRandom(data, 1.0f);
+    CAEUtil::MaxAbsFrames(&data[0], &peaks[0], frames, stride);
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+      float peak = 0.5f;
+      for (uint32_t c = 0; c < stride; c++)
+        peak = std::max(peak, fabsf(data[i * stride + c]));
+      ASSERT_EQ(peak, peaks[i]) << "stride " << stride << " frame " << i;
+    }
+  }
+}
+
+TEST(TestAEUtil, NeedsClamp)
+{
+  std::vector<float> data(1027);
+  FillRandom(data, 1.0f);
+  EXPECT_FALSE(CAEUtil::NeedsClamp(&data[0], data.size()));
+
+  // wherever the clipping sample is
+  for (size_t i = 0; i < data.size(); i += 13)
+  {
+    float sample = data[i];
+    data[i] = (i & 1) ? 1.01f : -1.01f;
+    EXPECT_TRUE(CAEUtil::NeedsClamp(&data[0], data.size())) << i;
+    data[i] = sample;
+  }
+}
+
+TEST(TestAEUtil, LimiterBlock)
+{
+  const int frames = 4096;
+  for (int channels = 1; channels <= 8; channels++)
+  {
+    // loud enough for the limiter to kick in every now and then
+    std::vector<float> data(frames * channels);
+    FillRandom(data, 0.5f);
+    for (int i = 0; i < frames; i += 1000)
+      data[i * channels] = 0.9f;
+    float* frame[AE_CH_MAX] = { &data[0] };
+
+    CAELimiter perFrame, block;
+    perFrame.SetAmplification(2.0f);
+    block.SetAmplification(2.0f);
+
+    std::vector<float> gains(frames, 1.0f);
+    block.RunBlock(frame, channels, frames, false, &gains[0]);
+    for (int i = 0; i < frames; i++)
+      ASSERT_FLOAT_EQ(perFrame.Run(frame, channels, i * channels, false), gains[i]) << "channels " << channels << " frame " << i;
+  }
+}
+
+TEST(TestAEUtil, LimiterBlockPlanar)
+{
+  const int frames = 4096;
+  const int channels = 6;
+  std::vector<float> planes[channels];
+  float* frame[AE_CH_MAX];
+  for (int i = 0; i < channels; i++)
+  {
+    planes[i].resize(frames);
+    FillRandom(planes[i], 0.4f);
+    frame[i] = &planes[i][0];
+  }
+  planes[3][1234] = -0.8f;
+
+  CAELimiter perFrame, block;
+  perFrame.SetAmplification(2.0f);
+  block.SetAmplification(2.0f);
+
+  std::vector<float> gains(frames, 0.5f);
+  block.RunBlock(frame, channels, frames, true, &gains[0]);
+  for (int i = 0; i < frames; i++)
+    ASSERT_FLOAT_EQ(0.5f * perFrame.Run(frame, channels, i, true), gains[i]) << i;
+}
+
+/* Mixing a stream with ramped gain through the limiter, once frame by frame
+   the way ActiveAE did and once on whole buffers */
+// a benchmark without checks, enabled by --gtest_also_run_disabled_tests
+TEST(TestAEUtil, DISABLED_MixBenchmark)
+{
+  const int frames = 1024;
+  const int buffers = 500;
+  const int channelCounts[] = { 1, 2, 6, 8 };
+
+  for (unsigned int n = 0; n < sizeof(channelCounts) / sizeof(channelCounts[0]); n++)
+  {
+    int channels = channelCounts[n];
+    std::vector<float> out(frames * channels), mix(frames * channels), gains(frames);
+    FillRandom(out, 0.5f);
+    FillRandom(mix, 0.5f);
+    float* frame[AE_CH_MAX] = { &mix[0] };
+
+    CAELimiter limiter;
+    limiter.SetAmplification(1.5f);
+    float volume = 0.0f;
+    float step = 1.0f / (frames * buffers);
+    int64_t start = CurrentHostCounter();
+    for (int b = 0; b < buffers; b++)
+    {
+      for (int i = 0; i < frames; i++)
+      {
+        volume += step;
+        float gain = volume * limiter.Run(frame, channels, i * channels, false);
+#ifdef __SSE__
+        CAEUtil::SSEMulAddArray(&out[i * channels], &mix[i * channels], gain, channels);
+#else
+        for (int c = 0; c < channels; c++)
+          out[i * channels + c] += mix[i * channels + c] * gain;
+#endif
+      }
+      CAEUtil::NeedsClamp(&out[0], out.size());
+    }
+    int64_t perFrame = CurrentHostCounter() - start;
+
+    volume = 0.0f;
+    start = CurrentHostCounter();
+    for (int b = 0; b < buffers; b++)
+    {
+      for (int i = 0; i < frames; i++)
+      {
+        volume += step;
+        gains[i] = volume;
+      }
+      limiter.RunBlock(frame, channels, frames, false, &gains[0]);
+      CAEUtil::MulAddArrayGains(&out[0], &mix[0], &gains[0], frames, channels);
+      CAEUtil::NeedsClamp(&out[0], out.size());
+    }
+    int64_t block = CurrentHostCounter() - start;
+
+    double nsPerTick = 1000000000.0 / CurrentHostFrequency();
+    printf("%d channels: %.2fns per frame frame by frame, %.2fns per frame in blocks\n", channels,
+           perFrame * nsPerTick / (frames * buffers), block * nsPerTick / (frames * buffers));
+  }
+}
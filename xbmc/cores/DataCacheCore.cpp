@@ -19,6 +19,32 @@
 */
 
 #include "cores/DataCacheCore.h"
+#include "threads/SystemClock.h"
+
+#include <math.h>
+#include <string.h>
+
+// how far the published play time is moved on at most
+#define PLAYTIME_EXTRAPOLATION_LIMIT 200
+
+static bool Equals(const CDataCacheCore::SVideoInfo &a, const CDataCacheCore::SVideoInfo &b)
+{
+  return a.bitrate == b.bitrate && a.aspectRatio == b.aspectRatio &&
+         a.width == b.width && a.height == b.height &&
+         strcmp(a.codec, b.codec) == 0 && strcmp(a.stereoMode, b.stereoMode) == 0;
+}
+
+static bool Equals(const CDataCacheCore::SAudioInfo &a, const CDataCacheCore::SAudioInfo &b)
+{
+  return a.bitrate == b.bitrate && a.channels == b.channels &&
+         a.sampleRate == b.sampleRate && a.bitsPerSample == b.bitsPerSample &&
+         a.passthrough == b.passthrough && strcmp(a.codec, b.codec) == 0;
+}
+
+CDataCacheCore::CDataCacheCore()
+{
+  m_hasAVInfoChanges = false;
+}
 
 bool CDataCacheCore::HasAVInfoChanges()
 {
@@ -35,4 +61,96 @@ void CDataCacheCore::SignalVideoInfoChange()
 void CDataCacheCore::SignalAudioInfoChange()
 {
   m_hasAVInfoChanges = true;
-}
\ No newline at end of file
+}
+
+void CDataCacheCore::SetPlayerInfo(const SPlayerInfo &info)
+{
+  SPublished<SPlayerInfo> published;
+  published.valid = true;
+  published.info = info;
+  m_playerInfo.Store(published);
+}
+
+void CDataCacheCore::SetVideoInfo(const SVideoInfo &info)
+{
+  SPublished<SVideoInfo> published;
+  m_videoInfo.Load(published);
+  if (published.valid && Equals(published.info, info))
+    return;
+
+  published.valid = true;
+  published.info = info;
+  m_videoInfo.Store(published);
+  m_hasAVInfoChanges = true;
+}
+
+void CDataCacheCore::SetAudioInfo(const SAudioInfo &info)
+{
+  SPublished<SAudioInfo> published;
+  m_audioInfo.Load(published);
+  if (published.valid && Equals(published.info, info))
+    return;
+
+  published.valid = true;
+  published.info = info;
+  m_audioInfo.Store(published);
+  m_hasAVInfoChanges = true;
+}
+
+void CDataCacheCore::Reset()
+{
+  SPublished<SPlayerInfo> player;
+  memset(&player, 0, sizeof(player));
+  m_playerInfo.Store(player);
+
+  SPublished<SVideoInfo> video;
+  memset(&video, 0, sizeof(video));
+  m_videoInfo.Store(video);
+
+  SPublished<SAudioInfo> audio;
+  memset(&audio, 0, sizeof(audio));
+  m_audioInfo.Store(audio);
+
+  m_hasAVInfoChanges = true;
+}
+
+bool CDataCacheCore::GetPlayerInfo(SPlayerInfo &info) const
+{
+  SPublished<SPlayerInfo> published;
+  m_playerInfo.Load(published);
+  if (published.valid)
+    info = published.info;
+  return published.valid;
+}
+
+bool CDataCacheCore::GetVideoInfo(SVideoInfo &info) const
+{
+  SPublished<SVideoInfo> published;
+  m_videoInfo.Load(published);
+  if (published.valid)
+    info = published.info;
+  return published.valid;
+}
+
+bool CDataCacheCore::GetAudioInfo(SAudioInfo &info) const
+{
+  SPublished<SAudioInfo> published;
+  m_audioInfo.Load(published);
+  if (published.valid)
+    info = published.info;
+  return published.valid;
+}
+
+bool CDataCacheCore::GetPlayTime(int64_t &time) const
+{
+  SPlayerInfo info;
+  if (!GetPlayerInfo(info))
+    return false;
+
+  // the player may have published after we took the clock
+  double offset = (double)(int)(XbmcThreads::SystemClockMillis() - info.stamp) * info.speed;
+  if (offset >  PLAYTIME_EXTRAPOLATION_LIMIT) offset =  PLAYTIME_EXTRAPOLATION_LIMIT;
+  if (offset < -PLAYTIME_EXTRAPOLATION_LIMIT) offset = -PLAYTIME_EXTRAPOLATION_LIMIT;
+  time = llrint(info.time + offset);
+  return true;
+}
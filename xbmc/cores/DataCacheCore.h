@@ -20,15 +20,86 @@
 *
 */
 
+#include "threads/SeqLock.h"
+
+#include <stdint.h>
+
+/*!
+ \brief Snapshot of the playing player's state
+
+ The player threads publish their state here as they go, so the GUI, the
+ application and JSON-RPC can read it without calling into the player and
+ waiting on its locks. Readers get a consistent copy without ever blocking,
+ a Get method returns false if the current player doesn't publish that part.
+ */
 class CDataCacheCore
 {
 public:
+  struct SPlayerInfo
+  {
+    double       time;       ///< position in ms at stamp
+    double       timeTotal;  ///< length in ms
+    float        speed;      ///< 1.0 for normal playback, 0.0 while paused
+    int          cacheLevel; ///< in percent
+    unsigned int stamp;      ///< SystemClockMillis() when time was taken
+  };
+
+  struct SVideoInfo
+  {
+    int   bitrate;
+    float aspectRatio;
+    int   width;
+    int   height;
+    char  codec[32];
+    char  stereoMode[32];
+  };
+
+  struct SAudioInfo
+  {
+    int   bitrate;
+    int   channels;
+    int   sampleRate;
+    int   bitsPerSample;
+    bool  passthrough;
+    char  codec[32];
+  };
+
+  CDataCacheCore();
+
   bool HasAVInfoChanges();
   void SignalVideoInfoChange();
   void SignalAudioInfoChange();
 
+  // called by the player threads, as often as once per frame
+  void SetPlayerInfo(const SPlayerInfo &info);
+  void SetVideoInfo(const SVideoInfo &info);
+  void SetAudioInfo(const SAudioInfo &info);
+  /*! \brief Drop all published state, called by the player when it stops */
+  void Reset();
+
+  bool GetPlayerInfo(SPlayerInfo &info) const;
+  bool GetVideoInfo(SVideoInfo &info) const;
+  bool GetAudioInfo(SAudioInfo &info) const;
+
+  /*!
+   \brief Get the playback position in ms
+   The last published time is moved on by the time passed since, by at most
+   200ms so that a stalled player doesn't run away.
+   */
+  bool GetPlayTime(int64_t &time) const;
+
 protected:
+  template<class T> struct SPublished
+  {
+    bool valid;
+    T    info;
+  };
+
   volatile bool m_hasAVInfoChanges;
+
+  XbmcThreads::SeqLock< SPublished<SPlayerInfo> > m_playerInfo;
+  XbmcThreads::SeqLock< SPublished<SVideoInfo> >  m_videoInfo;
+  XbmcThreads::SeqLock< SPublished<SAudioInfo> >  m_audioInfo;
 };
 
 extern CDataCacheCore g_dataCacheCore;
\ No newline at end of file
@@ -46,6 +46,8 @@ public:
     identify = false;
     fullscreen = false;
     video_only = false;
+    null_output = false;
+    unpaced = false;
   }
   double  starttime; /* start time in seconds */
   double  startpercent; /* start time in percent */  
@@ -53,6 +55,8 @@ public:
   std::string state;  /* potential playerstate to restore to */
   bool    fullscreen; /* player is allowed to switch to fullscreen */
   bool    video_only; /* player is not allowed to play audio streams, video streams only */
+  bool    null_output; /* decoded pictures are not handed to the renderer, used for benchmarking */
+  bool    unpaced; /* with null_output, decode as fast as possible without syncing to the clock or playing audio */
 };
 
 class CFileItem;
@@ -18,17 +18,30 @@
  *
  */
 
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
 #include "DVDCodecUtils.h"
 #include "DVDClock.h"
 #include "cores/VideoRenderers/RenderManager.h"
+#include "threads/Condition.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+#include "utils/CPUInfo.h"
 #include "utils/log.h"
-#include "utils/fastmemcpy.h"
 #include "cores/FFmpeg.h"
 #include "Util.h"
 #ifdef HAS_DX
 #include "cores/dvdplayer/DVDCodecs/Video/DXVA.h"
 #endif
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #ifdef TARGET_WINDOWS
 #pragma comment(lib, "avcodec.lib")
 #pragma comment(lib, "avfilter.lib")
@@ -39,10 +52,6 @@
 #pragma comment(lib, "swscale.lib")
 #endif
 
-extern "C" {
-#include "libswscale/swscale.h"
-}
-
 // allocate a new picture (PIX_FMT_YUV420P)
 DVDVideoPicture* CDVDCodecUtils::AllocatePicture(int iWidth, int iHeight)
 {
@@ -84,96 +93,357 @@ void CDVDCodecUtils::FreePicture(DVDVideoPicture* pPicture)
   delete pPicture;
 }
 
-bool CDVDCodecUtils::CopyPicture(DVDVideoPicture* pDst, DVDVideoPicture* pSrc)
-{
-  uint8_t *s, *d;
-  int w = pSrc->iWidth;
-  int h = pSrc->iHeight;
+// pictures are split into bands of rows, copied in parallel, once a copy
+// is big enough to be limited by the memory bandwidth of a single core
+#define PLANE_BAND_MIN_BYTES    (1024 * 1024)
+#define PLANE_WORKERS_MAX       3
 
-  s = pSrc->data[0];
-  d = pDst->data[0];
+struct SPlaneTask
+{
+  enum EType
+  {
+    COPY,
+    INTERLEAVE,
+    PACK_YUYV,
+    PACK_UYVY
+  } type;
+  uint8_t       *dst;
+  int            dstStride;
+  const uint8_t *src[3];
+  int            srcStride[3];
+  int            width;
+  int            height;
+};
 
-  for (int y = 0; y < h; y++)
+static void InterleaveRow(uint8_t *dst, const uint8_t *srcU, const uint8_t *srcV, int width)
+{
+  int x = 0;
+#if defined(__SSE2__)
+  for (; x + 16 <= width; x += 16)
   {
-    fast_memcpy(d, s, w);
-    s += pSrc->iLineSize[0];
-    d += pDst->iLineSize[0];
+    __m128i u = _mm_loadu_si128((const __m128i*)(srcU + x));
+    __m128i v = _mm_loadu_si128((const __m128i*)(srcV + x));
+    _mm_storeu_si128((__m128i*)(dst + 2 * x),      _mm_unpacklo_epi8(u, v));
+    _mm_storeu_si128((__m128i*)(dst + 2 * x + 16), _mm_unpackhi_epi8(u, v));
   }
+#elif defined(__ARM_NEON__)
+  for (; x + 16 <= width; x += 16)
+  {
+    uint8x16x2_t uv;
+    uv.val[0] = vld1q_u8(srcU + x);
+    uv.val[1] = vld1q_u8(srcV + x);
+    vst2q_u8(dst + 2 * x, uv);
+  }
+#endif
+  for (; x < width; x++)
+  {
+    dst[2 * x]     = srcU[x];
+    dst[2 * x + 1] = srcV[x];
+  }
+}
 
-  w >>= 1;
-  h >>= 1;
-
-  s = pSrc->data[1];
-  d = pDst->data[1];
-  for (int y = 0; y < h; y++)
+// width is in pairs of pixels sharing their chroma
+static void PackRow(uint8_t *dst, const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV, int width, bool uyvy)
+{
+  int x = 0;
+#if defined(__SSE2__)
+  for (; x + 16 <= width; x += 16)
   {
-    fast_memcpy(d, s, w);
-    s += pSrc->iLineSize[1];
-    d += pDst->iLineSize[1];
+    __m128i y0   = _mm_loadu_si128((const __m128i*)(srcY + 2 * x));
+    __m128i y1   = _mm_loadu_si128((const __m128i*)(srcY + 2 * x + 16));
+    __m128i u    = _mm_loadu_si128((const __m128i*)(srcU + x));
+    __m128i v    = _mm_loadu_si128((const __m128i*)(srcV + x));
+    __m128i uvlo = _mm_unpacklo_epi8(u, v);
+    __m128i uvhi = _mm_unpackhi_epi8(u, v);
+    if (uyvy)
+    {
+      _mm_storeu_si128((__m128i*)(dst + 4 * x),      _mm_unpacklo_epi8(uvlo, y0));
+      _mm_storeu_si128((__m128i*)(dst + 4 * x + 16), _mm_unpackhi_epi8(uvlo, y0));
+      _mm_storeu_si128((__m128i*)(dst + 4 * x + 32), _mm_unpacklo_epi8(uvhi, y1));
+      _mm_storeu_si128((__m128i*)(dst + 4 * x + 48), _mm_unpackhi_epi8(uvhi, y1));
+    }
+    else
+    {
+      _mm_storeu_si128((__m128i*)(dst + 4 * x),      _mm_unpacklo_epi8(y0, uvlo));
+      _mm_storeu_si128((__m128i*)(dst + 4 * x + 16), _mm_unpackhi_epi8(y0, uvlo));
+      _mm_storeu_si128((__m128i*)(dst + 4 * x + 32), _mm_unpacklo_epi8(y1, uvhi));
+      _mm_storeu_si128((__m128i*)(dst + 4 * x + 48), _mm_unpackhi_epi8(y1, uvhi));
+    }
   }
+#elif defined(__ARM_NEON__)
+  for (; x + 16 <= width; x += 16)
+  {
+    uint8x16x2_t y = vld2q_u8(srcY + 2 * x);
+    uint8x16x4_t packed;
+    if (uyvy)
+    {
+      packed.val[0] = vld1q_u8(srcU + x);
+      packed.val[1] = y.val[0];
+      packed.val[2] = vld1q_u8(srcV + x);
+      packed.val[3] = y.val[1];
+    }
+    else
+    {
+      packed.val[0] = y.val[0];
+      packed.val[1] = vld1q_u8(srcU + x);
+      packed.val[2] = y.val[1];
+      packed.val[3] = vld1q_u8(srcV + x);
+    }
+    vst4q_u8(dst + 4 * x, packed);
+  }
+#endif
+  for (; x < width; x++)
+  {
+    uint8_t *d = dst + 4 * x;
+    if (uyvy)
+    {
+      d[0] = srcU[x];
+      d[1] = srcY[2 * x];
+      d[2] = srcV[x];
+      d[3] = srcY[2 * x + 1];
+    }
+    else
+    {
+      d[0] = srcY[2 * x];
+      d[1] = srcU[x];
+      d[2] = srcY[2 * x + 1];
+      d[3] = srcV[x];
+    }
+  }
+}
 
-  s = pSrc->data[2];
-  d = pDst->data[2];
-  for (int y = 0; y < h; y++)
+static void RunPlaneTaskRows(const SPlaneTask &task, int first, int last)
+{
+  uint8_t *d = task.dst + first * task.dstStride;
+  switch (task.type)
   {
-    fast_memcpy(d, s, w);
-    s += pSrc->iLineSize[2];
-    d += pDst->iLineSize[2];
+    case SPlaneTask::COPY:
+    {
+      // memcpy of libc already picks the widest vector unit of the cpu at runtime
+      const uint8_t *s = task.src[0] + first * task.srcStride[0];
+      if (task.width == task.srcStride[0] && task.width == task.dstStride)
+        memcpy(d, s, task.width * (last - first));
+      else
+      {
+        for (int y = first; y < last; y++, s += task.srcStride[0], d += task.dstStride)
+          memcpy(d, s, task.width);
+      }
+      break;
+    }
+    case SPlaneTask::INTERLEAVE:
+    {
+      for (int y = first; y < last; y++, d += task.dstStride)
+        InterleaveRow(d, task.src[1] + y * task.srcStride[1], task.src[2] + y * task.srcStride[2], task.width);
+      break;
+    }
+    case SPlaneTask::PACK_YUYV:
+    case SPlaneTask::PACK_UYVY:
+    {
+      for (int y = first; y < last; y++, d += task.dstStride)
+      {
+        PackRow(d, task.src[0] + y * task.srcStride[0],
+                   task.src[1] + (y >> 1) * task.srcStride[1],
+                   task.src[2] + (y >> 1) * task.srcStride[2],
+                   task.width >> 1, task.type == SPlaneTask::PACK_UYVY);
+      }
+      break;
+    }
   }
-  return true;
 }
 
-bool CDVDCodecUtils::CopyPicture(YV12Image* pImage, DVDVideoPicture *pSrc)
+/*!
+ \brief Small pool of threads copying bands of a plane along with the caller
+ Only one task is spread at a time, others are run by their caller alone.
+ */
+class CPlaneWorkers : public IRunnable
 {
-  uint8_t *s = pSrc->data[0];
-  uint8_t *d = pImage->plane[0];
-  int w = pImage->width * pImage->bpp;
-  int h = pImage->height;
-  if ((w == pSrc->iLineSize[0]) && ((unsigned int) pSrc->iLineSize[0] == pImage->stride[0]))
+public:
+  static CPlaneWorkers& Get()
   {
-    fast_memcpy(d, s, w*h);
+    static CPlaneWorkers sPlaneWorkers;
+    return sPlaneWorkers;
   }
-  else
+
+  void Run(const SPlaneTask &task)
   {
-    for (int y = 0; y < h; y++)
+    int bytes = task.width * task.height;
+    if (task.type != SPlaneTask::COPY)
+      bytes *= 2;
+    int bands = std::min(bytes / PLANE_BAND_MIN_BYTES, PLANE_WORKERS_MAX + 1);
+
+    CSingleLock lock(m_section);
+    if (bands < 2 || m_active || !StartWorkers())
     {
-      fast_memcpy(d, s, w);
-      s += pSrc->iLineSize[0];
-      d += pImage->stride[0];
+      lock.Leave();
+      RunPlaneTaskRows(task, 0, task.height);
+      return;
     }
+
+    m_active = true;
+    m_task = task;
+    m_bands = std::min(bands, (int)m_workers.size() + 1);
+    m_next = 0;
+    m_done = 0;
+    m_work.notifyAll();
+
+    RunBands(lock);
+    while (m_done < m_bands)
+      m_finished.wait(lock);
+    m_active = false;
   }
-  s = pSrc->data[1];
-  d = pImage->plane[1];
-  w =(pImage->width  >> pImage->cshift_x) * pImage->bpp;
-  h =(pImage->height >> pImage->cshift_y);
-  if ((w==pSrc->iLineSize[1]) && ((unsigned int) pSrc->iLineSize[1]==pImage->stride[1]))
+
+private:
+  CPlaneWorkers()
+    : m_stop(false),
+      m_active(false),
+      m_bands(0),
+      m_next(0),
+      m_done(0)
+  { }
+
+  virtual ~CPlaneWorkers()
   {
-    fast_memcpy(d, s, w*h);
+    CSingleLock lock(m_section);
+    m_stop = true;
+    m_work.notifyAll();
+    lock.Leave();
+
+    for (std::vector<CThread*>::iterator worker = m_workers.begin(); worker != m_workers.end(); ++worker)
+    {
+      (*worker)->StopThread(true);
+      delete *worker;
+    }
   }
-  else
+
+  bool StartWorkers()
   {
-    for (int y = 0; y < h; y++)
+    if (m_workers.empty())
     {
-      fast_memcpy(d, s, w);
-      s += pSrc->iLineSize[1];
-      d += pImage->stride[1];
+      int workers = std::min(g_cpuInfo.getCPUCount() - 1, PLANE_WORKERS_MAX);
+      for (int i = 0; i < workers; i++)
+      {
+        CThread *worker = new CThread(this, "PlaneCopy");
+        worker->Create();
+        m_workers.push_back(worker);
+      }
     }
+    return !m_workers.empty();
   }
-  s = pSrc->data[2];
-  d = pImage->plane[2];
-  if ((w==pSrc->iLineSize[2]) && ((unsigned int) pSrc->iLineSize[2]==pImage->stride[2]))
+
+  // runs bands of the current task until all have been taken
+  void RunBands(CSingleLock &lock)
   {
-    fast_memcpy(d, s, w*h);
+    while (m_next < m_bands)
+    {
+      int band = m_next++;
+      int first = (int)((int64_t)m_task.height * band / m_bands);
+      int last  = (int)((int64_t)m_task.height * (band + 1) / m_bands);
+      SPlaneTask task = m_task;
+
+      lock.Leave();
+      RunPlaneTaskRows(task, first, last);
+      lock.Enter();
+
+      if (++m_done == m_bands)
+        m_finished.notifyAll();
+    }
   }
-  else
+
+  virtual void Run()
   {
-    for (int y = 0; y < h; y++)
+    CSingleLock lock(m_section);
+    while (!m_stop)
     {
-      fast_memcpy(d, s, w);
-      s += pSrc->iLineSize[2];
-      d += pImage->stride[2];
+      RunBands(lock);
+      m_work.wait(lock);
     }
   }
+
+  CCriticalSection m_section;
+  XbmcThreads::ConditionVariable m_work;
+  XbmcThreads::ConditionVariable m_finished;
+  std::vector<CThread*> m_workers;
+  bool m_stop;
+  bool m_active;
+  SPlaneTask m_task;
+  int m_bands;
+  int m_next;
+  int m_done;
+};
+
+void CDVDCodecUtils::CopyPlane(uint8_t *dst, int dstStride, const uint8_t *src, int srcStride, int width, int height)
+{
+  SPlaneTask task;
+  task.type         = SPlaneTask::COPY;
+  task.dst          = dst;
+  task.dstStride    = dstStride;
+  task.src[0]       = src;
+  task.srcStride[0] = srcStride;
+  task.src[1]       = task.src[2]       = NULL;
+  task.srcStride[1] = task.srcStride[2] = 0;
+  task.width        = width;
+  task.height       = height;
+  CPlaneWorkers::Get().Run(task);
+}
+
+void CDVDCodecUtils::InterleavePlanes(uint8_t *dst, int dstStride, const uint8_t *srcU, int strideU, const uint8_t *srcV, int strideV, int width, int height)
+{
+  SPlaneTask task;
+  task.type         = SPlaneTask::INTERLEAVE;
+  task.dst          = dst;
+  task.dstStride    = dstStride;
+  task.src[0]       = NULL;
+  task.srcStride[0] = 0;
+  task.src[1]       = srcU;
+  task.srcStride[1] = strideU;
+  task.src[2]       = srcV;
+  task.srcStride[2] = strideV;
+  task.width        = width;
+  task.height       = height;
+  CPlaneWorkers::Get().Run(task);
+}
+
+void CDVDCodecUtils::PackYUV422(uint8_t *dst, int dstStride, uint8_t* const src[3], const int srcStride[3], int width, int height, ERenderFormat format)
+{
+  SPlaneTask task;
+  task.type      = format == RENDER_FMT_UYVY422 ? SPlaneTask::PACK_UYVY : SPlaneTask::PACK_YUYV;
+  task.dst       = dst;
+  task.dstStride = dstStride;
+  for (int i = 0; i < 3; i++)
+  {
+    task.src[i]       = src[i];
+    task.srcStride[i] = srcStride[i];
+  }
+  task.width     = width;
+  task.height    = height;
+  CPlaneWorkers::Get().Run(task);
+}
+
+bool CDVDCodecUtils::CopyPicture(DVDVideoPicture* pDst, DVDVideoPicture* pSrc)
+{
+  int w = pSrc->iWidth;
+  int h = pSrc->iHeight;
+
+  CopyPlane(pDst->data[0], pDst->iLineSize[0], pSrc->data[0], pSrc->iLineSize[0], w, h);
+
+  w >>= 1;
+  h >>= 1;
+
+  CopyPlane(pDst->data[1], pDst->iLineSize[1], pSrc->data[1], pSrc->iLineSize[1], w, h);
+  CopyPlane(pDst->data[2], pDst->iLineSize[2], pSrc->data[2], pSrc->iLineSize[2], w, h);
+  return true;
+}
+
+bool CDVDCodecUtils::CopyPicture(YV12Image* pImage, DVDVideoPicture *pSrc)
+{
+  int w = pImage->width * pImage->bpp;
+  int h = pImage->height;
+  CopyPlane(pImage->plane[0], pImage->stride[0], pSrc->data[0], pSrc->iLineSize[0], w, h);
+
+  w =(pImage->width  >> pImage->cshift_x) * pImage->bpp;
+  h =(pImage->height >> pImage->cshift_y);
+  CopyPlane(pImage->plane[1], pImage->stride[1], pSrc->data[1], pSrc->iLineSize[1], w, h);
+  CopyPlane(pImage->plane[2], pImage->stride[2], pSrc->data[2], pSrc->iLineSize[2], w, h);
   return true;
 }
 
@@ -203,26 +473,13 @@ DVDVideoPicture* CDVDCodecUtils::ConvertToNV12Picture(DVDVideoPicture *pSrc)
       pPicture->format = RENDER_FMT_NV12;
       
       // copy luma
-      uint8_t *s = pSrc->data[0];
-      uint8_t *d = pPicture->data[0];
-      for (int y = 0; y < (int)pSrc->iHeight; y++)
-      {
-        fast_memcpy(d, s, pSrc->iWidth);
-        s += pSrc->iLineSize[0];
-        d += pPicture->iLineSize[0];
-      }
+      CopyPlane(pPicture->data[0], pPicture->iLineSize[0], pSrc->data[0], pSrc->iLineSize[0], pSrc->iWidth, pSrc->iHeight);
 
       //copy chroma
-      for (int y = 0; y < (int)pSrc->iHeight/2; y++) {
-        uint8_t *s_u = pSrc->data[1] + (y * pSrc->iLineSize[1]);
-        uint8_t *s_v = pSrc->data[2] + (y * pSrc->iLineSize[2]);
-        uint8_t *d_uv = pPicture->data[1] + (y * pPicture->iLineSize[1]);
-        for (int x = 0; x < (int)pSrc->iWidth/2; x++) {
-          *d_uv++ = *s_u++;
-          *d_uv++ = *s_v++;
-        }
-      }
-      
+      InterleavePlanes(pPicture->data[1], pPicture->iLineSize[1],
+                       pSrc->data[1], pSrc->iLineSize[1],
+                       pSrc->data[2], pSrc->iLineSize[2],
+                       pSrc->iWidth / 2, pSrc->iHeight / 2);
     }
     else
     {
@@ -257,27 +514,8 @@ DVDVideoPicture* CDVDCodecUtils::ConvertToYUV422PackedPicture(DVDVideoPicture *p
       pPicture->iLineSize[3] = 0;
       pPicture->format = format;
 
-      //if this is going to be used for anything else than testing the renderer
-      //the library should not be loaded on every function call
-      {
-        // Perform the scaling.
-        uint8_t* src[] =       { pSrc->data[0],          pSrc->data[1],      pSrc->data[2],      NULL };
-        int      srcStride[] = { pSrc->iLineSize[0],     pSrc->iLineSize[1], pSrc->iLineSize[2], 0    };
-        uint8_t* dst[] =       { pPicture->data[0],      NULL,               NULL,               NULL };
-        int      dstStride[] = { pPicture->iLineSize[0], 0,                  0,                  0    };
-
-        int dstformat;
-        if (format == RENDER_FMT_UYVY422)
-          dstformat = PIX_FMT_UYVY422;
-        else
-          dstformat = PIX_FMT_YUYV422;
-
-        struct SwsContext *ctx = sws_getContext(pSrc->iWidth, pSrc->iHeight, PIX_FMT_YUV420P,
-                                                           pPicture->iWidth, pPicture->iHeight, (AVPixelFormat)dstformat,
-                                                           SWS_FAST_BILINEAR | SwScaleCPUFlags(), NULL, NULL, NULL);
-        sws_scale(ctx, src, srcStride, 0, pSrc->iHeight, dst, dstStride);
-        sws_freeContext(ctx);
-      }
+      // every chroma line is used for the two lines of luma it belongs to
+      PackYUV422(pPicture->data[0], pPicture->iLineSize[0], pSrc->data, pSrc->iLineSize, pSrc->iWidth, pSrc->iHeight, format);
     }
     else
     {
@@ -291,69 +529,20 @@ DVDVideoPicture* CDVDCodecUtils::ConvertToYUV422PackedPicture(DVDVideoPicture *p
 
 bool CDVDCodecUtils::CopyNV12Picture(YV12Image* pImage, DVDVideoPicture *pSrc)
 {
-  uint8_t *s = pSrc->data[0];
-  uint8_t *d = pImage->plane[0];
-  int w = pSrc->iWidth;
-  int h = pSrc->iHeight;
   // Copy Y
-  if ((w == pSrc->iLineSize[0]) && ((unsigned int) pSrc->iLineSize[0] == pImage->stride[0]))
-  {
-    fast_memcpy(d, s, w*h);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      fast_memcpy(d, s, w);
-      s += pSrc->iLineSize[0];
-      d += pImage->stride[0];
-    }
-  }
-  
-  s = pSrc->data[1];
-  d = pImage->plane[1];
-  w = pSrc->iWidth;
-  h = pSrc->iHeight >> 1;
+  CopyPlane(pImage->plane[0], pImage->stride[0], pSrc->data[0], pSrc->iLineSize[0], pSrc->iWidth, pSrc->iHeight);
+
   // Copy packed UV (width is same as for Y as it's both U and V components)
-  if ((w==pSrc->iLineSize[1]) && ((unsigned int) pSrc->iLineSize[1]==pImage->stride[1]))
-  {
-    fast_memcpy(d, s, w*h);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      fast_memcpy(d, s, w);
-      s += pSrc->iLineSize[1];
-      d += pImage->stride[1];
-    }
-  }
+  CopyPlane(pImage->plane[1], pImage->stride[1], pSrc->data[1], pSrc->iLineSize[1], pSrc->iWidth, pSrc->iHeight >> 1);
 
   return true;
 }
 
 bool CDVDCodecUtils::CopyYUV422PackedPicture(YV12Image* pImage, DVDVideoPicture *pSrc)
 {
-  uint8_t *s = pSrc->data[0];
-  uint8_t *d = pImage->plane[0];
-  int w = pSrc->iWidth;
-  int h = pSrc->iHeight;
-
   // Copy YUYV
-  if ((w * 2 == pSrc->iLineSize[0]) && ((unsigned int) pSrc->iLineSize[0] == pImage->stride[0]))
-  {
-    fast_memcpy(d, s, w*h*2);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      fast_memcpy(d, s, w*2);
-      s += pSrc->iLineSize[0];
-      d += pImage->stride[0];
-    }
-  }
-  
+  CopyPlane(pImage->plane[0], pImage->stride[0], pSrc->data[0], pSrc->iLineSize[0], pSrc->iWidth * 2, pSrc->iHeight);
+
   return true;
 }
 
@@ -39,6 +39,13 @@ public:
   static bool CopyYUV422PackedPicture(YV12Image* pImage, DVDVideoPicture *pSrc);
   static bool CopyDXVA2Picture(YV12Image* pImage, DVDVideoPicture *pSrc);
 
+  /*! \brief Copy width bytes of height rows of a plane */
+  static void CopyPlane(uint8_t *dst, int dstStride, const uint8_t *src, int srcStride, int width, int height);
+  /*! \brief Interleave width samples of two chroma planes into rows of UV pairs, as used by NV12 */
+  static void InterleavePlanes(uint8_t *dst, int dstStride, const uint8_t *srcU, int strideU, const uint8_t *srcV, int strideV, int width, int height);
+  /*! \brief Pack a YUV 4:2:0 picture of the given size into rows of YUYV or UYVY */
+  static void PackYUV422(uint8_t *dst, int dstStride, uint8_t* const src[3], const int srcStride[3], int width, int height, ERenderFormat format);
+
   static bool IsVP3CompatibleWidth(int width);
 
   static double NormalizeFrameduration(double frameduration);
@@ -179,6 +179,8 @@ CDVDDemuxFFmpeg::CDVDDemuxFFmpeg() : CDVDDemux()
   memset(&m_pkt.pkt, 0, sizeof(AVPacket));
   m_streaminfo = true; /* set to true if we want to look for streams before playback */
   m_checkvideo = false;
+  m_keyframeIndexUsable = false;
+  m_keyframeStream = -1;
 }
 
 CDVDDemuxFFmpeg::~CDVDDemuxFFmpeg()
@@ -476,6 +478,17 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
   if (skipCreateStreams && GetNrOfStreams() == 0)
     m_program = 0;
 
+  // containers without an index (like mpegts) have to be searched on each seek,
+  // keep track of the keyframes we come across instead
+  m_keyframeIndexUsable = m_pInput->IsStreamType(DVDSTREAM_TYPE_FILE) && m_pInput->Seek(0, SEEK_POSSIBLE) &&
+                          !m_bMatroska && !(m_pFormatContext->iformat->flags & AVFMT_NO_BYTE_SEEK);
+  for (unsigned int i = 0; i < m_pFormatContext->nb_streams && m_keyframeIndexUsable; i++)
+  {
+    if (m_pFormatContext->streams[i]->nb_index_entries > 0)
+      m_keyframeIndexUsable = false;
+  }
+  m_keyframeStream = -1;
+
   return true;
 }
 
@@ -523,6 +536,7 @@ void CDVDDemuxFFmpeg::Flush()
     av_read_frame_flush(m_pFormatContext);
 
   m_currentPts = DVD_NOPTS_VALUE;
+  m_keyframeIndex.Break();
 
   m_pkt.result = -1;
   av_free_packet(&m_pkt.pkt);
@@ -777,6 +791,17 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
         if (pPacket->dts != DVD_NOPTS_VALUE && (pPacket->dts > m_currentPts || m_currentPts == DVD_NOPTS_VALUE))
           m_currentPts = pPacket->dts;
 
+        if (m_keyframeIndexUsable && (m_pkt.pkt.flags & AV_PKT_FLAG_KEY) && m_pkt.pkt.pos >= 0)
+        {
+          // streams of mpegts may only show up while reading
+          if (m_keyframeStream < 0 && stream->codec && stream->codec->codec_type == AVMEDIA_TYPE_VIDEO)
+            m_keyframeStream = m_pkt.pkt.stream_index;
+
+          double ts = pPacket->pts != DVD_NOPTS_VALUE ? pPacket->pts : pPacket->dts;
+          if (m_pkt.pkt.stream_index == m_keyframeStream && ts != DVD_NOPTS_VALUE)
+            m_keyframeIndex.Add(DVD_TIME_TO_MSEC(ts), m_pkt.pkt.pos);
+        }
+
 
         // check if stream has passed full duration, needed for live streams
         bool bAllowDurationExt = (stream->codec && (stream->codec->codec_type == AVMEDIA_TYPE_VIDEO || stream->codec->codec_type == AVMEDIA_TYPE_AUDIO));
@@ -895,10 +920,23 @@ bool CDVDDemuxFFmpeg::SeekTime(int time, bool backwords, double *startpts)
   int ret;
   {
     CSingleLock lock(m_critSection);
-    ret = av_seek_frame(m_pFormatContext, -1, seek_pts, backwords ? AVSEEK_FLAG_BACKWARD : 0);
+    int keyframe;
+    int64_t pos;
+    if (m_keyframeIndexUsable && m_keyframeIndex.Find(time, backwords, keyframe, pos)
+    &&  av_seek_frame(m_pFormatContext, -1, pos, AVSEEK_FLAG_BYTE) >= 0)
+    {
+      CLog::Log(LOGDEBUG, "%s - seeking to keyframe at %d from the index", __FUNCTION__, keyframe);
+      m_currentPts = DVD_MSEC_TO_TIME(keyframe);
+      ret = 0;
+    }
+    else
+    {
+      ret = av_seek_frame(m_pFormatContext, -1, seek_pts, backwords ? AVSEEK_FLAG_BACKWARD : 0);
 
-    if(ret >= 0)
-      UpdateCurrentPTS();
+      if(ret >= 0)
+        UpdateCurrentPTS();
+    }
+    m_keyframeIndex.Break();
   }
 
   if(m_currentPts == DVD_NOPTS_VALUE)
@@ -924,6 +962,7 @@ bool CDVDDemuxFFmpeg::SeekByte(int64_t pos)
 
   if(ret >= 0)
     UpdateCurrentPTS();
+  m_keyframeIndex.Break();
 
   m_pkt.result = -1;
   av_free_packet(&m_pkt.pkt);
@@ -948,6 +987,11 @@ void CDVDDemuxFFmpeg::UpdateCurrentPTS()
   }
 }
 
+CDVDDemuxKeyframeIndex* CDVDDemuxFFmpeg::GetKeyframeIndex()
+{
+  return m_keyframeIndexUsable ? &m_keyframeIndex : NULL;
+}
+
 int CDVDDemuxFFmpeg::GetStreamLength()
 {
   if (!m_pFormatContext)
@@ -21,6 +21,7 @@
  */
 
 #include "DVDDemux.h"
+#include "DVDDemuxKeyframeIndex.h"
 #include "threads/CriticalSection.h"
 #include "threads/SystemClock.h"
 #include <map>
@@ -115,6 +116,13 @@ public:
 
   bool Aborted();
 
+  /*!
+   \brief Get the index seeks are answered from, NULL if the file doesn't need one
+   The index is built up while reading, it can be loaded and stored with its
+   Serialize() and Deserialize() methods.
+   */
+  CDVDDemuxKeyframeIndex* GetKeyframeIndex();
+
   AVFormatContext* m_pFormatContext;
   CDVDInputStream* m_pInput;
 
@@ -165,5 +173,9 @@ protected:
 
   bool m_streaminfo;
   bool m_checkvideo;
+
+  CDVDDemuxKeyframeIndex m_keyframeIndex;
+  bool m_keyframeIndexUsable; // the container has no index of its own and allows seeking by byte
+  int  m_keyframeStream;      // ffmpeg index of the video stream whose keyframes are indexed
 };
 
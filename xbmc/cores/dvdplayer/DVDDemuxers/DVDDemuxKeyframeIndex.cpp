@@ -0,0 +1,251 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDDemuxKeyframeIndex.h"
+#include "utils/Base64.h"
+
+#include <algorithm>
+#include <limits.h>
+
+// at most one keyframe per second keeps the index of a film at a few thousand entries
+#define KEYFRAME_INDEX_SPACING  1000
+#define KEYFRAME_INDEX_VERSION  1
+
+static void WriteNumber(std::string &data, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    data += (char)(value | 0x80);
+    value >>= 7;
+  }
+  data += (char)value;
+}
+
+static bool ReadNumber(const std::string &data, size_t &offset, uint64_t &value)
+{
+  value = 0;
+  for (unsigned int shift = 0; shift < 64 && offset < data.size(); shift += 7)
+  {
+    uint8_t byte = (uint8_t)data[offset++];
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// positions aren't guaranteed to grow with time, so their differences are signed
+static uint64_t ZigZag(int64_t value)
+{
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t UnZigZag(uint64_t value)
+{
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+CDVDDemuxKeyframeIndex::CDVDDemuxKeyframeIndex()
+{
+  Clear();
+}
+
+void CDVDDemuxKeyframeIndex::Clear()
+{
+  m_keyframes.clear();
+  m_spans.clear();
+  m_lastTime = -1;
+  m_modified = false;
+}
+
+void CDVDDemuxKeyframeIndex::Add(int time, int64_t pos)
+{
+  if (time < 0 || pos < 0)
+    return;
+
+  // timestamps going back are a discontinuity rather than a span
+  if (m_lastTime >= 0 && time > m_lastTime)
+    AddSpan(m_lastTime, time);
+  m_lastTime = time;
+
+  std::vector<Keyframe>::iterator it = std::lower_bound(m_keyframes.begin(), m_keyframes.end(), time - KEYFRAME_INDEX_SPACING + 1, KeyframeBefore);
+  if (it != m_keyframes.end() && it->time < time + KEYFRAME_INDEX_SPACING)
+    return;
+
+  Keyframe keyframe;
+  keyframe.time = time;
+  keyframe.pos = pos;
+  m_keyframes.insert(std::lower_bound(it, m_keyframes.end(), time, KeyframeBefore), keyframe);
+  m_modified = true;
+}
+
+bool CDVDDemuxKeyframeIndex::KeyframeBefore(const Keyframe &keyframe, int time)
+{
+  return keyframe.time < time;
+}
+
+bool CDVDDemuxKeyframeIndex::TimeBefore(int time, const Keyframe &keyframe)
+{
+  return time < keyframe.time;
+}
+
+void CDVDDemuxKeyframeIndex::Break()
+{
+  m_lastTime = -1;
+}
+
+bool CDVDDemuxKeyframeIndex::Find(int time, bool backwards, int &keyframeTime, int64_t &pos) const
+{
+  std::vector<Keyframe>::const_iterator it;
+  if (backwards)
+  {
+    it = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time, TimeBefore);
+    if (it == m_keyframes.begin())
+      return false;
+    --it;
+    if (!IsCovered(it->time, time))
+      return false;
+  }
+  else
+  {
+    it = std::lower_bound(m_keyframes.begin(), m_keyframes.end(), time, KeyframeBefore);
+    if (it == m_keyframes.end() || !IsCovered(time, it->time))
+      return false;
+  }
+
+  keyframeTime = it->time;
+  pos = it->pos;
+  return true;
+}
+
+void CDVDDemuxKeyframeIndex::AddSpan(int start, int end)
+{
+  // spans are mostly extended at their end while playing, so search from there
+  std::vector<Span>::iterator last = m_spans.end();
+  while (last != m_spans.begin() && (last - 1)->start > end)
+    --last;
+  std::vector<Span>::iterator first = last;
+  while (first != m_spans.begin() && (first - 1)->end >= start)
+    --first;
+
+  Span span;
+  span.start = start;
+  span.end = end;
+  for (std::vector<Span>::iterator it = first; it != last; ++it)
+  {
+    span.start = std::min(span.start, it->start);
+    span.end = std::max(span.end, it->end);
+  }
+
+  // nothing new
+  if (last - first == 1 && first->start == span.start && first->end == span.end)
+    return;
+
+  m_spans.insert(m_spans.erase(first, last), span);
+  m_modified = true;
+}
+
+bool CDVDDemuxKeyframeIndex::IsCovered(int start, int end) const
+{
+  for (std::vector<Span>::const_reverse_iterator it = m_spans.rbegin(); it != m_spans.rend(); ++it)
+  {
+    if (it->start <= start)
+      return it->end >= end;
+  }
+  return false;
+}
+
+std::string CDVDDemuxKeyframeIndex::Serialize(int64_t fileSize) const
+{
+  std::string data;
+  WriteNumber(data, KEYFRAME_INDEX_VERSION);
+  WriteNumber(data, (uint64_t)fileSize);
+
+  WriteNumber(data, m_keyframes.size());
+  Keyframe previous = { 0, 0 };
+  for (std::vector<Keyframe>::const_iterator it = m_keyframes.begin(); it != m_keyframes.end(); ++it)
+  {
+    WriteNumber(data, (uint64_t)(it->time - previous.time));
+    WriteNumber(data, ZigZag(it->pos - previous.pos));
+    previous = *it;
+  }
+
+  WriteNumber(data, m_spans.size());
+  int end = 0;
+  for (std::vector<Span>::const_iterator it = m_spans.begin(); it != m_spans.end(); ++it)
+  {
+    WriteNumber(data, (uint64_t)(it->start - end));
+    WriteNumber(data, (uint64_t)(it->end - it->start));
+    end = it->end;
+  }
+
+  return Base64::Encode(data);
+}
+
+bool CDVDDemuxKeyframeIndex::Deserialize(const std::string &encoded, int64_t fileSize)
+{
+  Clear();
+
+  std::string data = Base64::Decode(encoded);
+  size_t offset = 0;
+  uint64_t version, size, count;
+  if (!ReadNumber(data, offset, version) || version != KEYFRAME_INDEX_VERSION ||
+      !ReadNumber(data, offset, size) || (int64_t)size != fileSize ||
+      !ReadNumber(data, offset, count) || count > data.size())
+    return false;
+
+  Keyframe keyframe = { 0, 0 };
+  for (uint64_t i = 0; i < count; i++)
+  {
+    uint64_t time, pos;
+    if (!ReadNumber(data, offset, time) || !ReadNumber(data, offset, pos) || time > INT_MAX - (uint64_t)keyframe.time)
+    {
+      Clear();
+      return false;
+    }
+    keyframe.time += (int)time;
+    keyframe.pos += UnZigZag(pos);
+    m_keyframes.push_back(keyframe);
+  }
+
+  if (!ReadNumber(data, offset, count) || count > data.size())
+  {
+    Clear();
+    return false;
+  }
+  int end = 0;
+  for (uint64_t i = 0; i < count; i++)
+  {
+    uint64_t start, length;
+    if (!ReadNumber(data, offset, start) || !ReadNumber(data, offset, length) ||
+        start + length > INT_MAX - (uint64_t)end || (i > 0 && start == 0))
+    {
+      Clear();
+      return false;
+    }
+    Span span;
+    span.start = end + (int)start;
+    span.end = span.start + (int)length;
+    m_spans.push_back(span);
+    end = span.end;
+  }
+
+  return true;
+}
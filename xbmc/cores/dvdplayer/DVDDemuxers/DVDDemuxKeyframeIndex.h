@@ -0,0 +1,107 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*!
+ \brief Byte offsets of the keyframes of a file, built up while it's read
+
+ Keyframes are added as the demuxer comes across them, at most one per
+ KEYFRAME_INDEX_SPACING ms. Besides the keyframes the index keeps the time
+ spans that have been read without a seek, within those it knows there's
+ no keyframe it hasn't seen (apart from the ones left out for spacing).
+ Only seeks to a time inside such a span are answered from the index, so
+ it never jumps further away from the target than av_seek_frame would.
+
+ Times are in ms from the start of the file.
+ */
+class CDVDDemuxKeyframeIndex
+{
+public:
+  CDVDDemuxKeyframeIndex();
+
+  void Clear();
+
+  /*!
+   \brief Add a keyframe which was read
+   Every keyframe added since the last call to Break() is known to follow the
+   one before without any in between.
+   */
+  void Add(int time, int64_t pos);
+
+  /*!
+   \brief Note that the next keyframe added doesn't follow the last one, e.g. after a seek
+   */
+  void Break();
+
+  /*!
+   \brief Find the keyframe to start from for a seek
+   \param time the time to seek to.
+   \param backwards whether the keyframe should be at or before the time, else it's at or after.
+   \param keyframeTime the time of the keyframe found.
+   \param pos the byte offset of the keyframe found.
+   \return false if the index doesn't know the keyframe.
+   */
+  bool Find(int time, bool backwards, int &keyframeTime, int64_t &pos) const;
+
+  /*!
+   \brief Store the index in a string
+   \param fileSize the size of the file indexed, so a changed file is noticed on load.
+   */
+  std::string Serialize(int64_t fileSize) const;
+
+  /*!
+   \brief Load an index stored by Serialize()
+   \return false if the data is invalid or belongs to a file of a different size, the index is empty then.
+   */
+  bool Deserialize(const std::string &data, int64_t fileSize);
+
+  size_t GetKeyframeCount() const { return m_keyframes.size(); }
+
+  /*! \brief Whether keyframes or spans were added since the index was cleared or loaded */
+  bool IsModified() const { return m_modified; }
+
+private:
+  struct Keyframe
+  {
+    int time;
+    int64_t pos;
+  };
+
+  struct Span
+  {
+    int start;
+    int end;
+  };
+
+  static bool KeyframeBefore(const Keyframe &keyframe, int time);
+  static bool TimeBefore(int time, const Keyframe &keyframe);
+
+  void AddSpan(int start, int end);
+  bool IsCovered(int start, int end) const;
+
+  std::vector<Keyframe> m_keyframes; ///< sorted by time
+  std::vector<Span> m_spans;         ///< sorted, neither overlapping nor touching
+  int m_lastTime;                    ///< time of the last keyframe added, -1 after a break
+  bool m_modified;
+};
@@ -23,19 +23,189 @@
 #endif
 #include "DVDDemuxUtils.h"
 #include "DVDClock.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
 #include "utils/log.h"
 
 extern "C" {
 #include "libavcodec/avcodec.h"
 }
 
+// payload sizes are rounded up to 4 size classes per power of two, starting
+// at 256 bytes. Larger payloads than the biggest class aren't pooled.
+#define POOL_MIN_SHIFT    8
+#define POOL_MAX_SHIFT    22
+#define POOL_CLASSES      (2 + (POOL_MAX_SHIFT - POOL_MIN_SHIFT) * 4)
+#define POOL_MAX_BYTES    (32 * 1024 * 1024)
+#define POOL_MAX_PACKETS  4096
+
+struct PooledPacket
+{
+  DemuxPacket packet;   // has to be the first member, FreeDemuxPacket casts back
+  uint8_t* data;        // payload, pPacket->pData may have been changed by its user
+  size_t capacity;
+  int sizeClass;        // -1 if the packet isn't returned to the pool
+  PooledPacket* next;
+};
+
+class CDemuxPacketPool
+{
+public:
+  static CDemuxPacketPool& Get()
+  {
+    static CDemuxPacketPool sPool;
+    return sPool;
+  }
+
+  PooledPacket* Take(int iDataSize)
+  {
+    size_t size = iDataSize > 0 ? iDataSize + FF_INPUT_BUFFER_PADDING_SIZE : 0;
+    size_t capacity;
+    int sizeClass = GetSizeClass(size, capacity);
+
+    CSingleLock lock(m_section);
+    if (++m_stats.inUse > m_stats.highWatermark)
+      m_stats.highWatermark = m_stats.inUse;
+
+    PooledPacket* pooled = sizeClass >= 0 ? m_free[sizeClass] : NULL;
+    if (pooled)
+    {
+      m_free[sizeClass] = pooled->next;
+      m_stats.cached--;
+      m_stats.cachedBytes -= pooled->capacity;
+      m_stats.reuses++;
+      return pooled;
+    }
+    m_stats.allocations++;
+    lock.Leave();
+
+    pooled = new PooledPacket;
+    pooled->packet.pData = NULL;
+    pooled->data = NULL;
+    pooled->capacity = capacity;
+    pooled->sizeClass = sizeClass;
+    if (capacity > 0)
+    {
+      pooled->data = (uint8_t*)_aligned_malloc(capacity, 16);
+      if (!pooled->data)
+      {
+        Give(pooled);
+        return NULL;
+      }
+    }
+    return pooled;
+  }
+
+  void Give(PooledPacket* pooled)
+  {
+    CSingleLock lock(m_section);
+    m_stats.inUse--;
+    if (pooled->sizeClass >= 0 &&
+        (pooled->capacity == 0 || pooled->data) &&
+        pooled->data == pooled->packet.pData &&
+        m_stats.cached < POOL_MAX_PACKETS &&
+        m_stats.cachedBytes + pooled->capacity <= POOL_MAX_BYTES)
+    {
+      pooled->next = m_free[pooled->sizeClass];
+      m_free[pooled->sizeClass] = pooled;
+      m_stats.cached++;
+      m_stats.cachedBytes += pooled->capacity;
+      return;
+    }
+    lock.Leave();
+
+    Release(pooled);
+  }
+
+  void Trim()
+  {
+    PooledPacket* packets[POOL_CLASSES];
+    {
+      CSingleLock lock(m_section);
+      memcpy(packets, m_free, sizeof(packets));
+      memset(m_free, 0, sizeof(m_free));
+      m_stats.cached = 0;
+      m_stats.cachedBytes = 0;
+      m_stats.highWatermark = m_stats.inUse;
+      m_stats.allocations = 0;
+      m_stats.reuses = 0;
+    }
+
+    for (int i = 0; i < POOL_CLASSES; i++)
+    {
+      while (packets[i])
+      {
+        PooledPacket* next = packets[i]->next;
+        Release(packets[i]);
+        packets[i] = next;
+      }
+    }
+  }
+
+  CDVDDemuxUtils::PoolStats GetStats()
+  {
+    CSingleLock lock(m_section);
+    return m_stats;
+  }
+
+private:
+  CDemuxPacketPool()
+  {
+    memset(m_free, 0, sizeof(m_free));
+    memset(&m_stats, 0, sizeof(m_stats));
+  }
+
+  ~CDemuxPacketPool()
+  {
+    Trim();
+  }
+
+  static int GetSizeClass(size_t size, size_t &capacity)
+  {
+    if (size == 0)
+    {
+      capacity = 0;
+      return 0;
+    }
+    if (size <= ((size_t)1 << POOL_MIN_SHIFT))
+    {
+      capacity = (size_t)1 << POOL_MIN_SHIFT;
+      return 1;
+    }
+    if (size > ((size_t)1 << POOL_MAX_SHIFT))
+    {
+      capacity = size;
+      return -1;
+    }
+
+    // size - 1 lies in [2^shift, 2^(shift+1)), split that range into 4 steps
+    int shift = POOL_MIN_SHIFT;
+    while (((size - 1) >> (shift + 1)) != 0)
+      shift++;
+    size_t step = (size_t)1 << (shift - 2);
+    size_t steps = (size + step - 1) / step; // 5..8
+    capacity = steps * step;
+    return 2 + (shift - POOL_MIN_SHIFT) * 4 + (int)(steps - 5);
+  }
+
+  static void Release(PooledPacket* pooled)
+  {
+    if (pooled->data)
+      _aligned_free(pooled->data);
+    delete pooled;
+  }
+
+  CCriticalSection m_section;
+  PooledPacket* m_free[POOL_CLASSES];
+  CDVDDemuxUtils::PoolStats m_stats;
+};
+
 void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 {
   if (pPacket)
   {
     try {
-      if (pPacket->pData) _aligned_free(pPacket->pData);
-      delete pPacket;
+      CDemuxPacketPool::Get().Give((PooledPacket*)pPacket);
     }
     catch(...) {
       CLog::Log(LOGERROR, "%s - Exception thrown while freeing packet", __FUNCTION__);
@@ -45,11 +215,14 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 
 DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
 {
-  DemuxPacket* pPacket = new DemuxPacket;
-  if (!pPacket) return NULL;
-
+  PooledPacket* pooled = NULL;
   try
   {
+    pooled = CDemuxPacketPool::Get().Take(iDataSize);
+    if (!pooled)
+      return NULL;
+
+    DemuxPacket* pPacket = &pooled->packet;
     memset(pPacket, 0, sizeof(DemuxPacket));
 
     if (iDataSize > 0)
@@ -63,12 +236,7 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
         * Note, if the first 23 bits of the additional bytes are not 0 then damaged
         * MPEG bitstreams could cause overread and segfault
         */
-      pPacket->pData =(uint8_t*)_aligned_malloc(iDataSize + FF_INPUT_BUFFER_PADDING_SIZE, 16);
-      if (!pPacket->pData)
-      {
-        FreeDemuxPacket(pPacket);
-        return NULL;
-      }
+      pPacket->pData = pooled->data;
 
       // reset the last 8 bytes to 0;
       memset(pPacket->pData + iDataSize, 0, FF_INPUT_BUFFER_PADDING_SIZE);
@@ -78,12 +246,23 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
     pPacket->dts       = DVD_NOPTS_VALUE;
     pPacket->pts       = DVD_NOPTS_VALUE;
     pPacket->iStreamId = -1;
+    return pPacket;
   }
   catch(...)
   {
     CLog::Log(LOGERROR, "%s - Exception thrown", __FUNCTION__);
-    FreeDemuxPacket(pPacket);
-    pPacket = NULL;
+    if (pooled)
+      CDemuxPacketPool::Get().Give(pooled);
   }
-  return pPacket;
+  return NULL;
+}
+
+CDVDDemuxUtils::PoolStats CDVDDemuxUtils::GetPoolStats()
+{
+  return CDemuxPacketPool::Get().GetStats();
+}
+
+void CDVDDemuxUtils::TrimPool()
+{
+  CDemuxPacketPool::Get().Trim();
 }
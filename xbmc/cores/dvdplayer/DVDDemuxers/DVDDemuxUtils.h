@@ -20,12 +20,34 @@
  *
  */
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "DVDDemuxPacket.h"
 
+/*
+ * Packets are recycled through a pool with size classes for their payload,
+ * so once playback has reached its steady state allocating a packet doesn't
+ * touch the heap anymore. Packets may be allocated and freed on any thread.
+ */
 class CDVDDemuxUtils
 {
 public:
+  struct PoolStats
+  {
+    unsigned int inUse;         // packets which haven't been freed yet
+    unsigned int highWatermark; // most packets in use at the same time
+    unsigned int cached;        // freed packets kept for reuse
+    size_t cachedBytes;         // payload capacity of the cached packets
+    uint64_t allocations;       // packets which had to be allocated from the heap
+    uint64_t reuses;            // packets which were taken from the pool
+  };
+
   static void FreeDemuxPacket(DemuxPacket* pPacket);
   static DemuxPacket* AllocateDemuxPacket(int iDataSize = 0);
+
+  static PoolStats GetPoolStats();
+  /* release the packets cached by the pool and restart the statistics */
+  static void TrimPool();
 };
 
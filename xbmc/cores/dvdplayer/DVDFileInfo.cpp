@@ -28,6 +28,7 @@
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
 #include "utils/URIUtils.h"
+#include "utils/Job.h"
 
 #include "DVDClock.h"
 #include "DVDStreamInfo.h"
@@ -78,6 +79,42 @@ bool CDVDFileInfo::GetFileDuration(const std::string &path, int& duration)
     return false;
 }
 
+bool CDVDFileInfo::BuildKeyframeIndex(const std::string &path, std::string &keyframes, CJob *job)
+{
+  std::auto_ptr<CDVDInputStream> input;
+  std::auto_ptr<CDVDDemux> demux;
+
+  input.reset(CDVDFactoryInputStream::CreateInputStream(NULL, path, ""));
+  if (!input.get())
+    return false;
+
+  if (!input->IsStreamType(DVDSTREAM_TYPE_FILE) || !input->Open(path.c_str(), ""))
+    return false;
+
+  demux.reset(CDVDFactoryDemuxer::CreateDemuxer(input.get(), true));
+  CDVDDemuxFFmpeg *demuxer = dynamic_cast<CDVDDemuxFFmpeg*>(demux.get());
+  CDVDDemuxKeyframeIndex *index = demuxer ? demuxer->GetKeyframeIndex() : NULL;
+  if (!index)
+    return false;
+
+  int64_t length = input->GetLength();
+  unsigned int packets = 0;
+  DemuxPacket *packet;
+  while ((packet = demux->Read()) != NULL)
+  {
+    CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+    // the position of the input is the only progress we have
+    if (job && ++packets % 1000 == 0 && length > 0 &&
+        job->ShouldCancel((unsigned int)(input->Seek(0, SEEK_CUR) * 100 / length), 100))
+      return false;
+  }
+
+  CLog::Log(LOGDEBUG, "%s - indexed %u keyframes of %s", __FUNCTION__, (unsigned int)index->GetKeyframeCount(), CURL::GetRedacted(path).c_str());
+  keyframes = index->Serialize(length);
+  return true;
+}
+
 int DegreeToOrientation(int degrees)
 {
   switch(degrees)
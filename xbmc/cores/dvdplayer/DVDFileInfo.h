@@ -29,6 +29,7 @@ class CStreamDetails;
 class CStreamDetailSubtitle;
 class CDVDInputStream;
 class CTextureDetails;
+class CJob;
 
 class CDVDFileInfo
 {
@@ -49,6 +50,13 @@ public:
 
   static bool GetFileDuration(const std::string &path, int &duration);
 
+  /** \brief Read through the file to build the index of its keyframes used for seeking.
+  *   \param[out] keyframes The serialized index, see CDVDDemuxKeyframeIndex.
+  *   \param job The job to check for cancellation, if any.
+  *   \return false if the file doesn't need an index or reading it was cancelled.
+  */
+  static bool BuildKeyframeIndex(const std::string &path, std::string &keyframes, CJob *job = NULL);
+
   /** \brief Probe the streams of an external subtitle file and store the info in the StreamDetails parameter.
   *   \param[out] details The external subtitle file's StreamDetails.
   */
@@ -21,24 +21,50 @@
 #include "DVDMessageQueue.h"
 #include "DVDDemuxers/DVDDemuxUtils.h"
 #include "utils/log.h"
+#include "threads/Atomics.h"
 #include "threads/SingleLock.h"
 #include "DVDClock.h"
 #include "utils/MathUtils.h"
 
+#include <limits.h>
+
+#define MSGQ_NOPTS LONG_MIN
+
 using namespace std;
 
-CDVDMessageQueue::CDVDMessageQueue(const string &owner) : m_hEvent(true), m_owner(owner)
+static inline void AtomicSet(volatile long* pAddr, long value)
+{
+  long old;
+  do
+  {
+    old = *pAddr;
+  } while (cas(pAddr, old, value) != old);
+}
+
+static inline int GetTypeIndex(CDVDMsg* pMsg)
+{
+  int index = pMsg->GetMessageType() - CDVDMsg::NONE;
+  return index >= 0 && index < MSGQ_TYPE_COUNT ? index : -1;
+}
+
+CDVDMessageQueue::CDVDMessageQueue(const string &owner, unsigned int capacity)
+  : m_hEvent(true), m_owner(owner), m_queue(capacity)
 {
   m_iDataSize     = 0;
   m_bAbortRequest = false;
   m_bInitialized  = false;
-  m_bCaching      = false;
   m_bEmptied      = true;
 
-  m_TimeBack      = DVD_NOPTS_VALUE;
-  m_TimeFront     = DVD_NOPTS_VALUE;
+  m_TimeBack      = MSGQ_NOPTS;
+  m_TimeFront     = MSGQ_NOPTS;
   m_TimeSize      = 1.0 / 4.0; /* 4 seconds */
   m_iMaxDataSize  = 0;
+
+  m_waiting       = 0;
+  m_listSize      = 0;
+  m_overflowSize  = 0;
+  for (int i = 0; i < MSGQ_TYPE_COUNT; i++)
+    m_typeCount[i] = 0;
 }
 
 CDVDMessageQueue::~CDVDMessageQueue()
@@ -53,35 +79,69 @@ void CDVDMessageQueue::Init()
   m_bAbortRequest = false;
   m_bEmptied      = true;
   m_bInitialized  = true;
-  m_TimeBack      = DVD_NOPTS_VALUE;
-  m_TimeFront     = DVD_NOPTS_VALUE;
+  m_TimeBack      = MSGQ_NOPTS;
+  m_TimeFront     = MSGQ_NOPTS;
 }
 
 void CDVDMessageQueue::Flush(CDVDMsg::Message type)
 {
-  CSingleLock lock(m_section);
+  CSingleLock consumerLock(m_consumerSection);
+
+  // messages can't be removed from the middle of the ring, so move them out
+  CDVDMsg* msg;
+  while (m_queue.Pop(msg))
+    m_pending.push_back(msg);
 
-  for(SList::iterator it = m_list.begin(); it != m_list.end();)
+  for (deque<CDVDMsg*>::iterator it = m_pending.begin(); it != m_pending.end();)
   {
-    if (it->message->IsType(type) ||  type == CDVDMsg::NONE)
-      it = m_list.erase(it);
+    if ((*it)->IsType(type) || type == CDVDMsg::NONE)
+    {
+      OnRemove(*it, 0);
+      (*it)->Release();
+      it = m_pending.erase(it);
+    }
     else
       ++it;
   }
 
+  {
+    CSingleLock lock(m_section);
+    for (deque<CDVDMsg*>::iterator it = m_overflow.begin(); it != m_overflow.end();)
+    {
+      if ((*it)->IsType(type) || type == CDVDMsg::NONE)
+      {
+        OnRemove(*it, 0);
+        (*it)->Release();
+        it = m_overflow.erase(it);
+        AtomicDecrement(&m_overflowSize);
+      }
+      else
+        ++it;
+    }
+
+    for (SList::iterator it = m_list.begin(); it != m_list.end();)
+    {
+      if (it->message->IsType(type) || type == CDVDMsg::NONE)
+      {
+        OnRemove(it->message, it->priority);
+        it = m_list.erase(it);
+        AtomicDecrement(&m_listSize);
+      }
+      else
+        ++it;
+    }
+  }
+
   if (type == CDVDMsg::DEMUXER_PACKET ||  type == CDVDMsg::NONE)
   {
-    m_iDataSize = 0;
-    m_TimeBack  = DVD_NOPTS_VALUE;
-    m_TimeFront = DVD_NOPTS_VALUE;
+    AtomicSet(&m_TimeBack, MSGQ_NOPTS);
+    AtomicSet(&m_TimeFront, MSGQ_NOPTS);
     m_bEmptied = true;
   }
 }
 
 void CDVDMessageQueue::Abort()
 {
-  CSingleLock lock(m_section);
-
   m_bAbortRequest = true;
 
   m_hEvent.Set(); // inform waiter for abort action
@@ -89,7 +149,7 @@ void CDVDMessageQueue::Abort()
 
 void CDVDMessageQueue::End()
 {
-  CSingleLock lock(m_section);
+  CSingleLock lock(m_consumerSection);
 
   Flush(CDVDMsg::NONE);
 
@@ -101,8 +161,6 @@ void CDVDMessageQueue::End()
 
 MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority)
 {
-  CSingleLock lock(m_section);
-
   if (!m_bInitialized)
   {
     CLog::Log(LOGWARNING, "CDVDMessageQueue(%s)::Put MSGQ_NOT_INITIALIZED", m_owner.c_str());
@@ -115,40 +173,44 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority)
     return MSGQ_INVALID_MSG;
   }
 
-  SList::iterator it = m_list.begin();
-  while(it != m_list.end())
+  // account for the message before the consumer can see it
+  OnPut(pMsg, priority);
+
+  if (priority == 0)
   {
-    if(priority <= it->priority)
-      break;
-    ++it;
+    // once the ring has overflown everything goes behind it until it's drained
+    if (m_overflowSize > 0 || !m_queue.Push(pMsg))
+    {
+      CSingleLock lock(m_section);
+      m_overflow.push_back(pMsg);
+      AtomicIncrement(&m_overflowSize);
+    }
   }
-  m_list.insert(it, DVDMessageListItem(pMsg, priority));
-
-  if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
+  else
   {
-    DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
-    if(packet)
+    CSingleLock lock(m_section);
+    SList::iterator it = m_list.begin();
+    while(it != m_list.end())
     {
-      m_iDataSize += packet->iSize;
-      if     (packet->dts != DVD_NOPTS_VALUE)
-        m_TimeFront = packet->dts;
-      else if(packet->pts != DVD_NOPTS_VALUE)
-        m_TimeFront = packet->pts;
-      if(m_TimeBack == DVD_NOPTS_VALUE)
-        m_TimeBack = m_TimeFront;
+      if(priority <= it->priority)
+        break;
+      ++it;
     }
+    m_list.insert(it, DVDMessageListItem(pMsg, priority));
+    AtomicIncrement(&m_listSize);
+    pMsg->Release();
   }
 
-  pMsg->Release();
-
-  m_hEvent.Set(); // inform waiter for new packet
+  // inform waiter for new packet
+  if (AtomicAdd(&m_waiting, 0) != 0)
+    m_hEvent.Set();
 
   return MSGQ_OK;
 }
 
 MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutInMilliSeconds, int &priority)
 {
-  CSingleLock lock(m_section);
+  CSingleLock lock(m_consumerSection);
 
   *pMsg = NULL;
 
@@ -160,7 +222,8 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
     return MSGQ_NOT_INITIALIZED;
   }
 
-  if(m_list.empty() && m_bEmptied == false && priority == 0 && m_owner != "teletext")
+  if(m_listSize == 0 && m_pending.empty() && m_queue.Size() == 0 && m_overflowSize == 0 &&
+     m_bEmptied == false && priority == 0 && m_owner != "teletext")
   {
 #if !defined(TARGET_RASPBERRY_PI)
     CLog::Log(LOGWARNING, "CDVDMessageQueue(%s)::Get - asked for new data packet, with nothing available", m_owner.c_str());
@@ -170,30 +233,8 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
 
   while (!m_bAbortRequest)
   {
-    if(!m_list.empty() && m_list.back().priority >= priority && !m_bCaching)
+    if (Take(pMsg, priority))
     {
-      DVDMessageListItem& item(m_list.back());
-      priority = item.priority;
-
-      if (item.message->IsType(CDVDMsg::DEMUXER_PACKET) && item.priority == 0)
-      {
-        DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)item.message)->GetPacket();
-        if(packet)
-        {
-          m_iDataSize -= packet->iSize;
-          if     (packet->dts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->dts;
-          else if(packet->pts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->pts;
-        }
-
-        if(m_bEmptied && m_iDataSize > 0)
-          m_bEmptied = false;
-      }
-
-      *pMsg = item.message->Acquire();
-      m_list.pop_back();
-
       ret = MSGQ_OK;
       break;
     }
@@ -204,11 +245,27 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
     }
     else
     {
+      // announce that we're going to wait before looking again, so that
+      // a producer either sees us waiting or we see its message
+      AtomicIncrement(&m_waiting);
       m_hEvent.Reset();
+      if (Take(pMsg, priority))
+      {
+        AtomicDecrement(&m_waiting);
+        ret = MSGQ_OK;
+        break;
+      }
+      if (m_bAbortRequest)
+      {
+        AtomicDecrement(&m_waiting);
+        break;
+      }
       lock.Leave();
 
       // wait for a new message
-      if (!m_hEvent.WaitMSec(iTimeoutInMilliSeconds))
+      bool signaled = m_hEvent.WaitMSec(iTimeoutInMilliSeconds);
+      AtomicDecrement(&m_waiting);
+      if (!signaled)
         return MSGQ_TIMEOUT;
 
       lock.Enter();
@@ -220,22 +277,143 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
   return (MsgQueueReturnCode)ret;
 }
 
+bool CDVDMessageQueue::Take(CDVDMsg** pMsg, int &priority)
+{
+  int minPriority = priority;
 
-unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
+  // messages of higher priority go first
+  if (m_listSize > 0 && TakeFromList(pMsg, priority, std::max(minPriority, 1)))
+    return true;
+
+  if (minPriority <= 0 && TakeFromQueue(pMsg))
+  {
+    priority = 0;
+    OnRemove(*pMsg, 0);
+
+    if ((*pMsg)->IsType(CDVDMsg::DEMUXER_PACKET))
+    {
+      DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)*pMsg)->GetPacket();
+      if(packet)
+      {
+        if     (packet->dts != DVD_NOPTS_VALUE)
+          AtomicSet(&m_TimeBack, ToQueueTime(packet->dts));
+        else if(packet->pts != DVD_NOPTS_VALUE)
+          AtomicSet(&m_TimeBack, ToQueueTime(packet->pts));
+      }
+
+      if(m_bEmptied && m_iDataSize > 0)
+        m_bEmptied = false;
+    }
+    return true;
+  }
+
+  // and those of negative priority last
+  return m_listSize > 0 && TakeFromList(pMsg, priority, minPriority);
+}
+
+bool CDVDMessageQueue::TakeFromList(CDVDMsg** pMsg, int &priority, int minPriority)
 {
   CSingleLock lock(m_section);
+  if (m_list.empty() || m_list.back().priority < minPriority)
+    return false;
+
+  DVDMessageListItem& item(m_list.back());
+  priority = item.priority;
+  *pMsg = item.message->Acquire();
+  m_list.pop_back();
+  AtomicDecrement(&m_listSize);
+  lock.Leave();
+
+  OnRemove(*pMsg, priority);
+  return true;
+}
 
-  if (!m_bInitialized)
-    return 0;
+bool CDVDMessageQueue::TakeFromQueue(CDVDMsg** pMsg)
+{
+  if (!m_pending.empty())
+  {
+    *pMsg = m_pending.front();
+    m_pending.pop_front();
+    return true;
+  }
+
+  if (m_queue.Pop(*pMsg))
+    return true;
+
+  if (m_overflowSize > 0)
+  {
+    CSingleLock lock(m_section);
+    if (!m_overflow.empty())
+    {
+      *pMsg = m_overflow.front();
+      m_overflow.pop_front();
+      AtomicDecrement(&m_overflowSize);
+      return true;
+    }
+  }
+  return false;
+}
+
+void CDVDMessageQueue::OnPut(CDVDMsg* pMsg, int priority)
+{
+  int index = GetTypeIndex(pMsg);
+  if (index >= 0)
+    AtomicIncrement(&m_typeCount[index]);
+
+  if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
+  {
+    DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
+    if(packet)
+    {
+      AtomicAdd(&m_iDataSize, packet->iSize);
+      long front = MSGQ_NOPTS;
+      if     (packet->dts != DVD_NOPTS_VALUE)
+        front = ToQueueTime(packet->dts);
+      else if(packet->pts != DVD_NOPTS_VALUE)
+        front = ToQueueTime(packet->pts);
+      if (front != MSGQ_NOPTS)
+        AtomicSet(&m_TimeFront, front);
+      cas(&m_TimeBack, MSGQ_NOPTS, m_TimeFront);
+    }
+  }
+}
 
-  unsigned count = 0;
-  for(SList::iterator it = m_list.begin(); it != m_list.end();++it)
+void CDVDMessageQueue::OnRemove(CDVDMsg* pMsg, int priority)
+{
+  int index = GetTypeIndex(pMsg);
+  if (index >= 0)
+    AtomicDecrement(&m_typeCount[index]);
+
+  if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
   {
-    if(it->message->IsType(type))
-      count++;
+    DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
+    if(packet)
+      AtomicSubtract(&m_iDataSize, packet->iSize);
   }
+}
+
+long CDVDMessageQueue::ToQueueTime(double time)
+{
+  // milliseconds fit into a long on every platform for any sane timestamp
+  double ms = time / (DVD_TIME_BASE / 1000);
+  if (ms >= (double)LONG_MAX)
+    return LONG_MAX;
+  if (ms <= (double)MSGQ_NOPTS)
+    return MSGQ_NOPTS + 1;
+  return (long)ms;
+}
+
+unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
+{
+  if (!m_bInitialized)
+    return 0;
 
-  return count;
+  int index = type - CDVDMsg::NONE;
+  if (index < 0 || index >= MSGQ_TYPE_COUNT)
+    return 0;
+
+  long count = m_typeCount[index];
+  return count > 0 ? (unsigned)count : 0;
 }
 
 void CDVDMessageQueue::WaitUntilEmpty()
@@ -249,32 +427,37 @@ void CDVDMessageQueue::WaitUntilEmpty()
 
 int CDVDMessageQueue::GetLevel() const
 {
-  CSingleLock lock(m_section);
+  int dataSize = (int)m_iDataSize;
+  long front = m_TimeFront;
+  long back = m_TimeBack;
 
-  if(m_iDataSize > m_iMaxDataSize)
+  if(dataSize > m_iMaxDataSize)
     return 100;
-  if(m_iDataSize == 0)
+  if(dataSize == 0)
     return 0;
 
-  if(IsDataBased())
-    return min(100, 100 * m_iDataSize / m_iMaxDataSize);
+  if(back == MSGQ_NOPTS || front == MSGQ_NOPTS || front <= back)
+    return min(100, 100 * dataSize / m_iMaxDataSize);
 
-  return min(100, MathUtils::round_int(100.0 * m_TimeSize * (m_TimeFront - m_TimeBack) / DVD_TIME_BASE ));
+  return min(100, MathUtils::round_int(100.0 * m_TimeSize * ((double)front - back) / 1000));
 }
 
 int CDVDMessageQueue::GetTimeSize() const
 {
-  CSingleLock lock(m_section);
+  long front = m_TimeFront;
+  long back = m_TimeBack;
 
-  if(IsDataBased())
+  if(back == MSGQ_NOPTS || front == MSGQ_NOPTS || front <= back)
     return 0;
   else
-    return (int)((m_TimeFront - m_TimeBack) / DVD_TIME_BASE);
+    return (int)(((double)front - back) / 1000);
 }
 
 bool CDVDMessageQueue::IsDataBased() const
 {
-  return (m_TimeBack == DVD_NOPTS_VALUE  ||
-          m_TimeFront == DVD_NOPTS_VALUE ||
-          m_TimeFront <= m_TimeBack);
+  long front = m_TimeFront;
+  long back = m_TimeBack;
+  return (back == MSGQ_NOPTS  ||
+          front == MSGQ_NOPTS ||
+          front <= back);
 }
@@ -23,8 +23,10 @@
 #include "DVDMessage.h"
 #include <string>
 #include <list>
+#include <deque>
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
+#include "threads/MPSCQueue.h"
 
 struct DVDMessageListItem
 {
@@ -80,10 +82,26 @@ enum MsgQueueReturnCode
 
 #define MSGQ_IS_ERROR(c)    (c < 0)
 
+#define MSGQ_TYPE_COUNT (CDVDMsg::SUBTITLE_CLUTCHANGE - CDVDMsg::NONE + 1)
+
+/**
+ * Messages of priority 0, i.e. the demuxer packets, travel through a lock-free
+ * ring which any number of threads can put into without taking a lock or
+ * allocating. Should a consumer fall behind that much that the ring is full,
+ * they queue up in an overflow list behind it. Messages of other priorities
+ * are rare and kept in a sorted list instead.
+ *
+ * The data size, the time span and the number of messages of every type are
+ * maintained with atomic operations, so querying the level of the queue never
+ * blocks the producer or the consumer.
+ *
+ * Only one thread at a time may get messages, Flush() may be called from any
+ * thread though.
+ */
 class CDVDMessageQueue
 {
 public:
-  CDVDMessageQueue(const std::string &owner);
+  CDVDMessageQueue(const std::string &owner, unsigned int capacity = 4096);
   virtual ~CDVDMessageQueue();
 
   void  Init();
@@ -105,7 +123,7 @@ public:
     return Get(pMsg, iTimeoutInMilliSeconds, priority);
   }
 
-  int GetDataSize() const               { return m_iDataSize; }
+  int GetDataSize() const               { return (int)m_iDataSize; }
   int GetTimeSize() const;
   unsigned GetPacketCount(CDVDMsg::Message type);
   bool ReceivedAbortRequest()           { return m_bAbortRequest; }
@@ -123,24 +141,39 @@ public:
   bool IsDataBased() const;
 
 private:
+  bool Take(CDVDMsg** pMsg, int &priority);
+  bool TakeFromList(CDVDMsg** pMsg, int &priority, int minPriority);
+  bool TakeFromQueue(CDVDMsg** pMsg);
+  void OnPut(CDVDMsg* pMsg, int priority);
+  void OnRemove(CDVDMsg* pMsg, int priority);
+
+  static long ToQueueTime(double time);
 
   CEvent m_hEvent;
-  mutable CCriticalSection m_section;
+  CCriticalSection m_section;         // guards m_list and m_overflow
+  CCriticalSection m_consumerSection; // serializes the consumers of m_queue
 
-  bool m_bAbortRequest;
-  bool m_bInitialized;
-  bool m_bCaching;
+  volatile bool m_bAbortRequest;
+  volatile bool m_bInitialized;
 
-  int m_iDataSize;
-  double m_TimeFront;
-  double m_TimeBack;
+  volatile long m_iDataSize;
+  volatile long m_TimeFront;          // in ms, LONG_MIN if unknown
+  volatile long m_TimeBack;
   double m_TimeSize;
 
   int m_iMaxDataSize;
   bool m_bEmptied;
   std::string m_owner;
 
+  volatile long m_waiting;            // a consumer is about to wait for the event
+  volatile long m_listSize;
+  volatile long m_overflowSize;
+  volatile long m_typeCount[MSGQ_TYPE_COUNT];
+
+  XbmcThreads::MPSCQueue<CDVDMsg*> m_queue;
+  std::deque<CDVDMsg*> m_pending;     // taken from m_queue by Flush(), older than m_queue
+  std::deque<CDVDMsg*> m_overflow;    // newer than m_queue
+
   typedef std::list<DVDMessageListItem> SList;
   SList m_list;
 };
-
@@ -69,6 +69,7 @@
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
 #include "utils/StreamDetails.h"
+#include "utils/Profiler.h"
 #include "pvr/PVRManager.h"
 #include "pvr/channels/PVRChannel.h"
 #include "filesystem/PVRFile.h"
@@ -85,6 +86,7 @@
 #include "URL.h"
 #include "utils/LangCodeExpander.h"
 #include "video/VideoReferenceClock.h"
+#include "video/VideoDatabase.h"
 
 #ifdef HAS_OMXPLAYER
 #include "cores/omxplayer/OMXPlayerAudio.h"
@@ -616,7 +618,8 @@ bool CDVDPlayer::OpenFile(const CFileItem& file, const CPlayerOptions &options)
     m_ready.Reset();
 
 #if defined(HAS_VIDEO_PLAYBACK)
-    g_renderManager.PreInit();
+    if (!m_PlayerOptions.null_output)
+      g_renderManager.PreInit();
 #endif
 
     Create();
@@ -799,9 +802,48 @@ bool CDVDPlayer::OpenDemuxStream()
   if(len > 0 && tim > 0)
     m_pInputStream->SetReadRate((unsigned int) (g_advancedSettings.m_readBufferFactor * len * 1000 / tim));
 
+  LoadKeyframeIndex();
+
   return true;
 }
 
+void CDVDPlayer::LoadKeyframeIndex()
+{
+  CDVDDemuxFFmpeg *demuxer = dynamic_cast<CDVDDemuxFFmpeg*>(m_pDemuxer);
+  CDVDDemuxKeyframeIndex *index = demuxer ? demuxer->GetKeyframeIndex() : NULL;
+  if (!index)
+    return;
+
+  CVideoDatabase db;
+  if (!db.Open())
+    return;
+
+  std::string keyframes;
+  if (db.GetKeyframeIndex(m_filename, keyframes))
+  {
+    if (index->Deserialize(keyframes, m_pInputStream->GetLength()))
+      CLog::Log(LOGDEBUG, "%s - loaded %u keyframes", __FUNCTION__, (unsigned int)index->GetKeyframeCount());
+    else
+      CLog::Log(LOGDEBUG, "%s - keyframe index is outdated", __FUNCTION__);
+  }
+  db.Close();
+}
+
+void CDVDPlayer::SaveKeyframeIndex()
+{
+  CDVDDemuxFFmpeg *demuxer = dynamic_cast<CDVDDemuxFFmpeg*>(m_pDemuxer);
+  CDVDDemuxKeyframeIndex *index = demuxer ? demuxer->GetKeyframeIndex() : NULL;
+  if (!index || !index->IsModified() || !m_pInputStream)
+    return;
+
+  CVideoDatabase db;
+  if (db.Open())
+  {
+    db.SetKeyframeIndex(m_filename, index->Serialize(m_pInputStream->GetLength()));
+    db.Close();
+  }
+}
+
 void CDVDPlayer::OpenDefaultStreams(bool reset)
 {
   // if input stream dictate, we will open later
@@ -877,6 +919,7 @@ void CDVDPlayer::OpenDefaultStreams(bool reset)
 
 bool CDVDPlayer::ReadPacket(DemuxPacket*& packet, CDemuxStream*& stream)
 {
+  PROFILE_SCOPE("DVDPlayer.Demux");
 
   // check if we should read from subtitle demuxer
   if( m_pSubtitleDemuxer && m_dvdPlayerSubtitle->AcceptsData() )
@@ -1092,6 +1135,12 @@ void CDVDPlayer::Process()
   // allow renderer to switch to fullscreen if requested
   m_dvdPlayerVideo->EnableFullscreen(m_PlayerOptions.fullscreen);
 
+  if (m_PlayerOptions.null_output)
+  {
+    m_dvdPlayerVideo->EnableNullOutput(true, !m_PlayerOptions.unpaced);
+    m_dvdPlayerAudio->EnableNullOutput(m_PlayerOptions.unpaced);
+  }
+
   if (m_omxplayer_mode)
   {
     if (!m_OmxPlayerState.av_clock.OMXInitialize(&m_clock))
@@ -1252,6 +1301,7 @@ void CDVDPlayer::Process()
 
     // update player state
     UpdatePlayState(200);
+    PublishState();
 
     // update application with our state
     UpdateApplication(1000);
@@ -2122,6 +2172,11 @@ void CDVDPlayer::OnExit()
 {
     CLog::Log(LOGNOTICE, "CDVDPlayer::OnExit()");
 
+    // nothing gets published from here on
+    if (m_PlayerOptions.identify == false)
+      g_dataCacheCore.Reset();
+    m_PublishAVInfo.SetExpired();
+
     // set event to inform openfile something went wrong in case openfile is still waiting for this event
     SetCaching(CACHESTATE_DONE);
 
@@ -2133,6 +2188,7 @@ void CDVDPlayer::OnExit()
     CloseStream(m_CurrentTeletext, !m_bAbortRequest);
 
     // destroy objects
+    SaveKeyframeIndex();
     SAFE_DELETE(m_pDemuxer);
     SAFE_DELETE(m_pSubtitleDemuxer);
     SAFE_DELETE(m_pInputStream);
@@ -2142,6 +2198,12 @@ void CDVDPlayer::OnExit()
 
     m_messenger.End();
 
+    // all packets of this file have been freed by now
+    CDVDDemuxUtils::PoolStats stats = CDVDDemuxUtils::GetPoolStats();
+    CLog::Log(LOGDEBUG, "DVDPlayer: demux packets allocated %" PRIu64 ", reused %" PRIu64 ", at most %u in use",
+              stats.allocations, stats.reuses, stats.highWatermark);
+    CDVDDemuxUtils::TrimPool();
+
     if (m_omxplayer_mode)
     {
       m_OmxPlayerState.av_clock.OMXStop();
@@ -3991,6 +4053,27 @@ double CDVDPlayer::GetQueueTime()
   return max(a, v) * 8000.0 / 100;
 }
 
+void CDVDPlayer::GetPipelineStats(SPipelineStats &stats)
+{
+  memset(&stats, 0, sizeof(stats));
+  stats.player_usage = CThread::GetAbsoluteUsage();
+  if (!m_players_created)
+    return;
+
+  stats.video_frames   = m_dvdPlayerVideo->GetOutputFrames();
+  stats.dropped_frames = m_dvdPlayerVideo->GetDroppedFrames();
+  stats.video_level    = m_dvdPlayerVideo->GetLevel();
+  stats.audio_level    = m_dvdPlayerAudio->GetLevel();
+
+  // the interfaces don't expose the threads behind the players
+  CThread *thread = dynamic_cast<CThread*>(m_dvdPlayerVideo);
+  if (thread)
+    stats.video_usage = thread->GetAbsoluteUsage();
+  thread = dynamic_cast<CThread*>(m_dvdPlayerAudio);
+  if (thread)
+    stats.audio_usage = thread->GetAbsoluteUsage();
+}
+
 void CDVDPlayer::GetVideoStreamInfo(SPlayerVideoStreamInfo &info)
 {
   info.bitrate = m_dvdPlayerVideo->GetVideoBitrate();
@@ -4258,6 +4341,50 @@ void CDVDPlayer::UpdatePlayState(double timeout)
   m_StateInput = state;
 }
 
+void CDVDPlayer::PublishState()
+{
+  // only the player the application plays with publishes
+  if (m_PlayerOptions.identify)
+    return;
+
+  CDataCacheCore::SPlayerInfo player;
+  player.time       = (double)GetTime();
+  player.timeTotal  = (double)GetTotalTimeInMsec();
+  player.speed      = (float)m_playSpeed / DVD_PLAYSPEED_NORMAL;
+  player.cacheLevel = GetCacheLevel();
+  player.stamp      = XbmcThreads::SystemClockMillis();
+  g_dataCacheCore.SetPlayerInfo(player);
+
+  // stream info changes rarely and takes a while to gather
+  if (!m_PublishAVInfo.IsTimePast())
+    return;
+  m_PublishAVInfo.Set(500);
+
+  SPlayerVideoStreamInfo video;
+  GetVideoStreamInfo(video);
+  CDataCacheCore::SVideoInfo videoInfo;
+  memset(&videoInfo, 0, sizeof(videoInfo));
+  videoInfo.bitrate     = video.bitrate;
+  videoInfo.aspectRatio = video.videoAspectRatio;
+  videoInfo.width       = video.width;
+  videoInfo.height      = video.height;
+  strncpy(videoInfo.codec, video.videoCodecName.c_str(), sizeof(videoInfo.codec) - 1);
+  strncpy(videoInfo.stereoMode, video.stereoMode.c_str(), sizeof(videoInfo.stereoMode) - 1);
+  g_dataCacheCore.SetVideoInfo(videoInfo);
+
+  SPlayerAudioStreamInfo audio;
+  GetAudioStreamInfo(GetAudioStream(), audio);
+  CDataCacheCore::SAudioInfo audioInfo;
+  memset(&audioInfo, 0, sizeof(audioInfo));
+  audioInfo.bitrate       = audio.bitrate;
+  audioInfo.channels      = audio.channels;
+  audioInfo.sampleRate    = audio.samplerate;
+  audioInfo.bitsPerSample = audio.bitspersample;
+  audioInfo.passthrough   = IsPassthrough();
+  strncpy(audioInfo.codec, audio.audioCodecName.c_str(), sizeof(audioInfo.codec) - 1);
+  g_dataCacheCore.SetAudioInfo(audioInfo);
+}
+
 void CDVDPlayer::UpdateApplication(double timeout)
 {
   if(m_UpdateApplication != 0
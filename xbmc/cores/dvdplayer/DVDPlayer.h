@@ -299,6 +299,20 @@ public:
   virtual bool IsCaching() const { return m_caching == CACHESTATE_FULL || m_caching == CACHESTATE_PVR; }
   virtual int GetCacheLevel() const ;
 
+  struct SPipelineStats
+  {
+    int     video_frames;   // pictures handed to the video output
+    int     dropped_frames; // pictures dropped by decoder or output
+    int     video_level;    // fill level of the video queue in percent
+    int     audio_level;    // fill level of the audio queue in percent
+    int64_t player_usage;   // cpu time of the demux thread in 100ns units
+    int64_t video_usage;    // cpu time of the video thread in 100ns units
+    int64_t audio_usage;    // cpu time of the audio thread in 100ns units
+  };
+
+  /* throughput of the demux and decode threads, used for benchmarking */
+  void GetPipelineStats(SPipelineStats &stats);
+
   virtual int OnDVDNavResult(void* pData, int iMessage);
 
   virtual bool ControlsVolume() {return m_omxplayer_mode;}
@@ -379,12 +393,16 @@ protected:
 
   bool OpenInputStream();
   bool OpenDemuxStream();
+  void LoadKeyframeIndex();
+  void SaveKeyframeIndex();
   void OpenDefaultStreams(bool reset = true);
 
   void UpdateApplication(double timeout);
   void UpdatePlayState(double timeout);
   void UpdateClockMaster();
+  void PublishState();
   double m_UpdateApplication;
+  XbmcThreads::EndTime m_PublishAVInfo;
 
   bool m_players_created;
   bool m_bAbortRequest;
@@ -27,6 +27,7 @@
 #include "settings/Settings.h"
 #include "video/VideoReferenceClock.h"
 #include "utils/log.h"
+#include "utils/Profiler.h"
 #include "utils/TimeUtils.h"
 #include "utils/MathUtils.h"
 #include "cores/AudioEngine/AEFactory.h"
@@ -112,6 +113,7 @@ CDVDPlayerAudio::CDVDPlayerAudio(CDVDClock* pClock, CDVDMessageQueue& parent)
   m_stalled = true;
   m_started = false;
   m_silence = false;
+  m_bNullOutput = false;
   m_resampleratio = 1.0;
   m_synctype = SYNC_DISCON;
   m_setsynctype = SYNC_DISCON;
@@ -265,7 +267,11 @@ int CDVDPlayerAudio::DecodeFrame(DVDAudioFrame &audioframe)
       if (dts != DVD_NOPTS_VALUE)
         m_audioClock = dts;
 
-      int len = m_pAudioCodec->Decode(m_decode.data, m_decode.size);
+      int len;
+      {
+        PROFILE_SCOPE("DVDPlayer.AudioDecode");
+        len = m_pAudioCodec->Decode(m_decode.data, m_decode.size);
+      }
       if (len < 0 || len > m_decode.size)
       {
         /* if error, we skip the packet */
@@ -508,6 +514,9 @@ void CDVDPlayerAudio::Process()
       result |= DECODE_FLAG_DROP;
     }
 
+    if(m_bNullOutput)
+      result |= DECODE_FLAG_DROP;
+
     UpdatePlayerInfo();
 
     if( result & DECODE_FLAG_ERROR )
@@ -573,6 +582,10 @@ void CDVDPlayerAudio::Process()
     {
       // keep output times in sync
       m_dvdAudio.SetPlayingPts(m_audioClock);
+
+      // nothing will ever be cached in the output device
+      if(m_bNullOutput)
+        m_stalled = false;
     }
     else
     {
@@ -599,7 +612,7 @@ void CDVDPlayerAudio::Process()
     if( m_speed != DVD_PLAYSPEED_NORMAL )
       continue;
 
-    if (packetadded)
+    if (packetadded && !m_bNullOutput)
       HandleSyncError(audioframe.duration);
   }
 }
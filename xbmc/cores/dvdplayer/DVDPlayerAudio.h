@@ -124,6 +124,9 @@ public:
   void SetVolume(float fVolume)                         { m_dvdAudio.SetVolume(fVolume); }
   void SetMute(bool bOnOff)                             { }
   void SetDynamicRangeCompression(long drc)             { m_dvdAudio.SetDynamicRangeCompression(drc); }
+
+  // decoded audio is dropped instead of being played, output times are kept in sync
+  void EnableNullOutput(bool bEnable)                   { m_bNullOutput = bEnable; }
   float GetDynamicRangeAmplification() const            { return 0.0f; }
 
 
@@ -213,6 +216,7 @@ protected:
   bool    m_stalled;
   bool    m_started;
   bool    m_silence;
+  bool    m_bNullOutput;
 
   bool OutputPacket(DVDAudioFrame &audioframe);
 
@@ -45,6 +45,7 @@
 #include <iterator>
 #include "guilib/GraphicContext.h"
 #include "utils/log.h"
+#include "utils/Profiler.h"
 
 using namespace std;
 using namespace RenderManager;
@@ -158,6 +159,10 @@ CDVDPlayerVideo::CDVDPlayerVideo( CDVDClock* pClock
   m_iFrameRateLength = 0;
   m_bFpsInvalid = false;
   m_bAllowFullscreen = false;
+  m_bNullOutput = false;
+  m_bNullOutputPaced = false;
+  m_nullOutputPts = DVD_NOPTS_VALUE;
+  m_iOutputFrames = 0;
   memset(&m_output, 0, sizeof(m_output));
 }
 
@@ -292,6 +297,7 @@ void CDVDPlayerVideo::CloseStream(bool bWaitForBuffers)
 void CDVDPlayerVideo::OnStartup()
 {
   m_iDroppedFrames = 0;
+  m_iOutputFrames = 0;
 
   m_crop.x1 = m_crop.x2 = 0.0f;
   m_crop.y1 = m_crop.y2 = 0.0f;
@@ -573,7 +579,11 @@ void CDVDPlayerVideo::Process()
 
       mFilters = m_pVideoCodec->SetFilters(mFilters);
 
-      int iDecoderState = m_pVideoCodec->Decode(pPacket->pData, pPacket->iSize, pPacket->dts, pPacket->pts);
+      int iDecoderState;
+      {
+        PROFILE_SCOPE("DVDPlayer.VideoDecode");
+        iDecoderState = m_pVideoCodec->Decode(pPacket->pData, pPacket->iSize, pPacket->dts, pPacket->pts);
+      }
 
       // buffer packets so we can recover should decoder flush for some reason
       if(m_pVideoCodec->GetConvergeCount() > 0)
@@ -1027,6 +1037,9 @@ std::string CDVDPlayerVideo::GetStereoMode()
 
 int CDVDPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
 {
+  if (m_bNullOutput)
+    return OutputNullPicture(src, pts);
+
   /* picture buffer is not allowed to be modified in this call */
   DVDVideoPicture picture(*src);
   DVDVideoPicture* pPicture = &picture;
@@ -1247,6 +1260,38 @@ int CDVDPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
 #endif
 }
 
+int CDVDPlayerVideo::OutputNullPicture(const DVDVideoPicture* pPicture, double pts)
+{
+  //try to calculate the framerate
+  CalcFrameRate();
+
+  if (pPicture->iFlags & DVP_FLAG_DROPPED)
+    return EOS_DROPPED;
+
+  m_nullOutputPts = pts;
+
+  if (m_bNullOutputPaced && m_started && m_speed == DVD_PLAYSPEED_NORMAL)
+  {
+    pts += m_iVideoDelay;
+
+    // a picture more than a frame late wouldn't have made it to the screen
+    double iCurrentClock;
+    double iSleepTime = pts - m_pClock->GetClock(iCurrentClock, false);
+    if (iSleepTime < -DVD_TIME_BASE / m_fFrameRate)
+      return EOS_DROPPED;
+
+    // the clock may be paused or adjusted while we wait for the picture to be due
+    while (!m_bStop && iSleepTime > 0.0)
+    {
+      Sleep(std::min(DVD_TIME_TO_MSEC(iSleepTime) + 1, 20));
+      iSleepTime = pts - m_pClock->GetClock(iCurrentClock, false);
+    }
+  }
+
+  m_iOutputFrames++;
+  return 0;
+}
+
 void CDVDPlayerVideo::AutoCrop(DVDVideoPicture *pPicture)
 {
   if ((pPicture->format == RENDER_FMT_YUV420P) ||
@@ -1463,6 +1508,9 @@ double CDVDPlayerVideo::GetCurrentPts()
   double iSleepTime, iRenderPts;
   int iBufferLevel;
 
+  if (m_bNullOutput)
+    return m_stalled ? DVD_NOPTS_VALUE : m_nullOutputPts;
+
   // get render stats
   g_renderManager.GetStats(iSleepTime, iRenderPts, iBufferLevel);
 
@@ -1569,6 +1617,10 @@ int CDVDPlayerVideo::CalcDropRequirement(double pts, bool updateOnly)
   int    iDroppedPics = -1;
   int    iBufferLevel;
 
+  // without a renderer there are no render stats to base dropping on
+  if (m_bNullOutput)
+    return result;
+
   m_droppingStats.m_lastPts = pts;
 
   // get decoder stats
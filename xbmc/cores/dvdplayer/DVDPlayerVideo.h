@@ -84,6 +84,12 @@ public:
 
   void EnableFullscreen(bool bEnable)               { m_bAllowFullscreen = bEnable; }
 
+  // decode pictures without handing them to the renderer, when paced they are
+  // still held back until they are due
+  void EnableNullOutput(bool bEnable, bool bPaced)  { m_bNullOutput = bEnable; m_bNullOutputPaced = bPaced; }
+  int  GetOutputFrames() const                      { return m_iOutputFrames; }
+  int  GetDroppedFrames() const                     { return m_iDroppedFrames; }
+
 #ifdef HAS_VIDEO_PLAYBACK
   void GetVideoRect(CRect& SrcRect, CRect& DestRect) const { g_renderManager.GetVideoRect(SrcRect, DestRect); }
   float GetAspectRatio()                            { return g_renderManager.GetAspectRatio(); }
@@ -129,6 +135,7 @@ protected:
   CRect m_crop;
 
   int OutputPicture(const DVDVideoPicture* src, double pts);
+  int OutputNullPicture(const DVDVideoPicture* pPicture, double pts);
 #ifdef HAS_VIDEO_PLAYBACK
   void ProcessOverlays(DVDVideoPicture* pSource, double pts);
 #endif
@@ -146,6 +153,7 @@ protected:
   int m_iLateFrames;
   int m_iDroppedFrames;
   int m_iDroppedRequest;
+  int m_iOutputFrames;
 
   void   ResetFrameRateCalc();
   void   CalcFrameRate();
@@ -181,6 +189,9 @@ protected:
 
   bool m_bAllowFullscreen;
   bool m_bRenderSubs;
+  bool m_bNullOutput;
+  bool m_bNullOutputPaced;
+  double m_nullOutputPts;
 
   float m_fForcedAspectRatio;
 
@@ -87,6 +87,9 @@ public:
   virtual int  GetDecoderFreeSpace() = 0;
   virtual bool IsEOS() = 0;
   virtual bool SubmittedEOS() const = 0;
+  virtual void EnableNullOutput(bool bEnable, bool bPaced) { }
+  virtual int  GetOutputFrames() const { return 0; }
+  virtual int  GetDroppedFrames() const { return 0; }
 };
 
 class CDVDAudioCodec;
@@ -119,4 +122,5 @@ public:
   virtual double GetCacheTotal() = 0;
   virtual float GetDynamicRangeAmplification() const = 0;
   virtual bool IsEOS() = 0;
+  virtual void EnableNullOutput(bool bEnable) { }
 };
@@ -0,0 +1,224 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDCodecs/DVDCodecUtils.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+struct SPlanes
+{
+  SPlanes(int width, int height, int padding)
+  {
+    int chromaWidth = width / 2;
+    stride[0] = width + padding;
+    stride[1] = stride[2] = chromaWidth + padding;
+    for (int i = 0; i < 3; i++)
+    {
+      buffer[i].resize(stride[i] * (i ? height / 2 : height));
+      for (size_t j = 0; j < buffer[i].size(); j++)
+        buffer[i][j] = rand() & 0xff;
+      data[i] = &buffer[i][0];
+    }
+  }
+
+  std::vector<uint8_t> buffer[3];
+  uint8_t *data[3];
+  int stride[3];
+};
+
+static void InterleaveReference(uint8_t *dst, int dstStride, const SPlanes &src, int width, int height)
+{
+  for (int y = 0; y < height; y++)
+  {
+    const uint8_t *u = src.data[1] + y * src.stride[1];
+    const uint8_t *v = src.data[2] + y * src.stride[2];
+    uint8_t *d = dst + y * dstStride;
+    for (int x = 0; x < width; x++)
+    {
+      *d++ = *u++;
+      *d++ = *v++;
+    }
+  }
+}
+
+static void PackReference(uint8_t *dst, int dstStride, const SPlanes &src, int width, int height, bool uyvy)
+{
+  for (int y = 0; y < height; y++)
+  {
+    const uint8_t *s = src.data[0] + y * src.stride[0];
+    const uint8_t *u = src.data[1] + (y / 2) * src.stride[1];
+    const uint8_t *v = src.data[2] + (y / 2) * src.stride[2];
+    uint8_t *d = dst + y * dstStride;
+    for (int x = 0; x < width / 2; x++)
+    {
+      if (uyvy)
+      {
+        *d++ = u[x];
+        *d++ = s[2 * x];
+        *d++ = v[x];
+        *d++ = s[2 * x + 1];
+      }
+      else
+      {
+        *d++ = s[2 * x];
+        *d++ = u[x];
+        *d++ = s[2 * x + 1];
+        *d++ = v[x];
+      }
+    }
+  }
+}
+
+// the large sizes are split into bands
+static const int sizes[][2] = { { 2, 2 }, { 34, 18 }, { 720, 576 }, { 1918, 1080 }, { 3840, 2160 } };
+
+TEST(TestDVDCodecUtils, CopyPlane)
+{
+  for (unsigned int n = 0; n < sizeof(sizes) / sizeof(sizes[0]); n++)
+  {
+    int width = sizes[n][0], height = sizes[n][1];
+    for (int padding = 0; padding <= 32; padding += 32)
+    {
+      SPlanes src(width, height, padding);
+      std::vector<uint8_t> dst((width + 16) * height, 0);
+      CDVDCodecUtils::CopyPlane(&dst[0], width + 16, src.data[0], src.stride[0], width, height);
+      for (int y = 0; y < height; y++)
+        ASSERT_EQ(0, memcmp(&dst[y * (width + 16)], src.data[0] + y * src.stride[0], width)) << width << "x" << height << " row " << y;
+
+      // contiguous planes are copied as a whole
+      std::vector<uint8_t> contiguous(src.stride[0] * height, 0);
+      CDVDCodecUtils::CopyPlane(&contiguous[0], src.stride[0], src.data[0], src.stride[0], src.stride[0], height);
+      EXPECT_TRUE(contiguous == src.buffer[0]) << width << "x" << height;
+    }
+  }
+}
+
+TEST(TestDVDCodecUtils, InterleavePlanes)
+{
+  for (unsigned int n = 0; n < sizeof(sizes) / sizeof(sizes[0]); n++)
+  {
+    // odd chroma widths leave a tail for the scalar loop
+    int width = sizes[n][0] + 2, height = sizes[n][1];
+    SPlanes src(width, height, 8);
+    int stride = width + 8;
+    std::vector<uint8_t> expected(stride * height / 2, 0), result(stride * height / 2, 0);
+
+    InterleaveReference(&expected[0], stride, src, width / 2, height / 2);
+    CDVDCodecUtils::InterleavePlanes(&result[0], stride, src.data[1], src.stride[1], src.data[2], src.stride[2], width / 2, height / 2);
+    EXPECT_TRUE(expected == result) << width << "x" << height;
+  }
+}
+
+TEST(TestDVDCodecUtils, PackYUV422)
+{
+  for (unsigned int n = 0; n < sizeof(sizes) / sizeof(sizes[0]); n++)
+  {
+    int width = sizes[n][0] + 4, height = sizes[n][1];
+    SPlanes src(width, height, 16);
+    int stride = width * 2 + 8;
+    for (int uyvy = 0; uyvy < 2; uyvy++)
+    {
+      std::vector<uint8_t> expected(stride * height, 0), result(stride * height, 0);
+      PackReference(&expected[0], stride, src, width, height, uyvy != 0);
+      CDVDCodecUtils::PackYUV422(&result[0], stride, src.data, src.stride, width, height,
+                                 uyvy ? RENDER_FMT_UYVY422 : RENDER_FMT_YUYV422);
+      EXPECT_TRUE(expected == result) << width << "x" << height << (uyvy ? " UYVY" : " YUYV");
+    }
+  }
+}
+
+TEST(TestDVDCodecUtils, ConvertToNV12Picture)
+{
+  DVDVideoPicture *picture = CDVDCodecUtils::AllocatePicture(64, 32);
+  ASSERT_TRUE(picture != NULL);
+  for (int i = 0; i < 64 * 32 * 3 / 2; i++)
+    picture->data[0][i] = i & 0xff;
+
+  DVDVideoPicture *nv12 = CDVDCodecUtils::ConvertToNV12Picture(picture);
+  ASSERT_TRUE(nv12 != NULL);
+  EXPECT_EQ(RENDER_FMT_NV12, nv12->format);
+  EXPECT_EQ(0, memcmp(nv12->data[0], picture->data[0], 64 * 32));
+  for (int y = 0; y < 16; y++)
+  {
+    for (int x = 0; x < 32; x++)
+    {
+      EXPECT_EQ(picture->data[1][y * 32 + x], nv12->data[1][y * 64 + 2 * x]);
+      EXPECT_EQ(picture->data[2][y * 32 + x], nv12->data[1][y * 64 + 2 * x + 1]);
+    }
+  }
+
+  CDVDCodecUtils::FreePicture(nv12);
+  CDVDCodecUtils::FreePicture(picture);
+}
+
+// throughput numbers only, run it with --gtest_also_run_disabled_tests
+TEST(TestDVDCodecUtils, DISABLED_Benchmark)
+{
+  const int resolutions[][2] = { { 720, 576 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+  const int pictures = 20;
+
+  for (unsigned int n = 0; n < sizeof(resolutions) / sizeof(resolutions[0]); n++)
+  {
+    int width = resolutions[n][0], height = resolutions[n][1];
+    SPlanes src(width, height, 64);
+    int stride = width * 2;
+    std::vector<uint8_t> dst(stride * height);
+
+    int64_t start = CurrentHostCounter();
+    for (int i = 0; i < pictures; i++)
+    {
+      for (int y = 0; y < height; y++)
+        memcpy(&dst[y * width], src.data[0] + y * src.stride[0], width);
+      InterleaveReference(&dst[width * height], width, src, width / 2, height / 2);
+    }
+    int64_t nv12Reference = CurrentHostCounter() - start;
+
+    start = CurrentHostCounter();
+    for (int i = 0; i < pictures; i++)
+    {
+      CDVDCodecUtils::CopyPlane(&dst[0], width, src.data[0], src.stride[0], width, height);
+      CDVDCodecUtils::InterleavePlanes(&dst[width * height], width, src.data[1], src.stride[1], src.data[2], src.stride[2], width / 2, height / 2);
+    }
+    int64_t nv12 = CurrentHostCounter() - start;
+
+    start = CurrentHostCounter();
+    for (int i = 0; i < pictures; i++)
+      PackReference(&dst[0], stride, src, width, height, false);
+    int64_t packReference = CurrentHostCounter() - start;
+
+    start = CurrentHostCounter();
+    for (int i = 0; i < pictures; i++)
+      CDVDCodecUtils::PackYUV422(&dst[0], stride, src.data, src.stride, width, height, RENDER_FMT_YUYV422);
+    int64_t pack = CurrentHostCounter() - start;
+
+    // throughput in MB of the written picture per second
+    double megabytes = (double)width * height * pictures / (1024 * 1024);
+    double frequency = CurrentHostFrequency();
+    printf("%dx%d: NV12 %.0f MB/s (row by row %.0f MB/s), YUYV %.0f MB/s (row by row %.0f MB/s)\n", width, height,
+           megabytes * 1.5 * frequency / nv12, megabytes * 1.5 * frequency / nv12Reference,
+           megabytes * 2 * frequency / pack, megabytes * 2 * frequency / packReference);
+  }
+}
@@ -0,0 +1,128 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDDemuxers/DVDDemuxKeyframeIndex.h"
+
+#include "gtest/gtest.h"
+
+// a keyframe every 500ms, 100000 bytes apart
+static void AddKeyframes(CDVDDemuxKeyframeIndex &index, int from, int to)
+{
+  for (int time = from; time <= to; time += 500)
+    index.Add(time, (int64_t)time * 200);
+}
+
+TEST(TestDVDDemuxKeyframeIndex, Spacing)
+{
+  CDVDDemuxKeyframeIndex index;
+  EXPECT_FALSE(index.IsModified());
+
+  AddKeyframes(index, 0, 10000);
+  EXPECT_EQ(11U, index.GetKeyframeCount());
+  EXPECT_TRUE(index.IsModified());
+
+  // a second pass over the same part doesn't add any
+  index.Break();
+  AddKeyframes(index, 0, 10000);
+  EXPECT_EQ(11U, index.GetKeyframeCount());
+}
+
+TEST(TestDVDDemuxKeyframeIndex, Find)
+{
+  CDVDDemuxKeyframeIndex index;
+  AddKeyframes(index, 0, 10000);
+
+  int time;
+  int64_t pos;
+  ASSERT_TRUE(index.Find(4500, true, time, pos));
+  EXPECT_EQ(4000, time);
+  EXPECT_EQ(800000, pos);
+  ASSERT_TRUE(index.Find(4000, true, time, pos));
+  EXPECT_EQ(4000, time);
+  ASSERT_TRUE(index.Find(4500, false, time, pos));
+  EXPECT_EQ(5000, time);
+  EXPECT_EQ(1000000, pos);
+
+  // nothing known beyond what was read
+  EXPECT_FALSE(index.Find(10500, true, time, pos));
+  EXPECT_FALSE(index.Find(10500, false, time, pos));
+}
+
+TEST(TestDVDDemuxKeyframeIndex, Gaps)
+{
+  CDVDDemuxKeyframeIndex index;
+  AddKeyframes(index, 0, 3000);
+  index.Break();
+  AddKeyframes(index, 6000, 9000);
+
+  // there may be keyframes between 3000 and 6000 which weren't read
+  int time;
+  int64_t pos;
+  EXPECT_FALSE(index.Find(4000, true, time, pos));
+  EXPECT_FALSE(index.Find(4000, false, time, pos));
+  ASSERT_TRUE(index.Find(7200, true, time, pos));
+  EXPECT_EQ(7000, time);
+
+  // reading the gap joins both spans
+  index.Break();
+  AddKeyframes(index, 3000, 6000);
+  ASSERT_TRUE(index.Find(4200, true, time, pos));
+  EXPECT_EQ(4000, time);
+  ASSERT_TRUE(index.Find(2500, false, time, pos));
+  EXPECT_EQ(3000, time);
+}
+
+TEST(TestDVDDemuxKeyframeIndex, Serialize)
+{
+  CDVDDemuxKeyframeIndex index;
+  AddKeyframes(index, 0, 3000);
+  index.Break();
+  AddKeyframes(index, 6000, 9000);
+  std::string data = index.Serialize(123456789);
+
+  CDVDDemuxKeyframeIndex loaded;
+  ASSERT_TRUE(loaded.Deserialize(data, 123456789));
+  EXPECT_FALSE(loaded.IsModified());
+  EXPECT_EQ(index.GetKeyframeCount(), loaded.GetKeyframeCount());
+  EXPECT_EQ(data, loaded.Serialize(123456789));
+
+  int time;
+  int64_t pos;
+  ASSERT_TRUE(loaded.Find(7200, true, time, pos));
+  EXPECT_EQ(7000, time);
+  EXPECT_EQ(1400000, pos);
+  EXPECT_FALSE(loaded.Find(4000, true, time, pos));
+}
+
+TEST(TestDVDDemuxKeyframeIndex, DeserializeInvalid)
+{
+  CDVDDemuxKeyframeIndex index;
+  AddKeyframes(index, 0, 3000);
+  std::string data = index.Serialize(1000);
+
+  CDVDDemuxKeyframeIndex loaded;
+  // the file has changed
+  EXPECT_FALSE(loaded.Deserialize(data, 1001));
+  EXPECT_EQ(0U, loaded.GetKeyframeCount());
+
+  EXPECT_FALSE(loaded.Deserialize(data.substr(0, data.size() / 2), 1000));
+  EXPECT_EQ(0U, loaded.GetKeyframeCount());
+  EXPECT_FALSE(loaded.Deserialize("", 1000));
+}
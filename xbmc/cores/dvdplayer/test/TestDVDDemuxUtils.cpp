@@ -0,0 +1,174 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDClock.h"
+#include "DVDDemuxers/DVDDemuxUtils.h"
+#include "threads/Thread.h"
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+#include <vector>
+
+class TestDVDDemuxUtils : public testing::Test
+{
+protected:
+  TestDVDDemuxUtils()
+  {
+    CDVDDemuxUtils::TrimPool();
+  }
+
+  ~TestDVDDemuxUtils()
+  {
+    CDVDDemuxUtils::TrimPool();
+  }
+};
+
+TEST_F(TestDVDDemuxUtils, Allocate)
+{
+  DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(0);
+  ASSERT_TRUE(packet != NULL);
+  EXPECT_TRUE(packet->pData == NULL);
+  EXPECT_EQ(0, packet->iSize);
+  EXPECT_EQ(-1, packet->iStreamId);
+  EXPECT_EQ(DVD_NOPTS_VALUE, packet->dts);
+  EXPECT_EQ(DVD_NOPTS_VALUE, packet->pts);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  packet = CDVDDemuxUtils::AllocateDemuxPacket(1000);
+  ASSERT_TRUE(packet != NULL);
+  ASSERT_TRUE(packet->pData != NULL);
+  EXPECT_EQ(0U, (uintptr_t)packet->pData % 16);
+  memset(packet->pData, 0xff, 1000);
+  packet->iSize = 1000;
+  packet->pts = 1.0;
+  packet->iStreamId = 1;
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  // a recycled packet looks like a new one
+  packet = CDVDDemuxUtils::AllocateDemuxPacket(990);
+  ASSERT_TRUE(packet != NULL);
+  EXPECT_EQ(0, packet->iSize);
+  EXPECT_EQ(-1, packet->iStreamId);
+  EXPECT_EQ(DVD_NOPTS_VALUE, packet->pts);
+  for (int i = 990; i < 1000; i++)
+    EXPECT_EQ(0, packet->pData[i]);
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+  CDVDDemuxUtils::PoolStats stats = CDVDDemuxUtils::GetPoolStats();
+  EXPECT_EQ(0U, stats.inUse);
+  EXPECT_EQ(1U, stats.highWatermark);
+  EXPECT_EQ(2U, stats.allocations);
+  EXPECT_EQ(1U, stats.reuses);
+  EXPECT_EQ(2U, stats.cached);
+
+  CDVDDemuxUtils::FreeDemuxPacket(NULL);
+}
+
+TEST_F(TestDVDDemuxUtils, SteadyState)
+{
+  // what a demuxer does during playback: a window of packets of varying size
+  // is in flight, so after the first round everything comes from the pool
+  const int sizes[] = { 188, 4000, 50000, 100, 300000, 2000, 1200, 65536 };
+  const unsigned int count = sizeof(sizes) / sizeof(sizes[0]);
+
+  for (int round = 0; round < 10; round++)
+  {
+    std::vector<DemuxPacket*> packets;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      // vary the sizes a bit within their size class
+      DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(sizes[i] - round);
+      ASSERT_TRUE(packet != NULL);
+      packet->iSize = sizes[i] - round;
+      memset(packet->pData, round, packet->iSize);
+      packets.push_back(packet);
+    }
+    for (unsigned int i = 0; i < count; i++)
+      CDVDDemuxUtils::FreeDemuxPacket(packets[i]);
+  }
+
+  CDVDDemuxUtils::PoolStats stats = CDVDDemuxUtils::GetPoolStats();
+  EXPECT_EQ(0U, stats.inUse);
+  EXPECT_EQ(count, stats.highWatermark);
+  EXPECT_EQ(count, stats.allocations);
+  EXPECT_EQ(9 * count, stats.reuses);
+  EXPECT_EQ(count, stats.cached);
+  EXPECT_GT(stats.cachedBytes, 0U);
+
+  CDVDDemuxUtils::TrimPool();
+  stats = CDVDDemuxUtils::GetPoolStats();
+  EXPECT_EQ(0U, stats.cached);
+  EXPECT_EQ(0U, stats.cachedBytes);
+  EXPECT_EQ(0U, stats.allocations);
+}
+
+TEST_F(TestDVDDemuxUtils, Large)
+{
+  // packets beyond the biggest size class are not kept
+  DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(8 * 1024 * 1024);
+  ASSERT_TRUE(packet != NULL);
+  packet->pData[8 * 1024 * 1024 - 1] = 1;
+  CDVDDemuxUtils::FreeDemuxPacket(packet);
+  EXPECT_EQ(0U, CDVDDemuxUtils::GetPoolStats().cached);
+}
+
+class CPacketConsumer : public IRunnable
+{
+public:
+  CPacketConsumer(std::vector<DemuxPacket*> &packets) : m_packets(packets) { }
+
+  virtual void Run()
+  {
+    for (size_t i = 0; i < m_packets.size(); i++)
+      CDVDDemuxUtils::FreeDemuxPacket(m_packets[i]);
+  }
+
+private:
+  std::vector<DemuxPacket*> &m_packets;
+};
+
+TEST_F(TestDVDDemuxUtils, Threads)
+{
+  // packets are allocated by the demuxer and freed by the audio/video players
+  for (int round = 0; round < 20; round++)
+  {
+    std::vector<DemuxPacket*> video, audio;
+    for (int i = 0; i < 100; i++)
+    {
+      video.push_back(CDVDDemuxUtils::AllocateDemuxPacket(20000 + i * 100));
+      audio.push_back(CDVDDemuxUtils::AllocateDemuxPacket(1500));
+    }
+
+    CPacketConsumer videoConsumer(video), audioConsumer(audio);
+    CThread videoThread(&videoConsumer, "TestVideo");
+    CThread audioThread(&audioConsumer, "TestAudio");
+    videoThread.Create();
+    audioThread.Create();
+    videoThread.StopThread(true);
+    audioThread.StopThread(true);
+  }
+
+  CDVDDemuxUtils::PoolStats stats = CDVDDemuxUtils::GetPoolStats();
+  EXPECT_EQ(0U, stats.inUse);
+  EXPECT_EQ(200U, stats.highWatermark);
+  EXPECT_EQ(4000U, stats.allocations + stats.reuses);
+  EXPECT_LE(stats.allocations, 400U);
+}
@@ -0,0 +1,350 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDClock.h"
+#include "DVDMessageQueue.h"
+#include "DVDDemuxers/DVDDemuxUtils.h"
+#include "threads/Thread.h"
+#include "utils/TimeUtils.h"
+
+#if defined(TARGET_POSIX)
+#include "linux/XTimeUtils.h"
+#endif
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static CDVDMsgDemuxerPacket* CreatePacket(int size, double dts, int streamId = 0)
+{
+  DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(size);
+  packet->iSize = size;
+  packet->dts = dts;
+  packet->iStreamId = streamId;
+  return new CDVDMsgDemuxerPacket(packet);
+}
+
+static DemuxPacket* GetPacket(CDVDMsg* msg)
+{
+  if (!msg || !msg->IsType(CDVDMsg::DEMUXER_PACKET))
+    return NULL;
+  return ((CDVDMsgDemuxerPacket*)msg)->GetPacket();
+}
+
+TEST(TestDVDMessageQueue, Priorities)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  queue.Put(CreatePacket(100, 0.0));
+  queue.Put(CreatePacket(100, DVD_TIME_BASE));
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESET), 1);
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_FLUSH), 2);
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_EOF), -1);
+  EXPECT_EQ(200, queue.GetDataSize());
+  EXPECT_EQ(2U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(1U, queue.GetPacketCount(CDVDMsg::GENERAL_RESET));
+
+  CDVDMsg* msg;
+  int priority = 0;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0, priority));
+  EXPECT_TRUE(msg->IsType(CDVDMsg::GENERAL_FLUSH));
+  EXPECT_EQ(2, priority);
+  msg->Release();
+
+  // only messages of at least the requested priority
+  priority = 1;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0, priority));
+  EXPECT_TRUE(msg->IsType(CDVDMsg::GENERAL_RESET));
+  msg->Release();
+  priority = 1;
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&msg, 0, priority));
+  EXPECT_TRUE(msg == NULL);
+
+  for (int i = 0; i < 2; i++)
+  {
+    priority = 0;
+    ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0, priority));
+    ASSERT_TRUE(GetPacket(msg) != NULL);
+    EXPECT_EQ(i * DVD_TIME_BASE, GetPacket(msg)->dts);
+    EXPECT_EQ(0, priority);
+    msg->Release();
+  }
+  EXPECT_EQ(0, queue.GetDataSize());
+
+  // messages of negative priority have to be asked for
+  priority = 0;
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&msg, 0, priority));
+  priority = -1;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0, priority));
+  EXPECT_TRUE(msg->IsType(CDVDMsg::GENERAL_EOF));
+  EXPECT_EQ(-1, priority);
+  msg->Release();
+
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&msg, 10));
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, Overflow)
+{
+  // a tiny ring, most of the packets end up in the overflow list
+  CDVDMessageQueue queue("test", 8);
+  queue.Init();
+
+  for (int i = 0; i < 100; i++)
+    EXPECT_EQ(MSGQ_OK, queue.Put(CreatePacket(10, i * DVD_TIME_BASE)));
+  EXPECT_EQ(1000, queue.GetDataSize());
+  EXPECT_EQ(100U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+
+  CDVDMsg* msg;
+  for (int i = 0; i < 50; i++)
+  {
+    ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+    EXPECT_EQ(i * DVD_TIME_BASE, GetPacket(msg)->dts);
+    msg->Release();
+  }
+
+  // new packets queue up behind the ones which overflowed
+  for (int i = 100; i < 120; i++)
+    queue.Put(CreatePacket(10, i * DVD_TIME_BASE));
+  for (int i = 50; i < 120; i++)
+  {
+    ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+    EXPECT_EQ(i * DVD_TIME_BASE, GetPacket(msg)->dts);
+    msg->Release();
+  }
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, Flush)
+{
+  CDVDMessageQueue queue("test", 8);
+  queue.Init();
+
+  for (int i = 0; i < 20; i++)
+  {
+    queue.Put(CreatePacket(10, i * DVD_TIME_BASE));
+    if (i % 5 == 0)
+      queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESYNC));
+  }
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESET), 1);
+  EXPECT_EQ(19, queue.GetTimeSize());
+
+  queue.Flush();
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_EQ(0, queue.GetTimeSize());
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(4U, queue.GetPacketCount(CDVDMsg::GENERAL_RESYNC));
+
+  // the remaining messages keep their order
+  CDVDMsg* msg;
+  ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+  EXPECT_TRUE(msg->IsType(CDVDMsg::GENERAL_RESET));
+  msg->Release();
+  for (int i = 0; i < 4; i++)
+  {
+    ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 0));
+    EXPECT_TRUE(msg->IsType(CDVDMsg::GENERAL_RESYNC));
+    msg->Release();
+  }
+
+  queue.Put(CreatePacket(10, 0.0));
+  queue.Flush(CDVDMsg::NONE);
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&msg, 0));
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, Level)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+  queue.SetMaxDataSize(1000);
+  queue.SetMaxTimeSize(8.0);
+  EXPECT_EQ(0, queue.GetLevel());
+
+  // without timestamps the level is based on the data size
+  queue.Put(CreatePacket(250, DVD_NOPTS_VALUE));
+  EXPECT_TRUE(queue.IsDataBased());
+  EXPECT_EQ(25, queue.GetLevel());
+
+  queue.Put(CreatePacket(10, 0.0));
+  queue.Put(CreatePacket(10, 2 * DVD_TIME_BASE));
+  EXPECT_FALSE(queue.IsDataBased());
+  EXPECT_EQ(2, queue.GetTimeSize());
+  EXPECT_EQ(25, queue.GetLevel());
+
+  queue.Put(CreatePacket(1000, 4 * DVD_TIME_BASE));
+  EXPECT_TRUE(queue.IsFull());
+  queue.End();
+}
+
+class CMessageQueueConsumer : public IRunnable
+{
+public:
+  CMessageQueueConsumer(CDVDMessageQueue &queue, unsigned int producers)
+    : m_queue(queue), m_next(producers, 0), m_packets(0), m_errors(0)
+  { }
+
+  virtual void Run()
+  {
+    CDVDMsg* msg;
+    while (m_queue.Get(&msg, 1000) == MSGQ_OK)
+    {
+      DemuxPacket* packet = GetPacket(msg);
+      if (packet)
+      {
+        // the packets of every producer arrive in order
+        if (packet->iStreamId < 0 || packet->iStreamId >= (int)m_next.size() ||
+            packet->dts != m_next[packet->iStreamId])
+          m_errors++;
+        else
+          m_next[packet->iStreamId]++;
+
+        if (packet->iSize == sizeof(int64_t))
+        {
+          int64_t sent;
+          memcpy(&sent, packet->pData, sizeof(sent));
+          m_latencies.push_back(CurrentHostCounter() - sent);
+        }
+        m_packets++;
+      }
+      bool eof = msg->IsType(CDVDMsg::GENERAL_EOF);
+      msg->Release();
+      if (eof)
+        break;
+    }
+  }
+
+  CDVDMessageQueue &m_queue;
+  std::vector<double> m_next;
+  std::vector<int64_t> m_latencies;
+  unsigned int m_packets;
+  unsigned int m_errors;
+};
+
+class CMessageQueueProducer : public IRunnable
+{
+public:
+  CMessageQueueProducer(CDVDMessageQueue &queue, int id, unsigned int packets, bool timestamp)
+    : m_queue(queue), m_id(id), m_packets(packets), m_timestamp(timestamp)
+  { }
+
+  virtual void Run()
+  {
+    for (unsigned int i = 0; i < m_packets; i++)
+    {
+      CDVDMsgDemuxerPacket* msg = CreatePacket(m_timestamp ? sizeof(int64_t) : 0, i, m_id);
+      if (m_timestamp)
+      {
+        int64_t now = CurrentHostCounter();
+        memcpy(msg->GetPacket()->pData, &now, sizeof(now));
+      }
+      m_queue.Put(msg);
+
+      // measure the latency of a single packet rather than a full queue
+      if (m_timestamp)
+      {
+        while (m_queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET) > 0)
+          Sleep(0);
+        Sleep(1);
+      }
+    }
+  }
+
+  CDVDMessageQueue &m_queue;
+  int m_id;
+  unsigned int m_packets;
+  bool m_timestamp;
+};
+
+TEST(TestDVDMessageQueue, Stress)
+{
+  const unsigned int producerCount = 4;
+  const unsigned int packets = 50000;
+
+  // small enough for the ring to overflow every now and then
+  CDVDMessageQueue queue("test", 256);
+  queue.Init();
+
+  CMessageQueueConsumer consumer(queue, producerCount);
+  CThread consumerThread(&consumer, "TestConsumer");
+  consumerThread.Create();
+
+  std::vector<CMessageQueueProducer*> producers;
+  std::vector<CThread*> threads;
+  for (unsigned int i = 0; i < producerCount; i++)
+  {
+    producers.push_back(new CMessageQueueProducer(queue, i, packets, false));
+    threads.push_back(new CThread(producers.back(), "TestProducer"));
+    threads.back()->Create();
+  }
+  for (unsigned int i = 0; i < producerCount; i++)
+  {
+    threads[i]->StopThread(true);
+    delete threads[i];
+    delete producers[i];
+  }
+
+  // all packets have been consumed once the queue is empty
+  queue.WaitUntilEmpty();
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_EOF));
+  consumerThread.StopThread(true);
+
+  EXPECT_EQ(producerCount * packets, consumer.m_packets);
+  EXPECT_EQ(0U, consumer.m_errors);
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  queue.End();
+}
+
+// measures latencies, Stress covers the hand over; run with --gtest_also_run_disabled_tests
+TEST(TestDVDMessageQueue, DISABLED_Latency)
+{
+  const unsigned int packets = 1000;
+
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  CMessageQueueConsumer consumer(queue, 1);
+  CThread consumerThread(&consumer, "TestConsumer");
+  consumerThread.Create();
+
+  CMessageQueueProducer producer(queue, 0, packets, true);
+  producer.Run();
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_EOF));
+  consumerThread.StopThread(true);
+
+  ASSERT_EQ(packets, consumer.m_latencies.size());
+  EXPECT_EQ(0U, consumer.m_errors);
+
+  std::sort(consumer.m_latencies.begin(), consumer.m_latencies.end());
+  double usPerTick = 1000000.0 / CurrentHostFrequency();
+  printf("packet latency: p50 %.1fus, p99 %.1fus, max %.1fus\n",
+         consumer.m_latencies[packets / 2] * usPerTick,
+         consumer.m_latencies[packets * 99 / 100] * usPerTick,
+         consumer.m_latencies.back() * usPerTick);
+  queue.End();
+}
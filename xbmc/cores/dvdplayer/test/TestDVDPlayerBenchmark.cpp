@@ -0,0 +1,171 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDPlayer.h"
+#include "FileItem.h"
+#include "cores/AudioEngine/AEFactory.h"
+#include "filesystem/File.h"
+#include "settings/Settings.h"
+#include "test/TestUtils.h"
+#include "threads/Event.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/TimeUtils.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// the player threads are gone once playback has ended, so sample them often
+#define BENCHMARK_SAMPLE_INTERVAL 100
+
+class CBenchmarkCallback : public IPlayerCallback
+{
+public:
+  virtual void OnPlayBackEnded()   { m_ended.Set(); }
+  virtual void OnPlayBackStarted() { }
+  virtual void OnPlayBackStopped() { m_ended.Set(); }
+  virtual void OnQueueNextItem()   { }
+
+  CEvent m_ended;
+};
+
+class CQueueLevel
+{
+public:
+  CQueueLevel() : m_total(0), m_samples(0), m_min(100), m_max(0) { }
+
+  void Add(int level)
+  {
+    m_total += level;
+    m_samples++;
+    m_min = std::min(m_min, level);
+    m_max = std::max(m_max, level);
+  }
+
+  CVariant ToVariant() const
+  {
+    CVariant result(CVariant::VariantTypeObject);
+    result["average"] = m_samples ? (double)m_total / m_samples : 0.0;
+    result["min"] = m_samples ? m_min : 0;
+    result["max"] = m_max;
+    return result;
+  }
+
+private:
+  int64_t m_total;
+  int m_samples;
+  int m_min;
+  int m_max;
+};
+
+// GetAbsoluteUsage() is in 100ns units
+static double UsageToSeconds(int64_t usage)
+{
+  return usage / 10000000.0;
+}
+
+TEST(TestDVDPlayerBenchmark, Playback)
+{
+  CXBMCTestUtils &utils = CXBMCTestUtils::Instance();
+  const std::string &file = utils.getPlayerBenchmarkFile();
+  if (file.empty())
+  {
+    // see --set-playerbenchmark-file
+    return;
+  }
+  bool unpaced = utils.getPlayerBenchmarkUnpaced();
+
+  // the audio is played into the null sink
+  CSettings::Get().SetString("audiooutput.audiodevice", "NULL:NULL");
+  ASSERT_TRUE(CAEFactory::LoadEngine());
+  ASSERT_TRUE(CAEFactory::StartEngine());
+
+  CBenchmarkCallback callback;
+  CDVDPlayer *player = new CDVDPlayer(callback);
+
+  CPlayerOptions options;
+  options.null_output = true;
+  options.unpaced = unpaced;
+
+  CDVDPlayer::SPipelineStats stats;
+  memset(&stats, 0, sizeof(stats));
+  int64_t playerUsage = 0, videoUsage = 0, audioUsage = 0;
+  CQueueLevel videoLevel, audioLevel;
+  bool hasVideo = false;
+
+  int64_t start = CurrentHostCounter();
+  bool opened = player->OpenFile(CFileItem(file, false), options);
+  if (opened)
+  {
+    while (!callback.m_ended.WaitMSec(BENCHMARK_SAMPLE_INTERVAL))
+    {
+      player->GetPipelineStats(stats);
+      playerUsage = std::max(playerUsage, stats.player_usage);
+      videoUsage = std::max(videoUsage, stats.video_usage);
+      audioUsage = std::max(audioUsage, stats.audio_usage);
+      videoLevel.Add(stats.video_level);
+      audioLevel.Add(stats.audio_level);
+      hasVideo |= player->HasVideo();
+    }
+  }
+  double duration = (double)(CurrentHostCounter() - start) / CurrentHostFrequency();
+
+  player->CloseFile();
+  // the counters of the players outlive their threads
+  player->GetPipelineStats(stats);
+  delete player;
+
+  CAEFactory::Shutdown();
+  CAEFactory::UnLoadEngine();
+
+  ASSERT_TRUE(opened) << file;
+  if (hasVideo)
+  {
+    EXPECT_GT(stats.video_frames, 0);
+  }
+
+  CVariant result(CVariant::VariantTypeObject);
+  result["file"] = file;
+  result["mode"] = unpaced ? "unpaced" : "paced";
+  result["duration"] = duration;
+  result["video"]["frames"] = stats.video_frames;
+  result["video"]["dropped"] = stats.dropped_frames;
+  result["video"]["fps"] = duration > 0.0 ? stats.video_frames / duration : 0.0;
+  result["queues"]["video"] = videoLevel.ToVariant();
+  result["queues"]["audio"] = audioLevel.ToVariant();
+  result["cpu"]["demux"] = UsageToSeconds(playerUsage);
+  result["cpu"]["video"] = UsageToSeconds(videoUsage);
+  result["cpu"]["audio"] = UsageToSeconds(audioUsage);
+
+  std::string json = CJSONVariantWriter::Write(result, false);
+  const std::string &output = utils.getPlayerBenchmarkOutput();
+  if (output.empty())
+    printf("%s\n", json.c_str());
+  else
+  {
+    XFILE::CFile outputFile;
+    ASSERT_TRUE(outputFile.OpenForWrite(output, true)) << output;
+    EXPECT_EQ((ssize_t)json.size(), outputFile.Write(json.c_str(), json.size()));
+    outputFile.Close();
+  }
+}
@@ -28,6 +28,9 @@
 #include "utils/log.h"
 #include <math.h>
 
+#define DECODE_AHEAD_SECONDS  5 /* how much decoded audio the worker keeps buffered */
+#define QUEUED_SECONDS        2 /* how much must be buffered before playback may start */
+
 CAudioDecoder::CAudioDecoder()
 {
   m_codec = NULL;
@@ -36,6 +39,13 @@ CAudioDecoder::CAudioDecoder()
 
   m_status = STATUS_NO_FILE;
   m_canPlay = false;
+  m_queuedSize = 0;
+
+  m_worker = NULL;
+  m_stopWorker = false;
+  m_workerError = false;
+  m_seekTime = -1;
+  m_seekCount = 0;
 
   // output buffer (for transferring data from the Pcm Buffer to the rest of the audio chain)
   memset(&m_outputBuffer, 0, OUTPUT_SAMPLES * sizeof(float));
@@ -51,6 +61,8 @@ CAudioDecoder::~CAudioDecoder()
 
 void CAudioDecoder::Destroy()
 {
+  StopWorker();
+
   CSingleLock lock(m_critSection);
   m_status = STATUS_NO_FILE;
 
@@ -65,13 +77,6 @@ void CAudioDecoder::Destroy()
 
 bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
 {
-  Destroy();
-
-  CSingleLock lock(m_critSection);
-
-  // reset our playback timing variables
-  m_eof = false;
-
   // get correct cache size
   unsigned int filecache = CSettings::Get().GetInt("cacheaudio.internet");
   if ( file.IsHD() )
@@ -82,14 +87,33 @@ bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
     filecache = CSettings::Get().GetInt("cacheaudio.lan");
 
   // create our codec
-  m_codec=CodecFactory::CreateCodecDemux(file.GetPath(), file.GetMimeType(), filecache * 1024);
+  ICodec *codec = CodecFactory::CreateCodecDemux(file.GetPath(), file.GetMimeType(), filecache * 1024);
 
-  if (!m_codec || !m_codec->Init(file.GetPath(), filecache * 1024))
+  if (!codec || !codec->Init(file.GetPath(), filecache * 1024))
   {
     CLog::Log(LOGERROR, "CAudioDecoder: Unable to Init Codec while loading file %s", file.GetPath().c_str());
+    delete codec;
     Destroy();
     return false;
   }
+
+  // set total time from the given tag
+  if (file.HasMusicInfoTag() && file.GetMusicInfoTag()->GetDuration())
+    codec->SetTotalTime(file.GetMusicInfoTag()->GetDuration());
+
+  return Create(codec, seekOffset);
+}
+
+bool CAudioDecoder::Create(ICodec *codec, int64_t seekOffset)
+{
+  Destroy();
+
+  CSingleLock lock(m_critSection);
+
+  // reset our playback timing variables
+  m_eof = false;
+
+  m_codec = codec;
   unsigned int blockSize = (m_codec->m_BitsPerSample >> 3) * m_codec->GetChannelInfo().Count();
 
   if (blockSize == 0)
@@ -99,21 +123,85 @@ bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
     return false;
   }
 
-  /* allocate the pcmBuffer for 2 seconds of audio */
-  m_pcmBuffer.Create(2 * blockSize * m_codec->m_SampleRate);
-
-  // set total time from the given tag
-  if (file.HasMusicInfoTag() && file.GetMusicInfoTag()->GetDuration())
-    m_codec->SetTotalTime(file.GetMusicInfoTag()->GetDuration());
+  /* allocate the pcmBuffer for the audio we decode ahead */
+  m_pcmBuffer.Create(DECODE_AHEAD_SECONDS * blockSize * m_codec->m_SampleRate);
+  m_queuedSize = (unsigned int)(QUEUED_SECONDS * blockSize * m_codec->m_SampleRate * 0.9);
 
   if (seekOffset)
     m_codec->Seek(seekOffset);
 
   m_status = STATUS_QUEUING;
 
+  {
+    CSingleLock seekLock(m_seekSection);
+    m_stopWorker = false;
+    m_workerError = false;
+    m_seekTime = -1;
+  }
+  m_worker = new CThread(this, "AudioDecoder");
+  m_worker->Create();
+
   return true;
 }
 
+void CAudioDecoder::StopWorker()
+{
+  if (!m_worker)
+    return;
+
+  {
+    CSingleLock lock(m_seekSection);
+    m_stopWorker = true;
+  }
+  m_workerEvent.Set();
+  m_worker->StopThread(true);
+  delete m_worker;
+  m_worker = NULL;
+}
+
+void CAudioDecoder::Run()
+{
+  while (true)
+  {
+    int64_t seekTime;
+    unsigned int seekCount;
+    {
+      CSingleLock lock(m_seekSection);
+      if (m_stopWorker)
+        break;
+      seekTime = m_seekTime;
+      seekCount = m_seekCount;
+      m_seekTime = -1;
+    }
+    if (seekTime >= 0)
+    {
+      CSingleLock lock(m_critSection);
+      m_codec->Seek(seekTime);
+    }
+
+    int result = ReadSamples(PACKET_SIZE, seekCount);
+    if (result == RET_ERROR)
+    {
+      // what has been decoded so far still plays, the file ends after it
+      CSingleLock lock(m_seekSection);
+      m_workerError = true;
+      if (m_status < STATUS_ENDING)
+        m_status = STATUS_ENDING;
+      break;
+    }
+
+    // the buffer is full or the file has ended, wait for the player to take data or seek
+    if (result == RET_SLEEP)
+      m_workerEvent.WaitMSec(100);
+  }
+}
+
+bool CAudioDecoder::HasError()
+{
+  CSingleLock lock(m_seekSection);
+  return m_workerError && m_pcmBuffer.getMaxReadSize() == 0;
+}
+
 void CAudioDecoder::GetDataFormat(CAEChannelInfo *channelInfo, unsigned int *samplerate, unsigned int *encodedSampleRate, enum AEDataFormat *dataFormat)
 {
   if (!m_codec)
@@ -127,12 +215,18 @@ void CAudioDecoder::GetDataFormat(CAEChannelInfo *channelInfo, unsigned int *sam
 
 int64_t CAudioDecoder::Seek(int64_t time)
 {
+  CSingleLock lock(m_seekSection);
   m_pcmBuffer.Clear();
   if (!m_codec)
     return 0;
   if (time < 0) time = 0;
   if (time > m_codec->m_TotalTime) time = m_codec->m_TotalTime;
-  return m_codec->Seek(time);
+
+  // the worker seeks before it reads on, anything it is reading right now gets dropped
+  m_seekTime = time;
+  m_seekCount++;
+  m_workerEvent.Set();
+  return time;
 }
 
 int64_t CAudioDecoder::TotalTime()
@@ -169,6 +263,7 @@ void *CAudioDecoder::GetData(unsigned int samples)
 
   if (m_pcmBuffer.ReadData((char *)m_outputBuffer, size))
   {
+    m_workerEvent.Set();
     if (m_status == STATUS_ENDING && m_pcmBuffer.getMaxReadSize() == 0)
       m_status = STATUS_ENDED;
     
@@ -179,7 +274,7 @@ void *CAudioDecoder::GetData(unsigned int samples)
   return NULL;
 }
 
-int CAudioDecoder::ReadSamples(int numsamples)
+int CAudioDecoder::ReadSamples(int numsamples, unsigned int seekCount)
 {
   if (m_status == STATUS_NO_FILE || m_status == STATUS_ENDING || m_status == STATUS_ENDED)
     return RET_SLEEP;             // nothing loaded yet
@@ -202,11 +297,14 @@ int CAudioDecoder::ReadSamples(int numsamples)
 
     if (result != READ_ERROR && readSize)
     {
-      // move it into our buffer
+      // move it into our buffer, unless it was read before a seek came in
+      CSingleLock seekLock(m_seekSection);
+      if (seekCount != m_seekCount)
+        return RET_SUCCESS;
       m_pcmBuffer.WriteData((char *)m_pcmInputBuffer, readSize);
 
       // update status
-      if (m_status == STATUS_QUEUING && m_pcmBuffer.getMaxReadSize() > m_pcmBuffer.getSize() * 0.9)
+      if (m_status == STATUS_QUEUING && m_pcmBuffer.getMaxReadSize() > m_queuedSize)
       {
         CLog::Log(LOGINFO, "AudioDecoder: File is queued");
         m_status = STATUS_QUEUED;
@@ -230,6 +328,10 @@ int CAudioDecoder::ReadSamples(int numsamples)
     }
     if (result == READ_EOF)
     {
+      // a seek came in, the worker goes on reading from there
+      CSingleLock seekLock(m_seekSection);
+      if (seekCount != m_seekCount)
+        return RET_SUCCESS;
       m_eof = true;
       // setup ending if we're within set time of the end (currently just EOF)
       if (m_status < STATUS_ENDING)
@@ -23,6 +23,7 @@
 #include "threads/Thread.h"
 #include "ICodec.h"
 #include "threads/CriticalSection.h"
+#include "threads/Event.h"
 #include "utils/RingBuffer.h"
 #include "cores/AudioEngine/Utils/AEChannelInfo.h"
 
@@ -50,18 +51,41 @@ class CFileItem;
 #define RET_SUCCESS 0
 #define RET_SLEEP 1
 
-class CAudioDecoder
+/*!
+ \brief Decodes a file into a PCM ring buffer on a worker thread of its own
+
+ The worker starts reading as soon as the file is created, so the next file
+ is opened and its first seconds decoded while the current one still plays.
+ The thread feeding the audio engine only takes data out of the buffer and
+ never waits on I/O or the codec, seeks are handed over to the worker too.
+ */
+class CAudioDecoder : public IRunnable
 {
 public:
   CAudioDecoder();
   ~CAudioDecoder();
 
   bool Create(const CFileItem &file, int64_t seekOffset);
+
+  /*!
+   \brief Decode from a codec which has been initialized already
+   \param codec the codec, which is owned (and deleted) by the decoder from now on.
+   \param seekOffset the time in ms to start decoding at.
+   */
+  bool Create(ICodec *codec, int64_t seekOffset);
   void Destroy();
 
-  int ReadSamples(int numsamples);
+  /*!
+   \brief Whether decoding failed and all data decoded before has been taken
+   */
+  bool HasError();
 
   bool CanSeek() { if (m_codec) return m_codec->CanSeek(); else return false; };
+  /*!
+   \brief Seek to the given time, the worker seeks the codec before it reads on
+   \return the time requested, limited to the length of the file. Where the codec actually
+   lands isn't known yet.
+   */
   int64_t Seek(int64_t time);
   int64_t TotalTime();
   void Start() { m_canPlay = true;}; // cause a pre-buffered stream to start.
@@ -76,9 +100,16 @@ public:
   ICodec *GetCodec() const { return m_codec; }
   float GetReplayGain();
 
+protected:
+  virtual void Run();
+
 private:
+  int ReadSamples(int numsamples, unsigned int seekCount);
+  void StopWorker();
+
   // pcm buffer
   CRingBuffer m_pcmBuffer;
+  unsigned int m_queuedSize; // bytes to buffer before the file counts as queued
 
   // output buffer (for transferring data from the Pcm Buffer to the rest of the audio chain)
   float m_outputBuffer[OUTPUT_SAMPLES];
@@ -96,4 +127,13 @@ private:
   ICodec*          m_codec;
 
   CCriticalSection m_critSection;
+
+  // decoding thread
+  CThread*         m_worker;
+  bool             m_stopWorker;
+  bool             m_workerError;
+  CEvent           m_workerEvent;  // data was taken from the buffer, a seek is pending or the worker should stop
+  CCriticalSection m_seekSection;  // guards the pending seek, the worker flags and writes to the buffer against a seek
+  int64_t          m_seekTime;     // the time the worker should seek to, -1 for none
+  unsigned int     m_seekCount;    // seeks requested so far, data read before the latest one is dropped
 };
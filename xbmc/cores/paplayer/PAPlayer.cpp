@@ -30,6 +30,7 @@
 #include "utils/JobManager.h"
 
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "cores/AudioEngine/AEFactory.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
 #include "cores/AudioEngine/Interfaces/AEStream.h"
@@ -360,14 +361,14 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */, b
     return false;
   }
 
-  /* decode until there is data-available */
+  /* wait until the decoder has data available */
   si->m_decoder.Start();
   while(si->m_decoder.GetDataSize() == 0)
   {
     int status = si->m_decoder.GetStatus();
     if (status == STATUS_ENDED   ||
         status == STATUS_NO_FILE ||
-        si->m_decoder.ReadSamples(PACKET_SIZE) == RET_ERROR)
+        si->m_decoder.HasError())
     {
       CLog::Log(LOGINFO, "PAPlayer::QueueNextFileEx - Error reading samples");
 
@@ -506,7 +507,7 @@ inline bool PAPlayer::PrepareStream(StreamInfo *si)
     int status = si->m_decoder.GetStatus();
     if (status == STATUS_ENDED   ||
         status == STATUS_NO_FILE ||
-        si->m_decoder.ReadSamples(PACKET_SIZE) == RET_ERROR)
+        si->m_decoder.HasError())
     {
       CLog::Log(LOGINFO, "PAPlayer::PrepareStream - Stream Finished");
       break;
@@ -577,9 +578,17 @@ void PAPlayer::Process()
       CThread::Sleep(10);
     }
 
-    GetTimeInternal(); //update for GUI
+    CDataCacheCore::SPlayerInfo info;
+    info.time       = (double)GetTimeInternal(); //update for GUI
+    info.timeTotal  = (double)m_playerGUIData.m_totalTime;
+    info.speed      = m_isPaused ? 0.0f : (float)m_playbackSpeed;
+    info.cacheLevel = m_playerGUIData.m_cacheLevel;
+    info.stamp      = XbmcThreads::SystemClockMillis();
+    g_dataCacheCore.SetPlayerInfo(info);
   }
 
+  g_dataCacheCore.Reset();
+
   if(m_isFinished && !m_bStop)
     m_callback.OnPlayBackEnded();
   else
@@ -763,7 +772,7 @@ inline bool PAPlayer::ProcessStream(StreamInfo *si, double &freeBufferTime)
   int status = si->m_decoder.GetStatus();
   if (status == STATUS_ENDED   ||
       status == STATUS_NO_FILE ||
-      si->m_decoder.ReadSamples(PACKET_SIZE) == RET_ERROR ||
+      si->m_decoder.HasError() ||
       ((si->m_endOffset) && (si->m_framesSent / si->m_sampleRate >= (si->m_endOffset - si->m_startOffset) / 1000)))
   {
     if (si == m_currentStream && m_continueStream)
@@ -1065,7 +1074,15 @@ void PAPlayer::UpdateGUIData(StreamInfo *si)
   total -= m_currentStream->m_startOffset;
   m_playerGUIData.m_totalTime = total;
 
-  g_dataCacheCore.SignalAudioInfoChange();
+  CDataCacheCore::SAudioInfo info;
+  memset(&info, 0, sizeof(info));
+  info.bitrate       = m_playerGUIData.m_audioBitrate;
+  info.channels      = m_playerGUIData.m_channelCount;
+  info.sampleRate    = m_playerGUIData.m_sampleRate;
+  info.bitsPerSample = m_playerGUIData.m_bitsPerSample;
+  info.passthrough   = AE_IS_RAW(si->m_dataFormat);
+  strncpy(info.codec, m_playerGUIData.m_codec, sizeof(info.codec) - 1);
+  g_dataCacheCore.SetAudioInfo(info);
 }
 
 void PAPlayer::OnJobComplete(unsigned int jobID, bool success, CJob *job)
@@ -0,0 +1,109 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/paplayer/AudioDecoder.h"
+#include "threads/SystemClock.h"
+
+#if defined(TARGET_POSIX)
+#include "linux/XTimeUtils.h"
+#endif
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+// 16 bit stereo which returns a few bytes and then fails
+class CFailingCodec : public ICodec
+{
+public:
+  CFailingCodec(int goodReads, int readSize) : m_goodReads(goodReads), m_readSize(readSize)
+  {
+    m_SampleRate = 44100;
+    m_EncodedSampleRate = 44100;
+    m_BitsPerSample = 16;
+    m_DataFormat = AE_FMT_S16NE;
+    m_Channels = 2;
+    m_TotalTime = 10000;
+  }
+
+  virtual bool Init(const std::string &strFile, unsigned int filecache) { return true; }
+  virtual void DeInit() { }
+  virtual int64_t Seek(int64_t iSeekTime) { return iSeekTime; }
+  virtual bool CanInit() { return true; }
+
+  virtual int ReadPCM(BYTE *pBuffer, int size, int *actualsize)
+  {
+    *actualsize = 0;
+    if (m_goodReads-- <= 0)
+      return READ_ERROR;
+    *actualsize = std::min(size, m_readSize);
+    memset(pBuffer, 0, *actualsize);
+    return READ_SUCCESS;
+  }
+
+private:
+  int m_goodReads;
+  int m_readSize;
+};
+
+// waits for data like PAPlayer::QueueNextFileEx, returns false if it times out
+static bool WaitForData(CAudioDecoder &decoder, unsigned int &samples)
+{
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  while ((samples = decoder.GetDataSize()) == 0)
+  {
+    int status = decoder.GetStatus();
+    if (status == STATUS_ENDED || status == STATUS_NO_FILE || decoder.HasError())
+      return true;
+    if (XbmcThreads::SystemClockMillis() - start > 5000)
+      return false;
+    Sleep(1);
+  }
+  return true;
+}
+
+TEST(TestAudioDecoder, ErrorAfterShortRead)
+{
+  CAudioDecoder decoder;
+  ASSERT_TRUE(decoder.Create(new CFailingCodec(1, 1000), 0));
+  decoder.Start();
+
+  // far less than needed to be queued, what there is still gets played
+  unsigned int samples;
+  ASSERT_TRUE(WaitForData(decoder, samples));
+  EXPECT_EQ(500U, samples);
+  EXPECT_TRUE(decoder.GetData(samples) != NULL);
+
+  EXPECT_EQ(STATUS_ENDED, decoder.GetStatus());
+  EXPECT_EQ(0U, decoder.GetDataSize());
+  EXPECT_TRUE(decoder.HasError());
+}
+
+TEST(TestAudioDecoder, ErrorAtStart)
+{
+  CAudioDecoder decoder;
+  ASSERT_TRUE(decoder.Create(new CFailingCodec(0, 0), 0));
+  decoder.Start();
+
+  unsigned int samples;
+  ASSERT_TRUE(WaitForData(decoder, samples));
+  EXPECT_EQ(0U, samples);
+  EXPECT_TRUE(decoder.HasError());
+}
@@ -0,0 +1,358 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FullTextSearch.h"
+#include "dataset.h"
+#include "utils/StringUtils.h"
+
+#include <algorithm>
+#include <map>
+#include <string.h>
+#include <vector>
+
+using namespace std;
+using namespace dbiplus;
+
+// MySQL leaves shorter words out of its FULLTEXT indexes by default (ft_min_word_len)
+#define MIN_FULLTEXT_WORD_LENGTH 4
+
+/* The default stopwords of MySQL, of MyISAM and InnoDB, which aren't indexed. Shorter ones and the
+   ones with apostrophes are left out, as searches for them can't use the index anyway. Sorted. */
+static const char *fullTextStopwords[] =
+{
+  "able", "about", "above", "according", "accordingly", "across", "actually", "after", "afterwards", "again",
+  "against", "allow", "allows", "almost", "alone", "along", "already", "also", "although", "always", "among",
+  "amongst", "another", "anybody", "anyhow", "anyone", "anything", "anyway", "anyways", "anywhere", "apart",
+  "appear", "appreciate", "appropriate", "around", "aside", "asking", "associated", "available", "away",
+  "awfully", "became", "because", "become", "becomes", "becoming", "been", "before", "beforehand", "behind",
+  "being", "believe", "below", "beside", "besides", "best", "better", "between", "beyond", "both", "brief",
+  "came", "cannot", "cant", "cause", "causes", "certain", "certainly", "changes", "clearly", "come", "comes",
+  "concerning", "consequently", "consider", "considering", "contain", "containing", "contains",
+  "corresponding", "could", "course", "currently", "definitely", "described", "despite", "different", "does",
+  "doing", "done", "down", "downwards", "during", "each", "eight", "either", "else", "elsewhere", "enough",
+  "entirely", "especially", "even", "ever", "every", "everybody", "everyone", "everything", "everywhere",
+  "exactly", "example", "except", "fifth", "first", "five", "followed", "following", "follows", "former",
+  "formerly", "forth", "four", "from", "further", "furthermore", "gets", "getting", "given", "gives", "goes",
+  "going", "gone", "gotten", "greetings", "happens", "hardly", "have", "having", "hello", "help", "hence",
+  "here", "hereafter", "hereby", "herein", "hereupon", "hers", "herself", "himself", "hither", "hopefully",
+  "howbeit", "however", "ignored", "immediate", "inasmuch", "indeed", "indicate", "indicated", "indicates",
+  "inner", "insofar", "instead", "into", "inward", "itself", "just", "keep", "keeps", "kept", "know",
+  "known", "knows", "last", "lately", "later", "latter", "latterly", "least", "less", "lest", "like",
+  "liked", "likely", "little", "look", "looking", "looks", "mainly", "many", "maybe", "mean", "meanwhile",
+  "merely", "might", "more", "moreover", "most", "mostly", "much", "must", "myself", "name", "namely",
+  "near", "nearly", "necessary", "need", "needs", "neither", "never", "nevertheless", "next", "nine",
+  "nobody", "none", "noone", "normally", "nothing", "novel", "nowhere", "obviously", "often", "okay", "once",
+  "ones", "only", "onto", "other", "others", "otherwise", "ought", "ours", "ourselves", "outside", "over",
+  "overall", "particular", "particularly", "perhaps", "placed", "please", "plus", "possible", "presumably",
+  "probably", "provides", "quite", "rather", "really", "reasonably", "regarding", "regardless", "regards",
+  "relatively", "respectively", "right", "said", "same", "saying", "says", "second", "secondly", "seeing",
+  "seem", "seemed", "seeming", "seems", "seen", "self", "selves", "sensible", "sent", "serious", "seriously",
+  "seven", "several", "shall", "should", "since", "some", "somebody", "somehow", "someone", "something",
+  "sometime", "sometimes", "somewhat", "somewhere", "soon", "sorry", "specified", "specify", "specifying",
+  "still", "such", "sure", "take", "taken", "tell", "tends", "than", "thank", "thanks", "thanx", "that",
+  "thats", "their", "theirs", "them", "themselves", "then", "thence", "there", "thereafter", "thereby",
+  "therefore", "therein", "theres", "thereupon", "these", "they", "think", "third", "this", "thorough",
+  "thoroughly", "those", "though", "three", "through", "throughout", "thru", "thus", "together", "took",
+  "toward", "towards", "tried", "tries", "truly", "trying", "twice", "under", "unfortunately", "unless",
+  "unlikely", "until", "unto", "upon", "used", "useful", "uses", "using", "usually", "value", "various",
+  "very", "want", "wants", "welcome", "well", "went", "were", "what", "whatever", "when", "whence",
+  "whenever", "where", "whereafter", "whereas", "whereby", "wherein", "whereupon", "wherever", "whether",
+  "which", "while", "whither", "whoever", "whole", "whom", "whose", "will", "willing", "wish", "with",
+  "within", "without", "wonder", "would", "zero"
+};
+
+static bool StopwordBefore(const char *left, const string &right)
+{
+  return right.compare(left) > 0;
+}
+
+// whether MySQL wouldn't find the word as a prefix, because a word of its stopword list starts with it
+static bool IsStopwordPrefix(const string &word)
+{
+  const char **end = fullTextStopwords + sizeof(fullTextStopwords) / sizeof(fullTextStopwords[0]);
+  const char **it = lower_bound(fullTextStopwords, end, word, StopwordBefore);
+  return it != end && StringUtils::StartsWith(*it, word.c_str());
+}
+
+static vector<string> SplitColumns(const char *columns)
+{
+  vector<string> names = StringUtils::Split(columns, ",");
+  for (vector<string>::iterator it = names.begin(); it != names.end(); ++it)
+    StringUtils::Trim(*it);
+  return names;
+}
+
+// the value of a column for a row of the indexed table outside of triggers
+static string GetRowValue(const FullTextIndex &index, const FullTextColumn &column)
+{
+  string value = column.value;
+  StringUtils::Replace(value, "new.", string(index.source) + ".");
+  return value;
+}
+
+namespace
+{
+  struct TriggerStatement
+  {
+    string sql;
+    vector<string> watched; // the statement is skipped unless one of these changed
+  };
+
+  struct Trigger
+  {
+    string table;
+    string event;
+    vector<string> watched;
+    vector<TriggerStatement> statements;
+  };
+}
+
+static void AddStatement(map<string, Trigger> &triggers, const string &table, const string &event, const string &sql, const char *watched = NULL)
+{
+  Trigger &trigger = triggers[event + " ON " + table];
+  trigger.table = table;
+  trigger.event = event;
+  TriggerStatement statement;
+  statement.sql = sql;
+  if (watched != NULL)
+  {
+    statement.watched = SplitColumns(watched);
+    for (vector<string>::const_iterator it = statement.watched.begin(); it != statement.watched.end(); ++it)
+    {
+      if (find(trigger.watched.begin(), trigger.watched.end(), *it) == trigger.watched.end())
+        trigger.watched.push_back(*it);
+    }
+  }
+  trigger.statements.push_back(statement);
+}
+
+bool CFullTextSearch::CreateTable(Dataset &ds, bool sqlite, const FullTextIndex &index)
+{
+  if (sqlite)
+  {
+    // unicode61 folds case and diacritics beyond ASCII, but needs sqlite 3.7.13
+    try
+    {
+      ds.exec(StringUtils::Format("CREATE VIRTUAL TABLE %s USING fts4(%s, tokenize=unicode61)", index.table, GetColumns(index).c_str()));
+    }
+    catch (...)
+    {
+      ds.exec(StringUtils::Format("CREATE VIRTUAL TABLE %s USING fts4(%s)", index.table, GetColumns(index).c_str()));
+    }
+  }
+  else
+  {
+    string columns = "docid integer primary key";
+    for (const FullTextColumn *column = index.columns; column->name != NULL; column++)
+      columns += StringUtils::Format(", %s %s", column->name, column->type);
+    ds.exec(StringUtils::Format("CREATE TABLE %s (%s)", index.table, columns.c_str()));
+  }
+  return true;
+}
+
+bool CFullTextSearch::CreateIndex(Dataset &ds, bool sqlite, const FullTextIndex &index)
+{
+  if (!sqlite)
+    ds.exec(StringUtils::Format("CREATE FULLTEXT INDEX ix_%s ON %s (%s)", index.table, index.table, GetColumns(index).c_str()));
+  return true;
+}
+
+void CFullTextSearch::Fill(Dataset &ds, const FullTextIndex &index)
+{
+  string values;
+  for (const FullTextColumn *column = index.columns; column->name != NULL; column++)
+    values += ", " + GetRowValue(index, *column);
+  ds.exec(StringUtils::Format("INSERT INTO %s (docid, %s) SELECT %s.%s%s FROM %s",
+                              index.table, GetColumns(index).c_str(), index.source, index.idColumn, values.c_str(), index.source));
+}
+
+void CFullTextSearch::CreateTriggers(Dataset &ds, bool sqlite, const FullTextIndex *indexes, size_t count)
+{
+  map<string, Trigger> triggers;
+  for (size_t i = 0; i < count; i++)
+  {
+    const FullTextIndex &index = indexes[i];
+    string values, assignments;
+    for (const FullTextColumn *column = index.columns; column->name != NULL; column++)
+    {
+      values += string(", ") + column->value;
+      assignments += StringUtils::Format("%s%s = %s", assignments.empty() ? "" : ", ", column->name, column->value);
+    }
+    AddStatement(triggers, index.source, "AFTER INSERT",
+                 StringUtils::Format("INSERT INTO %s (docid, %s) VALUES (new.%s%s)", index.table, GetColumns(index).c_str(), index.idColumn, values.c_str()));
+    AddStatement(triggers, index.source, "AFTER UPDATE",
+                 StringUtils::Format("UPDATE %s SET %s WHERE docid = new.%s", index.table, assignments.c_str(), index.idColumn), index.watched);
+    AddStatement(triggers, index.source, "BEFORE DELETE",
+                 StringUtils::Format("DELETE FROM %s WHERE docid = old.%s", index.table, index.idColumn));
+
+    for (const FullTextDependency *dependency = index.dependencies; dependency != NULL && dependency->table != NULL; dependency++)
+    {
+      const FullTextColumn *column = index.columns;
+      while (column->name != NULL && strcmp(column->name, dependency->refresh) != 0)
+        column++;
+      if (column->name == NULL)
+        continue;
+
+      // the column is refreshed from the indexed row, which its value is written for
+      string refresh = StringUtils::Format("UPDATE %s SET %s = (SELECT %s FROM %s WHERE %s.%s = %s.docid) WHERE docid IN (%s)",
+                                           index.table, column->name, GetRowValue(index, *column).c_str(),
+                                           index.source, index.source, index.idColumn, index.table, dependency->rows);
+      if (dependency->watched != NULL)
+        AddStatement(triggers, dependency->table, "AFTER UPDATE", refresh, dependency->watched);
+      else
+      {
+        AddStatement(triggers, dependency->table, "AFTER INSERT", refresh);
+        StringUtils::Replace(refresh, "new.", "old.");
+        AddStatement(triggers, dependency->table, "AFTER DELETE", refresh);
+      }
+    }
+  }
+
+  for (map<string, Trigger>::const_iterator it = triggers.begin(); it != triggers.end(); ++it)
+  {
+    const Trigger &trigger = it->second;
+    string name = "search_" + trigger.event + "_" + trigger.table;
+    StringUtils::Replace(name, ' ', '_');
+    StringUtils::ToLower(name);
+    string sql = StringUtils::Format("CREATE TRIGGER %s %s", name.c_str(), trigger.event.c_str());
+    // sqlite skips updates of other columns itself
+    if (sqlite && !trigger.watched.empty())
+      sql += " OF " + StringUtils::Join(trigger.watched, ", ");
+    sql += " ON " + trigger.table + " FOR EACH ROW BEGIN";
+    for (vector<TriggerStatement>::const_iterator statement = trigger.statements.begin(); statement != trigger.statements.end(); ++statement)
+    {
+      if (statement->watched.empty())
+      {
+        sql += " " + statement->sql + ";";
+        continue;
+      }
+      vector<string> changes;
+      for (vector<string>::const_iterator column = statement->watched.begin(); column != statement->watched.end(); ++column)
+        changes.push_back(StringUtils::Format(sqlite ? "new.%s IS NOT old.%s" : "NOT (new.%s <=> old.%s)", column->c_str(), column->c_str()));
+      string changed = StringUtils::Join(changes, " OR ");
+      if (sqlite)
+        sql += " " + statement->sql + " AND (" + changed + ");";
+      else
+        sql += " IF " + changed + " THEN " + statement->sql + "; END IF;";
+    }
+    sql += " END";
+    ds.exec(sql);
+  }
+}
+
+bool CFullTextSearch::IsAvailable(Database &db, Dataset &ds, bool sqlite, const FullTextIndex &index)
+{
+  try
+  {
+    // fails without the search table or, on MySQL, without its FULLTEXT index
+    string sql = StringUtils::Format("SELECT 1 FROM %s WHERE ", index.table) +
+                 GetCondition(db, sqlite, index, GetMatch("search", sqlite, false, true)) + " LIMIT 1";
+    if (ds.query(sql.c_str()))
+    {
+      ds.close();
+      return true;
+    }
+  }
+  catch (...)
+  {
+  }
+  return false;
+}
+
+std::string CFullTextSearch::GetMatch(const std::string &search, bool sqlite, bool phrase, bool allWords)
+{
+  if (!sqlite && search.find_first_of("'_") != string::npos)
+    return "";
+
+  vector<string> words;
+  string word;
+  size_t length = 0;
+  for (size_t i = 0; i <= search.size(); i++)
+  {
+    char c = i < search.size() ? search[i] : ' ';
+    if ((unsigned char)c >= 0x80 || StringUtils::isasciialphanum(c))
+    {
+      word += StringUtils::isasciiuppercaseletter(c) ? (char)(c - 'A' + 'a') : c;
+      if (((unsigned char)c & 0xc0) != 0x80) // UTF-8 continuation bytes are part of the last character
+        length++;
+    }
+    else if (!word.empty())
+    {
+      if (!sqlite && (length < MIN_FULLTEXT_WORD_LENGTH || IsStopwordPrefix(word)))
+      {
+        if (allWords)
+          return "";
+      }
+      else
+        words.push_back(word);
+      word.clear();
+      length = 0;
+    }
+  }
+  if (words.empty())
+    return "";
+
+  if (sqlite && phrase)
+    return "\"" + StringUtils::Join(words, " ") + "*\"";
+
+  string match;
+  for (vector<string>::const_iterator it = words.begin(); it != words.end(); ++it)
+  {
+    if (!match.empty())
+      match += " ";
+    match += (sqlite ? "" : "+") + *it + "*";
+  }
+  return match;
+}
+
+std::string CFullTextSearch::GetCondition(Database &db, bool sqlite, const FullTextIndex &index, const std::string &match)
+{
+  if (sqlite)
+    return db.prepare("%s MATCH '%s'", index.table, match.c_str());
+  return db.prepare("MATCH (%s) AGAINST ('%s' IN BOOLEAN MODE)", GetColumns(index).c_str(), match.c_str());
+}
+
+std::string CFullTextSearch::GetFilter(Database &db, bool sqlite, const FullTextIndex &index, const std::string &search, bool phrase, bool allWords)
+{
+  string match = GetMatch(search, sqlite, phrase, allWords);
+  if (match.empty())
+    return "";
+  return StringUtils::Format("%s IN (SELECT docid FROM %s WHERE ", index.idColumn, index.table) +
+         GetCondition(db, sqlite, index, match) + ")";
+}
+
+std::string CFullTextSearch::GetRankedQuery(Database &db, bool sqlite, const FullTextIndex &index, const std::string &search, bool useIndex)
+{
+  const char *name = index.nameColumn;
+  string sql = db.prepare("SELECT %s, %s, CASE WHEN %s LIKE '%s' THEN 0 WHEN %s LIKE '%s%%' THEN 1 WHEN %s LIKE '%% %s%%' THEN 2 ELSE 3 END AS iRank FROM %s WHERE ",
+                          index.idColumn, name, name, search.c_str(), name, search.c_str(), name, search.c_str(), index.source);
+  string filter = useIndex ? GetFilter(db, sqlite, index, search, false, true) : "";
+  if (filter.empty()) // only the names can be searched without the index
+    return sql + db.prepare("(%s LIKE '%s%%' OR %s LIKE '%% %s%%')", name, search.c_str(), name, search.c_str());
+  return sql + filter;
+}
+
+std::string CFullTextSearch::GetColumns(const FullTextIndex &index)
+{
+  vector<string> names;
+  for (const FullTextColumn *column = index.columns; column->name != NULL; column++)
+    names.push_back(column->name);
+  return StringUtils::Join(names, ", ");
+}
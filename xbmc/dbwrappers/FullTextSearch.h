@@ -0,0 +1,134 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+
+namespace dbiplus
+{
+  class Database;
+  class Dataset;
+}
+
+/*! \brief A column of a full text search table */
+struct FullTextColumn
+{
+  const char *name;  ///< name of the column in the search table, e.g. strTitle
+  const char *type;  ///< its type on MySQL, e.g. varchar(512)
+  const char *value; ///< its value for a row "new" of the indexed table, e.g. new.strTitle
+};
+
+/*! \brief A table, other than the indexed one, that values of a search table are taken from
+ The columns are refreshed from the indexed table, for the rows a change of the table affects.
+ */
+struct FullTextDependency
+{
+  const char *table;   ///< the table, e.g. album
+  const char *watched; ///< the columns whose update changes the values, NULL if inserts and deletes do
+  const char *rows;    ///< the ids of the affected rows for a row "new" of the table, e.g. new.idMovie
+  const char *refresh; ///< the column of the search table to refresh, e.g. strAlbum
+};
+
+/*! \brief A full text search table over a table, kept up to date by triggers
+ On sqlite the search table is a fts4 table, on MySQL a table with a FULLTEXT index. Either way its
+ id column is called docid and holds the id of the indexed row.
+ */
+struct FullTextIndex
+{
+  const char *table;                        ///< the search table, e.g. songsearch
+  const char *source;                       ///< the indexed table, e.g. song
+  const char *idColumn;                     ///< the id column of the indexed table, e.g. idSong
+  const char *nameColumn;                   ///< the column of the indexed table ranked searches rank by, e.g. strTitle
+  const char *watched;                      ///< the columns of the indexed table the values depend on
+  const FullTextColumn *columns;            ///< the columns of the search table, up to one without a name
+  const FullTextDependency *dependencies;   ///< the other tables the values depend on, up to one without a table, or NULL
+};
+
+class CFullTextSearch
+{
+public:
+  /*! \brief Create a search table
+   \param ds the dataset to run the statements with.
+   \param sqlite whether the database is sqlite, MySQL otherwise.
+   \param index the search table to create.
+   \return false if the database doesn't support full text search.
+   */
+  static bool CreateTable(dbiplus::Dataset &ds, bool sqlite, const FullTextIndex &index);
+
+  /*! \brief Create the FULLTEXT index of a search table on MySQL, it's part of the table on sqlite
+   \return false if the database doesn't support FULLTEXT indexes.
+   */
+  static bool CreateIndex(dbiplus::Dataset &ds, bool sqlite, const FullTextIndex &index);
+
+  /*! \brief Fill a search table with the rows already in the indexed table
+   */
+  static void Fill(dbiplus::Dataset &ds, const FullTextIndex &index);
+
+  /*! \brief Create the triggers keeping search tables up to date
+   The triggers of the given search tables are merged into one per table, event and time, as MySQL allows no more.
+   Rows are removed before they're deleted, as the indexed tables have their own AFTER DELETE triggers.
+   \param indexes the search tables.
+   \param count the number of search tables.
+   */
+  static void CreateTriggers(dbiplus::Dataset &ds, bool sqlite, const FullTextIndex *indexes, size_t count);
+
+  /*! \brief Whether the search table can be queried, it can't without its FULLTEXT index on MySQL
+   */
+  static bool IsAvailable(dbiplus::Database &db, dbiplus::Dataset &ds, bool sqlite, const FullTextIndex &index);
+
+  /*! \brief Turn a search into a full text match of its words at the start of words of the indexed columns
+   The words are split like the tokenizers do at anything but ASCII letters and digits, leaving multibyte
+   characters to them.
+
+   MySQL doesn't index short words and words on its stopword list, and it takes apostrophes and underscores as
+   part of words. Searches with the latter can't be matched. Short words and words a stopword starts with are
+   left out, unless all words are asked for.
+   \param search the words to search for.
+   \param sqlite whether the database is sqlite, MySQL otherwise.
+   \param phrase whether the words have to follow each other, only sqlite supports it.
+   \param allWords whether the match has to require every word of the search.
+   \return the match in the boolean syntax of the database, empty if the index can't be used for the search.
+   */
+  static std::string GetMatch(const std::string &search, bool sqlite, bool phrase, bool allWords);
+
+  /*! \brief Get the condition on a search table for a full text match
+   \param match the match, as returned by GetMatch().
+   \return the condition for the WHERE clause of a query on the search table.
+   */
+  static std::string GetCondition(dbiplus::Database &db, bool sqlite, const FullTextIndex &index, const std::string &match);
+
+  /*! \brief Get a condition narrowing down the rows of the indexed table to the ones matching a search
+   \return the condition for the WHERE clause of a query on the indexed table, empty if the index can't be used.
+   \sa GetMatch()
+   */
+  static std::string GetFilter(dbiplus::Database &db, bool sqlite, const FullTextIndex &index, const std::string &search, bool phrase, bool allWords);
+
+  /*! \brief Get a query for the id, name and rank of the rows of the indexed table matching every word of a search
+   The rank is 0 for an exact name, 1 for names starting with the search, 2 for names containing it at the
+   start of a word and 3 for other matches. Without the index only the names are searched.
+   \param useIndex whether the search table can be used.
+   \return the query, to be completed with further conditions and the order.
+   */
+  static std::string GetRankedQuery(dbiplus::Database &db, bool sqlite, const FullTextIndex &index, const std::string &search, bool useIndex);
+
+  /*! \brief Get the names of the columns of a search table, separated by commas
+   */
+  static std::string GetColumns(const FullTextIndex &index);
+};
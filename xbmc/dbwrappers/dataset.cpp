@@ -199,6 +199,45 @@ void Dataset::parse_sql(string &sql) {
 }
 
 
+string Dataset::format_sql(const string &sql, const BindParams &params) {
+  string result;
+  result.reserve(sql.size());
+  unsigned int param = 0;
+  bool quoted = false;
+  for (unsigned int i = 0; i < sql.size(); i++) {
+    if (sql[i] == '\'')
+      quoted = !quoted;
+    if (sql[i] != '?' || quoted) {
+      result += sql[i];
+      continue;
+    }
+    if (param >= params.size())
+      throw DbErrors("Too few parameters for query: %s", sql.c_str());
+
+    const field_value &value = params[param++];
+    if (value.get_isNull())
+      result += "NULL";
+    else if (value.get_fType() == ft_String)
+      result += db->prepare("'%s'", value.get_asString().c_str());
+    else if (value.get_fType() == ft_Boolean)
+      result += value.get_asBool() ? "1" : "0";
+    else
+      result += value.get_asString();
+  }
+  if (param != params.size())
+    throw DbErrors("Too many parameters for query: %s", sql.c_str());
+  return result;
+}
+
+bool Dataset::query_bind(const string &sql, const BindParams &params) {
+  return query(format_sql(sql, params).c_str());
+}
+
+int Dataset::exec_bind(const string &sql, const BindParams &params) {
+  return exec(format_sql(sql, params));
+}
+
+
 void Dataset::close(void) {
   haveError  = false;
   frecno = 0;
@@ -47,6 +47,7 @@ class Dataset;		// forward declaration of class Dataset
 #define S_NO_CONNECTION "No active connection";
 
 #define DB_BUFF_MAX           8*1024    // Maximum buffer's capacity
+#define DB_STATEMENT_CACHE    32        // Prepared statements kept per connection
 
 #define DB_CONNECTION_NONE	0
 #define DB_CONNECTION_OK	1
@@ -186,6 +187,18 @@ enum sqlType {sqlSelect,sqlUpdate,sqlInsert,sqlDelete,sqlExec};
 typedef std::list<std::string> StringList;
 typedef std::map<std::string,field_value> ParamList;
 
+/* Values for the ? placeholders of a statement, in order:
+   BindParams().add(strFileName).add(idPath) */
+class BindParams : public std::vector<field_value> {
+public:
+  BindParams &add(const std::string &value) { field_value v; v.set_asString(value); push_back(v); return *this; }
+  BindParams &add(const char *value) { push_back(field_value(value)); return *this; }
+  BindParams &add(int value) { push_back(field_value(value)); return *this; }
+  BindParams &add(int64_t value) { push_back(field_value(value)); return *this; }
+  BindParams &add(double value) { push_back(field_value(value)); return *this; }
+  BindParams &add_null() { field_value v; v.set_isNull(); push_back(v); return *this; }
+};
+
 
 class Dataset  {
 protected:
@@ -262,6 +275,9 @@ protected:
 /* Parse Sql - replacing fields with prefixes :OLD_ and :NEW_ with current values of OLD or NEW field. */
   void parse_sql(std::string &sql);
 
+/* Replaces the ? placeholders in sql with params, escaped as by Database::prepare */
+  std::string format_sql(const std::string &sql, const BindParams &params);
+
 /* Returns old field value (for :OLD) */
   virtual const field_value f_old(const char *f);
 
@@ -310,6 +326,15 @@ public:
   virtual const void* getExecRes()=0;
 /* as open, but with our query exept Sql */
   virtual bool query(const char *sql) = 0;
+/* as query, but forward only: rows are fetched one at a time by next() rather than all up front,
+   so num_rows() only counts the rows fetched so far and there's no going back.
+   Datasets which can't do that fetch all rows as query does */
+  virtual bool query_stream(const char *sql) { return query(sql); }
+/* as query and exec, but the ? placeholders in sql are bound to params rather than formatted
+   into it, so the statement can be compiled once and kept by the connection for the next time.
+   Datasets which can't bind do the formatting themselves */
+  virtual bool query_bind(const std::string &sql, const BindParams &params);
+  virtual int  exec_bind(const std::string &sql, const BindParams &params);
 /* Close SQL Query*/
   virtual void close();
 /* This function looks for field Field_name with value equal Field_value
@@ -404,7 +429,7 @@ public:
 
 /* --------------- for fast access ---------------- */
   const result_set& get_result_set() { return result; }
-  const sql_record* const get_sql_record();
+  virtual const sql_record* const get_sql_record();
 
  private:
   void set_ds_state(dsStates new_state) {ds_state = new_state;};	
@@ -146,6 +146,14 @@ int MysqlDatabase::connect(bool create_new) {
                   db.c_str(), mysql_errno(conn), mysql_error(conn));
       }
 
+      // the search tables concatenate names with group_concat(), which cuts them at 1024 bytes by default
+      static const char *concatLength = "SET SESSION group_concat_max_len = 1048576";
+      if (mysql_real_query(conn, concatLength, strlen(concatLength)))
+      {
+        CLog::Log(LOGERROR, "Unable to set group_concat_max_len: %s [%d](%s)",
+                  db.c_str(), mysql_errno(conn), mysql_error(conn));
+      }
+
       // check existence
       if (exists())
       {
@@ -198,6 +206,7 @@ int MysqlDatabase::connect(bool create_new) {
 void MysqlDatabase::disconnect(void) {
   if (conn != NULL)
   {
+    clear_statements();
     mysql_close(conn);
     conn = NULL;
   }
@@ -399,6 +408,61 @@ int MysqlDatabase::query_with_reconnect(const char* query) {
   return result;
 }
 
+MYSQL_STMT *MysqlDatabase::get_statement(const char *sql) {
+  if (!active) throw DbErrors("No Database Connection");
+
+  map<string, StatementList::iterator>::iterator it = statement_index.find(sql);
+  if (it != statement_index.end())
+  {
+    MYSQL_STMT *stmt = it->second->second;
+    statements.erase(it->second);
+    statement_index.erase(it);
+    return stmt;
+  }
+
+  MYSQL_STMT *stmt = mysql_stmt_init(conn);
+  if (stmt == NULL)
+    throw DbErrors("Can't allocate a statement for query: %s", sql);
+  if (mysql_stmt_prepare(stmt, sql, strlen(sql)) != MYSQL_OK)
+  {
+    setErr(mysql_stmt_errno(stmt), sql);
+    mysql_stmt_close(stmt);
+    throw DbErrors(getErrorMsg());
+  }
+
+  // have the longest value of each column known once the result is stored
+  my_bool update_max_length = 1;
+  mysql_stmt_attr_set(stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &update_max_length);
+  return stmt;
+}
+
+void MysqlDatabase::put_statement(const char *sql, MYSQL_STMT *stmt) {
+  mysql_stmt_free_result(stmt);
+
+  // the same statement may have been in use twice at a time
+  if (statement_index.find(sql) != statement_index.end())
+  {
+    mysql_stmt_close(stmt);
+    return;
+  }
+
+  statements.push_front(make_pair(string(sql), stmt));
+  statement_index[sql] = statements.begin();
+  if (statements.size() > DB_STATEMENT_CACHE)
+  {
+    mysql_stmt_close(statements.back().second);
+    statement_index.erase(statements.back().first);
+    statements.pop_back();
+  }
+}
+
+void MysqlDatabase::clear_statements() {
+  for (StatementList::iterator it = statements.begin(); it != statements.end(); ++it)
+    mysql_stmt_close(it->second);
+  statements.clear();
+  statement_index.clear();
+}
+
 long MysqlDatabase::nextid(const char* sname) {
   CLog::Log(LOGDEBUG,"MysqlDatabase::nextid for %s",sname);
   if (!active) return DB_UNEXPECTED_RESULT;
@@ -1471,6 +1535,56 @@ const void* MysqlDataset::getExecRes() {
 }
 
 
+static void get_column_value(const MYSQL_FIELD &field, const char *value, sql_record &rec, unsigned int i)
+{
+  switch (field.type)
+  {
+    case MYSQL_TYPE_LONGLONG:
+    case MYSQL_TYPE_DECIMAL:
+    case MYSQL_TYPE_NEWDECIMAL:
+    case MYSQL_TYPE_TINY:
+    case MYSQL_TYPE_SHORT:
+    case MYSQL_TYPE_INT24:
+    case MYSQL_TYPE_LONG:
+      if (value != NULL)
+      {
+        rec.set_asInt(i, atoi(value));
+      }
+      else
+      {
+        rec.set_asInt(i, 0);
+      }
+      break;
+    case MYSQL_TYPE_FLOAT:
+    case MYSQL_TYPE_DOUBLE:
+      if (value != NULL)
+      {
+        rec.set_asDouble(i, atof(value));
+      }
+      else
+      {
+        rec.set_asDouble(i, 0);
+      }
+      break;
+    case MYSQL_TYPE_STRING:
+    case MYSQL_TYPE_VAR_STRING:
+    case MYSQL_TYPE_VARCHAR:
+      if (value != NULL) rec.set_asString(i, (const char *)value );
+      break;
+    case MYSQL_TYPE_TINY_BLOB:
+    case MYSQL_TYPE_MEDIUM_BLOB:
+    case MYSQL_TYPE_LONG_BLOB:
+    case MYSQL_TYPE_BLOB:
+      if (value != NULL) rec.set_asString(i, (const char *)value);
+      break;
+    case MYSQL_TYPE_NULL:
+    default:
+      CLog::Log(LOGDEBUG,"MYSQL: Unknown field type: %u", field.type);
+      rec.set_isNull(i);
+      break;
+  }
+}
+
 bool MysqlDataset::query(const char *query) {
   if(!handle()) throw DbErrors("No Database Connection");
   std::string qry = query;
@@ -1506,70 +1620,192 @@ bool MysqlDataset::query(const char *query) {
   // returned rows
   while ((row = mysql_fetch_row(stmt)))
   { // have a row of data
-    sql_record *res = new sql_record;
-    res->resize(numColumns);
+    sql_record *res = result.add_record(numColumns);
     for (unsigned int i = 0; i < numColumns; i++)
+      get_column_value(fields[i], row[i], *res, i);
+  }
+  mysql_free_result(stmt);
+  active = true;
+  ds_state = dsSelect;
+  this->first();
+  return true;
+}
+
+bool MysqlDataset::query(const string &q) {
+  return query(q.c_str());
+}
+
+MYSQL_STMT *MysqlDataset::execute_statement(const string &sql, const BindParams &params) {
+  MysqlDatabase *mysql = static_cast<MysqlDatabase*>(db);
+
+  // the values bound have to be there until the statement has run
+  vector<MYSQL_BIND> binds(params.size());
+  vector<string> strings(params.size());
+  vector<long long> ints(params.size());
+  vector<double> doubles(params.size());
+  if (!binds.empty())
+    memset(&binds[0], 0, binds.size() * sizeof(MYSQL_BIND));
+  for (unsigned int i = 0; i < params.size(); i++)
+  {
+    const field_value &v = params[i];
+    MYSQL_BIND &bind = binds[i];
+    if (v.get_isNull())
+    {
+      bind.buffer_type = MYSQL_TYPE_NULL;
+      continue;
+    }
+    switch (v.get_fType())
     {
-      field_value &v = res->at(i);
-      switch (fields[i].type)
+      case ft_Boolean:
+      case ft_Char:
+      case ft_Short:
+      case ft_UShort:
+      case ft_Int:
+      case ft_UInt:
+      case ft_Int64:
+        ints[i] = v.get_asInt64();
+        bind.buffer_type = MYSQL_TYPE_LONGLONG;
+        bind.buffer = &ints[i];
+        break;
+      case ft_Float:
+      case ft_Double:
+        doubles[i] = v.get_asDouble();
+        bind.buffer_type = MYSQL_TYPE_DOUBLE;
+        bind.buffer = &doubles[i];
+        break;
+      default:
+        strings[i] = v.get_asString();
+        bind.buffer_type = MYSQL_TYPE_STRING;
+        bind.buffer = (void *)strings[i].c_str();
+        bind.buffer_length = strings[i].size();
+        break;
+    }
+  }
+
+  for (int attempts = 5; ; attempts--)
+  {
+    MYSQL_STMT *stmt = mysql->get_statement(sql.c_str());
+    if (mysql_stmt_param_count(stmt) != params.size())
+    {
+      mysql->put_statement(sql.c_str(), stmt);
+      throw DbErrors("Wrong number of parameters for query: %s", sql.c_str());
+    }
+
+    if ((binds.empty() || mysql_stmt_bind_param(stmt, &binds[0]) == 0) &&
+        mysql_stmt_execute(stmt) == MYSQL_OK &&
+        mysql_stmt_store_result(stmt) == MYSQL_OK)
+      return stmt;
+
+    // a statement which failed isn't kept
+    int err = mysql_stmt_errno(stmt);
+    mysql_stmt_close(stmt);
+    if ((err != CR_SERVER_GONE_ERROR && err != CR_SERVER_LOST) || attempts <= 0)
+    {
+      db->setErr(err, sql.c_str());
+      throw DbErrors(db->getErrorMsg());
+    }
+
+    // statements are gone with the connection, the reconnect drops them from the cache too
+    CLog::Log(LOGINFO,"MYSQL server has gone. Will try %d more attempt(s) to reconnect.", attempts);
+    mysql->connect(true);
+  }
+}
+
+bool MysqlDataset::query_bind(const string &sql, const BindParams &params) {
+  if(!handle()) throw DbErrors("No Database Connection");
+  if (sql.find("select") == string::npos && sql.find("SELECT") == string::npos)
+    throw DbErrors("MUST be select SQL!");
+
+  close();
+
+  string qry = sql;
+  size_t loc;
+
+  // mysql doesn't understand CAST(foo as integer) => change to CAST(foo as signed integer)
+  while ((loc = ci_find(qry, "as integer)")) != string::npos)
+    qry = qry.insert(loc + 3, "signed ");
+
+  MYSQL_STMT *stmt = execute_statement(qry, params);
+  MYSQL_RES *meta = mysql_stmt_result_metadata(stmt);
+  const unsigned int numColumns = meta ? mysql_num_fields(meta) : 0;
+  MYSQL_FIELD *fields = meta ? mysql_fetch_fields(meta) : NULL;
+
+  // every column is fetched as text, the same as query() gets it, into a
+  // buffer as long as its longest value
+  vector<MYSQL_BIND> binds(numColumns);
+  vector< vector<char> > buffers(numColumns);
+  vector<unsigned long> lengths(numColumns);
+  vector<my_bool> nulls(numColumns);
+  if (numColumns)
+    memset(&binds[0], 0, binds.size() * sizeof(MYSQL_BIND));
+  result.record_header.resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    result.record_header[i].name = fields[i].name;
+    buffers[i].resize(max(fields[i].max_length, 64UL) + 1);
+    binds[i].buffer_type = MYSQL_TYPE_STRING;
+    binds[i].buffer = &buffers[i][0];
+    binds[i].buffer_length = buffers[i].size();
+    binds[i].length = &lengths[i];
+    binds[i].is_null = &nulls[i];
+  }
+
+  int res = numColumns ? mysql_stmt_bind_result(stmt, &binds[0]) : MYSQL_NO_DATA;
+  if (res == MYSQL_OK)
+  {
+    // returned rows
+    while ((res = mysql_stmt_fetch(stmt)) == MYSQL_OK || res == MYSQL_DATA_TRUNCATED)
+    { // have a row of data
+      sql_record *rec = result.add_record(numColumns);
+      bool rebind = false;
+      for (unsigned int i = 0; i < numColumns; i++)
       {
-        case MYSQL_TYPE_LONGLONG:
-        case MYSQL_TYPE_DECIMAL:
-        case MYSQL_TYPE_NEWDECIMAL:
-        case MYSQL_TYPE_TINY:
-        case MYSQL_TYPE_SHORT:
-        case MYSQL_TYPE_INT24:
-        case MYSQL_TYPE_LONG:
-          if (row[i] != NULL)
-          {
-            v.set_asInt(atoi(row[i]));
-          }
-          else
-          {
-            v.set_asInt(0);
-          }
-          break;
-        case MYSQL_TYPE_FLOAT:
-        case MYSQL_TYPE_DOUBLE:
-          if (row[i] != NULL)
-          {
-            v.set_asDouble(atof(row[i]));
-          }
-          else
-          {
-            v.set_asDouble(0);
-          }
-          break;
-        case MYSQL_TYPE_STRING:
-        case MYSQL_TYPE_VAR_STRING:
-        case MYSQL_TYPE_VARCHAR:
-          if (row[i] != NULL) v.set_asString((const char *)row[i] );
-          break;
-        case MYSQL_TYPE_TINY_BLOB:
-        case MYSQL_TYPE_MEDIUM_BLOB:
-        case MYSQL_TYPE_LONG_BLOB:
-        case MYSQL_TYPE_BLOB:
-          if (row[i] != NULL) v.set_asString((const char *)row[i]);
-          break;
-        case MYSQL_TYPE_NULL:
-        default:
-          CLog::Log(LOGDEBUG,"MYSQL: Unknown field type: %u", fields[i].type);
-          v.set_asString("");
-          v.set_isNull();
-          break;
+        if (nulls[i])
+        {
+          get_column_value(fields[i], NULL, *rec, i);
+          continue;
+        }
+        if (lengths[i] >= buffers[i].size())
+        { // longer than the buffer, fetch it again into one big enough
+          buffers[i].resize(lengths[i] + 1);
+          binds[i].buffer = &buffers[i][0];
+          binds[i].buffer_length = buffers[i].size();
+          mysql_stmt_fetch_column(stmt, &binds[i], i, 0);
+          rebind = true;
+        }
+        buffers[i][lengths[i]] = 0;
+        get_column_value(fields[i], &buffers[i][0], *rec, i);
       }
+      if (rebind)
+        mysql_stmt_bind_result(stmt, &binds[0]);
     }
-    result.records.push_back(res);
   }
-  mysql_free_result(stmt);
+
+  if (meta)
+    mysql_free_result(meta);
+  if (res != MYSQL_NO_DATA)
+  {
+    db->setErr(mysql_stmt_errno(stmt), qry.c_str());
+    static_cast<MysqlDatabase*>(db)->put_statement(qry.c_str(), stmt);
+    throw DbErrors(db->getErrorMsg());
+  }
+  static_cast<MysqlDatabase*>(db)->put_statement(qry.c_str(), stmt);
+
   active = true;
   ds_state = dsSelect;
   this->first();
   return true;
 }
 
-bool MysqlDataset::query(const string &q) {
-  return query(q.c_str());
+int MysqlDataset::exec_bind(const string &sql, const BindParams &params) {
+  if (!handle()) throw DbErrors("No Database Connection");
+  exec_res.clear();
+
+  CLog::Log(LOGDEBUG,"Mysql execute: %s", sql.c_str());
+
+  MYSQL_STMT *stmt = execute_statement(sql, params);
+  static_cast<MysqlDatabase*>(db)->put_statement(sql.c_str(), stmt);
+  return MYSQL_OK;
 }
 
 void MysqlDataset::open(const string &sql) {
@@ -1647,15 +1883,7 @@ void MysqlDataset::next(void) {
 
 void MysqlDataset::free_row(void)
 {
-  if (frecno < 0 || (unsigned int)frecno >= result.records.size())
-    return;
-
-  sql_record *row = result.records[frecno];
-  if (row)
-  {
-    delete row;
-    result.records[frecno] = NULL;
-  }
+  // rows live in the arena of the result set and go all at once with it
 }
 
 bool MysqlDataset::seek(int pos) {
@@ -38,6 +38,11 @@ protected:
   bool _in_transaction;
   int last_err;
 
+/* statements given back by put_statement, most recently used first */
+  typedef std::list<std::pair<std::string, MYSQL_STMT*> > StatementList;
+  StatementList statements;
+  std::map<std::string, StatementList::iterator> statement_index;
+
 
 public:
 /* default constructor */
@@ -86,6 +91,14 @@ public:
   bool in_transaction() {return _in_transaction;};
   int query_with_reconnect(const char* query);
 
+/* func. returns the prepared statement for sql, taken from the cache if it's there.
+   It stays out of the cache until given back by put_statement() */
+  MYSQL_STMT *get_statement(const char *sql);
+/* func. frees the result of a statement from get_statement() and keeps it for the next one */
+  void put_statement(const char *sql, MYSQL_STMT *stmt);
+/* func. closes all statements kept */
+  void clear_statements();
+
 private:
 
   typedef struct StrAccum StrAccum;
@@ -128,6 +141,10 @@ protected:
 /* Changing field values during dataset navigation */
   virtual void free_row();  // free the memory allocated for the current row
 
+/* Runs sql with params bound on a statement from the cache, reconnecting if the
+   server has gone. The statement is returned with its result stored */
+  MYSQL_STMT *execute_statement(const std::string &sql, const BindParams &params);
+
 public:
 /* constructor */
   MysqlDataset();
@@ -150,6 +167,9 @@ or insert() operations default = false) */
 /* as open, but with our query exept Sql */
   virtual bool query(const char *query);
   virtual bool query(const std::string &query);
+/* as query and exec, but with cached statements, see Dataset::query_bind */
+  virtual bool query_bind(const std::string &sql, const BindParams &params);
+  virtual int  exec_bind(const std::string &sql, const BindParams &params);
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
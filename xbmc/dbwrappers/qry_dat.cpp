@@ -35,6 +35,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
 
 #ifndef __GNUC__
 #pragma warning (disable:4800)
@@ -744,4 +748,233 @@ string field_value::gft() {
   return tmp;
   }
 
-} //namespace 
+// the first block fits a few small lookups, later ones grow with the query
+#define ARENA_FIRST_BLOCK   4096
+#define ARENA_MAX_BLOCK     131072
+
+record_arena::record_arena() {
+  block_size = 0;
+  used = 0;
+  total = 0;
+}
+
+record_arena::~record_arena() {
+  clear();
+  for (unsigned int i = 0; i < blocks.size(); i++)
+    delete[] blocks[i];
+}
+
+void *record_arena::alloc(size_t size) {
+  used = (used + 7) & ~(size_t)7;
+  size = (size + 7) & ~(size_t)7;
+  if (size > ARENA_MAX_BLOCK / 2) {
+    char *p = new char[size];
+    large.push_back(p);
+    total += size;
+    return p;
+  }
+  if (blocks.empty() || used + size > block_size) {
+    block_size = blocks.empty() ? ARENA_FIRST_BLOCK : std::min(block_size * 2, (size_t)ARENA_MAX_BLOCK);
+    blocks.push_back(new char[block_size]);
+    used = 0;
+    total += block_size;
+  }
+  char *p = blocks.back() + used;
+  used += size;
+  return p;
+}
+
+const char *record_arena::store(const char *s, size_t len) {
+  char *p;
+  if (!blocks.empty() && used + len + 1 <= block_size) {
+    // strings don't need aligning
+    p = blocks.back() + used;
+    used += len + 1;
+  }
+  else
+    p = (char *)alloc(len + 1);
+  memcpy(p, s, len);
+  p[len] = 0;
+  return p;
+}
+
+void record_arena::clear() {
+  for (unsigned int i = 0; i < large.size(); i++)
+    delete[] large[i];
+  large.clear();
+
+  // the last block is the biggest, it's kept
+  if (blocks.size() > 1) {
+    for (unsigned int i = 0; i + 1 < blocks.size(); i++)
+      delete[] blocks[i];
+    blocks.erase(blocks.begin(), blocks.end() - 1);
+  }
+  used = 0;
+  total = blocks.empty() ? 0 : block_size;
+}
+
+size_t record_arena::capacity() const {
+  return total;
+}
+
+std::string field_ref::get_asString() const {
+  if (cell->type == ft_String)
+    return std::string(cell->str_value, cell->str_len);
+  field_value value = *this;
+  return value.get_asString();
+}
+
+bool field_ref::get_asBool() const {
+  field_value value = *this;
+  return value.get_asBool();
+}
+
+char field_ref::get_asChar() const {
+  field_value value = *this;
+  return value.get_asChar();
+}
+
+short field_ref::get_asShort() const {
+  field_value value = *this;
+  return value.get_asShort();
+}
+
+unsigned short field_ref::get_asUShort() const {
+  field_value value = *this;
+  return value.get_asUShort();
+}
+
+int field_ref::get_asInt() const {
+  switch (cell->type) {
+    case ft_String:
+      return (int)atoi(cell->str_value);
+    case ft_Int:
+    case ft_Int64:
+      return (int)cell->int_value;
+    case ft_Double:
+      return (int)cell->double_value;
+    default:
+      return 0;
+  }
+}
+
+unsigned int field_ref::get_asUInt() const {
+  field_value value = *this;
+  return value.get_asUInt();
+}
+
+float field_ref::get_asFloat() const {
+  field_value value = *this;
+  return value.get_asFloat();
+}
+
+double field_ref::get_asDouble() const {
+  switch (cell->type) {
+    case ft_String:
+      return atof(cell->str_value);
+    case ft_Int:
+    case ft_Int64:
+      return (double)cell->int_value;
+    case ft_Double:
+      return cell->double_value;
+    default:
+      return 0;
+  }
+}
+
+int64_t field_ref::get_asInt64() const {
+  switch (cell->type) {
+    case ft_String:
+      return _atoi64(cell->str_value);
+    case ft_Int:
+    case ft_Int64:
+      return cell->int_value;
+    case ft_Double:
+      return (int64_t)cell->double_value;
+    default:
+      return 0;
+  }
+}
+
+field_ref::operator field_value() const {
+  field_value value;
+  switch (cell->type) {
+    case ft_Int:
+      value.set_asInt((int)cell->int_value);
+      break;
+    case ft_Int64:
+      value.set_asInt64(cell->int_value);
+      break;
+    case ft_Double:
+      value.set_asDouble(cell->double_value);
+      break;
+    default:
+      value.set_asString(std::string(cell->str_value, cell->str_len));
+      break;
+  }
+  if (cell->is_null)
+    value.set_isNull();
+  return value;
+}
+
+field_ref sql_record::at(unsigned int i) const {
+  if (i >= count)
+    throw std::out_of_range("sql_record::at");
+  return field_ref(&cells[i]);
+}
+
+void sql_record::set_asString(unsigned int i, const char *s) {
+  set_asString(i, s, strlen(s));
+}
+
+void sql_record::set_asString(unsigned int i, const char *s, size_t len) {
+  field_cell &cell = cells[i];
+  cell.str_value = len ? arena->store(s, len) : "";
+  cell.str_len = len;
+  cell.type = ft_String;
+  cell.is_null = false;
+}
+
+void sql_record::set_asInt(unsigned int i, int value) {
+  field_cell &cell = cells[i];
+  cell.int_value = value;
+  cell.type = ft_Int;
+  cell.is_null = false;
+}
+
+void sql_record::set_asInt64(unsigned int i, int64_t value) {
+  field_cell &cell = cells[i];
+  cell.int_value = value;
+  cell.type = ft_Int64;
+  cell.is_null = false;
+}
+
+void sql_record::set_asDouble(unsigned int i, double value) {
+  field_cell &cell = cells[i];
+  cell.double_value = value;
+  cell.type = ft_Double;
+  cell.is_null = false;
+}
+
+void sql_record::set_isNull(unsigned int i) {
+  field_cell &cell = cells[i];
+  cell.str_value = "";
+  cell.str_len = 0;
+  cell.type = ft_String;
+  cell.is_null = true;
+}
+
+sql_record *result_set::add_record(unsigned int columns) {
+  field_cell *cells = (field_cell *)arena.alloc(columns * sizeof(field_cell));
+  sql_record *record = new (arena.alloc(sizeof(sql_record))) sql_record(cells, columns, &arena);
+  for (unsigned int i = 0; i < columns; i++) {
+    cells[i].str_value = "";
+    cells[i].str_len = 0;
+    cells[i].type = ft_String;
+    cells[i].is_null = false;
+  }
+  records.push_back(record);
+  return record;
+}
+
+} //namespace
@@ -33,6 +33,7 @@
 #include <vector>
 #include <iostream>
 #include <string>
+#include <stddef.h>
 #include <stdint.h>
 
 namespace dbiplus {
@@ -208,14 +209,104 @@ struct field {
 }; 
 
 
+/* Memory for the records of a result set and their strings. It's taken from
+   blocks in turn and only given back all at once, so a query costs a few
+   allocations rather than a few per cell */
+class record_arena {
+public:
+  record_arena();
+  ~record_arena();
+
+/* returns size bytes aligned for any cell */
+  void *alloc(size_t size);
+/* returns a copy of the len bytes at s, zero terminated */
+  const char *store(const char *s, size_t len);
+/* frees everything allocated, the last and largest block is kept for the next query */
+  void clear();
+/* bytes taken by the blocks */
+  size_t capacity() const;
+
+private:
+  record_arena(const record_arena &);
+  record_arena &operator=(const record_arena &);
+
+  std::vector<char*> blocks;  // the last one is being filled
+  std::vector<char*> large;   // allocations too big for a block get their own
+  size_t block_size;          // of the last block
+  size_t used;                // of the last block
+  size_t total;
+};
+
+/* A value in a record: numbers are kept as they are, strings point into the arena */
+struct field_cell {
+  union {
+    int64_t int_value;
+    double double_value;
+    const char *str_value;
+  };
+  unsigned int str_len;
+  unsigned char type;  // fType
+  bool is_null;
+};
+
+/* Read access to a cell with the getters of field_value. It's only valid
+   while the result set it's from is */
+class field_ref {
+public:
+  fType get_fType() const { return (fType)cell->type; }
+  bool get_isNull() const { return cell->is_null; }
+  std::string get_asString() const;
+  bool get_asBool() const;
+  char get_asChar() const;
+  short get_asShort() const;
+  unsigned short get_asUShort() const;
+  int get_asInt() const;
+  unsigned int get_asUInt() const;
+  float get_asFloat() const;
+  double get_asDouble() const;
+  int64_t get_asInt64() const;
+
+/* a copy of the value, for whatever needs one to keep */
+  operator field_value() const;
+
+private:
+  friend class sql_record;
+  explicit field_ref(const field_cell *c) : cell(c) {}
+
+  const field_cell *cell;
+};
+
+/* A row of a result set. Both the record and its cells live in the arena
+   of the result set */
+class sql_record {
+public:
+  unsigned int size() const { return count; }
+  field_ref at(unsigned int i) const;
+  field_ref operator[](unsigned int i) const { return field_ref(&cells[i]); }
+
+  void set_asString(unsigned int i, const char *s);
+  void set_asString(unsigned int i, const char *s, size_t len);
+  void set_asInt(unsigned int i, int value);
+  void set_asInt64(unsigned int i, int64_t value);
+  void set_asDouble(unsigned int i, double value);
+/* the cell is an empty string which is null */
+  void set_isNull(unsigned int i);
+
+private:
+  friend class result_set;
+  sql_record(field_cell *c, unsigned int n, record_arena *a) : cells(c), count(n), arena(a) {}
+
+  field_cell *cells;
+  unsigned int count;
+  record_arena *arena;
+};
+
 typedef std::vector<field> Fields;
-typedef std::vector<field_value> sql_record;
 typedef std::vector<field_prop> record_prop;
 typedef std::vector<sql_record*> query_data;
 typedef field_value variant;
 
 //typedef Fields::iterator fld_itor;
-typedef sql_record::iterator rec_itor;
 typedef record_prop::iterator recprop_itor;
 typedef query_data::iterator qry_itor;
 
@@ -231,15 +322,21 @@ public:
   };
   void clear()
   {
-    for (unsigned int i = 0; i < records.size(); i++)
-      if (records[i])
-        delete records[i];
-    records.clear();
+    clear_records();
     record_header.clear();
   };
+/* drops the records but not the columns */
+  void clear_records()
+  {
+    records.clear();
+    arena.clear();
+  };
+/* appends a record of columns cells, all empty strings */
+  sql_record *add_record(unsigned int columns);
 
   record_prop record_header;
   query_data records;
+  record_arena arena;
 };
 
 } // namespace
@@ -28,6 +28,7 @@
 
 #include <iostream>
 #include <string>
+#include <cstring>
 
 #include "sqlitedataset.h"
 #include "utils/log.h"
@@ -59,22 +60,18 @@ int callback(void* res_ptr,int ncol, char** reslt,char** cols)
 
   if (reslt != NULL)
   {
-    sql_record *rec = new sql_record;
-    rec->resize(ncol);
+    sql_record *rec = r->add_record(ncol);
     for (int i=0; i<ncol; i++)
     { 
-      field_value &v = rec->at(i);
       if (reslt[i] == NULL)
       {
-        v.set_asString("");
-        v.set_isNull();
+        rec->set_isNull(i);
       }
       else
       {
-        v.set_asString(reslt[i]);
+        rec->set_asString(i, reslt[i]);
       }
     }
-    r->records.push_back(rec);
   }
   return 0;  
 }
@@ -258,6 +255,8 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
+  // the connection won't close with statements left
+  clear_statements();
   sqlite3_close(conn);
   active = false;
 }
@@ -322,7 +321,8 @@ int SqliteDatabase::drop_analytics(void) {
   result_set res;
 
   CLog::Log(LOGDEBUG, "Cleaning indexes from database %s at %s", db.c_str(), host.c_str());
-  sprintf(sqlcmd, "SELECT name FROM sqlite_master WHERE type == 'index'");
+  // indexes without sql belong to constraints or virtual tables like fts4, they can't be dropped
+  sprintf(sqlcmd, "SELECT name FROM sqlite_master WHERE type == 'index' AND sql IS NOT NULL");
   if ((last_err = sqlite3_exec(conn, sqlcmd, &callback, &res, NULL)) != SQLITE_OK) return DB_UNEXPECTED_RESULT;
 
   for (size_t i=0; i < res.records.size(); i++) {
@@ -413,6 +413,53 @@ void SqliteDatabase::rollback_transaction() {
 }
 
 
+// methods for prepared statements
+// ---------------------------------------------
+sqlite3_stmt *SqliteDatabase::get_statement(const char *sql) {
+  if (!active) throw DbErrors("No Database Connection");
+
+  map<string, StatementList::iterator>::iterator it = statement_index.find(sql);
+  if (it != statement_index.end()) {
+    sqlite3_stmt *stmt = it->second->second;
+    statements.erase(it->second);
+    statement_index.erase(it);
+    return stmt;
+  }
+
+  sqlite3_stmt *stmt = NULL;
+  if (setErr(sqlite3_prepare_v2(conn, sql, -1, &stmt, NULL), sql) != SQLITE_OK)
+    throw DbErrors(getErrorMsg());
+  return stmt;
+}
+
+void SqliteDatabase::put_statement(sqlite3_stmt *stmt) {
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+
+  // the same statement may have been in use twice at a time
+  string sql = sqlite3_sql(stmt);
+  if (statement_index.find(sql) != statement_index.end()) {
+    sqlite3_finalize(stmt);
+    return;
+  }
+
+  statements.push_front(make_pair(sql, stmt));
+  statement_index[sql] = statements.begin();
+  if (statements.size() > DB_STATEMENT_CACHE) {
+    sqlite3_finalize(statements.back().second);
+    statement_index.erase(statements.back().first);
+    statements.pop_back();
+  }
+}
+
+void SqliteDatabase::clear_statements() {
+  for (StatementList::iterator it = statements.begin(); it != statements.end(); ++it)
+    sqlite3_finalize(it->second);
+  statements.clear();
+  statement_index.clear();
+}
+
+
 // methods for formatting
 // ---------------------------------------------
 string SqliteDatabase::vprepare(const char *format, va_list args)
@@ -452,6 +499,9 @@ SqliteDataset::SqliteDataset():Dataset() {
   db = NULL;
   errmsg = NULL;
   autorefresh = false;
+  cursor = NULL;
+  cursor_rows = 0;
+  streaming = false;
 }
 
 
@@ -460,9 +510,14 @@ SqliteDataset::SqliteDataset(SqliteDatabase *newDb):Dataset(newDb) {
   db = newDb;
   errmsg = NULL;
   autorefresh = false;
+  cursor = NULL;
+  cursor_rows = 0;
+  streaming = false;
 }
 
  SqliteDataset::~SqliteDataset(){
+   // a live statement keeps the database from being closed
+   if (cursor) sqlite3_finalize(cursor);
    if (errmsg) sqlite3_free(errmsg);
  }
 
@@ -475,6 +530,93 @@ void SqliteDataset::set_autorefresh(bool val){
 
 //--------- protected functions implementation -----------------//
 
+static void get_column_value(sqlite3_stmt *stmt, int i, sql_record &rec)
+{
+  switch (sqlite3_column_type(stmt, i))
+  {
+  case SQLITE_INTEGER:
+    rec.set_asInt64(i, sqlite3_column_int64(stmt, i));
+    break;
+  case SQLITE_FLOAT:
+    rec.set_asDouble(i, sqlite3_column_double(stmt, i));
+    break;
+  case SQLITE_TEXT:
+  case SQLITE_BLOB:
+    {
+      // the text first, its length is only known after it's converted
+      const char *text = (const char *)sqlite3_column_text(stmt, i);
+      rec.set_asString(i, text, sqlite3_column_bytes(stmt, i));
+    }
+    break;
+  case SQLITE_NULL:
+  default:
+    rec.set_isNull(i);
+    break;
+  }
+}
+
+static int bind_params(sqlite3_stmt *stmt, const BindParams &params)
+{
+  if ((int)params.size() != sqlite3_bind_parameter_count(stmt))
+    return SQLITE_RANGE;
+
+  int res = SQLITE_OK;
+  for (unsigned int i = 0; i < params.size() && res == SQLITE_OK; i++)
+  {
+    const field_value &v = params[i];
+    if (v.get_isNull())
+    {
+      res = sqlite3_bind_null(stmt, i + 1);
+      continue;
+    }
+    switch (v.get_fType())
+    {
+    case ft_Boolean:
+    case ft_Char:
+    case ft_Short:
+    case ft_UShort:
+    case ft_Int:
+      res = sqlite3_bind_int(stmt, i + 1, v.get_asInt());
+      break;
+    case ft_UInt:
+    case ft_Int64:
+      res = sqlite3_bind_int64(stmt, i + 1, v.get_asInt64());
+      break;
+    case ft_Float:
+    case ft_Double:
+      res = sqlite3_bind_double(stmt, i + 1, v.get_asDouble());
+      break;
+    default:
+      {
+        std::string value = v.get_asString();
+        res = sqlite3_bind_text(stmt, i + 1, value.c_str(), value.size(), SQLITE_TRANSIENT);
+      }
+      break;
+    }
+  }
+  return res;
+}
+
+// reads all rows of a statement, returns the result of the last step
+static int fetch_rows(sqlite3_stmt *stmt, result_set &result)
+{
+  // column headers
+  const unsigned int numColumns = sqlite3_column_count(stmt);
+  result.record_header.resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+    result.record_header[i].name = sqlite3_column_name(stmt, i);
+
+  // returned rows
+  int res;
+  while ((res = sqlite3_step(stmt)) == SQLITE_ROW)
+  { // have a row of data
+    sql_record *rec = result.add_record(numColumns);
+    for (unsigned int i = 0; i < numColumns; i++)
+      get_column_value(stmt, i, *rec);
+  }
+  return res;
+}
+
 sqlite3* SqliteDataset::handle(){
   if (db != NULL){
     return static_cast<SqliteDatabase*>(db)->getHandle();
@@ -651,43 +793,7 @@ bool SqliteDataset::query(const char *query) {
   if (db->setErr(sqlite3_prepare_v2(handle(),query,-1,&stmt, NULL),query) != SQLITE_OK)
     throw DbErrors(db->getErrorMsg());
 
-  // column headers
-  const unsigned int numColumns = sqlite3_column_count(stmt);
-  result.record_header.resize(numColumns);
-  for (unsigned int i = 0; i < numColumns; i++)
-    result.record_header[i].name = sqlite3_column_name(stmt, i);
-
-  // returned rows
-  while (sqlite3_step(stmt) == SQLITE_ROW)
-  { // have a row of data
-    sql_record *res = new sql_record;
-    res->resize(numColumns);
-    for (unsigned int i = 0; i < numColumns; i++)
-    {
-      field_value &v = res->at(i);
-      switch (sqlite3_column_type(stmt, i))
-      {
-      case SQLITE_INTEGER:
-        v.set_asInt64(sqlite3_column_int64(stmt, i));
-        break;
-      case SQLITE_FLOAT:
-        v.set_asDouble(sqlite3_column_double(stmt, i));
-        break;
-      case SQLITE_TEXT:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_BLOB:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_NULL:
-      default:
-        v.set_asString("");
-        v.set_isNull();
-        break;
-      }
-    }
-    result.records.push_back(res);
-  }
+  fetch_rows(stmt, result);
   if (db->setErr(sqlite3_finalize(stmt),query) == SQLITE_OK)
   {
     active = true;
@@ -705,6 +811,129 @@ bool SqliteDataset::query(const string &q){
   return query(q.c_str());
 }
 
+bool SqliteDataset::query_bind(const string &sql, const BindParams &params) {
+  if(!handle()) throw DbErrors("No Database Connection");
+  if (sql.find("select") == string::npos && sql.find("SELECT") == string::npos)
+    throw DbErrors("MUST be select SQL!");
+
+  close();
+
+  SqliteDatabase *sqlite = static_cast<SqliteDatabase*>(db);
+  sqlite3_stmt *stmt = sqlite->get_statement(sql.c_str());
+  int res = bind_params(stmt, params);
+  if (res == SQLITE_OK)
+    res = fetch_rows(stmt, result);
+  sqlite->put_statement(stmt);
+
+  if (db->setErr(res == SQLITE_DONE ? SQLITE_OK : res, sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+
+  active = true;
+  ds_state = dsSelect;
+  this->first();
+  return true;
+}
+
+int SqliteDataset::exec_bind(const string &sql, const BindParams &params) {
+  if (!handle()) throw DbErrors("No Database Connection");
+  exec_res.clear();
+
+  SqliteDatabase *sqlite = static_cast<SqliteDatabase*>(db);
+  sqlite3_stmt *stmt = sqlite->get_statement(sql.c_str());
+  int res = bind_params(stmt, params);
+  if (res == SQLITE_OK)
+    res = fetch_rows(stmt, exec_res);
+  sqlite->put_statement(stmt);
+
+  if (db->setErr(res == SQLITE_DONE ? SQLITE_OK : res, sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+  return SQLITE_OK;
+}
+
+bool SqliteDataset::query_stream(const char *query) {
+    if(!handle()) throw DbErrors("No Database Connection");
+    std::string qry = query;
+    int fs = qry.find("select");
+    int fS = qry.find("SELECT");
+    if (!( fs >= 0 || fS >=0))                                 
+         throw DbErrors("MUST be select SQL!"); 
+
+  close();
+
+  if (db->setErr(sqlite3_prepare_v2(handle(),query,-1,&cursor, NULL),query) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+
+  // column headers
+  const unsigned int numColumns = sqlite3_column_count(cursor);
+  result.record_header.resize(numColumns);
+  fields_object->resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    result.record_header[i].name = sqlite3_column_name(cursor, i);
+    (*fields_object)[i].props = result.record_header[i];
+  }
+
+  // the one row kept is the current one
+  result.add_record(numColumns);
+  cursor_decoded.assign(numColumns, false);
+  cursor_rows = 0;
+  streaming = true;
+
+  active = true;
+  ds_state = dsSelect;
+  frecno = 0;
+  step_cursor();
+  fbof = true;
+  return true;
+}
+
+void SqliteDataset::step_cursor() {
+  if (!cursor) {
+    feof = true;
+    return;
+  }
+
+  int res = sqlite3_step(cursor);
+  if (res == SQLITE_ROW) {
+    cursor_rows++;
+    // the strings of the last row go with it
+    result.clear_records();
+    result.add_record(cursor_decoded.size());
+    cursor_decoded.assign(cursor_decoded.size(), false);
+    feof = false;
+    return;
+  }
+
+  // done or failed, the statement isn't needed either way
+  std::string qry = sqlite3_sql(cursor);
+  res = sqlite3_finalize(cursor);
+  cursor = NULL;
+  feof = true;
+  if (db->setErr(res, qry.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+}
+
+int SqliteDataset::column_index(const char *f_name) {
+  // same matching as Dataset::get_field_value, with or without the table name
+  const char* name=strstr(f_name, ".");
+  if (name) name++;
+  for (unsigned int i=0; i < result.record_header.size(); i++)
+    if (str_compare(result.record_header[i].name.c_str(), f_name)==0 || (name && str_compare(result.record_header[i].name.c_str(), name)==0))
+      return i;
+  throw DbErrors("Field not found: %s",f_name);
+}
+
+field_ref SqliteDataset::cursor_value(int index) {
+  sql_record &row = *result.records[0];
+  if (index < 0 || index >= (int)row.size())
+    throw DbErrors("Field index not found: %d",index);
+  if (cursor && !cursor_decoded[index]) {
+    get_column_value(cursor, index, row);
+    cursor_decoded[index] = true;
+  }
+  return row[index];
+}
+
 void SqliteDataset::open(const string &sql) {
   set_select_sql(sql);
   open();
@@ -722,6 +951,13 @@ void SqliteDataset::open() {
 
 void SqliteDataset::close() {
   Dataset::close();
+  if (cursor) {
+    sqlite3_finalize(cursor);
+    cursor = NULL;
+  }
+  streaming = false;
+  cursor_rows = 0;
+  cursor_decoded.clear();
   result.clear();
   edit_object->clear();
   fields_object->clear();
@@ -741,6 +977,8 @@ void SqliteDataset::cancel() {
 
 
 int SqliteDataset::num_rows() {
+  if (streaming)
+    return cursor_rows;
   return result.records.size();
 }
 
@@ -756,21 +994,35 @@ bool SqliteDataset::bof() {
 
 
 void SqliteDataset::first() {
+  if (streaming) {
+    // already there unless moved on
+    if (!fbof) throw DbErrors("Can't go back in a forward only query");
+    return;
+  }
   Dataset::first();
   this->fill_fields();
 }
 
 void SqliteDataset::last() {
+  if (streaming) throw DbErrors("Can't go to the last row of a forward only query");
   Dataset::last();
   fill_fields();
 }
 
 void SqliteDataset::prev(void) {
+  if (streaming) throw DbErrors("Can't go back in a forward only query");
   Dataset::prev();
   fill_fields();
 }
 
 void SqliteDataset::next(void) {
+  if (streaming) {
+    if (ds_state == dsSelect) {
+      fbof = false;
+      step_cursor();
+    }
+    return;
+  }
   Dataset::next();
   if (!eof()) 
       fill_fields();
@@ -778,18 +1030,11 @@ void SqliteDataset::next(void) {
 
 void SqliteDataset::free_row(void)
 {
-  if (frecno < 0 || (unsigned int)frecno >= result.records.size())
-    return;
-
-  sql_record *row = result.records[frecno];
-  if (row)
-  {
-    delete row;
-    result.records[frecno] = NULL;
-  }
+  // rows live in the arena of the result set and go all at once with it
 }
 
 bool SqliteDataset::seek(int pos) {
+  if (streaming) throw DbErrors("Can't seek in a forward only query");
   if (ds_state == dsSelect) {
     Dataset::seek(pos);
     fill_fields();
@@ -798,6 +1043,28 @@ bool SqliteDataset::seek(int pos) {
   return false;
 }
 
+const field_value SqliteDataset::get_field_value(const char *f_name) {
+  if (streaming && ds_state == dsSelect)
+    return cursor_value(column_index(f_name));
+  return Dataset::get_field_value(f_name);
+}
+
+const field_value SqliteDataset::get_field_value(int index) {
+  if (streaming && ds_state == dsSelect)
+    return cursor_value(index);
+  return Dataset::get_field_value(index);
+}
+
+const sql_record* const SqliteDataset::get_sql_record() {
+  if (streaming) {
+    if (!cursor)
+      return NULL;
+    for (unsigned int i = 0; i < cursor_decoded.size(); i++)
+      cursor_value(i);
+  }
+  return Dataset::get_sql_record();
+}
+
 int64_t SqliteDataset::lastinsertid()
 {
   if(!handle()) throw DbErrors("No Database Connection");
@@ -46,6 +46,11 @@ protected:
   bool _in_transaction;
   int last_err;
 
+/* statements given back by put_statement, most recently used first */
+  typedef std::list<std::pair<std::string, sqlite3_stmt*> > StatementList;
+  StatementList statements;
+  std::map<std::string, StatementList::iterator> statement_index;
+
 public:
 /* default constructor */
   SqliteDatabase();
@@ -97,6 +102,14 @@ public:
 
   bool in_transaction() {return _in_transaction;}; 	
 
+/* func. returns the compiled statement for sql, taken from the cache if it's there.
+   It stays out of the cache until given back by put_statement() */
+  sqlite3_stmt *get_statement(const char *sql);
+/* func. resets a statement from get_statement() and keeps it for the next one */
+  void put_statement(sqlite3_stmt *stmt);
+/* func. finalizes all statements kept */
+  void clear_statements();
+
 };
 
 
@@ -128,6 +141,17 @@ protected:
 /* Changing field values during dataset navigation */
   virtual void free_row();  // free the memory allocated for the current row
 
+/* Forward only queries: the statement stays live and the current row
+   is decoded from it as its values are asked for */
+  sqlite3_stmt *cursor;
+  int cursor_rows;                    // rows stepped to so far
+  std::vector<bool> cursor_decoded;   // columns of the current row in result.records[0]
+  bool streaming;
+
+  void step_cursor();
+  int column_index(const char *f_name);
+  field_ref cursor_value(int index);
+
 public:
 /* constructor */
   SqliteDataset();
@@ -150,6 +174,11 @@ or insert() operations default = false) */
 /* as open, but with our query exept Sql */
   virtual bool query(const char *query);
   virtual bool query(const std::string &query);
+/* as query, but forward only, see Dataset::query_stream */
+  virtual bool query_stream(const char *query);
+/* as query and exec, but with cached statements, see Dataset::query_bind */
+  virtual bool query_bind(const std::string &sql, const BindParams &params);
+  virtual int  exec_bind(const std::string &sql, const BindParams &params);
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
@@ -172,6 +201,10 @@ or insert() operations default = false) */
 /* Go to record No (starting with 0) */
   virtual bool seek(int pos=0);
 
+  virtual const field_value get_field_value(const char *f_name);
+  virtual const field_value get_field_value(int index);
+  virtual const sql_record* const get_sql_record();
+
   virtual bool dropIndex(const char *table, const char *index);
 };
 } //namespace
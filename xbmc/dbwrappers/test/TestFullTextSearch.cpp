@@ -0,0 +1,285 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/FullTextSearch.h"
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "music/MusicSearchIndex.h"
+#include "test/TestUtils.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "video/VideoSearchIndex.h"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <set>
+
+using namespace dbiplus;
+
+static const FullTextIndex &songs = MusicSearchIndexes[MUSICSEARCH_SONGS];
+static const FullTextIndex &movies = VideoSearchIndexes[VIDEOSEARCH_MOVIES];
+
+// the music tables, with the columns the search tables are filled from
+class TestFullTextSearch : public testing::Test
+{
+protected:
+  TestFullTextSearch()
+  {
+    m_file = XBMC_CREATETEMPFILE(".db");
+    std::string path = XBMC_TEMPFILEPATH(m_file);
+    m_db.setHostName(URIUtils::GetDirectory(path).c_str());
+    m_db.setDatabase(URIUtils::GetFileName(path).c_str());
+    if (m_db.connect(true) != DB_CONNECTION_OK)
+      return;
+
+    m_ds.reset(m_db.CreateDataset());
+    m_ds->exec("CREATE TABLE artist (idArtist integer primary key, strArtist varchar(256), strGenres text)");
+    m_ds->exec("CREATE TABLE album (idAlbum integer primary key, strAlbum varchar(256), strArtists text, strGenres text)");
+    m_ds->exec("CREATE TABLE song (idSong integer primary key, idAlbum integer, strTitle varchar(512), strArtists text, strGenres text, iTimesPlayed integer)");
+    for (int i = 0; i < MUSICSEARCH_COUNT; i++)
+      CFullTextSearch::CreateTable(*m_ds, true, MusicSearchIndexes[i]);
+  }
+
+  ~TestFullTextSearch()
+  {
+    m_ds.reset();
+    m_db.disconnect();
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  void CreateTriggers()
+  {
+    CFullTextSearch::CreateTriggers(*m_ds, true, MusicSearchIndexes, MUSICSEARCH_COUNT);
+  }
+
+  void AddSongs()
+  {
+    m_ds->exec("INSERT INTO album VALUES (1, 'Help!', 'The Beatles', 'Rock')");
+    m_ds->exec("INSERT INTO album VALUES (2, 'Élan vital', 'Fünf Sterne', 'Pop')");
+    m_ds->exec("INSERT INTO song VALUES (1, 1, 'Help!', 'The Beatles', 'Rock', 0)");
+    m_ds->exec("INSERT INTO song VALUES (2, 1, 'You''re Going to Lose That Girl', 'The Beatles', 'Rock', 0)");
+    m_ds->exec("INSERT INTO song VALUES (3, 1, 'Helping Hands', 'The Beatles', 'Rock', 0)");
+    m_ds->exec("INSERT INTO song VALUES (4, 2, 'Cry for Help', 'Fünf Sterne', 'Pop', 0)");
+    m_ds->exec("INSERT INTO song VALUES (5, 2, 'Über alles', 'Fünf Sterne', 'Pop', 0)");
+    m_ds->exec("INSERT INTO song VALUES (6, 2, 'help', 'Fünf Sterne', 'Pop', 0)");
+    m_ds->exec("INSERT INTO song VALUES (7, 2, 'Rock-a-bye help me', 'Fünf Sterne', 'Pop', 0)");
+    m_ds->exec("INSERT INTO song VALUES (8, NULL, 'Helpless', NULL, NULL, 0)");
+  }
+
+  std::string GetColumn(const FullTextIndex &index, int id, const char *column)
+  {
+    std::string value;
+    if (m_ds->query(m_db.prepare("SELECT %s FROM %s WHERE docid = %i", column, index.table, id).c_str()) && !m_ds->eof())
+      value = m_ds->fv(0).get_asString();
+    m_ds->close();
+    return value;
+  }
+
+  std::set<int> GetIds(const std::string &sql)
+  {
+    std::set<int> ids;
+    EXPECT_TRUE(m_ds->query(sql.c_str()));
+    for (; !m_ds->eof(); m_ds->next())
+      ids.insert(m_ds->fv(0).get_asInt());
+    m_ds->close();
+    return ids;
+  }
+
+  XFILE::CFile *m_file;
+  SqliteDatabase m_db;
+  std::auto_ptr<Dataset> m_ds;
+};
+
+TEST(TestFullTextSearchMatch, Sqlite)
+{
+  EXPECT_EQ("\"love me*\"", CFullTextSearch::GetMatch("Love Me", true, true, true));
+  EXPECT_EQ("love* me*", CFullTextSearch::GetMatch("Love Me", true, false, true));
+  EXPECT_EQ("don* t* stop*", CFullTextSearch::GetMatch("don't stop!", true, false, true));
+  EXPECT_EQ("rock* a* bye*", CFullTextSearch::GetMatch("rock_a-bye", true, false, false));
+  EXPECT_EQ("\xc3\x9c" "ber*", CFullTextSearch::GetMatch("\xc3\x9c" "ber", true, false, true));
+  EXPECT_EQ("", CFullTextSearch::GetMatch(" - ", true, false, true));
+}
+
+TEST(TestFullTextSearchMatch, MySQL)
+{
+  EXPECT_EQ("+love* +song*", CFullTextSearch::GetMatch("Love song", false, true, true));
+  // short words aren't indexed, so they're left to the LIKE conditions
+  EXPECT_EQ("+love*", CFullTextSearch::GetMatch("love me", false, false, false));
+  EXPECT_EQ("", CFullTextSearch::GetMatch("love me", false, false, true));
+  // a multibyte character counts once
+  EXPECT_EQ("+\xc3\xa9l\xc3\xa9" "a*", CFullTextSearch::GetMatch("\xc3\xa9l\xc3\xa9" "a", false, false, true));
+  EXPECT_EQ("", CFullTextSearch::GetMatch("\xc3\xa9l\xc3\xa9", false, false, true));
+  // stopwords aren't indexed, neither are the words starting with "abou" then
+  EXPECT_EQ("+love*", CFullTextSearch::GetMatch("love without", false, false, false));
+  EXPECT_EQ("", CFullTextSearch::GetMatch("abou", false, false, true));
+  EXPECT_EQ("+aboutique*", CFullTextSearch::GetMatch("aboutique", false, false, true));
+  // MySQL keeps apostrophes and underscores in words
+  EXPECT_EQ("", CFullTextSearch::GetMatch("o'connor", false, false, false));
+  EXPECT_EQ("", CFullTextSearch::GetMatch("rock_and_roll", false, false, false));
+}
+
+TEST_F(TestFullTextSearch, Triggers)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  CreateTriggers();
+  AddSongs();
+  m_ds->exec("INSERT INTO artist VALUES (1, 'The Beatles', 'Rock')");
+
+  EXPECT_EQ("The Beatles", GetColumn(MusicSearchIndexes[MUSICSEARCH_ARTISTS], 1, "strArtist"));
+  EXPECT_EQ("Help!", GetColumn(MusicSearchIndexes[MUSICSEARCH_ALBUMS], 1, "strAlbum"));
+  EXPECT_EQ("Cry for Help", GetColumn(songs, 4, "strTitle"));
+  EXPECT_EQ("Élan vital", GetColumn(songs, 4, "strAlbum"));
+
+  m_ds->exec("UPDATE song SET strTitle = 'Cry for Love' WHERE idSong = 4");
+  EXPECT_EQ("Cry for Love", GetColumn(songs, 4, "strTitle"));
+  m_ds->exec("UPDATE song SET idAlbum = 1 WHERE idSong = 4");
+  EXPECT_EQ("Help!", GetColumn(songs, 4, "strAlbum"));
+
+  // updates of other columns leave the search tables alone
+  m_ds->exec("UPDATE songsearch SET strTitle = 'stale' WHERE docid = 4");
+  m_ds->exec("UPDATE song SET iTimesPlayed = iTimesPlayed + 1");
+  EXPECT_EQ("stale", GetColumn(songs, 4, "strTitle"));
+
+  // renaming an album renames it in its songs
+  m_ds->exec("UPDATE album SET strAlbum = 'Help! (Remastered)' WHERE idAlbum = 1");
+  EXPECT_EQ("Help! (Remastered)", GetColumn(MusicSearchIndexes[MUSICSEARCH_ALBUMS], 1, "strAlbum"));
+  EXPECT_EQ("Help! (Remastered)", GetColumn(songs, 1, "strAlbum"));
+  EXPECT_EQ("Help! (Remastered)", GetColumn(songs, 4, "strAlbum"));
+  EXPECT_EQ("Élan vital", GetColumn(songs, 5, "strAlbum"));
+
+  m_ds->exec("DELETE FROM song WHERE idSong = 4");
+  m_ds->exec("DELETE FROM artist");
+  EXPECT_EQ(std::set<int>(), GetIds("SELECT docid FROM songsearch WHERE docid = 4"));
+  EXPECT_EQ(std::set<int>(), GetIds("SELECT docid FROM artistsearch"));
+}
+
+TEST_F(TestFullTextSearch, Fill)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  AddSongs();
+  for (int i = 0; i < MUSICSEARCH_COUNT; i++)
+    CFullTextSearch::Fill(*m_ds, MusicSearchIndexes[i]);
+
+  EXPECT_EQ(8U, GetIds("SELECT docid FROM songsearch").size());
+  EXPECT_EQ("Élan vital", GetColumn(songs, 5, "strAlbum"));
+  EXPECT_EQ("", GetColumn(songs, 8, "strAlbum"));
+}
+
+TEST_F(TestFullTextSearch, FilterKeepsLikeMatches)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  CreateTriggers();
+  AddSongs();
+
+  const char *searches[] = { "help", "Help!", "hel", "cry for", "lose that", "über", "rock-a", "you're", "a" };
+  for (size_t i = 0; i < sizeof(searches) / sizeof(searches[0]); i++)
+  {
+    const char *search = searches[i];
+    std::string like = m_db.prepare("(strTitle LIKE '%s%%' OR strTitle LIKE '%% %s%%')", search, search);
+    std::set<int> expected = GetIds("SELECT idSong FROM song WHERE " + like);
+    std::string filter = CFullTextSearch::GetFilter(m_db, true, songs, search, true, false);
+    ASSERT_FALSE(filter.empty()) << search;
+    EXPECT_EQ(expected, GetIds("SELECT idSong FROM song WHERE " + filter + " AND " + like)) << search;
+  }
+}
+
+TEST_F(TestFullTextSearch, RankedQuery)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  CreateTriggers();
+  AddSongs();
+
+  int expected[] = { 6, 1, 3, 8, 4, 7, 2 };
+  std::string sql = CFullTextSearch::GetRankedQuery(m_db, true, songs, "help", true) + " ORDER BY iRank, strTitle";
+  ASSERT_TRUE(m_ds->query(sql.c_str()));
+  ASSERT_EQ((int)(sizeof(expected) / sizeof(expected[0])), m_ds->num_rows());
+  for (int i = 0; !m_ds->eof(); m_ds->next(), i++)
+    EXPECT_EQ(expected[i], m_ds->fv(0).get_asInt()) << i;
+  m_ds->close();
+
+  // other columns match too, every word has to
+  EXPECT_EQ(std::set<int>(), GetIds(CFullTextSearch::GetRankedQuery(m_db, true, songs, "help sterne beatles", true)));
+  std::set<int> found = GetIds(CFullTextSearch::GetRankedQuery(m_db, true, songs, "beatles", true));
+  EXPECT_EQ(3U, found.size());
+  EXPECT_EQ(0U, GetIds(CFullTextSearch::GetRankedQuery(m_db, true, songs, "beatles", false)).size());
+}
+
+TEST_F(TestFullTextSearch, VideoCast)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  m_ds->exec("CREATE TABLE movie (idMovie integer primary key, c00 text, c01 text, c02 text, c03 text)");
+  m_ds->exec("CREATE TABLE actors (idActor integer primary key, strActor text, strThumb text)");
+  m_ds->exec("CREATE TABLE actorlinkmovie (idActor integer, idMovie integer, strRole text, iOrder integer)");
+  m_ds->exec("CREATE TABLE tvshow (idShow integer primary key, c00 text, c01 text)");
+  m_ds->exec("CREATE TABLE actorlinktvshow (idActor integer, idShow integer, strRole text, iOrder integer)");
+  m_ds->exec("CREATE TABLE episode (idEpisode integer primary key, c00 text, c01 text)");
+  m_ds->exec("CREATE TABLE actorlinkepisode (idActor integer, idEpisode integer, strRole text, iOrder integer)");
+  m_ds->exec("CREATE TABLE musicvideo (idMVideo integer primary key, c00 text, c08 text)");
+  m_ds->exec("CREATE TABLE artistlinkmusicvideo (idArtist integer, idMVideo integer)");
+  for (int i = 0; i < VIDEOSEARCH_COUNT; i++)
+    CFullTextSearch::CreateTable(*m_ds, true, VideoSearchIndexes[i]);
+  CFullTextSearch::CreateTriggers(*m_ds, true, VideoSearchIndexes, VIDEOSEARCH_COUNT);
+
+  m_ds->exec("INSERT INTO movie VALUES (1, 'Alien', 'In space no one can hear you scream.', NULL, NULL)");
+  m_ds->exec("INSERT INTO movie VALUES (2, 'Aliens', 'This time it''s war.', 'Ripley returns', 'Something''s out there')");
+  m_ds->exec("INSERT INTO musicvideo VALUES (1, 'Space Oddity', 'Ground control to major Tom')");
+  m_ds->exec("INSERT INTO actors VALUES (1, 'Sigourney Weaver', NULL)");
+  m_ds->exec("INSERT INTO actors VALUES (2, 'John Hurt', NULL)");
+  m_ds->exec("INSERT INTO actors VALUES (3, 'David Bowie', NULL)");
+  m_ds->exec("INSERT INTO actorlinkmovie VALUES (1, 1, 'Ripley', 0)");
+  m_ds->exec("INSERT INTO actorlinkmovie VALUES (2, 1, 'Kane', 1)");
+  m_ds->exec("INSERT INTO actorlinkmovie VALUES (1, 2, 'Ripley', 0)");
+  m_ds->exec("INSERT INTO artistlinkmusicvideo VALUES (3, 1)");
+
+  EXPECT_EQ("Sigourney Weaver,John Hurt", GetColumn(movies, 1, "strCast"));
+  EXPECT_EQ("David Bowie", GetColumn(VideoSearchIndexes[VIDEOSEARCH_MUSICVIDEOS], 1, "strCast"));
+
+  // renaming an actor renames them in the cast of every movie
+  m_ds->exec("UPDATE actors SET strActor = 'S. Weaver' WHERE idActor = 1");
+  EXPECT_EQ("S. Weaver,John Hurt", GetColumn(movies, 1, "strCast"));
+  EXPECT_EQ("S. Weaver", GetColumn(movies, 2, "strCast"));
+
+  m_ds->exec("DELETE FROM actorlinkmovie WHERE idActor = 2");
+  EXPECT_EQ("S. Weaver", GetColumn(movies, 1, "strCast"));
+
+  // titles, plots and the cast are searched
+  int expected[] = { 1, 2 };
+  EXPECT_EQ(std::set<int>(expected, expected + 2), GetIds(CFullTextSearch::GetRankedQuery(m_db, true, movies, "weaver", true)));
+  EXPECT_EQ(std::set<int>(expected, expected + 1), GetIds(CFullTextSearch::GetRankedQuery(m_db, true, movies, "space scream", true)));
+  EXPECT_EQ(std::set<int>(expected, expected + 2), GetIds(CFullTextSearch::GetRankedQuery(m_db, true, movies, "alien", true)));
+
+  // the searches of the library narrow down their LIKE conditions with the index
+  const char *searches[] = { "alien", "space scream", "ripley", "there", "it's war", "lien" };
+  for (size_t i = 0; i < sizeof(searches) / sizeof(searches[0]); i++)
+  {
+    const char *search = searches[i];
+    std::string like = m_db.prepare("(c00 LIKE '%s%%' OR c00 LIKE '%% %s%%' OR c01 LIKE '%s%%' OR c01 LIKE '%% %s%%' OR "
+                                    "c02 LIKE '%s%%' OR c02 LIKE '%% %s%%' OR c03 LIKE '%s%%' OR c03 LIKE '%% %s%%')",
+                                    search, search, search, search, search, search, search, search);
+    std::set<int> expected = GetIds("SELECT idMovie FROM movie WHERE " + like);
+    std::string filter = CFullTextSearch::GetFilter(m_db, true, movies, search, true, false);
+    ASSERT_FALSE(filter.empty()) << search;
+    EXPECT_EQ(expected, GetIds("SELECT idMovie FROM movie WHERE " + filter + " AND " + like)) << search;
+  }
+
+  m_ds->exec("DELETE FROM movie WHERE idMovie = 2");
+  EXPECT_EQ(std::set<int>(expected, expected + 1), GetIds("SELECT docid FROM moviesearch"));
+}
@@ -0,0 +1,285 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <stdexcept>
+
+using namespace dbiplus;
+
+static const int rows = 1000;
+
+class TestSqliteDataset : public testing::Test
+{
+protected:
+  TestSqliteDataset()
+  {
+    m_file = XBMC_CREATETEMPFILE(".db");
+    std::string path = XBMC_TEMPFILEPATH(m_file);
+    m_db.setHostName(URIUtils::GetDirectory(path).c_str());
+    m_db.setDatabase(URIUtils::GetFileName(path).c_str());
+    if (m_db.connect(true) != DB_CONNECTION_OK)
+      return;
+
+    m_ds.reset(m_db.CreateDataset());
+    m_ds->exec("CREATE TABLE song (idSong integer primary key, strTitle text, fRating float, strComment text)");
+    m_db.start_transaction();
+    for (int i = 0; i < rows; i++)
+    {
+      if (i % 3)
+        m_ds->exec(m_db.prepare("INSERT INTO song VALUES (%i, 'title %i', %i.5, 'comment')", i, i, i));
+      else
+        m_ds->exec(m_db.prepare("INSERT INTO song VALUES (%i, 'title %i', %i.5, NULL)", i, i, i));
+    }
+    m_db.commit_transaction();
+  }
+
+  ~TestSqliteDataset()
+  {
+    m_ds.reset();
+    m_db.disconnect();
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  XFILE::CFile *m_file;
+  SqliteDatabase m_db;
+  std::auto_ptr<Dataset> m_ds;
+};
+
+TEST_F(TestSqliteDataset, QueryStream)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  ASSERT_TRUE(m_ds->query_stream("SELECT * FROM song ORDER BY idSong"));
+
+  int row = 0;
+  for (; !m_ds->eof(); m_ds->next(), row++)
+  {
+    EXPECT_EQ(row + 1, m_ds->num_rows());
+    EXPECT_EQ(row, m_ds->fv("idSong").get_asInt());
+    EXPECT_EQ(StringUtils::Format("title %i", row), m_ds->fv(1).get_asString());
+
+    // columns not asked for by name are decoded with the record
+    const sql_record *record = m_ds->get_sql_record();
+    ASSERT_TRUE(record != NULL);
+    ASSERT_EQ(4U, record->size());
+    EXPECT_EQ(row, record->at(0).get_asInt());
+    EXPECT_DOUBLE_EQ(row + 0.5, record->at(2).get_asDouble());
+    EXPECT_EQ(row % 3 == 0, record->at(3).get_isNull());
+    EXPECT_EQ(row % 3 ? "comment" : "", m_ds->fv("song.strComment").get_asString());
+  }
+  EXPECT_EQ(rows, row);
+  EXPECT_TRUE(m_ds->get_sql_record() == NULL);
+
+  // the statement is gone once all rows are read
+  EXPECT_TRUE(sqlite3_next_stmt(m_db.getHandle(), NULL) == NULL);
+  m_ds->close();
+}
+
+TEST_F(TestSqliteDataset, QueryStreamMatchesQuery)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  std::auto_ptr<Dataset> all(m_db.CreateDataset());
+  ASSERT_TRUE(all->query("SELECT idSong, strTitle, strComment FROM song WHERE idSong % 7 = 1"));
+  ASSERT_TRUE(m_ds->query_stream("SELECT idSong, strTitle, strComment FROM song WHERE idSong % 7 = 1"));
+
+  for (; !all->eof(); all->next(), m_ds->next())
+  {
+    ASSERT_FALSE(m_ds->eof());
+    const sql_record *expected = all->get_sql_record();
+    const sql_record *record = m_ds->get_sql_record();
+    for (unsigned int i = 0; i < expected->size(); i++)
+    {
+      EXPECT_EQ(expected->at(i).get_asString(), record->at(i).get_asString());
+      EXPECT_EQ(expected->at(i).get_isNull(), record->at(i).get_isNull());
+    }
+  }
+  EXPECT_TRUE(m_ds->eof());
+  EXPECT_EQ(all->num_rows(), m_ds->num_rows());
+}
+
+TEST_F(TestSqliteDataset, QueryStreamEmpty)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  ASSERT_TRUE(m_ds->query_stream("SELECT * FROM song WHERE idSong < 0"));
+  EXPECT_TRUE(m_ds->eof());
+  EXPECT_EQ(0, m_ds->num_rows());
+  EXPECT_TRUE(m_ds->get_sql_record() == NULL);
+  EXPECT_EQ(4, m_ds->fieldCount());
+  m_ds->close();
+}
+
+TEST_F(TestSqliteDataset, QueryStreamForwardOnly)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  ASSERT_TRUE(m_ds->query_stream("SELECT * FROM song"));
+  m_ds->first();
+  m_ds->next();
+  EXPECT_THROW(m_ds->prev(), DbErrors);
+  EXPECT_THROW(m_ds->first(), DbErrors);
+  EXPECT_THROW(m_ds->seek(0), DbErrors);
+  EXPECT_THROW(m_ds->fv("strMissing"), DbErrors);
+
+  // closing half way finalizes the statement, the dataset can be used again
+  m_ds->close();
+  EXPECT_TRUE(sqlite3_next_stmt(m_db.getHandle(), NULL) == NULL);
+  ASSERT_TRUE(m_ds->query("SELECT * FROM song"));
+  EXPECT_EQ(rows, m_ds->num_rows());
+  m_ds->last();
+  EXPECT_EQ(rows - 1, m_ds->fv(0).get_asInt());
+  m_ds->close();
+}
+
+static int CountStatements(sqlite3 *handle)
+{
+  int count = 0;
+  for (sqlite3_stmt *stmt = sqlite3_next_stmt(handle, NULL); stmt; stmt = sqlite3_next_stmt(handle, stmt))
+    count++;
+  return count;
+}
+
+TEST_F(TestSqliteDataset, QueryBind)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  std::auto_ptr<Dataset> all(m_db.CreateDataset());
+  for (int i = 0; i < 10; i++)
+  {
+    ASSERT_TRUE(all->query(m_db.prepare("SELECT * FROM song WHERE idSong > %i AND strTitle < '%s'", i * 50, "title 7").c_str()));
+    ASSERT_TRUE(m_ds->query_bind("SELECT * FROM song WHERE idSong > ? AND strTitle < ?", BindParams().add(i * 50).add("title 7")));
+    ASSERT_EQ(all->num_rows(), m_ds->num_rows());
+    for (; !all->eof(); all->next(), m_ds->next())
+    {
+      EXPECT_EQ(all->fv("idSong").get_asInt(), m_ds->fv("song.idSong").get_asInt());
+      EXPECT_EQ(all->fv(3).get_isNull(), m_ds->fv(3).get_isNull());
+    }
+  }
+
+  // compiled once and kept
+  EXPECT_EQ(1, CountStatements(m_db.getHandle()));
+  m_ds->close();
+}
+
+TEST_F(TestSqliteDataset, ExecBind)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  const std::string title = "it's a 'quoted' title?";
+  m_ds->exec_bind("INSERT INTO song (idSong, strTitle, fRating, strComment) VALUES (?, ?, ?, ?)",
+                  BindParams().add(rows).add(title).add(0.25).add_null());
+
+  ASSERT_TRUE(m_ds->query_bind("SELECT * FROM song WHERE strTitle=?", BindParams().add(title)));
+  ASSERT_EQ(1, m_ds->num_rows());
+  EXPECT_EQ(rows, m_ds->fv("idSong").get_asInt());
+  EXPECT_DOUBLE_EQ(0.25, m_ds->fv("fRating").get_asDouble());
+  EXPECT_TRUE(m_ds->fv("strComment").get_isNull());
+
+  m_ds->exec_bind("DELETE FROM song WHERE idSong >= ?", BindParams().add((int64_t)rows / 2));
+  ASSERT_TRUE(m_ds->query("SELECT * FROM song"));
+  EXPECT_EQ(rows / 2, m_ds->num_rows());
+
+  EXPECT_THROW(m_ds->exec_bind("DELETE FROM song WHERE idSong = ?", BindParams()), DbErrors);
+  EXPECT_THROW(m_ds->query_bind("SELECT * FROM song WHERE idSong = ?", BindParams().add(1).add(2)), DbErrors);
+  EXPECT_THROW(m_ds->query_bind("SELECT * FROM nosuchtable WHERE id = ?", BindParams().add(1)), DbErrors);
+  m_ds->close();
+}
+
+TEST_F(TestSqliteDataset, StatementCache)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  std::auto_ptr<Dataset> other(m_db.CreateDataset());
+
+  // the least recently used statements go once the cache is full
+  for (int i = 0; i < DB_STATEMENT_CACHE + 10; i++)
+    ASSERT_TRUE(m_ds->query_bind(StringUtils::Format("SELECT %i, strTitle FROM song WHERE idSong=?", i), BindParams().add(i)));
+  EXPECT_EQ(DB_STATEMENT_CACHE, CountStatements(m_db.getHandle()));
+
+  // a statement reused from the cache gives the same results
+  for (int i = DB_STATEMENT_CACHE + 9; i >= 10; i--)
+  {
+    ASSERT_TRUE(other->query_bind(StringUtils::Format("SELECT %i, strTitle FROM song WHERE idSong=?", i), BindParams().add(i + 1)));
+    ASSERT_EQ(1, other->num_rows());
+    EXPECT_EQ(i, other->fv(0).get_asInt());
+    EXPECT_EQ(StringUtils::Format("title %i", i + 1), other->fv(1).get_asString());
+  }
+  EXPECT_EQ(DB_STATEMENT_CACHE, CountStatements(m_db.getHandle()));
+
+  // closing the connection finalizes them all
+  m_ds->close();
+  other->close();
+  m_db.disconnect();
+  EXPECT_FALSE(m_db.isActive());
+}
+
+TEST_F(TestSqliteDataset, ArenaRecords)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  const std::string large(100000, 'x');
+  m_ds->exec_bind("INSERT INTO song (idSong, strTitle, fRating, strComment) VALUES (?, ?, ?, ?)",
+                  BindParams().add(rows).add(large).add(1.25).add(""));
+
+  ASSERT_TRUE(m_ds->query("SELECT * FROM song ORDER BY idSong"));
+  ASSERT_EQ(rows + 1, m_ds->num_rows());
+  const query_data &data = m_ds->get_result_set().records;
+  for (int i = 0; i < rows; i++)
+  {
+    EXPECT_EQ(i, data[i]->at(0).get_asInt());
+    EXPECT_EQ(StringUtils::Format("title %i", i), data[i]->at(1).get_asString());
+    EXPECT_EQ(i % 3 == 0, data[i]->at(3).get_isNull());
+  }
+
+  // strings too large for a block and empty ones
+  const sql_record &last = *data[rows];
+  EXPECT_EQ(large, last.at(1).get_asString());
+  EXPECT_DOUBLE_EQ(1.25, last.at(2).get_asDouble());
+  EXPECT_FALSE(last.at(3).get_isNull());
+  EXPECT_EQ("", last.at(3).get_asString());
+  field_value copy = last.at(1);
+  EXPECT_EQ(large, copy.get_asString());
+  EXPECT_THROW(last.at(4), std::out_of_range);
+
+  // the arena is reused by the next query rather than grown
+  size_t capacity = m_ds->get_result_set().arena.capacity();
+  for (int i = 0; i < 5; i++)
+    ASSERT_TRUE(m_ds->query("SELECT * FROM song WHERE idSong < 1000 ORDER BY idSong"));
+  EXPECT_LE(m_ds->get_result_set().arena.capacity(), capacity);
+  EXPECT_EQ(rows, m_ds->num_rows());
+  m_ds->close();
+}
+
+TEST_F(TestSqliteDataset, DropAnalyticsKeepsFullTextTables)
+{
+  ASSERT_TRUE(m_ds.get() != NULL);
+  m_ds->exec("CREATE INDEX idxSong ON song (strTitle)");
+  m_ds->exec("CREATE VIRTUAL TABLE songsearch USING fts4(strTitle)");
+  m_ds->exec("INSERT INTO songsearch (docid, strTitle) SELECT idSong, strTitle FROM song");
+
+  // fts4 comes with an index of its own which can't be dropped
+  EXPECT_EQ(DB_COMMAND_OK, m_db.drop_analytics());
+  ASSERT_TRUE(m_ds->query("SELECT name FROM sqlite_master WHERE type == 'index' AND sql IS NOT NULL"));
+  EXPECT_EQ(0, m_ds->num_rows());
+
+  ASSERT_TRUE(m_ds->query("SELECT docid FROM songsearch WHERE songsearch MATCH 'title 12*'"));
+  EXPECT_EQ(11, m_ds->num_rows());
+}
@@ -19,20 +19,86 @@
  */
 
 #include "DirectoryCache.h"
+#include "DirectoryFactory.h"
 #include "FileItem.h"
+#include "GUIUserMessages.h"
+#include "URL.h"
+#include "guilib/GUIWindowManager.h"
+#include "music/tags/MusicInfoTag.h"
+#include "pictures/PictureInfoTag.h"
+#include "settings/AdvancedSettings.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 #include "utils/StringUtils.h"
-#include "climits"
+#include "video/VideoInfoTag.h"
+
+#include "boost/shared_ptr.hpp"
 
 using namespace std;
 using namespace XFILE;
 
+namespace
+{
+  /*!
+   \brief Rereads an expired listing in the background
+   */
+  class CRevalidateDirectoryJob : public CJob
+  {
+  public:
+    CRevalidateDirectoryJob(const std::string &path, int flags)
+      : m_path(path), m_flags(flags)
+    { }
+
+    virtual const char *GetType() const { return "revalidatedirectory"; }
+
+    virtual bool DoWork()
+    {
+      CURL url(m_path);
+      boost::shared_ptr<IDirectory> directory(CDirectoryFactory::Create(url));
+      if (!directory.get())
+        return false;
+
+      directory->SetFlags(m_flags);
+      m_items.SetURL(url);
+      return directory->GetDirectory(url, m_items);
+    }
+
+    const CFileItemList& GetItems() const { return m_items; }
+
+  private:
+    std::string m_path;
+    int m_flags;
+    CFileItemList m_items;
+  };
+
+  bool SameItems(const CFileItemList &left, const CFileItemList &right)
+  {
+    if (left.Size() != right.Size())
+      return false;
+
+    for (int i = 0; i < left.Size(); i++)
+    {
+      const CFileItem &l = *left[i];
+      const CFileItem &r = *right[i];
+      if (l.GetPath() != r.GetPath() || l.m_bIsFolder != r.m_bIsFolder ||
+          l.m_dwSize != r.m_dwSize || l.m_dateTime != r.m_dateTime)
+        return false;
+    }
+    return true;
+  }
+}
+
 CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
 {
   m_cacheType = cacheType;
-  m_lastAccess = 0;
+  m_flags = DIR_FLAG_DEFAULTS;
+  m_size = 0;
+  m_ttl = 0;
+  m_retrieved = XbmcThreads::SystemClockMillis();
+  m_revalidateJob = 0;
   m_Items = new CFileItemList;
   m_Items->SetFastLookup(true);
 }
@@ -42,18 +108,14 @@ CDirectoryCache::CDir::~CDir()
   delete m_Items;
 }
 
-void CDirectoryCache::CDir::SetLastAccess(unsigned int &accessCounter)
+bool CDirectoryCache::CDir::IsExpired(unsigned int now) const
 {
-  m_lastAccess = accessCounter++;
+  return m_ttl > 0 && now - m_retrieved >= m_ttl;
 }
 
 CDirectoryCache::CDirectoryCache(void)
 {
-  m_accessCounter = 0;
-#ifdef _DEBUG
-  m_cacheHits = 0;
-  m_cacheMisses = 0;
-#endif
+  memset(&m_stats, 0, sizeof(m_stats));
 }
 
 CDirectoryCache::~CDirectoryCache(void)
@@ -67,7 +129,7 @@ bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &it
   std::string storedPath = strPath;
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
+  iCache i = m_cache.find(storedPath);
   if (i != m_cache.end())
   {
     CDir* dir = i->second;
@@ -75,17 +137,23 @@ bool CDirectoryCache::GetDirectory(const std::string& strPath, CFileItemList &it
        (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
     {
       items.Copy(*dir->m_Items);
-      dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-      m_cacheHits+=items.Size();
-#endif
+      Touch(dir);
+      m_stats.hits++;
+
+      // serve the expired listing without waiting for it to be reread
+      if (dir->IsExpired(XbmcThreads::SystemClockMillis()))
+      {
+        m_stats.staleHits++;
+        Revalidate(i);
+      }
       return true;
     }
   }
+  m_stats.misses++;
   return false;
 }
 
-void CDirectoryCache::SetDirectory(const std::string& strPath, const CFileItemList &items, DIR_CACHE_TYPE cacheType)
+void CDirectoryCache::SetDirectory(const std::string& strPath, const CFileItemList &items, DIR_CACHE_TYPE cacheType, int flags /* = DIR_FLAG_DEFAULTS */)
 {
   if (cacheType == DIR_CACHE_NEVER)
     return; // nothing to do
@@ -108,12 +176,21 @@ void CDirectoryCache::SetDirectory(const std::string& strPath, const CFileItemLi
 
   ClearDirectory(storedPath);
 
-  CheckIfFull();
-
   CDir* dir = new CDir(cacheType);
   dir->m_Items->Copy(items);
-  dir->SetLastAccess(m_accessCounter);
-  m_cache.insert(pair<std::string, CDir*>(storedPath, dir));
+  dir->m_flags = flags;
+  dir->m_size = GetMemoryUsage(items);
+
+  map<std::string, unsigned int>::const_iterator ttl = g_advancedSettings.m_directoryCacheTTLs.find(CURL(storedPath).GetProtocol());
+  if (ttl != g_advancedSettings.m_directoryCacheTTLs.end())
+    dir->m_ttl = ttl->second * 1000;
+
+  CheckIfFull(dir->m_size);
+
+  iCache i = m_cache.insert(pair<std::string, CDir*>(storedPath, dir)).first;
+  LRUList &lru = GetLRU(dir);
+  dir->m_lru = lru.insert(lru.begin(), i);
+  m_stats.bytes += dir->m_size;
 }
 
 void CDirectoryCache::ClearFile(const std::string& strFile)
@@ -163,7 +240,11 @@ void CDirectoryCache::AddFile(const std::string& strFile)
     CDir *dir = i->second;
     CFileItemPtr item(new CFileItem(strFile, false));
     dir->m_Items->Add(item);
-    dir->SetLastAccess(m_accessCounter);
+    Touch(dir);
+
+    size_t size = GetMemoryUsage(*item);
+    dir->m_size += size;
+    m_stats.bytes += size;
   }
 }
 
@@ -178,19 +259,16 @@ bool CDirectoryCache::FileExists(const std::string& strFile, bool& bInCache)
   URIUtils::RemoveSlashAtEnd(storedPath);
 
   ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  // an expired listing may not know about the file
+  if (i != m_cache.end() && !i->second->IsExpired(XbmcThreads::SystemClockMillis()))
   {
     bInCache = true;
     CDir *dir = i->second;
-    dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-    m_cacheHits++;
-#endif
+    Touch(dir);
+    m_stats.hits++;
     return (URIUtils::PathEquals(strPath, storedPath) || dir->m_Items->Contains(strFile));
   }
-#ifdef _DEBUG
-  m_cacheMisses++;
-#endif
+  m_stats.misses++;
   return false;
 }
 
@@ -228,51 +306,145 @@ void CDirectoryCache::ClearCache(set<std::string>& dirs)
   }
 }
 
-void CDirectoryCache::CheckIfFull()
+void CDirectoryCache::CheckIfFull(size_t size)
 {
   CSingleLock lock (m_cs);
-  static const unsigned int max_cached_dirs = 10;
 
-  // find the last accessed folder, and remove if the number of cached folders is too many
-  iCache lastAccessed = m_cache.end();
-  unsigned int numCached = 0;
-  for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
+  // make room for a listing of the given size by removing the least recently
+  // used listings, those of directories that are always cached go last
+  uint64_t budget = g_advancedSettings.m_directoryCacheMemorySize;
+  while (!m_lruOnce.empty() && m_stats.bytes + size > budget)
   {
-    // ensure dirs that are always cached aren't cleared
-    if (i->second->m_cacheType != DIR_CACHE_ALWAYS)
-    {
-      if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
-        lastAccessed = i;
-      numCached++;
-    }
+    Delete(m_lruOnce.back());
+    m_stats.evictions++;
+  }
+  while (!m_lruAlways.empty() && m_stats.bytes + size > budget)
+  {
+    Delete(m_lruAlways.back());
+    m_stats.evictions++;
   }
-  if (lastAccessed != m_cache.end() && numCached >= max_cached_dirs)
-    Delete(lastAccessed);
 }
 
 void CDirectoryCache::Delete(iCache it)
 {
+  // a pending revalidation isn't cancelled, as that waits for running callbacks while we hold
+  // m_cs. OnJobComplete() drops the result of a job it doesn't know anymore.
   CDir* dir = it->second;
+  GetLRU(dir).erase(dir->m_lru);
+  m_stats.bytes -= dir->m_size;
   delete dir;
   m_cache.erase(it);
 }
 
-#ifdef _DEBUG
-void CDirectoryCache::PrintStats() const
+void CDirectoryCache::Touch(CDir *dir)
 {
-  CSingleLock lock (m_cs);
-  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, and %u cache misses", __FUNCTION__, m_cacheHits, m_cacheMisses);
-  // run through and find the oldest and the number of items cached
-  unsigned int oldest = UINT_MAX;
-  unsigned int numItems = 0;
-  unsigned int numDirs = 0;
-  for (ciCache i = m_cache.begin(); i != m_cache.end(); i++)
+  LRUList &lru = GetLRU(dir);
+  lru.splice(lru.begin(), lru, dir->m_lru);
+}
+
+void CDirectoryCache::Revalidate(iCache i)
+{
+  CDir *dir = i->second;
+  if (dir->m_revalidateJob != 0)
+    return;
+
+  dir->m_revalidateJob = CJobManager::GetInstance().AddJob(new CRevalidateDirectoryJob(i->first, dir->m_flags), this, CJob::PRIORITY_LOW);
+}
+
+void CDirectoryCache::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+{
+  std::string path;
   {
+    CSingleLock lock(m_cs);
+
+    iCache i = m_cache.begin();
+    for (; i != m_cache.end(); ++i)
+    {
+      if (i->second->m_revalidateJob == jobID)
+        break;
+    }
+    // the listing has been removed or replaced in the meantime
+    if (i == m_cache.end())
+      return;
+
     CDir *dir = i->second;
-    oldest = min(oldest, dir->GetLastAccess());
-    numItems += dir->m_Items->Size();
-    numDirs++;
+    dir->m_revalidateJob = 0;
+    m_stats.revalidations++;
+
+    if (!success)
+    {
+      // leave it to the next GetDirectory() to report the failure
+      CLog::Log(LOGDEBUG, "%s - unable to revalidate %s", __FUNCTION__, CURL::GetRedacted(i->first).c_str());
+      Delete(i);
+      return;
+    }
+
+    const CFileItemList &items = ((CRevalidateDirectoryJob *)job)->GetItems();
+    dir->m_retrieved = XbmcThreads::SystemClockMillis();
+    if (SameItems(*dir->m_Items, items))
+      return;
+
+    m_stats.changed++;
+    path = i->first;
+    dir->m_Items->Clear();
+    dir->m_Items->Copy(items);
+
+    size_t size = GetMemoryUsage(items);
+    m_stats.bytes = m_stats.bytes - dir->m_size + size;
+    dir->m_size = size;
+    CheckIfFull(0);
   }
-  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, oldest, m_accessCounter);
+
+  // let windows showing the directory update their listing
+  CGUIMessage message(GUI_MSG_NOTIFY_ALL, 0, 0, GUI_MSG_UPDATE_PATH);
+  message.SetStringParam(URIUtils::AddFileToFolder(path, ""));
+  g_windowManager.SendThreadMessage(message);
+}
+
+CDirectoryCache::Stats CDirectoryCache::GetStats() const
+{
+  CSingleLock lock (m_cs);
+
+  Stats stats = m_stats;
+  stats.directories = m_cache.size();
+  stats.items = 0;
+  for (ciCache i = m_cache.begin(); i != m_cache.end(); i++)
+    stats.items += i->second->m_Items->Size();
+  stats.budget = g_advancedSettings.m_directoryCacheMemorySize;
+
+  return stats;
+}
+
+void CDirectoryCache::PrintStats() const
+{
+  Stats stats = GetStats();
+  CLog::Log(LOGDEBUG, "%s - total of %u cache hits (%u of expired listings), and %u cache misses", __FUNCTION__, stats.hits, stats.staleHits, stats.misses);
+  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total using %" PRIu64" of %" PRIu64" bytes. %u evictions, %u revalidations (%u changed)",
+            __FUNCTION__, stats.directories, stats.items, stats.bytes, stats.budget, stats.evictions, stats.revalidations, stats.changed);
+}
+
+size_t CDirectoryCache::GetMemoryUsage(const CFileItemList &items)
+{
+  size_t size = sizeof(CFileItemList);
+  for (int i = 0; i < items.Size(); i++)
+    size += GetMemoryUsage(*items[i]);
+
+  return size;
+}
+
+size_t CDirectoryCache::GetMemoryUsage(const CFileItem &item)
+{
+  // the item, its shared pointer, the entry in the fast lookup map and the
+  // strings it's most likely to have
+  size_t size = sizeof(CFileItem) + sizeof(CFileItemPtr) + 64 +
+                2 * item.GetPath().size() + item.GetLabel().size() + item.GetLabel2().size();
+
+  if (item.HasMusicInfoTag())
+    size += sizeof(MUSIC_INFO::CMusicInfoTag);
+  if (item.HasVideoInfoTag())
+    size += sizeof(CVideoInfoTag);
+  if (item.HasPictureInfoTag())
+    size += sizeof(CPictureInfoTag);
+
+  return size;
 }
-#endif
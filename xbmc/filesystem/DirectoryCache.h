@@ -22,7 +22,9 @@
 #include "IDirectory.h"
 #include "Directory.h"
 #include "threads/CriticalSection.h"
+#include "utils/Job.h"
 
+#include <list>
 #include <map>
 #include <set>
 
@@ -30,54 +32,100 @@ class CFileItem;
 
 namespace XFILE
 {
-  class CDirectoryCache
+  /*!
+   \brief In-memory cache of directory listings.
+
+   Listings are evicted in least recently used order once their estimated
+   memory usage exceeds the budget set by <directorycache><memorysize> in
+   advancedsettings.xml, listings of DIR_CACHE_ONCE directories before those
+   of DIR_CACHE_ALWAYS directories.
+
+   Listings of protocols with a TTL (<directorycache><ttl protocol="smb">)
+   expire after that many seconds. An expired listing is still returned by
+   GetDirectory() while it's being reread by a background job, and windows
+   showing the directory are told to update if the listing has changed.
+   FileExists() doesn't answer from expired listings.
+   */
+  class CDirectoryCache : public IJobCallback
   {
+    class CDir;
+    typedef std::map<std::string, CDir*>::iterator iCache;
+    typedef std::map<std::string, CDir*>::const_iterator ciCache;
+    typedef std::list<iCache> LRUList;
+
     class CDir
     {
     public:
       CDir(DIR_CACHE_TYPE cacheType);
       virtual ~CDir();
 
-      void SetLastAccess(unsigned int &accessCounter);
-      unsigned int GetLastAccess() const { return m_lastAccess; };
+      bool IsExpired(unsigned int now) const;
 
       CFileItemList* m_Items;
       DIR_CACHE_TYPE m_cacheType;
-    private:
-      unsigned int m_lastAccess;
+      int m_flags;                   ///< flags the directory was retrieved with
+      size_t m_size;                 ///< estimated memory usage in bytes
+      unsigned int m_ttl;            ///< milliseconds until the listing expires, 0 if it doesn't
+      unsigned int m_retrieved;      ///< time the listing was retrieved
+      unsigned int m_revalidateJob;  ///< id of the job rereading the listing, 0 if there's none
+      LRUList::iterator m_lru;       ///< position of the directory in its LRU list
     };
   public:
+    /*!
+     \brief Statistics of the cache since it was created
+     */
+    typedef struct
+    {
+      unsigned int hits;          ///< listings and file lookups served from the cache
+      unsigned int misses;        ///< listings and file lookups which weren't cached
+      unsigned int staleHits;     ///< expired listings which have been served while being revalidated
+      unsigned int revalidations; ///< finished revalidations
+      unsigned int changed;       ///< revalidations which found a different listing
+      unsigned int evictions;     ///< listings evicted to stay within the memory budget
+      unsigned int directories;   ///< currently cached directories
+      unsigned int items;         ///< currently cached items
+      uint64_t bytes;             ///< estimated memory usage of the cached listings
+      uint64_t budget;            ///< memory budget of the cache
+    } Stats;
+
     CDirectoryCache(void);
     virtual ~CDirectoryCache(void);
     bool GetDirectory(const std::string& strPath, CFileItemList &items, bool retrieveAll = false);
-    void SetDirectory(const std::string& strPath, const CFileItemList &items, DIR_CACHE_TYPE cacheType);
+    void SetDirectory(const std::string& strPath, const CFileItemList &items, DIR_CACHE_TYPE cacheType, int flags = DIR_FLAG_DEFAULTS);
     void ClearDirectory(const std::string& strPath);
     void ClearFile(const std::string& strFile);
     void ClearSubPaths(const std::string& strPath);
     void Clear();
     void AddFile(const std::string& strFile);
     bool FileExists(const std::string& strPath, bool& bInCache);
-#ifdef _DEBUG
+    Stats GetStats() const;
     void PrintStats() const;
-#endif
+
+    virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job);
+
+    /*!
+     \brief Estimates the memory used by the given items
+     */
+    static size_t GetMemoryUsage(const CFileItemList &items);
   protected:
+    static size_t GetMemoryUsage(const CFileItem &item);
     void InitCache(std::set<std::string>& dirs);
     void ClearCache(std::set<std::string>& dirs);
-    void CheckIfFull();
+    void CheckIfFull(size_t size);
 
     std::map<std::string, CDir*> m_cache;
-    typedef std::map<std::string, CDir*>::iterator iCache;
-    typedef std::map<std::string, CDir*>::const_iterator ciCache;
     void Delete(iCache i);
+    void Touch(CDir *dir);
+    void Revalidate(iCache i);
+    LRUList& GetLRU(const CDir *dir) { return dir->m_cacheType == DIR_CACHE_ALWAYS ? m_lruAlways : m_lruOnce; }
 
     CCriticalSection m_cs;
 
-    unsigned int m_accessCounter;
+    // most recently used directories first
+    LRUList m_lruOnce;
+    LRUList m_lruAlways;
 
-#ifdef _DEBUG
-    unsigned int m_cacheHits;
-    unsigned int m_cacheMisses;
-#endif
+    Stats m_stats;
   };
 }
 extern XFILE::CDirectoryCache g_directoryCache;
@@ -21,6 +21,7 @@
 #include "threads/SystemClock.h"
 #include "utils/AutoPtrHandle.h"
 #include "FileCache.h"
+#include "FileCacheReadAhead.h"
 #include "threads/Thread.h"
 #include "File.h"
 #include "URL.h"
@@ -29,6 +30,7 @@
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
+#include "utils/URIUtils.h"
 #include "settings/AdvancedSettings.h"
 
 using namespace AUTOPTR;
@@ -104,6 +106,7 @@ CFileCache::CFileCache(bool useDoubleCache) : CThread("FileCache")
    }
    m_seekPossible = 0;
    m_cacheFull = false;
+   m_readAhead = NULL;
 }
 
 CFileCache::CFileCache(CCacheStrategy *pCache, bool bDeleteCache) : CThread("FileCacheStrategy")
@@ -115,6 +118,7 @@ CFileCache::CFileCache(CCacheStrategy *pCache, bool bDeleteCache) : CThread("Fil
   m_writePos = 0;
   m_nSeekResult = 0;
   m_chunkSize = 0;
+  m_readAhead = NULL;
 }
 
 CFileCache::~CFileCache()
@@ -179,6 +183,15 @@ bool CFileCache::Open(const CURL& url)
   m_seekPossible = m_source.IoControl(IOCTRL_SEEK_POSSIBLE, NULL);
   m_chunkSize = CFile::GetChunkSize(m_source.GetChunkSize(), READ_CACHE_CHUNK_SIZE);
 
+  // a single request at a time is bound by the round trip of remote sources,
+  // so keep several in flight if the source allows ranges to be requested
+  if (g_advancedSettings.m_cacheReadAheadConnections > 1 && m_seekPossible > 0 && m_source.GetLength() > 0 &&
+      (URIUtils::IsInternetStream(url, true) || URIUtils::IsSmb(m_sourcePath) || URIUtils::IsNfs(m_sourcePath)))
+  {
+    CLog::Log(LOGDEBUG, "CFileCache::Open - reading ahead through up to %u connections", g_advancedSettings.m_cacheReadAheadConnections);
+    m_readAhead = new CFileCacheReadAhead(m_sourcePath, m_source.GetLength(), m_chunkSize, g_advancedSettings.m_cacheReadAheadConnections);
+  }
+
   m_readPos = 0;
   m_writePos = 0;
   m_writeRate = 1024 * 1024;
@@ -211,6 +224,7 @@ void CFileCache::Process()
   CWriteRate limiter;
   CWriteRate average;
   bool cacheReachEOF = false;
+  bool readAhead = (m_readAhead != NULL);
 
   while (!m_bStop)
   {
@@ -221,7 +235,12 @@ void CFileCache::Process()
       int64_t cacheMaxPos = m_pCache->CachedDataEndPosIfSeekTo(m_seekPos);
       cacheReachEOF = (cacheMaxPos == m_source.GetLength());
       bool sourceSeekFailed = false;
-      if (!cacheReachEOF)
+      if (!cacheReachEOF && readAhead)
+      {
+        m_readAhead->Seek(cacheMaxPos);
+        m_nSeekResult = cacheMaxPos;
+      }
+      else if (!cacheReachEOF)
       {
         m_nSeekResult = m_source.Seek(cacheMaxPos, SEEK_SET);
         if (m_nSeekResult != cacheMaxPos)
@@ -279,7 +298,22 @@ void CFileCache::Process()
     }
 
     ssize_t iRead = 0;
-    if (!cacheReachEOF)
+    if (!cacheReachEOF && readAhead)
+    {
+      // the rate is held back on purpose while the cache is well ahead of the reader
+      if (!m_writeRate || m_writePos - m_readPos < m_writeRate)
+        m_readAhead->Adapt(m_writeRate, m_writeRateActual);
+
+      iRead = m_readAhead->Read(buffer.get(), maxWrite);
+      if (iRead < 0 && !m_bStop && m_source.Seek(m_writePos, SEEK_SET) == m_writePos)
+      {
+        CLog::Log(LOGWARNING, "CFileCache::Process - read ahead failed, continuing with a single connection");
+        m_readAhead->Abort();
+        readAhead = false;
+        iRead = m_source.Read(buffer.get(), maxWrite);
+      }
+    }
+    else if (!cacheReachEOF)
       iRead = m_source.Read(buffer.get(), maxWrite);
     if (iRead == 0)
     {
@@ -468,6 +502,9 @@ void CFileCache::Close()
   if (m_pCache)
     m_pCache->Close();
 
+  delete m_readAhead;
+  m_readAhead = NULL;
+
   m_source.Close();
 }
 
@@ -486,6 +523,9 @@ void CFileCache::StopThread(bool bWait /*= true*/)
   m_bStop = true;
   //Process could be waiting for seekEvent
   m_seekEvent.Set();
+  //or for a block of the read ahead
+  if (m_readAhead)
+    m_readAhead->Abort();
   CThread::StopThread(bWait);
 }
 
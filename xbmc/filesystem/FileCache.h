@@ -28,6 +28,8 @@
 namespace XFILE
 {
 
+  class CFileCacheReadAhead;
+
   class CFileCache : public IFile, public CThread
   {
   public:
@@ -66,6 +68,7 @@ namespace XFILE
     bool      m_bDeleteCache;
     int        m_seekPossible;
     CFile      m_source;
+    CFileCacheReadAhead *m_readAhead; ///< reads m_source through several connections, NULL if not used
     std::string    m_sourcePath;
     CEvent      m_seekEvent;
     CEvent      m_seekEnded;
@@ -0,0 +1,250 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileCacheReadAhead.h"
+#include "File.h"
+#include "URL.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace XFILE;
+
+#define READAHEAD_MIN_BLOCK       (256*1024)
+#define READAHEAD_MAX_BLOCK       (2*1024*1024)
+// a change of depth needs a while to show in the rate
+#define READAHEAD_ADAPT_INTERVAL  1000
+
+CFileCacheReadAhead::CFileCacheReadAhead(const std::string &path, int64_t length, unsigned chunkSize, unsigned maxConnections)
+  : m_path(path),
+    m_length(length),
+    m_schedulePos(0),
+    m_chunkSize(std::max(chunkSize, 1U)),
+    m_maxConnections(std::max(maxConnections, 1U)),
+    m_depth(std::min(m_maxConnections, 2U)),
+    m_adaptStamp(XbmcThreads::SystemClockMillis()),
+    m_abort(false)
+{
+  m_blockSize = std::max((unsigned)READAHEAD_MIN_BLOCK, m_chunkSize);
+}
+
+CFileCacheReadAhead::~CFileCacheReadAhead()
+{
+  Abort();
+
+  // a worker finishes the read it's in before it notices
+  for (std::vector<CThread*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+  {
+    (*it)->StopThread(true);
+    delete *it;
+  }
+  m_workers.clear();
+}
+
+ssize_t CFileCacheReadAhead::Read(char *buffer, size_t size)
+{
+  CSingleLock lock(m_section);
+  while (!m_abort)
+  {
+    Schedule();
+    if (m_blocks.empty())
+      return 0;
+
+    SBlock *block = m_blocks.front();
+    if (block->consumed < block->read)
+    {
+      size_t read = std::min<size_t>(size, block->read - block->consumed);
+      memcpy(buffer, &block->data[block->consumed], read);
+      block->consumed += read;
+      return (ssize_t)read;
+    }
+
+    if (block->state == SBlock::FAILED)
+      return -1;
+
+    if (block->state == SBlock::DONE)
+    {
+      m_blocks.pop_front();
+      bool complete = (block->read == block->size);
+      int64_t end = block->offset + block->read;
+      delete block;
+      if (complete)
+        continue;
+
+      // the file is shorter than it claimed to be
+      CLog::Log(LOGDEBUG, "CFileCacheReadAhead::Read - end of file at %" PRId64 " instead of %" PRId64, end, m_length);
+      DiscardBlocks();
+      m_length = end;
+      m_schedulePos = end;
+      return 0;
+    }
+
+    m_ready.wait(lock);
+  }
+  return -1;
+}
+
+void CFileCacheReadAhead::Seek(int64_t position)
+{
+  CSingleLock lock(m_section);
+  DiscardBlocks();
+  m_schedulePos = position;
+}
+
+void CFileCacheReadAhead::Adapt(unsigned wantedRate, unsigned actualRate)
+{
+  CSingleLock lock(m_section);
+
+  // blocks of about a quarter of a second, fewer requests for fast sources
+  unsigned blockSize = actualRate / 4;
+  blockSize -= blockSize % m_chunkSize;
+  m_blockSize = std::min(std::max(blockSize, std::max((unsigned)READAHEAD_MIN_BLOCK, m_chunkSize)), std::max((unsigned)READAHEAD_MAX_BLOCK, m_chunkSize));
+
+  unsigned now = XbmcThreads::SystemClockMillis();
+  if (now - m_adaptStamp < READAHEAD_ADAPT_INTERVAL)
+    return;
+  m_adaptStamp = now;
+
+  if ((wantedRate == 0 || actualRate < wantedRate) && m_depth < m_maxConnections)
+    m_depth++;
+  else if (wantedRate > 0 && actualRate > wantedRate + wantedRate / 2 && m_depth > 1)
+    m_depth--;
+}
+
+void CFileCacheReadAhead::Abort()
+{
+  CSingleLock lock(m_section);
+  m_abort = true;
+  DiscardBlocks();
+  m_work.notifyAll();
+  m_ready.notifyAll();
+}
+
+void CFileCacheReadAhead::Schedule()
+{
+  bool scheduled = false;
+  while (m_blocks.size() < m_depth && m_schedulePos < m_length)
+  {
+    SBlock *block = new SBlock;
+    block->offset = m_schedulePos;
+    block->size = (unsigned)std::min<int64_t>(m_blockSize, m_length - m_schedulePos);
+    block->read = 0;
+    block->consumed = 0;
+    block->state = SBlock::PENDING;
+    block->discarded = false;
+    block->data.resize(block->size);
+    m_blocks.push_back(block);
+    m_schedulePos += block->size;
+    scheduled = true;
+  }
+
+  // workers open their connection with the first block they get
+  while (m_workers.size() < m_depth)
+  {
+    CThread *worker = new CThread(this, "FileCacheReadAhead");
+    worker->Create();
+    m_workers.push_back(worker);
+  }
+
+  if (scheduled)
+    m_work.notifyAll();
+}
+
+void CFileCacheReadAhead::DiscardBlocks()
+{
+  for (std::list<SBlock*>::iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+  {
+    // the worker reading it deletes it once done
+    if ((*it)->state == SBlock::READING)
+      (*it)->discarded = true;
+    else
+      delete *it;
+  }
+  m_blocks.clear();
+}
+
+void CFileCacheReadAhead::Run()
+{
+  CFile file;
+  bool opened = false;
+
+  CSingleLock lock(m_section);
+  while (!m_abort)
+  {
+    SBlock *block = NULL;
+    for (std::list<SBlock*>::iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+    {
+      if ((*it)->state == SBlock::PENDING)
+      {
+        block = *it;
+        break;
+      }
+    }
+    if (!block)
+    {
+      m_work.wait(lock);
+      continue;
+    }
+    block->state = SBlock::READING;
+    lock.Leave();
+
+    if (!opened)
+    {
+      opened = file.Open(m_path, READ_NO_CACHE | READ_TRUNCATED | READ_CHUNKED);
+      if (!opened)
+        CLog::Log(LOGERROR, "CFileCacheReadAhead::Run - failed to open <%s>", CURL::GetRedacted(m_path).c_str());
+    }
+    bool success = opened && file.Seek(block->offset, SEEK_SET) == block->offset;
+
+    // the data read so far is handed out while the rest is still coming in
+    unsigned read = 0;
+    while (success && read < block->size)
+    {
+      ssize_t result = file.Read(&block->data[read], std::min(m_chunkSize, block->size - read));
+      if (result < 0)
+        success = false;
+      if (result <= 0)
+        break;
+
+      read += result;
+      CSingleLock progress(m_section);
+      block->read = read;
+      if (block->discarded)
+        break;
+      m_ready.notifyAll();
+    }
+
+    lock.Enter();
+    if (block->discarded)
+    {
+      delete block;
+      continue;
+    }
+    block->read = read;
+    block->state = success ? SBlock::DONE : SBlock::FAILED;
+    m_ready.notifyAll();
+  }
+
+  lock.Leave();
+  file.Close();
+}
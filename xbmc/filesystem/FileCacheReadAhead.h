@@ -0,0 +1,115 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+#include "threads/Thread.h"
+
+namespace XFILE
+{
+
+  /*!
+   \brief Reads a file ahead through several connections at once
+
+   The file is split into blocks which are fetched by worker threads, each
+   with a CFile handle of its own, so that several range requests are in
+   flight at the same time. Read() hands the data out in order, so the
+   caller sees a plain sequential stream.
+
+   Adapt() sizes the blocks and the number of blocks in flight by the rate
+   the caller manages to write out: requests are added while it stays below
+   the wanted rate and taken away again once it is well above.
+   */
+  class CFileCacheReadAhead : public IRunnable
+  {
+  public:
+    CFileCacheReadAhead(const std::string &path, int64_t length, unsigned chunkSize, unsigned maxConnections);
+    virtual ~CFileCacheReadAhead();
+
+    /*!
+     \brief Read the next bytes of the file
+     \return the number of bytes read, 0 at the end of the file and -1 if a
+             block couldn't be read or Abort() was called.
+     */
+    ssize_t Read(char *buffer, size_t size);
+
+    /*!
+     \brief Continue reading at the given position, dropping all blocks in flight
+     */
+    void Seek(int64_t position);
+
+    /*!
+     \brief Adjust block size and depth
+     \param wantedRate the rate the data should come in with in bytes/s, 0 for as fast as possible.
+     \param actualRate the rate the data is coming in with in bytes/s.
+     */
+    void Adapt(unsigned wantedRate, unsigned actualRate);
+
+    /*!
+     \brief Stop all workers, a blocked Read() returns -1
+     */
+    void Abort();
+
+    unsigned GetDepth() const { return m_depth; }
+    unsigned GetBlockSize() const { return m_blockSize; }
+
+  protected:
+    virtual void Run();
+
+  private:
+    struct SBlock
+    {
+      enum EState { PENDING, READING, DONE, FAILED };
+
+      int64_t  offset;
+      unsigned size;
+      unsigned read;     ///< bytes read by the worker so far
+      unsigned consumed; ///< bytes handed out by Read()
+      EState   state;
+      bool     discarded;
+      std::vector<char> data;
+    };
+
+    void Schedule();
+    void DiscardBlocks();
+
+    std::string m_path;
+    int64_t m_length;
+    int64_t m_schedulePos;   ///< offset of the next block to schedule
+    unsigned m_chunkSize;
+    unsigned m_maxConnections;
+    unsigned m_blockSize;
+    unsigned m_depth;
+    unsigned m_adaptStamp;
+    bool m_abort;
+
+    std::list<SBlock*> m_blocks; ///< blocks in file order, the front one is read next
+    std::vector<CThread*> m_workers;
+    CCriticalSection m_section;
+    XbmcThreads::ConditionVariable m_work;  ///< a block was scheduled
+    XbmcThreads::ConditionVariable m_ready; ///< a block got data
+  };
+
+}
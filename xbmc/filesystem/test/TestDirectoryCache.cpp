@@ -0,0 +1,231 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/Directory.h"
+#include "filesystem/DirectoryCache.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "FileItem.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#if defined(TARGET_POSIX)
+#include "linux/XTimeUtils.h"
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+class TestDirectoryCache : public testing::Test
+{
+protected:
+  TestDirectoryCache()
+  {
+    m_memorySize = g_advancedSettings.m_directoryCacheMemorySize;
+    m_ttls = g_advancedSettings.m_directoryCacheTTLs;
+  }
+
+  ~TestDirectoryCache()
+  {
+    cache.Clear();
+    g_advancedSettings.m_directoryCacheMemorySize = m_memorySize;
+    g_advancedSettings.m_directoryCacheTTLs = m_ttls;
+  }
+
+  static void GetItems(const std::string &path, int count, CFileItemList &items)
+  {
+    items.Clear();
+    for (int i = 0; i < count; i++)
+      items.Add(CFileItemPtr(new CFileItem(URIUtils::AddFileToFolder(path, StringUtils::Format("file%d.mkv", i)), false)));
+  }
+
+  CDirectoryCache cache;
+
+private:
+  unsigned int m_memorySize;
+  std::map<std::string, unsigned int> m_ttls;
+};
+
+TEST_F(TestDirectoryCache, LRU)
+{
+  CFileItemList items;
+  GetItems("smb://server/share/a/", 100, items);
+  size_t size = CDirectoryCache::GetMemoryUsage(items);
+
+  // room for two of the listings
+  g_advancedSettings.m_directoryCacheMemorySize = 2 * size + size / 2;
+
+  cache.SetDirectory("smb://server/share/a/", items, DIR_CACHE_ONCE);
+  GetItems("smb://server/share/b/", 100, items);
+  cache.SetDirectory("smb://server/share/b/", items, DIR_CACHE_ONCE);
+  EXPECT_EQ(2 * size, cache.GetStats().bytes);
+
+  // a is used more recently than b now
+  CFileItemList cached;
+  EXPECT_TRUE(cache.GetDirectory("smb://server/share/a/", cached, true));
+  EXPECT_EQ(100, cached.Size());
+
+  GetItems("smb://server/share/c/", 100, items);
+  cache.SetDirectory("smb://server/share/c/", items, DIR_CACHE_ONCE);
+
+  EXPECT_TRUE(cache.GetDirectory("smb://server/share/a/", cached, true));
+  EXPECT_FALSE(cache.GetDirectory("smb://server/share/b/", cached, true));
+  EXPECT_TRUE(cache.GetDirectory("smb://server/share/c/", cached, true));
+
+  CDirectoryCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(1U, stats.evictions);
+  EXPECT_EQ(2U, stats.directories);
+  EXPECT_EQ(200U, stats.items);
+  EXPECT_EQ(2 * size, stats.bytes);
+  EXPECT_EQ(3U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+}
+
+TEST_F(TestDirectoryCache, EvictAlwaysCachedLast)
+{
+  CFileItemList items;
+  GetItems("zip://archive/", 100, items);
+  size_t size = CDirectoryCache::GetMemoryUsage(items);
+  g_advancedSettings.m_directoryCacheMemorySize = 2 * size + size / 2;
+
+  cache.SetDirectory("zip://archive/", items, DIR_CACHE_ALWAYS);
+  GetItems("smb://server/share/a/", 100, items);
+  cache.SetDirectory("smb://server/share/a/", items, DIR_CACHE_ONCE);
+  GetItems("smb://server/share/b/", 100, items);
+  cache.SetDirectory("smb://server/share/b/", items, DIR_CACHE_ONCE);
+
+  CFileItemList cached;
+  EXPECT_TRUE(cache.GetDirectory("zip://archive/", cached));
+  EXPECT_FALSE(cache.GetDirectory("smb://server/share/a/", cached, true));
+  EXPECT_TRUE(cache.GetDirectory("smb://server/share/b/", cached, true));
+
+  // a listing bigger than the whole budget replaces everything
+  GetItems("smb://server/share/c/", 300, items);
+  cache.SetDirectory("smb://server/share/c/", items, DIR_CACHE_ONCE);
+  EXPECT_FALSE(cache.GetDirectory("zip://archive/", cached));
+  EXPECT_TRUE(cache.GetDirectory("smb://server/share/c/", cached, true));
+  EXPECT_EQ(1U, cache.GetStats().directories);
+  EXPECT_EQ(3U, cache.GetStats().evictions);
+}
+
+TEST_F(TestDirectoryCache, AddAndClear)
+{
+  CFileItemList items;
+  GetItems("smb://server/share/a/", 10, items);
+  cache.SetDirectory("smb://server/share/a/", items, DIR_CACHE_ONCE);
+  size_t size = cache.GetStats().bytes;
+
+  bool inCache;
+  EXPECT_FALSE(cache.FileExists("smb://server/share/a/new.mkv", inCache));
+  EXPECT_TRUE(inCache);
+  cache.AddFile("smb://server/share/a/new.mkv");
+  EXPECT_TRUE(cache.FileExists("smb://server/share/a/new.mkv", inCache));
+  EXPECT_GT(cache.GetStats().bytes, size);
+
+  EXPECT_FALSE(cache.FileExists("smb://server/share/b/file0.mkv", inCache));
+  EXPECT_FALSE(inCache);
+
+  cache.ClearSubPaths("smb://server/share/");
+  CDirectoryCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(0U, stats.directories);
+  EXPECT_EQ(0U, stats.bytes);
+  EXPECT_EQ(2U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+}
+
+TEST_F(TestDirectoryCache, Revalidate)
+{
+  std::string path = CSpecialProtocol::TranslatePath("special://temp/");
+  path = URIUtils::AddFileToFolder(path, "TestDirectoryCache/");
+  ASSERT_TRUE(CDirectory::Create(path));
+  std::string file = URIUtils::AddFileToFolder(path, "file.txt");
+  CFile f;
+  ASSERT_TRUE(f.OpenForWrite(file, true));
+  f.Close();
+
+  // local paths don't have a protocol
+  g_advancedSettings.m_directoryCacheTTLs[""] = 1;
+
+  CFileItemList items;
+  GetItems(path, 2, items);
+  cache.SetDirectory(path, items, DIR_CACHE_ALWAYS);
+
+  CFileItemList cached;
+  EXPECT_TRUE(cache.GetDirectory(path, cached));
+  EXPECT_EQ(2, cached.Size());
+
+  Sleep(1100);
+
+  // the expired listing is still served but not used for lookups
+  bool inCache;
+  cache.FileExists(URIUtils::AddFileToFolder(path, "file0.mkv"), inCache);
+  EXPECT_FALSE(inCache);
+  EXPECT_TRUE(cache.GetDirectory(path, cached));
+  EXPECT_EQ(2, cached.Size());
+  EXPECT_EQ(1U, cache.GetStats().staleHits);
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  while (cache.GetStats().revalidations == 0 && XbmcThreads::SystemClockMillis() - start < 5000)
+    Sleep(10);
+
+  CDirectoryCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(1U, stats.revalidations);
+  EXPECT_EQ(1U, stats.changed);
+  EXPECT_TRUE(cache.GetDirectory(path, cached));
+  ASSERT_EQ(1, cached.Size());
+  EXPECT_STREQ(file.c_str(), cached[0]->GetPath().c_str());
+  EXPECT_TRUE(cache.FileExists(file, inCache));
+  EXPECT_TRUE(inCache);
+
+  EXPECT_TRUE(CFile::Delete(file));
+  EXPECT_TRUE(CDirectory::Remove(path));
+}
+
+TEST_F(TestDirectoryCache, ClearWhileRevalidating)
+{
+  std::string path = CSpecialProtocol::TranslatePath("special://temp/");
+  path = URIUtils::AddFileToFolder(path, "TestDirectoryCache/");
+  ASSERT_TRUE(CDirectory::Create(path));
+
+  g_advancedSettings.m_directoryCacheTTLs[""] = 1;
+
+  CFileItemList items;
+  GetItems(path, 2, items);
+  cache.SetDirectory(path, items, DIR_CACHE_ALWAYS);
+  Sleep(1100);
+
+  // the stale hit starts a revalidation, clearing the listing mustn't wait for it
+  CFileItemList cached;
+  EXPECT_TRUE(cache.GetDirectory(path, cached));
+  cache.ClearDirectory(path);
+
+  // the result of the revalidation doesn't replace a listing set in the meantime
+  GetItems(path, 3, items);
+  cache.SetDirectory(path, items, DIR_CACHE_ALWAYS);
+  Sleep(500);
+  EXPECT_EQ(0U, cache.GetStats().revalidations);
+  EXPECT_TRUE(cache.GetDirectory(path, cached));
+  EXPECT_EQ(3, cached.Size());
+
+  EXPECT_TRUE(CDirectory::Remove(path));
+}
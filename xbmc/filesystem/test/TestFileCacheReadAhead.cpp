@@ -0,0 +1,145 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/File.h"
+#include "filesystem/FileCacheReadAhead.h"
+#include "test/TestUtils.h"
+
+#if defined(TARGET_POSIX)
+#include "linux/XTimeUtils.h"
+#endif
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+#include <vector>
+
+// not a multiple of the block size, so the last block is a short one
+static const int64_t fileSize = 5 * 1024 * 1024 + 12345;
+
+class TestFileCacheReadAhead : public testing::Test
+{
+protected:
+  TestFileCacheReadAhead()
+  {
+    m_data.resize((size_t)fileSize);
+    for (size_t i = 0; i < m_data.size(); i++)
+      m_data[i] = (char)(i * 7 + (i >> 12));
+
+    m_file = XBMC_CREATETEMPFILE("");
+    if (m_file)
+    {
+      m_file->Close();
+      m_file->OpenForWrite(XBMC_TEMPFILEPATH(m_file), true);
+      m_file->Write(&m_data[0], m_data.size());
+      m_file->Close();
+    }
+  }
+
+  ~TestFileCacheReadAhead()
+  {
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  // read everything from position up to the end and compare it with the file
+  void ReadToEnd(XFILE::CFileCacheReadAhead &readAhead, int64_t position, size_t size)
+  {
+    std::vector<char> buffer(size);
+    while (position < fileSize)
+    {
+      ssize_t read = readAhead.Read(&buffer[0], buffer.size());
+      ASSERT_GT(read, 0) << "at " << position;
+      ASSERT_EQ(0, memcmp(&buffer[0], &m_data[(size_t)position], read)) << "at " << position;
+      position += read;
+    }
+    EXPECT_EQ(fileSize, position);
+    EXPECT_EQ(0, readAhead.Read(&buffer[0], buffer.size()));
+  }
+
+  XFILE::CFile *m_file;
+  std::vector<char> m_data;
+};
+
+TEST_F(TestFileCacheReadAhead, Read)
+{
+  ASSERT_TRUE(m_file != NULL);
+  for (unsigned connections = 1; connections <= 4; connections++)
+  {
+    XFILE::CFileCacheReadAhead readAhead(XBMC_TEMPFILEPATH(m_file), fileSize, 64 * 1024, connections);
+    ReadToEnd(readAhead, 0, 100000);
+  }
+}
+
+TEST_F(TestFileCacheReadAhead, Seek)
+{
+  ASSERT_TRUE(m_file != NULL);
+  XFILE::CFileCacheReadAhead readAhead(XBMC_TEMPFILEPATH(m_file), fileSize, 64 * 1024, 4);
+
+  char buffer[1000];
+  ASSERT_EQ(1000, readAhead.Read(buffer, sizeof(buffer)));
+
+  // blocks in flight are dropped
+  readAhead.Seek(3 * 1024 * 1024 + 17);
+  ReadToEnd(readAhead, 3 * 1024 * 1024 + 17, 65536);
+
+  readAhead.Seek(12345);
+  ReadToEnd(readAhead, 12345, 777);
+
+  readAhead.Seek(fileSize);
+  EXPECT_EQ(0, readAhead.Read(buffer, sizeof(buffer)));
+}
+
+TEST_F(TestFileCacheReadAhead, ShortFile)
+{
+  ASSERT_TRUE(m_file != NULL);
+  // the file ends before the length given
+  XFILE::CFileCacheReadAhead readAhead(XBMC_TEMPFILEPATH(m_file), fileSize + 1024 * 1024, 64 * 1024, 3);
+  ReadToEnd(readAhead, 0, 65536);
+}
+
+TEST_F(TestFileCacheReadAhead, Failure)
+{
+  XFILE::CFileCacheReadAhead readAhead("/does/not/exist", fileSize, 64 * 1024, 2);
+  char buffer[1000];
+  EXPECT_EQ(-1, readAhead.Read(buffer, sizeof(buffer)));
+}
+
+TEST_F(TestFileCacheReadAhead, Adapt)
+{
+  XFILE::CFileCacheReadAhead readAhead("/does/not/exist", fileSize, 64 * 1024, 4);
+  EXPECT_EQ(2U, readAhead.GetDepth());
+
+  // a quarter of a second of data, within limits
+  readAhead.Adapt(0, 4 * 1024 * 1024);
+  EXPECT_EQ(1024U * 1024U, readAhead.GetBlockSize());
+  readAhead.Adapt(0, 0);
+  EXPECT_EQ(256U * 1024U, readAhead.GetBlockSize());
+  readAhead.Adapt(0, 100 * 1024 * 1024);
+  EXPECT_EQ(2U * 1024U * 1024U, readAhead.GetBlockSize());
+  EXPECT_EQ(2U, readAhead.GetDepth());
+
+  // more requests while too slow, fewer once well above the wanted rate
+  Sleep(1100);
+  readAhead.Adapt(1024 * 1024, 512 * 1024);
+  EXPECT_EQ(3U, readAhead.GetDepth());
+  Sleep(1100);
+  readAhead.Adapt(1024 * 1024, 2 * 1024 * 1024);
+  EXPECT_EQ(2U, readAhead.GetDepth());
+}
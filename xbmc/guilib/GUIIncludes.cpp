@@ -21,12 +21,15 @@
 #include "GUIIncludes.h"
 #include "addons/Skin.h"
 #include "GUIInfoManager.h"
+#include "SkinXMLCache.h"
 #include "utils/log.h"
 #include "utils/XBMCTinyXML.h"
 #include "utils/XMLUtils.h"
 #include "utils/StringUtils.h"
 #include "interfaces/info/SkinVariable.h"
 
+#include <memory>
+
 using namespace std;
 
 CGUIIncludes::CGUIIncludes()
@@ -104,14 +107,16 @@ bool CGUIIncludes::LoadIncludes(const CStdString &includeFile)
   if (HasIncludeFile(includeFile))
     return true;
 
+  // use the xml if it has been preloaded with the skin
+  std::auto_ptr<TiXmlElement> root(CSkinXMLCache::Get().Take(includeFile));
   CXBMCTinyXML doc;
-  if (!doc.LoadFile(includeFile))
+  if (!root.get() && !doc.LoadFile(includeFile))
   {
     CLog::Log(LOGINFO, "Error loading includes.xml file (%s): %s (row=%i, col=%i)", includeFile.c_str(), doc.ErrorDesc(), doc.ErrorRow(), doc.ErrorCol());
     return false;
   }
   // success, load the tags
-  if (LoadIncludesFromXML(doc.RootElement()))
+  if (LoadIncludesFromXML(root.get() ? root.get() : doc.RootElement()))
   {
     m_files.push_back(includeFile);
     return true;
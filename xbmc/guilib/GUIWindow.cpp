@@ -26,6 +26,7 @@
 #include "GUIControlFactory.h"
 #include "GUIControlGroup.h"
 #include "GUIControlProfiler.h"
+#include "SkinXMLCache.h"
 
 #include "addons/Skin.h"
 #include "GUIInfoManager.h"
@@ -137,16 +138,24 @@ bool CGUIWindow::LoadXML(const CStdString &strPath, const CStdString &strLowerPa
   // load window xml if we don't have it stored yet
   if (!m_windowXMLRootElement)
   {
-    CXBMCTinyXML xmlDoc;
     std::string strPathLower = strPath;
     StringUtils::ToLower(strPathLower);
-    if (!xmlDoc.LoadFile(strPath) && !xmlDoc.LoadFile(strPathLower) && !xmlDoc.LoadFile(strLowerPath))
+
+    // use the xml if it has been preloaded with the skin
+    CSkinXMLCache &cache = CSkinXMLCache::Get();
+    if (!(m_windowXMLRootElement = cache.Take(strPath)) &&
+        !(m_windowXMLRootElement = cache.Take(strPathLower)) &&
+        !(m_windowXMLRootElement = cache.Take(strLowerPath)))
     {
-      CLog::Log(LOGERROR, "unable to load:%s, Line %d\n%s", strPath.c_str(), xmlDoc.ErrorRow(), xmlDoc.ErrorDesc());
-      SetID(WINDOW_INVALID);
-      return false;
+      CXBMCTinyXML xmlDoc;
+      if (!xmlDoc.LoadFile(strPath) && !xmlDoc.LoadFile(strPathLower) && !xmlDoc.LoadFile(strLowerPath))
+      {
+        CLog::Log(LOGERROR, "unable to load:%s, Line %d\n%s", strPath.c_str(), xmlDoc.ErrorRow(), xmlDoc.ErrorDesc());
+        SetID(WINDOW_INVALID);
+        return false;
+      }
+      m_windowXMLRootElement = (TiXmlElement*)xmlDoc.RootElement()->Clone();
     }
-    m_windowXMLRootElement = (TiXmlElement*)xmlDoc.RootElement()->Clone();
   }
   else
     CLog::Log(LOGDEBUG, "Using already stored xml root node for %s", strPath.c_str());
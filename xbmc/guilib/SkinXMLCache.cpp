@@ -0,0 +1,224 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <set>
+
+#include "SkinXMLCache.h"
+#include "FileItem.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "threads/SingleLock.h"
+#include "utils/CPUInfo.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/XBMCTinyXML.h"
+
+// the files are mostly read from disk so a few workers are enough
+#define SKIN_PRELOAD_MAX_WORKERS 4
+
+using namespace XFILE;
+
+CSkinXMLCache& CSkinXMLCache::Get()
+{
+  static CSkinXMLCache sSkinXMLCache;
+  return sSkinXMLCache;
+}
+
+CSkinXMLCache::CSkinXMLCache()
+  : m_next(0),
+    m_stop(false)
+{ }
+
+CSkinXMLCache::~CSkinXMLCache()
+{
+  Clear();
+}
+
+void CSkinXMLCache::Preload(const std::vector<std::string> &folders)
+{
+  Clear();
+
+  std::vector<std::string> queue;
+  std::set<std::string> names;
+  for (std::vector<std::string>::const_iterator folder = folders.begin(); folder != folders.end(); ++folder)
+  {
+    CFileItemList items;
+    if (!CDirectory::GetDirectory(*folder, items, ".xml", DIR_FLAG_NO_FILE_DIRS))
+      continue;
+
+    for (int i = 0; i < items.Size(); i++)
+    {
+      if (items[i]->m_bIsFolder)
+        continue;
+
+      std::string name = URIUtils::GetFileName(items[i]->GetPath());
+      StringUtils::ToLower(name);
+      if (names.insert(name).second)
+        queue.push_back(CSpecialProtocol::TranslatePath(items[i]->GetPath()));
+    }
+  }
+
+  if (queue.empty())
+    return;
+
+  CSingleLock lock(m_section);
+  m_queue.swap(queue);
+  for (std::vector<std::string>::const_iterator path = m_queue.begin(); path != m_queue.end(); ++path)
+  {
+    CachedFile &file = m_files[*path];
+    file.state = StateQueued;
+    file.root = NULL;
+    file.mtime = 0;
+    file.size = 0;
+  }
+
+  size_t workers = std::min(std::min((size_t)std::max(g_cpuInfo.getCPUCount(), 1), (size_t)SKIN_PRELOAD_MAX_WORKERS), m_queue.size());
+  CLog::Log(LOGDEBUG, "%s - preloading %u skin files on %u threads", __FUNCTION__, (unsigned int)m_queue.size(), (unsigned int)workers);
+  for (size_t i = 0; i < workers; i++)
+  {
+    CThread *worker = new CThread(this, "SkinXMLPreload");
+    worker->Create();
+    m_workers.push_back(worker);
+  }
+}
+
+TiXmlElement* CSkinXMLCache::Take(const std::string &path)
+{
+  std::string translatedPath = CSpecialProtocol::TranslatePath(path);
+
+  CSingleLock lock(m_section);
+  CachedFiles::iterator it = m_files.find(translatedPath);
+  if (it == m_files.end())
+    return NULL;
+
+  while (it->second.state == StateParsing)
+  {
+    m_parsed.wait(lock);
+
+    // the cache may have been cleared in the meantime
+    it = m_files.find(translatedPath);
+    if (it == m_files.end())
+      return NULL;
+  }
+
+  CachedFile file = it->second;
+  m_files.erase(it);
+
+  // no worker has got to it yet
+  if (file.state == StateQueued)
+  {
+    lock.Leave();
+    Parse(translatedPath, file);
+    return file.root;
+  }
+
+  lock.Leave();
+
+  // make sure the file hasn't been changed since it has been parsed
+  int64_t mtime, size;
+  if (file.root != NULL && (!GetModification(translatedPath, mtime, size) || mtime != file.mtime || size != file.size))
+  {
+    CLog::Log(LOGDEBUG, "%s - %s has changed since it has been preloaded", __FUNCTION__, path.c_str());
+    delete file.root;
+    Parse(translatedPath, file);
+  }
+
+  return file.root;
+}
+
+void CSkinXMLCache::Clear()
+{
+  CSingleLock lock(m_section);
+  m_stop = true;
+  std::vector<CThread*> workers;
+  workers.swap(m_workers);
+  lock.Leave();
+
+  for (std::vector<CThread*>::iterator worker = workers.begin(); worker != workers.end(); ++worker)
+  {
+    (*worker)->StopThread(true);
+    delete *worker;
+  }
+
+  lock.Enter();
+  for (CachedFiles::iterator it = m_files.begin(); it != m_files.end(); ++it)
+    delete it->second.root;
+  m_files.clear();
+  m_queue.clear();
+  m_next = 0;
+  m_stop = false;
+  m_parsed.notifyAll();
+}
+
+void CSkinXMLCache::Run()
+{
+  CSingleLock lock(m_section);
+  while (!m_stop && m_next < m_queue.size())
+  {
+    std::string path = m_queue[m_next++];
+    CachedFiles::iterator it = m_files.find(path);
+    if (it == m_files.end() || it->second.state != StateQueued)
+      continue;
+
+    it->second.state = StateParsing;
+    CachedFile file = it->second;
+    lock.Leave();
+
+    Parse(path, file);
+
+    lock.Enter();
+    // Take() waits for files being parsed so the entry is still there
+    it = m_files.find(path);
+    if (it != m_files.end())
+      it->second = file;
+    else
+      delete file.root;
+    m_parsed.notifyAll();
+  }
+}
+
+bool CSkinXMLCache::Parse(const std::string &path, CachedFile &file)
+{
+  file.state = StateParsed;
+  file.root = NULL;
+  if (!GetModification(path, file.mtime, file.size))
+    return false;
+
+  CXBMCTinyXML xmlDoc;
+  if (!xmlDoc.LoadFile(path) || xmlDoc.RootElement() == NULL)
+    return false; // the caller loads it again and reports the error
+
+  file.root = (TiXmlElement*)xmlDoc.RootElement()->Clone();
+  return true;
+}
+
+bool CSkinXMLCache::GetModification(const std::string &path, int64_t &mtime, int64_t &size)
+{
+  struct __stat64 buffer;
+  if (CFile::Stat(path, &buffer) != 0)
+    return false;
+
+  mtime = buffer.st_mtime;
+  size = buffer.st_size;
+  return true;
+}
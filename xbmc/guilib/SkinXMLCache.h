@@ -0,0 +1,99 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+#include "threads/Thread.h"
+
+class TiXmlElement;
+
+/*!
+ \ingroup windows
+ \brief Parses the xml files of a skin in the background
+
+ Preload() parses all xml files of the given skin folders on a few worker
+ threads while the skin's fonts, strings and includes are being loaded.
+ Windows (and the includes) then take the parsed documents with Take()
+ instead of parsing the files on the GUI thread when they are loaded for
+ the first time. Every document can only be taken once, afterwards it's
+ kept by whoever took it.
+ */
+class CSkinXMLCache : public IRunnable
+{
+public:
+  static CSkinXMLCache& Get();
+
+  /*!
+   \brief Start parsing the xml files of the given skin folders in the background
+   Any previously preloaded files which haven't been taken are dropped. If the
+   same file name is found in several folders, only the first one is parsed
+   (matching CSkinInfo::GetSkinPath()).
+   \param folders the skin folders in the order in which they are searched for files.
+   */
+  void Preload(const std::vector<std::string> &folders);
+
+  /*!
+   \brief Take the parsed root element of the given file
+   Waits for the file if it's being parsed right now and parses it on the
+   calling thread if no worker has got to it yet or it has changed since.
+   \param path path of the xml file.
+   \return the root element (which has to be deleted by the caller) or NULL
+   if the file hasn't been preloaded or couldn't be parsed.
+   */
+  TiXmlElement* Take(const std::string &path);
+
+  /*!
+   \brief Stop preloading and drop all preloaded files
+   */
+  void Clear();
+
+  virtual void Run();
+
+private:
+  CSkinXMLCache();
+  virtual ~CSkinXMLCache();
+
+  enum State { StateQueued, StateParsing, StateParsed };
+
+  struct CachedFile
+  {
+    State state;
+    TiXmlElement *root;
+    int64_t mtime;
+    int64_t size;
+  };
+  typedef std::map<std::string, CachedFile> CachedFiles;
+
+  static bool Parse(const std::string &path, CachedFile &file);
+  static bool GetModification(const std::string &path, int64_t &mtime, int64_t &size);
+
+  CCriticalSection m_section;
+  XbmcThreads::ConditionVariable m_parsed;
+  CachedFiles m_files;
+  std::vector<std::string> m_queue; ///< files to be parsed by the workers (keys of m_files)
+  size_t m_next;                    ///< next file of m_queue to be parsed
+  std::vector<CThread*> m_workers;
+  bool m_stop;
+};
@@ -144,6 +144,21 @@ void CBaseTexture::Update(unsigned int width, unsigned int height, unsigned int
     LoadToGPU();
 }
 
+unsigned char* CBaseTexture::AllocateImage(unsigned int width, unsigned int height, unsigned int format, bool hasAlpha)
+{
+  // compressed formats that we don't support have to be decompressed by Update()
+  if (format & XB_FMT_DXT_MASK && !g_Windowing.SupportsDXT())
+    return NULL;
+
+  m_hasAlpha = hasAlpha;
+  Allocate(width, height, format);
+
+  if (m_imageWidth != width || m_imageHeight != height || GetPitch(m_textureWidth) != GetPitch(width))
+    return NULL;
+
+  return m_pixels;
+}
+
 void CBaseTexture::ClampToEdge()
 {
   unsigned int imagePitch = GetPitch(m_imageWidth);
@@ -308,7 +323,7 @@ bool CBaseTexture::LoadIImage(IImage *pImage, unsigned char* buffer, unsigned in
   return false;
 }
 
-bool CBaseTexture::LoadFromMemory(unsigned int width, unsigned int height, unsigned int pitch, unsigned int format, bool hasAlpha, unsigned char* pixels)
+bool CBaseTexture::LoadFromMemory(unsigned int width, unsigned int height, unsigned int pitch, unsigned int format, bool hasAlpha, const unsigned char* pixels)
 {
   m_imageWidth = m_originalWidth = width;
   m_imageHeight = m_originalHeight = height;
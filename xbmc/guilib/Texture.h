@@ -73,7 +73,7 @@ public:
   static CBaseTexture *LoadFromFileInMemory(unsigned char* buffer, size_t bufferSize, const std::string& mimeType,
                                             unsigned int idealWidth = 0, unsigned int idealHeight = 0);
 
-  bool LoadFromMemory(unsigned int width, unsigned int height, unsigned int pitch, unsigned int format, bool hasAlpha, unsigned char* pixels);
+  bool LoadFromMemory(unsigned int width, unsigned int height, unsigned int pitch, unsigned int format, bool hasAlpha, const unsigned char* pixels);
   bool LoadPaletted(unsigned int width, unsigned int height, unsigned int pitch, unsigned int format, const unsigned char *pixels, const COLOR *palette);
 
   bool HasAlpha() const;
@@ -102,6 +102,17 @@ public:
   void Allocate(unsigned int width, unsigned int height, unsigned int format);
   void ClampToEdge();
 
+  /*! \brief Allocate the texture for an image which is written straight into the pixel buffer
+   \param width the width of the image.
+   \param height the height of the image.
+   \param format the format of the image.
+   \param hasAlpha whether the image has an alpha channel.
+   \return the pixel buffer if the image can be written into it as-is (the format is supported and
+   the rows of the image and the texture have the same pitch), NULL otherwise. Call ClampToEdge()
+   after writing the image.
+   */
+  unsigned char* AllocateImage(unsigned int width, unsigned int height, unsigned int format, bool hasAlpha);
+
   static unsigned int PadPow2(unsigned int x);
   static bool SwapBlueRed(unsigned char *pixels, unsigned int height, unsigned int pitch, unsigned int elements = 4, unsigned int offset=0);
 
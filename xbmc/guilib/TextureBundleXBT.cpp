@@ -194,50 +194,59 @@ int CTextureBundleXBT::LoadAnim(const CStdString& Filename, CBaseTexture*** ppTe
 
 bool CTextureBundleXBT::ConvertFrameToTexture(const CStdString& name, CXBTFFrame& frame, CBaseTexture** ppTexture)
 {
-  // found texture - allocate the necessary buffers
-  squish::u8 *buffer = new squish::u8[(size_t)frame.GetPackedSize()];
-  if (buffer == NULL)
-  {
-    CLog::Log(LOGERROR, "Out of memory loading texture: %s (need %" PRIu64" bytes)", name.c_str(), frame.GetPackedSize());
-    return false;
-  }
-
-  // load the compressed texture
-  if (!m_XBTFReader.Load(frame, buffer))
+  // the (compressed) texture within the mapped bundle
+  const unsigned char *data = m_XBTFReader.GetData(frame);
+  if (data == NULL)
   {
     CLog::Log(LOGERROR, "Error loading texture: %s", name.c_str());
-    delete[] buffer;
     return false;
   }
 
+  // create an xbmc texture
+  CBaseTexture *texture = new CTexture();
+
   // check if it's packed with lzo
-  if (frame.IsPacked())
-  { // unpack
-    squish::u8 *unpacked = new squish::u8[(size_t)frame.GetUnpackedSize()];
+  if (!frame.IsPacked())
+  { // use it straight from the bundle
+    texture->LoadFromMemory(frame.GetWidth(), frame.GetHeight(), 0, frame.GetFormat(), frame.HasAlpha(), data);
+    *ppTexture = texture;
+    return true;
+  }
+
+  // unpack straight into the texture if it has the same layout as the image
+  squish::u8 *unpacked = NULL;
+  squish::u8 *pixels = texture->AllocateImage(frame.GetWidth(), frame.GetHeight(), frame.GetFormat(), frame.HasAlpha());
+  if (pixels == NULL || frame.GetUnpackedSize() > (uint64_t)texture->GetPitch() * texture->GetRows())
+  {
+    unpacked = new squish::u8[(size_t)frame.GetUnpackedSize()];
     if (unpacked == NULL)
     {
       CLog::Log(LOGERROR, "Out of memory unpacking texture: %s (need %" PRIu64" bytes)", name.c_str(), frame.GetUnpackedSize());
-      delete[] buffer;
-      return false;
-    }
-    lzo_uint s = (lzo_uint)frame.GetUnpackedSize();
-    if (lzo1x_decompress_safe(buffer, (lzo_uint)frame.GetPackedSize(), unpacked, &s, NULL) != LZO_E_OK ||
-        s != frame.GetUnpackedSize())
-    {
-      CLog::Log(LOGERROR, "Error loading texture: %s: Decompression error", name.c_str());
-      delete[] buffer;
-      delete[] unpacked;
+      delete texture;
       return false;
     }
-    delete[] buffer;
-    buffer = unpacked;
+    pixels = unpacked;
   }
 
-  // create an xbmc texture
-  *ppTexture = new CTexture();
-  (*ppTexture)->LoadFromMemory(frame.GetWidth(), frame.GetHeight(), 0, frame.GetFormat(), frame.HasAlpha(), buffer);
+  lzo_uint s = (lzo_uint)frame.GetUnpackedSize();
+  if (lzo1x_decompress_safe(data, (lzo_uint)frame.GetPackedSize(), pixels, &s, NULL) != LZO_E_OK ||
+      s != frame.GetUnpackedSize())
+  {
+    CLog::Log(LOGERROR, "Error loading texture: %s: Decompression error", name.c_str());
+    delete[] unpacked;
+    delete texture;
+    return false;
+  }
+
+  if (unpacked != NULL)
+  {
+    texture->LoadFromMemory(frame.GetWidth(), frame.GetHeight(), 0, frame.GetFormat(), frame.HasAlpha(), unpacked);
+    delete[] unpacked;
+  }
+  else
+    texture->ClampToEdge();
 
-  delete[] buffer;
+  *ppTexture = texture;
 
   return true;
 }
@@ -143,6 +143,11 @@ char* CXBTFFile::GetPath()
   return m_path;
 }
 
+const char* CXBTFFile::GetPath() const
+{
+  return m_path;
+}
+
 void CXBTFFile::SetPath(const std::string& path)
 {
   memset(m_path, 0, sizeof(m_path));
@@ -78,6 +78,7 @@ public:
   CXBTFFile();
   CXBTFFile(const CXBTFFile& ref);
   char* GetPath();
+  const char* GetPath() const;
   void SetPath(const std::string& path);
   uint32_t GetLoop() const;
   void SetLoop(uint32_t loop);
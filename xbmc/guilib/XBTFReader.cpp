@@ -19,33 +19,63 @@
  */
 
 #include <sys/stat.h>
+#include <algorithm>
 #include "XBTFReader.h"
 #include "utils/EndianSwap.h"
 #include "utils/CharsetConverter.h"
 #ifdef TARGET_WINDOWS
 #include "FileSystem/SpecialProtocol.h"
+#include <io.h>
+#else
+#include <sys/mman.h>
 #endif
 
 #include <string.h>
 #include "PlatformDefs.h"
 
-#define READ_STR(str, size, file) \
-  if (!fread(str, size, 1, file)) \
-    return false;
-
-#define READ_U32(i, file) \
-  if (!fread(&i, 4, 1, file)) \
+#define READ_STR(str, size, pos, end) \
+  if ((size_t)((end) - (pos)) < (size_t)(size)) \
     return false; \
+  memcpy(str, pos, size); \
+  pos += size;
+
+#define READ_U32(i, pos, end) \
+  READ_STR(&i, 4, pos, end) \
   i = Endian_SwapLE32(i);
 
-#define READ_U64(i, file) \
-  if (!fread(&i, 8, 1, file)) \
-    return false; \
+#define READ_U64(i, pos, end) \
+  READ_STR(&i, 8, pos, end) \
   i = Endian_SwapLE64(i);
 
+// size of the header of a file without any frames
+#define XBTF_FILE_HEADER_SIZE (256 + 4 + 4)
+
+namespace
+{
+  bool PathLess(const CXBTFFile* left, const CXBTFFile* right)
+  {
+    return strncmp(left->GetPath(), right->GetPath(), 256) < 0;
+  }
+
+  bool NameLessThanPath(const char* name, const CXBTFFile* file)
+  {
+    return strncmp(name, file->GetPath(), 256) < 0;
+  }
+}
+
 CXBTFReader::CXBTFReader()
 {
   m_file = NULL;
+#ifdef TARGET_WINDOWS
+  m_mapping = NULL;
+#endif
+  m_data = NULL;
+  m_size = 0;
+}
+
+CXBTFReader::~CXBTFReader()
+{
+  Close();
 }
 
 bool CXBTFReader::IsOpen() const
@@ -55,6 +85,8 @@ bool CXBTFReader::IsOpen() const
 
 bool CXBTFReader::Open(const CStdString& fileName)
 {
+  Close();
+
   m_fileName = fileName;
 
 #ifdef TARGET_WINDOWS
@@ -69,8 +101,75 @@ bool CXBTFReader::Open(const CStdString& fileName)
     return false;
   }
 
+  if (!Map() || !ReadHeader())
+  {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+bool CXBTFReader::Map()
+{
+  struct stat fileStat;
+  if (fstat(fileno(m_file), &fileStat) == -1 || fileStat.st_size <= 0 ||
+      (uint64_t)fileStat.st_size > (uint64_t)(size_t)-1)
+  {
+    return false;
+  }
+
+  m_size = (size_t)fileStat.st_size;
+
+#ifdef TARGET_WINDOWS
+  m_mapping = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(m_file)), NULL, PAGE_READONLY, 0, 0, NULL);
+  if (m_mapping == NULL)
+  {
+    return false;
+  }
+
+  m_data = (const unsigned char*)MapViewOfFile((HANDLE)m_mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+  void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fileno(m_file), 0);
+  if (data != MAP_FAILED)
+  {
+    m_data = (const unsigned char*)data;
+  }
+#endif
+
+  return m_data != NULL;
+}
+
+void CXBTFReader::Unmap()
+{
+#ifdef TARGET_WINDOWS
+  if (m_data)
+  {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mapping)
+  {
+    CloseHandle((HANDLE)m_mapping);
+    m_mapping = NULL;
+  }
+#else
+  if (m_data)
+  {
+    munmap((void*)m_data, m_size);
+  }
+#endif
+
+  m_data = NULL;
+  m_size = 0;
+}
+
+bool CXBTFReader::ReadHeader()
+{
+  const unsigned char* pos = m_data;
+  const unsigned char* end = m_data + m_size;
+
   char magic[4];
-  READ_STR(magic, 4, m_file);
+  READ_STR(magic, 4, pos, end);
 
   if (strncmp(magic, XBTF_MAGIC, sizeof(magic)) != 0)
   {
@@ -78,7 +177,7 @@ bool CXBTFReader::Open(const CStdString& fileName)
   }
 
   char version[1];
-  READ_STR(version, 1, m_file);
+  READ_STR(version, 1, pos, end);
 
   if (strncmp(version, XBTF_VERSION, sizeof(version)) != 0)
   {
@@ -86,60 +185,83 @@ bool CXBTFReader::Open(const CStdString& fileName)
   }
 
   unsigned int nofFiles;
-  READ_U32(nofFiles, m_file);
+  READ_U32(nofFiles, pos, end);
+
+  // every file needs at least its own header
+  if (nofFiles > (size_t)(end - pos) / XBTF_FILE_HEADER_SIZE)
+  {
+    return false;
+  }
+
+  std::vector<CXBTFFile>& files = m_xbtf.GetFiles();
+  files.resize(nofFiles);
   for (unsigned int i = 0; i < nofFiles; i++)
   {
-    CXBTFFile file;
+    CXBTFFile& file = files[i];
     unsigned int u32;
     uint64_t u64;
 
-    READ_STR(file.GetPath(), 256, m_file);
-    READ_U32(u32, m_file);
+    READ_STR(file.GetPath(), 256, pos, end);
+    READ_U32(u32, pos, end);
     file.SetLoop(u32);
 
     unsigned int nofFrames;
-    READ_U32(nofFrames, m_file);
+    READ_U32(nofFrames, pos, end);
+
+    std::vector<CXBTFFrame>& frames = file.GetFrames();
+    if (nofFrames > (size_t)(end - pos) / CXBTFFrame().GetHeaderSize())
+    {
+      return false;
+    }
+    frames.resize(nofFrames);
 
     for (unsigned int j = 0; j < nofFrames; j++)
     {
-      CXBTFFrame frame;
+      CXBTFFrame& frame = frames[j];
 
-      READ_U32(u32, m_file);
+      READ_U32(u32, pos, end);
       frame.SetWidth(u32);
-      READ_U32(u32, m_file);
+      READ_U32(u32, pos, end);
       frame.SetHeight(u32);
-      READ_U32(u32, m_file);
+      READ_U32(u32, pos, end);
       frame.SetFormat(u32);
-      READ_U64(u64, m_file);
+      READ_U64(u64, pos, end);
       frame.SetPackedSize(u64);
-      READ_U64(u64, m_file);
+      READ_U64(u64, pos, end);
       frame.SetUnpackedSize(u64);
-      READ_U32(u32, m_file);
+      READ_U32(u32, pos, end);
       frame.SetDuration(u32);
-      READ_U64(u64, m_file);
+      READ_U64(u64, pos, end);
       frame.SetOffset(u64);
 
-      file.GetFrames().push_back(frame);
+      // the data of every frame has to be within the bundle
+      if (frame.GetOffset() > m_size || frame.GetPackedSize() > m_size - frame.GetOffset())
+      {
+        return false;
+      }
     }
 
-    m_xbtf.GetFiles().push_back(file);
-
-    m_filesMap[file.GetPath()] = file;
+    m_index.push_back(&file);
   }
 
   // Sanity check
-  int64_t pos = ftell(m_file);
-  if (pos != (int64_t)m_xbtf.GetHeaderSize())
+  int64_t headerSize = pos - m_data;
+  if (headerSize != (int64_t)m_xbtf.GetHeaderSize())
   {
-    printf("Expected header size (%" PRId64") != actual size (%" PRId64")\n", m_xbtf.GetHeaderSize(), pos);
+    printf("Expected header size (%" PRId64") != actual size (%" PRId64")\n", m_xbtf.GetHeaderSize(), headerSize);
     return false;
   }
 
+  // stable so that Find() still returns the last of several files with the same path
+  std::stable_sort(m_index.begin(), m_index.end(), PathLess);
+
   return true;
 }
 
 void CXBTFReader::Close()
 {
+  Unmap();
+
   if (m_file)
   {
     fclose(m_file);
@@ -147,7 +269,7 @@ void CXBTFReader::Close()
   }
 
   m_xbtf.GetFiles().clear();
-  m_filesMap.clear();
+  m_index.clear();
 }
 
 time_t CXBTFReader::GetLastModificationTimestamp()
@@ -173,35 +295,41 @@ bool CXBTFReader::Exists(const CStdString& name)
 
 CXBTFFile* CXBTFReader::Find(const CStdString& name)
 {
-  std::map<CStdString, CXBTFFile>::iterator iter = m_filesMap.find(name);
-  if (iter == m_filesMap.end())
+  if (name.size() >= 256)
   {
     return NULL;
   }
 
-  return &(iter->second);
+  std::vector<CXBTFFile*>::const_iterator iter = std::upper_bound(m_index.begin(), m_index.end(), name.c_str(), NameLessThanPath);
+  if (iter == m_index.begin() || strncmp((*(iter - 1))->GetPath(), name.c_str(), 256) != 0)
+  {
+    return NULL;
+  }
+
+  return *(iter - 1);
 }
 
-bool CXBTFReader::Load(const CXBTFFrame& frame, unsigned char* buffer)
+const unsigned char* CXBTFReader::GetData(const CXBTFFrame& frame) const
 {
-  if (!m_file)
-  {
-    return false;
-  }
-#if defined(TARGET_DARWIN) || defined(TARGET_FREEBSD) || defined(TARGET_ANDROID)
-    if (fseeko(m_file, (off_t)frame.GetOffset(), SEEK_SET) == -1)
-#else
-    if (fseeko64(m_file, (off_t)frame.GetOffset(), SEEK_SET) == -1)
-#endif
+  // the frames have been checked to be within the mapping by ReadHeader()
+  if (!m_data)
   {
-    return false;
+    return NULL;
   }
 
-  if (fread(buffer, 1, (size_t)frame.GetPackedSize(), m_file) != frame.GetPackedSize())
+  return m_data + frame.GetOffset();
+}
+
+bool CXBTFReader::Load(const CXBTFFrame& frame, unsigned char* buffer)
+{
+  const unsigned char* data = GetData(frame);
+  if (!data)
   {
     return false;
   }
 
+  memcpy(buffer, data, (size_t)frame.GetPackedSize());
+
   return true;
 }
 
@@ -22,28 +22,55 @@
 #define XBTFREADER_H_
 
 #include <vector>
-#include <map>
 #include "utils/StdString.h"
 #include "XBTF.h"
 
+/*!
+ \brief Reader for XBTF texture bundles (Textures.xbt)
+
+ The bundle is mapped into memory as a whole. The header is parsed from the
+ mapping and the files are looked up through an index sorted by path. The
+ data of a frame is handed out as a pointer into the mapping (see GetData())
+ so it can be uploaded or decompressed without copying it into a buffer
+ first. The pointers stay valid until Close() is called.
+ */
 class CXBTFReader
 {
 public:
   CXBTFReader();
+  ~CXBTFReader();
   bool IsOpen() const;
   bool Open(const CStdString& fileName);
   void Close();
   time_t GetLastModificationTimestamp();
   bool Exists(const CStdString& name);
   CXBTFFile* Find(const CStdString& name);
+
+  /*!
+   \brief Get the (packed) data of the given frame
+   \param frame Frame of one of the files in the bundle
+   \return Pointer to GetPackedSize() bytes within the mapped bundle or NULL
+   if the bundle isn't open
+   */
+  const unsigned char* GetData(const CXBTFFrame& frame) const;
+
   bool Load(const CXBTFFrame& frame, unsigned char* buffer);
   std::vector<CXBTFFile>&  GetFiles();
 
 private:
+  bool Map();
+  void Unmap();
+  bool ReadHeader();
+
   CXBTF      m_xbtf;
   CStdString m_fileName;
   FILE*      m_file;
-  std::map<CStdString, CXBTFFile> m_filesMap;
+#ifdef TARGET_WINDOWS
+  void*      m_mapping; // HANDLE of the file mapping object
+#endif
+  const unsigned char* m_data;
+  size_t     m_size;
+  std::vector<CXBTFFile*> m_index; // files of m_xbtf sorted by path
 };
 
 #endif
@@ -0,0 +1,153 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "guilib/SkinXMLCache.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/XBMCTinyXML.h"
+
+#if defined(TARGET_POSIX)
+#include "linux/XTimeUtils.h"
+#endif
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <time.h>
+#if defined(TARGET_WINDOWS)
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+using namespace XFILE;
+
+class TestSkinXMLCache : public testing::Test
+{
+protected:
+  TestSkinXMLCache()
+  {
+    std::string temp = CSpecialProtocol::TranslatePath("special://temp/");
+    folders.push_back(URIUtils::AddFileToFolder(temp, "TestSkinXMLCache/720p/"));
+    folders.push_back(URIUtils::AddFileToFolder(temp, "TestSkinXMLCache/1080i/"));
+    CDirectory::Create(URIUtils::AddFileToFolder(temp, "TestSkinXMLCache/"));
+    for (std::vector<std::string>::const_iterator folder = folders.begin(); folder != folders.end(); ++folder)
+      CDirectory::Create(*folder);
+  }
+
+  ~TestSkinXMLCache()
+  {
+    CSkinXMLCache::Get().Clear();
+    for (std::vector<std::string>::const_iterator file = files.begin(); file != files.end(); ++file)
+      CFile::Delete(*file);
+    for (std::vector<std::string>::const_iterator folder = folders.begin(); folder != folders.end(); ++folder)
+      CDirectory::Remove(*folder);
+    CDirectory::Remove(URIUtils::AddFileToFolder(CSpecialProtocol::TranslatePath("special://temp/"), "TestSkinXMLCache/"));
+  }
+
+  std::string WriteFile(unsigned int folder, const std::string &name, const std::string &content)
+  {
+    std::string path = URIUtils::AddFileToFolder(folders[folder], name);
+    CFile file;
+    if (file.OpenForWrite(path, true))
+    {
+      file.Write(content.c_str(), content.size());
+      file.Close();
+    }
+    if (std::find(files.begin(), files.end(), path) == files.end())
+      files.push_back(path);
+    return path;
+  }
+
+  std::vector<std::string> folders;
+  std::vector<std::string> files;
+};
+
+TEST_F(TestSkinXMLCache, Take)
+{
+  std::vector<std::string> paths;
+  for (unsigned int i = 0; i < 20; i++)
+    paths.push_back(WriteFile(0, StringUtils::Format("Window%u.xml", i), StringUtils::Format("<window id=\"%u\"><controls/></window>", i)));
+  std::string includes = WriteFile(1, "Includes.xml", "<includes><include name=\"a\"/></includes>");
+  // only the file of the first folder is preloaded
+  std::string shadowed = WriteFile(1, "Window0.xml", "<window id=\"100\"/>");
+  std::string invalid = WriteFile(0, "Invalid.xml", "<window><controls></window>");
+
+  CSkinXMLCache &cache = CSkinXMLCache::Get();
+  cache.Preload(folders);
+
+  for (unsigned int i = 0; i < paths.size(); i++)
+  {
+    TiXmlElement *root = cache.Take(paths[i]);
+    ASSERT_TRUE(root != NULL) << paths[i];
+    EXPECT_STREQ("window", root->Value());
+    int id = -1;
+    EXPECT_TRUE(root->Attribute("id", &id) != NULL);
+    EXPECT_EQ((int)i, id);
+    delete root;
+
+    // every file can only be taken once
+    EXPECT_TRUE(cache.Take(paths[i]) == NULL);
+  }
+
+  TiXmlElement *root = cache.Take(includes);
+  ASSERT_TRUE(root != NULL);
+  EXPECT_STREQ("includes", root->Value());
+  delete root;
+
+  EXPECT_TRUE(cache.Take(shadowed) == NULL);
+  EXPECT_TRUE(cache.Take(invalid) == NULL);
+  EXPECT_TRUE(cache.Take(URIUtils::AddFileToFolder(folders[0], "Unknown.xml")) == NULL);
+}
+
+TEST_F(TestSkinXMLCache, Changed)
+{
+  std::string path = WriteFile(0, "Changed.xml", "<window><previous/></window>");
+
+  CSkinXMLCache &cache = CSkinXMLCache::Get();
+  cache.Preload(folders);
+
+  // give the workers time to parse the file, then change it without changing its size
+  Sleep(200);
+  WriteFile(0, "Changed.xml", "<window><controls/></window>");
+  struct utimbuf times;
+  times.actime = times.modtime = time(NULL) + 10;
+  ASSERT_EQ(0, utime(CSpecialProtocol::TranslatePath(path).c_str(), &times));
+
+  // the outdated document is never handed out, the file is parsed again
+  TiXmlElement *root = cache.Take(path);
+  ASSERT_TRUE(root != NULL);
+  EXPECT_TRUE(root->FirstChildElement("controls") != NULL);
+  EXPECT_TRUE(root->FirstChildElement("previous") == NULL);
+  delete root;
+}
+
+TEST_F(TestSkinXMLCache, Clear)
+{
+  std::string path = WriteFile(0, "Home.xml", "<window/>");
+
+  CSkinXMLCache &cache = CSkinXMLCache::Get();
+  cache.Preload(folders);
+  cache.Clear();
+  EXPECT_TRUE(cache.Take(path) == NULL);
+}
@@ -0,0 +1,189 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "guilib/XBTFReader.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+static void AppendU32(std::string &data, uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+    data += (char)((value >> (8 * i)) & 0xff);
+}
+
+static void AppendU64(std::string &data, uint64_t value)
+{
+  for (int i = 0; i < 8; i++)
+    data += (char)((value >> (8 * i)) & 0xff);
+}
+
+class TestXBTFReader : public testing::Test
+{
+protected:
+  TestXBTFReader()
+  {
+    file = XBMC_CREATETEMPFILE(".xbt");
+  }
+
+  ~TestXBTFReader()
+  {
+    reader.Close();
+    EXPECT_TRUE(XBMC_DELETETEMPFILE(file));
+  }
+
+  /*! \brief Write a bundle with the given files which all have a single frame
+   holding the name of the file (or as many frames as the name is long if
+   animated is true). */
+  bool WriteBundle(const char **names, unsigned int count, bool animated = false, uint64_t extraOffset = 0)
+  {
+    std::string header = XBTF_MAGIC XBTF_VERSION;
+    AppendU32(header, count);
+
+    size_t headerSize = header.size();
+    for (unsigned int i = 0; i < count; i++)
+      headerSize += 256 + 4 + 4 + (animated ? strlen(names[i]) : 1) * (4 * 4 + 8 * 3);
+
+    std::string data;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      char path[256];
+      memset(path, 0, sizeof(path));
+      strncpy(path, names[i], sizeof(path) - 1);
+      header.append(path, sizeof(path));
+      AppendU32(header, 0);
+
+      unsigned int frames = animated ? strlen(names[i]) : 1;
+      AppendU32(header, frames);
+      for (unsigned int j = 0; j < frames; j++)
+      {
+        std::string frame = animated ? std::string(names[i] + j) : std::string(names[i]);
+        AppendU32(header, 1);
+        AppendU32(header, 1);
+        AppendU32(header, XB_FMT_A8R8G8B8);
+        AppendU64(header, frame.size());
+        AppendU64(header, frame.size());
+        AppendU32(header, 100);
+        AppendU64(header, headerSize + data.size() + extraOffset);
+        data += frame;
+      }
+    }
+
+    header += data;
+    if (file->Write(header.c_str(), header.size()) != (int)header.size())
+      return false;
+    file->Close();
+    return true;
+  }
+
+  CXBTFReader reader;
+  XFILE::CFile *file;
+};
+
+TEST_F(TestXBTFReader, Find)
+{
+  const char *names[] = { "textures/b.png", "a.png", "textures/a.png", "c.png" };
+  ASSERT_TRUE(WriteBundle(names, 4));
+  ASSERT_TRUE(reader.Open(XBMC_TEMPFILEPATH(file)));
+  EXPECT_TRUE(reader.IsOpen());
+
+  // the files are kept in the order of the bundle
+  ASSERT_EQ(4U, reader.GetFiles().size());
+  for (unsigned int i = 0; i < 4; i++)
+    EXPECT_STREQ(names[i], reader.GetFiles()[i].GetPath());
+
+  for (unsigned int i = 0; i < 4; i++)
+  {
+    CXBTFFile *xbtfFile = reader.Find(names[i]);
+    ASSERT_TRUE(xbtfFile != NULL) << names[i];
+    EXPECT_EQ(&reader.GetFiles()[i], xbtfFile);
+    EXPECT_TRUE(reader.Exists(names[i]));
+  }
+
+  EXPECT_TRUE(reader.Find("") == NULL);
+  EXPECT_TRUE(reader.Find("a.pn") == NULL);
+  EXPECT_TRUE(reader.Find("a.png2") == NULL);
+  EXPECT_TRUE(reader.Find("b.png") == NULL);
+  EXPECT_TRUE(reader.Find("textures/") == NULL);
+  EXPECT_TRUE(reader.Find("z.png") == NULL);
+  EXPECT_FALSE(reader.Exists("textures/c.png"));
+
+  reader.Close();
+  EXPECT_FALSE(reader.IsOpen());
+  EXPECT_TRUE(reader.Find("a.png") == NULL);
+}
+
+TEST_F(TestXBTFReader, GetData)
+{
+  const char *names[] = { "anim.gif", "still.png" };
+  ASSERT_TRUE(WriteBundle(names, 2, true));
+  ASSERT_TRUE(reader.Open(XBMC_TEMPFILEPATH(file)));
+
+  for (unsigned int i = 0; i < 2; i++)
+  {
+    CXBTFFile *xbtfFile = reader.Find(names[i]);
+    ASSERT_TRUE(xbtfFile != NULL);
+    ASSERT_EQ(strlen(names[i]), xbtfFile->GetFrames().size());
+
+    for (unsigned int j = 0; j < xbtfFile->GetFrames().size(); j++)
+    {
+      const CXBTFFrame &frame = xbtfFile->GetFrames()[j];
+      std::string expected(names[i] + j);
+      ASSERT_EQ(expected.size(), frame.GetPackedSize());
+      EXPECT_FALSE(frame.IsPacked());
+
+      const unsigned char *data = reader.GetData(frame);
+      ASSERT_TRUE(data != NULL);
+      EXPECT_EQ(expected, std::string((const char *)data, (size_t)frame.GetPackedSize()));
+
+      std::string buffer(expected.size(), ' ');
+      EXPECT_TRUE(reader.Load(frame, (unsigned char *)&buffer[0]));
+      EXPECT_EQ(expected, buffer);
+    }
+  }
+}
+
+TEST_F(TestXBTFReader, Invalid)
+{
+  // frames beyond the end of the bundle
+  const char *names[] = { "a.png", "b.png" };
+  ASSERT_TRUE(WriteBundle(names, 2, false, 1));
+  EXPECT_FALSE(reader.Open(XBMC_TEMPFILEPATH(file)));
+  EXPECT_FALSE(reader.IsOpen());
+  EXPECT_TRUE(reader.GetFiles().empty());
+
+  // more files than the bundle holds
+  std::string header = XBTF_MAGIC XBTF_VERSION;
+  AppendU32(header, 1000);
+  ASSERT_TRUE(file->OpenForWrite(XBMC_TEMPFILEPATH(file), true));
+  ASSERT_EQ((int)header.size(), file->Write(header.c_str(), header.size()));
+  file->Close();
+  EXPECT_FALSE(reader.Open(XBMC_TEMPFILEPATH(file)));
+  EXPECT_FALSE(reader.IsOpen());
+
+  // empty file
+  ASSERT_TRUE(file->OpenForWrite(XBMC_TEMPFILEPATH(file), true));
+  file->Close();
+  EXPECT_FALSE(reader.Open(XBMC_TEMPFILEPATH(file)));
+  EXPECT_FALSE(reader.IsOpen());
+}
@@ -89,7 +89,7 @@ JSONRPC_STATUS CAudioLibrary::GetArtists(const std::string &method, ITransportLa
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("artistid", false, "artists", items, param, result, size, false);
+  StreamFileItemList("artistid", false, "artists", items, param, result, size, false);
   return OK;
 }
 
@@ -165,7 +165,7 @@ JSONRPC_STATUS CAudioLibrary::GetAlbums(const std::string &method, ITransportLay
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("albumid", false, "albums", items, parameterObject, result, size, false);
+  StreamFileItemList("albumid", false, "albums", items, parameterObject, result, size, false);
 
   return OK;
 }
@@ -247,7 +247,7 @@ JSONRPC_STATUS CAudioLibrary::GetSongs(const std::string &method, ITransportLaye
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("songid", true, "songs", items, parameterObject, result, size, false);
+  StreamFileItemList("songid", true, "songs", items, parameterObject, result, size, false);
 
   return OK;
 }
@@ -388,6 +388,33 @@ JSONRPC_STATUS CAudioLibrary::GetGenres(const std::string &method, ITransportLay
   return OK;
 }
 
+JSONRPC_STATUS CAudioLibrary::Search(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  CMusicDatabase musicdatabase;
+  if (!musicdatabase.Open())
+    return InternalError;
+
+  CFileItemList items;
+  if (!musicdatabase.RankedSearch(parameterObject["query"].asString(), items))
+    return InternalError;
+
+  int start, end;
+  HandleLimits(parameterObject, result, items.Size(), start, end);
+
+  result["results"] = CVariant(CVariant::VariantTypeArray);
+  for (int index = start; index < end; index++)
+  {
+    const CMusicInfoTag *tag = items[index]->GetMusicInfoTag();
+    CVariant object;
+    object["type"] = tag->GetType();
+    object["id"] = tag->GetDatabaseId();
+    object["label"] = items[index]->GetLabel();
+    result["results"].push_back(object);
+  }
+
+  return OK;
+}
+
 JSONRPC_STATUS CAudioLibrary::SetArtistDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   int id = (int)parameterObject["artistid"].asInteger();
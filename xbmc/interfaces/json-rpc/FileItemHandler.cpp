@@ -194,7 +194,8 @@ void CFileItemHandler::FillDetails(const ISerializable *info, const CFileItemPtr
   CVariant serialization;
   info->Serialize(serialization);
 
-  bool fetchedArt = false;
+  // art filled for the whole list isn't fetched again for items lacking some of it
+  bool fetchedArt = item->GetProperty("libraryartfilled").asBoolean();
 
   std::set<std::string> originalFields = fields;
 
@@ -213,6 +214,104 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
 void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit /* = true */)
 {
   int start, end;
+  std::set<std::string> fields;
+  PrepareFileItemList(items, parameterObject, result, size, sortLimit, start, end, fields);
+
+  CThumbLoader *thumbLoader = NULL;
+  if (end - start > 0)
+    thumbLoader = CreateThumbLoader(items.Get(start));
+
+  for (int i = start; i < end; i++)
+  {
+    CFileItemPtr item = items.Get(i);
+    HandleFileItem(ID, allowFile, resultname, item, parameterObject, fields, result, true, thumbLoader);
+  }
+
+  delete thumbLoader;
+}
+
+class CFileItemHandler::CFileItemListWriter : public IJSONRPCDeferredResult
+{
+public:
+  CFileItemListWriter(const char *ID, bool allowFile, const CVariant &parameterObject, const std::set<std::string> &fields)
+    : m_ID(ID != NULL ? ID : ""),
+      m_hasID(ID != NULL),
+      m_allowFile(allowFile),
+      m_parameterObject(parameterObject),
+      m_fields(fields),
+      m_thumbLoader(NULL),
+      m_next(-1)
+  { }
+
+  virtual ~CFileItemListWriter()
+  {
+    delete m_thumbLoader;
+  }
+
+  virtual bool WriteNext(CJSONStreamWriter &writer)
+  {
+    if (m_next < 0)
+    {
+      m_thumbLoader = CreateThumbLoader(m_items.front());
+      m_next = 0;
+      return writer.StartArray();
+    }
+
+    if (m_next < (int)m_items.size())
+    {
+      CVariant object;
+      HandleFileItem(m_hasID ? m_ID.c_str() : NULL, m_allowFile, "item", m_items[m_next], m_parameterObject, m_fields, object, false, m_thumbLoader);
+      m_items[m_next++].reset(); // the item isn't needed anymore
+      return writer.Value(object["item"]);
+    }
+
+    writer.EndArray();
+    return false;
+  }
+
+  std::vector<CFileItemPtr> m_items;
+
+private:
+  std::string m_ID;
+  bool m_hasID;
+  bool m_allowFile;
+  CVariant m_parameterObject;
+  std::set<std::string> m_fields;
+  CThumbLoader *m_thumbLoader;
+  int m_next;
+};
+
+void CFileItemHandler::StreamFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, bool sortLimit /* = true */)
+{
+  StreamFileItemList(ID, allowFile, resultname, items, parameterObject, result, items.Size(), sortLimit);
+}
+
+void CFileItemHandler::StreamFileItemList(const char *ID, bool allowFile, const char *resultname, CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit /* = true */)
+{
+  if (!CJSONRPC::CanDeferResult(result))
+  {
+    HandleFileItemList(ID, allowFile, resultname, items, parameterObject, result, size, sortLimit);
+    return;
+  }
+
+  int start, end;
+  std::set<std::string> fields;
+  PrepareFileItemList(items, parameterObject, result, size, sortLimit, start, end, fields);
+
+  // like HandleFileItemList() an empty list doesn't add the member at all
+  if (end - start <= 0)
+    return;
+
+  CFileItemListWriter *writer = new CFileItemListWriter(ID, allowFile, parameterObject, fields);
+  writer->m_items.reserve(end - start);
+  for (int i = start; i < end; i++)
+    writer->m_items.push_back(items.Get(i));
+
+  CJSONRPC::DeferResult(resultname, writer);
+}
+
+void CFileItemHandler::PrepareFileItemList(CFileItemList &items, const CVariant &parameterObject, CVariant &result, int size, bool sortLimit, int &start, int &end, std::set<std::string> &fields)
+{
   HandleLimits(parameterObject, result, size, start, end);
 
   if (sortLimit)
@@ -223,32 +322,25 @@ void CFileItemHandler::HandleFileItemList(const char *ID, bool allowFile, const
     end = items.Size();
   }
 
-  CThumbLoader *thumbLoader = NULL;
-  if (end - start > 0)
-  {
-    if (items.Get(start)->HasVideoInfoTag())
-      thumbLoader = new CVideoThumbLoader();
-    else if (items.Get(start)->HasMusicInfoTag())
-      thumbLoader = new CMusicThumbLoader();
-
-    if (thumbLoader != NULL)
-      thumbLoader->OnLoaderStart();
-  }
-
-  std::set<std::string> fields;
   if (parameterObject.isMember("properties") && parameterObject["properties"].isArray())
   {
     for (CVariant::const_iterator_array field = parameterObject["properties"].begin_array(); field != parameterObject["properties"].end_array(); field++)
       fields.insert(field->asString());
   }
+}
 
-  for (int i = start; i < end; i++)
-  {
-    CFileItemPtr item = items.Get(i);
-    HandleFileItem(ID, allowFile, resultname, item, parameterObject, fields, result, true, thumbLoader);
-  }
+CThumbLoader* CFileItemHandler::CreateThumbLoader(const CFileItemPtr &item)
+{
+  CThumbLoader *thumbLoader = NULL;
+  if (item->HasVideoInfoTag())
+    thumbLoader = new CVideoThumbLoader();
+  else if (item->HasMusicInfoTag())
+    thumbLoader = new CMusicThumbLoader();
 
-  delete thumbLoader;
+  if (thumbLoader != NULL)
+    thumbLoader->OnLoaderStart();
+
+  return thumbLoader;
 }
 
 void CFileItemHandler::HandleFileItem(const char *ID, bool allowFile, const char *resultname, CFileItemPtr item, const CVariant &parameterObject, const CVariant &validFields, CVariant &result, bool append /* = true */, CThumbLoader *thumbLoader /* = NULL */)
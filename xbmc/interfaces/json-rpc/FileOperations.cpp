@@ -152,7 +152,7 @@ JSONRPC_STATUS CFileOperations::GetDirectory(const std::string &method, ITranspo
       param["properties"].append("file");
     param["properties"].append("filetype");
 
-    HandleFileItemList("id", true, "files", filteredFiles, param, result);
+    StreamFileItemList("id", true, "files", filteredFiles, param, result);
 
     return OK;
   }
@@ -19,14 +19,17 @@
  */
 
 #include <string.h>
+#include <algorithm>
 
 #include "JSONRPC.h"
+#include "JSONRPCRequestParser.h"
 #include "ServiceDescription.h"
 #include "dbwrappers/DatabaseQuery.h"
 #include "input/ButtonTranslator.h"
 #include "interfaces/AnnouncementManager.h"
 #include "playlists/SmartPlayList.h"
 #include "settings/AdvancedSettings.h"
+#include "threads/ThreadLocal.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
@@ -38,6 +41,14 @@ using namespace std;
 
 bool CJSONRPC::m_initialized = false;
 
+// request currently handled by this thread which accepts deferred results
+struct DeferringContext
+{
+  CJSONRPCResponse *response;
+  const CVariant *result;
+};
+static XbmcThreads::ThreadLocal<DeferringContext> deferringContext;
+
 void CJSONRPC::Initialize()
 {
   if (m_initialized)
@@ -229,48 +240,120 @@ JSONRPC_STATUS CJSONRPC::NotifyAll(const std::string &method, ITransportLayer *t
 
 std::string CJSONRPC::MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client)
 {
-  CVariant inputroot, outputroot, result;
+  std::string str;
+  CJSONRPCResponse *response = MethodCallStreamed(inputString, transport, client);
+  if (response != NULL)
+  {
+    CJSONStringSink sink(str);
+    if (!response->Write(sink))
+      str.clear();
+    delete response;
+  }
+
+  return str;
+}
+
+CJSONRPCResponse* CJSONRPC::MethodCallStreamed(const std::string &inputString, ITransportLayer *transport, IClient *client)
+{
+  CVariant inputroot;
   bool hasResponse = false;
+  CJSONRPCResponse *streamedResponse = new CJSONRPCResponse(g_advancedSettings.m_jsonOutputCompact);
+  CVariant &outputroot = streamedResponse->m_response;
+
+  // results can only be deferred for single requests
+  DeferringContext context = { streamedResponse, NULL };
+  DeferringContext *outerContext = deferringContext.get();
 
   if(g_advancedSettings.CanLogComponent(LOGJSONRPC))
     CLog::Log(LOGDEBUG, "JSONRPC: Incoming request: %s", inputString.c_str());
 
-  inputroot = CJSONVariantParser::Parse((unsigned char *)inputString.c_str(), inputString.length());
-  if (!inputroot.isNull())
+  // valid single requests are parsed and checked in one go, everything
+  // else takes the generic path which produces the proper error responses
+  CJSONRPCRequestParser request;
+  if (request.Parse(inputString.c_str(), inputString.length(), transport, client))
   {
-    if (inputroot.isArray())
+    deferringContext.set(&context);
+    hasResponse = HandleMethodCall(request, outputroot, transport, client);
+    deferringContext.set(outerContext);
+  }
+  else
+  {
+    inputroot = CJSONVariantParser::Parse((unsigned char *)inputString.c_str(), inputString.length());
+    if (!inputroot.isNull())
     {
-      if (inputroot.size() <= 0)
+      if (inputroot.isArray())
       {
-        CLog::Log(LOGERROR, "JSONRPC: Empty batch call\n");
-        BuildResponse(inputroot, InvalidRequest, CVariant(), outputroot);
-        hasResponse = true;
-      }
-      else
-      {
-        for (CVariant::const_iterator_array itr = inputroot.begin_array(); itr != inputroot.end_array(); itr++)
+        if (inputroot.size() <= 0)
+        {
+          CLog::Log(LOGERROR, "JSONRPC: Empty batch call\n");
+          BuildResponse(CVariant(), InvalidRequest, CVariant(), outputroot);
+          hasResponse = true;
+        }
+        else
         {
-          CVariant response;
-          if (HandleMethodCall(*itr, response, transport, client))
+          deferringContext.set(NULL);
+          for (CVariant::const_iterator_array itr = inputroot.begin_array(); itr != inputroot.end_array(); itr++)
           {
-            outputroot.append(response);
-            hasResponse = true;
+            CVariant response;
+            if (HandleMethodCall(*itr, response, transport, client))
+            {
+              outputroot.append(response);
+              hasResponse = true;
+            }
           }
+          deferringContext.set(outerContext);
         }
       }
+      else
+      {
+        deferringContext.set(&context);
+        hasResponse = HandleMethodCall(inputroot, outputroot, transport, client);
+        deferringContext.set(outerContext);
+      }
     }
     else
-      hasResponse = HandleMethodCall(inputroot, outputroot, transport, client);
+    {
+      CLog::Log(LOGERROR, "JSONRPC: Failed to parse '%s'\n", inputString.c_str());
+      BuildResponse(CVariant(), ParseError, CVariant(), outputroot);
+      hasResponse = true;
+    }
   }
-  else
+
+  if (!hasResponse)
   {
-    CLog::Log(LOGERROR, "JSONRPC: Failed to parse '%s'\n", inputString.c_str());
-    BuildResponse(inputroot, ParseError, CVariant(), outputroot);
-    hasResponse = true;
+    delete streamedResponse;
+    return NULL;
   }
 
-  std::string str = hasResponse ? CJSONVariantWriter::Write(outputroot, g_advancedSettings.m_jsonOutputCompact) : "";
-  return str;
+  streamedResponse->Prepare();
+  return streamedResponse;
+}
+
+bool CJSONRPC::CanDeferResult(const CVariant &result)
+{
+  DeferringContext *context = deferringContext.get();
+  return context != NULL && context->result == &result;
+}
+
+void CJSONRPC::DeferResult(const std::string &key, IJSONRPCDeferredResult *result)
+{
+  DeferringContext *context = deferringContext.get();
+  if (context == NULL)
+  {
+    delete result;
+    return;
+  }
+
+  CJSONRPCResponse *response = context->response;
+
+  CJSONRPCResponse::DeferredResults::iterator it = response->m_deferred.find(key);
+  if (it != response->m_deferred.end())
+  {
+    delete it->second;
+    it->second = result;
+  }
+  else
+    response->m_deferred.insert(make_pair(key, result));
 }
 
 bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client)
@@ -289,6 +372,10 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
     JSONRPC::MethodCall method;
     CVariant params;
 
+    DeferringContext *context = deferringContext.get();
+    if (context != NULL)
+      context->result = &result;
+
     if ((errorCode = CJSONServiceDescription::CheckCall(methodName.c_str(), request["params"], transport, client, isNotification, method, params)) == OK)
       errorCode = method(methodName, transport, client, params, result);
     else
@@ -300,20 +387,34 @@ bool CJSONRPC::HandleMethodCall(const CVariant& request, CVariant& response, ITr
     errorCode = InvalidRequest;
   }
 
-  BuildResponse(request, errorCode, result, response);
+  BuildResponse(request.isObject() && request.isMember("id") ? request["id"] : CVariant(), errorCode, result, response);
 
   return !isNotification;
 }
 
+bool CJSONRPC::HandleMethodCall(const CJSONRPCRequestParser& request, CVariant& response, ITransportLayer *transport, IClient *client)
+{
+  CVariant result;
+
+  DeferringContext *context = deferringContext.get();
+  if (context != NULL)
+    context->result = &result;
+
+  JSONRPC_STATUS errorCode = request.GetMethodCall()(request.GetMethodName(), transport, client, request.GetParameters(), result);
+  BuildResponse(request.GetId(), errorCode, result, response);
+
+  return !request.IsNotification();
+}
+
 inline bool CJSONRPC::IsProperJSONRPC(const CVariant& inputroot)
 {
   return inputroot.isObject() && inputroot.isMember("jsonrpc") && inputroot["jsonrpc"].isString() && inputroot["jsonrpc"] == CVariant("2.0") && inputroot.isMember("method") && inputroot["method"].isString() && (!inputroot.isMember("params") || inputroot["params"].isArray() || inputroot["params"].isObject());
 }
 
-inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response)
+inline void CJSONRPC::BuildResponse(const CVariant& id, JSONRPC_STATUS code, const CVariant& result, CVariant& response)
 {
   response["jsonrpc"] = "2.0";
-  response["id"] = request.isObject() && request.isMember("id") ? request["id"] : CVariant();
+  response["id"] = id;
 
   switch (code)
   {
@@ -355,3 +456,156 @@ inline void CJSONRPC::BuildResponse(const CVariant& request, JSONRPC_STATUS code
       break;
   }
 }
+
+CJSONRPCResponse::CJSONRPCResponse(bool compact)
+  : m_step(0),
+    m_bufferPosition(0),
+    m_sink(m_buffer),
+    m_writer(m_sink, compact)
+{ }
+
+CJSONRPCResponse::~CJSONRPCResponse()
+{
+  for (DeferredResults::iterator it = m_deferred.begin(); it != m_deferred.end(); ++it)
+    delete it->second;
+}
+
+void CJSONRPCResponse::Prepare()
+{
+  Step step = { Step::Value, NULL, &m_response, NULL };
+
+  // deferred results only apply to successful responses
+  const CVariant &response = m_response;
+  const CVariant &result = response["result"];
+  if (m_deferred.empty() || !response.isMember("result") || !(result.isObject() || result.isNull()))
+  {
+    m_steps.push_back(step);
+    return;
+  }
+
+  step.type = Step::StartObject;
+  m_steps.push_back(step);
+  for (CVariant::const_iterator_map member = response.begin_map(); member != response.end_map(); ++member)
+  {
+    step.type = Step::Key;
+    step.key = &member->first;
+    m_steps.push_back(step);
+
+    if (member->first != "result")
+    {
+      step.type = Step::Value;
+      step.value = &member->second;
+      m_steps.push_back(step);
+      continue;
+    }
+
+    // merge the deferred results into the result object
+    // keeping the members sorted like CVariant does
+    step.type = Step::StartObject;
+    m_steps.push_back(step);
+
+    CVariant::const_iterator_map value = result.begin_map();
+    DeferredResults::const_iterator deferred = m_deferred.begin();
+    while (value != result.end_map() || deferred != m_deferred.end())
+    {
+      if (deferred != m_deferred.end() && (value == result.end_map() || deferred->first <= value->first))
+      {
+        if (value != result.end_map() && deferred->first == value->first)
+          ++value;
+
+        step.type = Step::Key;
+        step.key = &deferred->first;
+        m_steps.push_back(step);
+        step.type = Step::Deferred;
+        step.deferred = deferred->second;
+        m_steps.push_back(step);
+        ++deferred;
+      }
+      else
+      {
+        step.type = Step::Key;
+        step.key = &value->first;
+        m_steps.push_back(step);
+        step.type = Step::Value;
+        step.value = &value->second;
+        m_steps.push_back(step);
+        ++value;
+      }
+    }
+
+    step.type = Step::EndObject;
+    m_steps.push_back(step);
+  }
+  step.type = Step::EndObject;
+  m_steps.push_back(step);
+}
+
+bool CJSONRPCResponse::Produce()
+{
+  const Step &step = m_steps[m_step];
+  switch (step.type)
+  {
+    case Step::StartObject:
+      m_writer.StartObject();
+      break;
+    case Step::EndObject:
+      m_writer.EndObject();
+      break;
+    case Step::Key:
+      m_writer.Key(*step.key);
+      break;
+    case Step::Value:
+      m_writer.Value(*step.value);
+      break;
+    case Step::Deferred:
+      // stay on this step until the deferred result is complete
+      if (step.deferred->WriteNext(m_writer))
+        return !m_writer.Failed();
+      break;
+  }
+
+  m_step++;
+  return !m_writer.Failed();
+}
+
+int CJSONRPCResponse::Read(char *buffer, size_t size)
+{
+  while (m_buffer.size() - m_bufferPosition < size && m_step < m_steps.size())
+  {
+    if (!Produce())
+      return -1;
+  }
+
+  if (m_step >= m_steps.size() && !m_writer.Flush())
+    return -1;
+
+  size_t length = std::min(size, m_buffer.size() - m_bufferPosition);
+  memcpy(buffer, m_buffer.c_str() + m_bufferPosition, length);
+  m_bufferPosition += length;
+
+  if (m_bufferPosition == m_buffer.size())
+  {
+    m_buffer.clear();
+    m_bufferPosition = 0;
+  }
+  else if (m_bufferPosition > m_buffer.size() / 2)
+  {
+    m_buffer.erase(0, m_bufferPosition);
+    m_bufferPosition = 0;
+  }
+
+  return (int)length;
+}
+
+bool CJSONRPCResponse::Write(IJSONOutputSink &sink)
+{
+  char buffer[16384];
+  int length;
+  while ((length = Read(buffer, sizeof(buffer))) > 0)
+  {
+    if (!sink.Write(buffer, length))
+      return false;
+  }
+
+  return length == 0;
+}
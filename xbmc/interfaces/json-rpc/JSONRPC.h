@@ -23,13 +23,94 @@
 #include <map>
 #include <stdio.h>
 #include <string>
+#include <vector>
 
 #include "JSONRPCUtils.h"
 #include "JSONServiceDescription.h"
 #include "interfaces/IAnnouncer.h"
+#include "utils/JSONVariantWriter.h"
 
 namespace JSONRPC
 {
+  class CJSONRPCRequestParser;
+
+  /*!
+   \ingroup jsonrpc
+   \brief Part of a JSON-RPC result which is only serialized
+   while the response is being written
+
+   Methods returning large lists can hand a deferred result to
+   CJSONRPC::DeferResult() instead of putting every item into the
+   result CVariant. The items are then rendered one by one straight
+   into the output of the response.
+   */
+  class IJSONRPCDeferredResult
+  {
+  public:
+    virtual ~IJSONRPCDeferredResult() { }
+
+    /*!
+     \brief Writes the next part of the value
+     \param writer Writer to render the value with
+     \return True if there is more to write, false once the value is complete
+     */
+    virtual bool WriteNext(CJSONStreamWriter &writer) = 0;
+  };
+
+  /*!
+   \ingroup jsonrpc
+   \brief Response to a JSON-RPC request which is serialized on demand
+
+   Used by transports which can send the response in chunks (e.g. the
+   webserver with chunked transfer encoding) so that large responses
+   never need to be buffered completely.
+   */
+  class CJSONRPCResponse
+  {
+  public:
+    ~CJSONRPCResponse();
+
+    /*!
+     \brief Serializes the next part of the response into the given buffer
+     \param buffer Buffer to fill
+     \param size Size of the buffer
+     \return Number of bytes written to the buffer, 0 once the whole
+     response has been read or -1 if serializing the response failed
+     */
+    int Read(char *buffer, size_t size);
+
+    /*!
+     \brief Serializes the whole (remaining) response into the given sink
+     */
+    bool Write(IJSONOutputSink &sink);
+
+  private:
+    friend class CJSONRPC;
+    CJSONRPCResponse(bool compact);
+
+    void Prepare();
+    bool Produce();
+
+    struct Step
+    {
+      enum StepType { StartObject, EndObject, Key, Value, Deferred } type;
+      const std::string *key;
+      const CVariant *value;
+      IJSONRPCDeferredResult *deferred;
+    };
+
+    typedef std::map<std::string, IJSONRPCDeferredResult*> DeferredResults;
+
+    CVariant m_response;
+    DeferredResults m_deferred;
+    std::vector<Step> m_steps;
+    size_t m_step;
+    std::string m_buffer;
+    size_t m_bufferPosition;
+    CJSONStringSink m_sink;
+    CJSONStreamWriter m_writer;
+  };
+
   /*!
    \ingroup jsonrpc
    \brief JSON RPC handler
@@ -63,6 +144,34 @@ namespace JSONRPC
      */
     static std::string MethodCall(const std::string &inputString, ITransportLayer *transport, IClient *client);
 
+    /*
+     \brief Handles an incoming JSON-RPC request like MethodCall() but
+     returns a response which is serialized on demand
+     \param inputString received JSON-RPC request
+     \param transport Transport protocol on which the request arrived
+     \param client Client which sent the request
+     \return JSON-RPC response to be sent back to the client (owned by
+     the caller) or NULL if the request doesn't need a response
+     */
+    static CJSONRPCResponse* MethodCallStreamed(const std::string &inputString, ITransportLayer *transport, IClient *client);
+
+    /*!
+     \brief Whether DeferResult() may be used for the given result
+     \param result Result object of the method currently being executed
+
+     Deferring is only possible for the top-level result of a single
+     (non-batch) request which is serialized by CJSONRPCResponse.
+     */
+    static bool CanDeferResult(const CVariant &result);
+
+    /*!
+     \brief Replaces the given member of the result of the method
+     currently being executed with a value rendered while writing the response
+     \param key Name of the member of the result object
+     \param result Deferred value, ownership is taken
+     */
+    static void DeferResult(const std::string &key, IJSONRPCDeferredResult *result);
+
     static JSONRPC_STATUS Introspect(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Version(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
     static JSONRPC_STATUS Permission(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant& parameterObject, CVariant &result);
@@ -74,9 +183,10 @@ namespace JSONRPC
   private:
     static void setup();
     static bool HandleMethodCall(const CVariant& request, CVariant& response, ITransportLayer *transport, IClient *client);
+    static bool HandleMethodCall(const CJSONRPCRequestParser& request, CVariant& response, ITransportLayer *transport, IClient *client);
     static inline bool IsProperJSONRPC(const CVariant& inputroot);
 
-    inline static void BuildResponse(const CVariant& request, JSONRPC_STATUS code, const CVariant& result, CVariant& response);
+    inline static void BuildResponse(const CVariant& id, JSONRPC_STATUS code, const CVariant& result, CVariant& response);
 
     static bool m_initialized;
   };
@@ -0,0 +1,389 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+
+#include "JSONRPCRequestParser.h"
+#include "JSONServiceDescription.h"
+#include "utils/StringUtils.h"
+
+using namespace JSONRPC;
+
+#define KEY_IS(key, length, name) ((length) == sizeof(name) - 1 && memcmp((key), (name), sizeof(name) - 1) == 0)
+
+yajl_callbacks CJSONRPCRequestParser::callbacks = {
+  CJSONRPCRequestParser::ParseNull,
+  CJSONRPCRequestParser::ParseBoolean,
+  CJSONRPCRequestParser::ParseInteger,
+  CJSONRPCRequestParser::ParseDouble,
+  NULL,
+  CJSONRPCRequestParser::ParseString,
+  CJSONRPCRequestParser::ParseMapStart,
+  CJSONRPCRequestParser::ParseMapKey,
+  CJSONRPCRequestParser::ParseMapEnd,
+  CJSONRPCRequestParser::ParseArrayStart,
+  CJSONRPCRequestParser::ParseArrayEnd
+};
+
+CJSONRPCRequestParser::CJSONRPCRequestParser()
+  : m_method(NULL),
+    m_members(MemberNone),
+    m_member(MemberNone),
+    m_depth(0),
+    m_complete(false),
+    m_skipDepth(0),
+    m_parameter(-1)
+{ }
+
+CJSONRPCRequestParser::~CJSONRPCRequestParser()
+{ }
+
+bool CJSONRPCRequestParser::Parse(const char *json, size_t length, ITransportLayer *transport, IClient *client)
+{
+#if YAJL_MAJOR == 2
+  yajl_handle handler = yajl_alloc(&callbacks, NULL, this);
+
+  yajl_config(handler, yajl_allow_comments, 1);
+  yajl_config(handler, yajl_dont_validate_strings, 0);
+
+  bool parsed = yajl_parse(handler, (const unsigned char *)json, length) == yajl_status_ok &&
+                yajl_complete_parse(handler) == yajl_status_ok;
+#else
+  yajl_parser_config cfg = { 1, 1 };
+  yajl_handle handler = yajl_alloc(&callbacks, &cfg, NULL, this);
+
+  bool parsed = yajl_parse(handler, (const unsigned char *)json, (unsigned int)length) == yajl_status_ok &&
+                yajl_parse_complete(handler) == yajl_status_ok;
+#endif
+
+  yajl_free(handler);
+
+  return parsed && Finish(transport, client);
+}
+
+MethodCall CJSONRPCRequestParser::GetMethodCall() const
+{
+  return m_method != NULL ? m_method->method : NULL;
+}
+
+int CJSONRPCRequestParser::ParseNull(void *ctx)
+{
+  CVariant value(CVariant::VariantTypeNull);
+  return ((CJSONRPCRequestParser *)ctx)->OnValue(value) ? 1 : 0;
+}
+
+int CJSONRPCRequestParser::ParseBoolean(void *ctx, int boolean)
+{
+  CVariant value(boolean != 0);
+  return ((CJSONRPCRequestParser *)ctx)->OnValue(value) ? 1 : 0;
+}
+
+#if YAJL_MAJOR == 2
+int CJSONRPCRequestParser::ParseInteger(void *ctx, long long integerVal)
+#else
+int CJSONRPCRequestParser::ParseInteger(void *ctx, long integerVal)
+#endif
+{
+  CVariant value((int64_t)integerVal);
+  return ((CJSONRPCRequestParser *)ctx)->OnValue(value) ? 1 : 0;
+}
+
+int CJSONRPCRequestParser::ParseDouble(void *ctx, double doubleVal)
+{
+  // same precision as CJSONVariantParser
+  CVariant value((float)doubleVal);
+  return ((CJSONRPCRequestParser *)ctx)->OnValue(value) ? 1 : 0;
+}
+
+#if YAJL_MAJOR == 2
+int CJSONRPCRequestParser::ParseString(void *ctx, const unsigned char *stringVal, size_t stringLen)
+#else
+int CJSONRPCRequestParser::ParseString(void *ctx, const unsigned char *stringVal, unsigned int stringLen)
+#endif
+{
+  return ((CJSONRPCRequestParser *)ctx)->OnString((const char *)stringVal, stringLen) ? 1 : 0;
+}
+
+int CJSONRPCRequestParser::ParseMapStart(void *ctx)
+{
+  return ((CJSONRPCRequestParser *)ctx)->OnContainerStart(CVariant::VariantTypeObject) ? 1 : 0;
+}
+
+#if YAJL_MAJOR == 2
+int CJSONRPCRequestParser::ParseMapKey(void *ctx, const unsigned char *stringVal, size_t stringLen)
+#else
+int CJSONRPCRequestParser::ParseMapKey(void *ctx, const unsigned char *stringVal, unsigned int stringLen)
+#endif
+{
+  return ((CJSONRPCRequestParser *)ctx)->OnKey((const char *)stringVal, stringLen) ? 1 : 0;
+}
+
+int CJSONRPCRequestParser::ParseMapEnd(void *ctx)
+{
+  return ((CJSONRPCRequestParser *)ctx)->OnContainerEnd() ? 1 : 0;
+}
+
+int CJSONRPCRequestParser::ParseArrayStart(void *ctx)
+{
+  return ((CJSONRPCRequestParser *)ctx)->OnContainerStart(CVariant::VariantTypeArray) ? 1 : 0;
+}
+
+int CJSONRPCRequestParser::ParseArrayEnd(void *ctx)
+{
+  return ((CJSONRPCRequestParser *)ctx)->OnContainerEnd() ? 1 : 0;
+}
+
+bool CJSONRPCRequestParser::OnValue(CVariant &value)
+{
+  if (m_skipDepth > 0)
+    return true;
+
+  // part of an "id" or parameter value
+  if (!m_stack.empty())
+  {
+    AddValue()->swap(value);
+    return true;
+  }
+
+  // value of a member of the request
+  if (m_depth == 1)
+  {
+    if (m_member == MemberId)
+    {
+      m_id.swap(value);
+      return true;
+    }
+
+    return m_member == MemberUnknown;
+  }
+
+  // value of a parameter
+  if (m_depth == 2)
+  {
+    m_value.swap(value);
+    return CheckParameter();
+  }
+
+  return false;
+}
+
+bool CJSONRPCRequestParser::OnString(const char *value, size_t length)
+{
+  if (m_skipDepth > 0)
+    return true;
+
+  // the version and the method name are only read
+  if (m_stack.empty() && m_depth == 1)
+  {
+    switch (m_member)
+    {
+      case MemberJsonRpc:
+        return KEY_IS(value, length, "2.0");
+
+      case MemberMethod:
+        m_methodName.assign(value, length);
+        StringUtils::ToLower(m_methodName);
+        m_method = CJSONServiceDescription::GetMethod(m_methodName);
+        if (m_method == NULL)
+          return false;
+        m_parametersSeen.assign(m_method->parameters.size(), false);
+        return true;
+
+      case MemberUnknown:
+        return true;
+
+      default:
+        break;
+    }
+  }
+
+  CVariant variant(value, length);
+  return OnValue(variant);
+}
+
+bool CJSONRPCRequestParser::OnKey(const char *key, size_t length)
+{
+  if (m_skipDepth > 0)
+    return true;
+
+  if (!m_stack.empty())
+  {
+    m_key.assign(key, length);
+    return true;
+  }
+
+  // name of a parameter
+  if (m_depth == 2)
+  {
+    for (unsigned int index = 0; index < m_method->parameters.size(); index++)
+    {
+      const std::string &name = m_method->parameters[index]->name;
+      if (name.size() == length && memcmp(name.c_str(), key, length) == 0)
+      {
+        if (m_parametersSeen[index])
+          return false;
+
+        m_parametersSeen[index] = true;
+        m_parameter = index;
+        return true;
+      }
+    }
+
+    // let CheckCall() report the unknown parameter
+    return false;
+  }
+
+  // member of the request
+  if (KEY_IS(key, length, "jsonrpc"))
+    m_member = MemberJsonRpc;
+  else if (KEY_IS(key, length, "method"))
+    m_member = MemberMethod;
+  else if (KEY_IS(key, length, "id"))
+    m_member = MemberId;
+  else if (KEY_IS(key, length, "params"))
+    m_member = MemberParams;
+  else
+  {
+    m_member = MemberUnknown;
+    return true;
+  }
+
+  if ((m_members & m_member) != 0)
+    return false;
+
+  m_members |= m_member;
+  return true;
+}
+
+bool CJSONRPCRequestParser::OnContainerStart(CVariant::VariantType type)
+{
+  if (m_skipDepth > 0)
+  {
+    m_skipDepth++;
+    return true;
+  }
+
+  CVariant *target = NULL;
+  if (!m_stack.empty())
+    target = AddValue();
+  else if (m_depth == 0)
+  {
+    // batch requests are left to CJSONVariantParser
+    if (type != CVariant::VariantTypeObject)
+      return false;
+
+    m_depth = 1;
+    return true;
+  }
+  else if (m_depth == 1)
+  {
+    switch (m_member)
+    {
+      case MemberParams:
+        // the parameters can only be checked if the method is already known
+        if (type != CVariant::VariantTypeObject || m_method == NULL)
+          return false;
+
+        m_depth = 2;
+        return true;
+
+      case MemberId:
+        target = &m_id;
+        break;
+
+      case MemberUnknown:
+        m_skipDepth = 1;
+        return true;
+
+      default:
+        return false;
+    }
+  }
+  else
+    target = &m_value;
+
+  CVariant container(type);
+  target->swap(container);
+  m_stack.push_back(target);
+  return true;
+}
+
+bool CJSONRPCRequestParser::OnContainerEnd()
+{
+  if (m_skipDepth > 0)
+  {
+    m_skipDepth--;
+    return true;
+  }
+
+  if (!m_stack.empty())
+  {
+    m_stack.pop_back();
+    if (m_stack.empty() && m_depth == 2)
+      return CheckParameter();
+
+    return true;
+  }
+
+  if (m_depth == 1)
+    m_complete = true;
+
+  m_depth--;
+  return true;
+}
+
+CVariant* CJSONRPCRequestParser::AddValue()
+{
+  CVariant *container = m_stack.back();
+  if (container->isObject())
+    return &(*container)[m_key];
+
+  container->push_back(CVariant::VariantTypeNull);
+  return &(*container)[container->size() - 1];
+}
+
+bool CJSONRPCRequestParser::CheckParameter()
+{
+  const JSONSchemaTypeDefinitionPtr &type = m_method->parameters[m_parameter];
+
+  m_errorData.clear();
+  return type->Check(m_value, m_parameters[type->name], m_errorData) == OK;
+}
+
+bool CJSONRPCRequestParser::Finish(ITransportLayer *transport, IClient *client)
+{
+  if (!m_complete || (m_members & (MemberJsonRpc | MemberMethod)) != (MemberJsonRpc | MemberMethod))
+    return false;
+
+  // fill in the default values of the parameters which haven't been provided
+  for (unsigned int index = 0; index < m_method->parameters.size(); index++)
+  {
+    if (m_parametersSeen[index])
+      continue;
+
+    const JSONSchemaTypeDefinitionPtr &type = m_method->parameters[index];
+    if (!type->optional)
+      return false;
+
+    m_parameters[type->name] = type->defaultValue;
+  }
+
+  return m_method->CheckPermission(transport, client, IsNotification()) == OK;
+}
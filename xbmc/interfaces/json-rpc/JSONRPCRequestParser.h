@@ -0,0 +1,135 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#include "JSONRPCUtils.h"
+#include "utils/Variant.h"
+
+#include <yajl/yajl_parse.h>
+#ifdef HAVE_YAJL_YAJL_VERSION_H
+#include <yajl/yajl_version.h>
+#endif
+
+namespace JSONRPC
+{
+  class JsonRpcMethod;
+
+  /*!
+   \ingroup jsonrpc
+   \brief Single pass parser for JSON-RPC requests
+
+   Parses a single JSON-RPC request and checks the provided parameters
+   against the json schema description of the called method while the
+   request is being parsed. Only the "id" and the parameters are turned
+   into CVariants, every parameter is checked as soon as its value is
+   complete and the rest of the request (the "jsonrpc" version, the method
+   name and unknown members) is read straight from the input.
+
+   Parse() only succeeds for valid requests calling a known method with
+   named parameters which are specified after the "method" member. For
+   everything else (batches, positional parameters, invalid parameters,
+   missing permissions, ...) it returns false and the request has to be
+   handled by CJSONVariantParser and CJSONServiceDescription::CheckCall()
+   which produce the appropriate error response.
+   */
+  class CJSONRPCRequestParser
+  {
+  public:
+    CJSONRPCRequestParser();
+    ~CJSONRPCRequestParser();
+
+    /*!
+     \brief Parses and checks the given request
+     \param json Received request
+     \param length Length of the received request
+     \param transport Transport protocol on which the request arrived
+     \param client Client which sent the request
+     \return True if the request is a valid call which can be executed
+     */
+    bool Parse(const char *json, size_t length, ITransportLayer *transport, IClient *client);
+
+    const std::string& GetMethodName() const { return m_methodName; }
+    MethodCall GetMethodCall() const;
+    const CVariant& GetParameters() const { return m_parameters; }
+    const CVariant& GetId() const { return m_id; }
+    bool IsNotification() const { return (m_members & MemberId) == 0; }
+
+  private:
+    enum Member
+    {
+      MemberNone    = 0x00,
+      MemberJsonRpc = 0x01,
+      MemberMethod  = 0x02,
+      MemberId      = 0x04,
+      MemberParams  = 0x08,
+      MemberUnknown = 0x10
+    };
+
+    static int ParseNull(void *ctx);
+    static int ParseBoolean(void *ctx, int boolean);
+#if YAJL_MAJOR == 2
+    static int ParseInteger(void *ctx, long long integerVal);
+    static int ParseString(void *ctx, const unsigned char *stringVal, size_t stringLen);
+    static int ParseMapKey(void *ctx, const unsigned char *stringVal, size_t stringLen);
+#else
+    static int ParseInteger(void *ctx, long integerVal);
+    static int ParseString(void *ctx, const unsigned char *stringVal, unsigned int stringLen);
+    static int ParseMapKey(void *ctx, const unsigned char *stringVal, unsigned int stringLen);
+#endif
+    static int ParseDouble(void *ctx, double doubleVal);
+    static int ParseMapStart(void *ctx);
+    static int ParseMapEnd(void *ctx);
+    static int ParseArrayStart(void *ctx);
+    static int ParseArrayEnd(void *ctx);
+
+    bool OnValue(CVariant &value);
+    bool OnString(const char *value, size_t length);
+    bool OnKey(const char *key, size_t length);
+    bool OnContainerStart(CVariant::VariantType type);
+    bool OnContainerEnd();
+
+    CVariant* AddValue();
+    bool CheckParameter();
+    bool Finish(ITransportLayer *transport, IClient *client);
+
+    static yajl_callbacks callbacks;
+
+    const JsonRpcMethod *m_method;
+    std::string m_methodName;
+    CVariant m_id;
+    CVariant m_parameters;
+    std::vector<bool> m_parametersSeen;
+
+    unsigned int m_members;   // members of the request which have been parsed
+    Member m_member;          // member of the request being parsed
+    unsigned int m_depth;     // 1 while parsing the request object, 2 while parsing "params"
+    bool m_complete;          // the request object has been closed
+    unsigned int m_skipDepth; // nesting level within a value which is ignored
+
+    int m_parameter;          // index of the parameter being parsed
+    CVariant m_value;         // value of the parameter being parsed
+    std::vector<CVariant*> m_stack; // containers of the value being built
+    std::string m_key;              // key of the next member of the object on top of m_stack
+    CVariant m_errorData;
+  };
+}
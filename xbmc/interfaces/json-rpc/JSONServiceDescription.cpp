@@ -40,6 +40,7 @@
 #include "FavouritesOperations.h"
 #include "TextureOperations.h"
 #include "SettingsOperations.h"
+#include "ProfilerOperations.h"
 
 using namespace std;
 using namespace JSONRPC;
@@ -111,6 +112,7 @@ JsonRpcMethodMap CJSONServiceDescription::m_methodMaps[] = {
   { "AudioLibrary.GetRecentlyPlayedAlbums",         CAudioLibrary::GetRecentlyPlayedAlbums },
   { "AudioLibrary.GetRecentlyPlayedSongs",          CAudioLibrary::GetRecentlyPlayedSongs },
   { "AudioLibrary.GetGenres",                       CAudioLibrary::GetGenres },
+  { "AudioLibrary.Search",                          CAudioLibrary::Search },
   { "AudioLibrary.SetArtistDetails",                CAudioLibrary::SetArtistDetails },
   { "AudioLibrary.SetAlbumDetails",                 CAudioLibrary::SetAlbumDetails },
   { "AudioLibrary.SetSongDetails",                  CAudioLibrary::SetSongDetails },
@@ -120,6 +122,7 @@ JsonRpcMethodMap CJSONServiceDescription::m_methodMaps[] = {
 
 // Video Library
   { "VideoLibrary.GetGenres",                       CVideoLibrary::GetGenres },
+  { "VideoLibrary.Search",                          CVideoLibrary::Search },
   { "VideoLibrary.GetMovies",                       CVideoLibrary::GetMovies },
   { "VideoLibrary.GetMovieDetails",                 CVideoLibrary::GetMovieDetails },
   { "VideoLibrary.GetMovieSets",                    CVideoLibrary::GetMovieSets },
@@ -228,6 +231,10 @@ JsonRpcMethodMap CJSONServiceDescription::m_methodMaps[] = {
   { "Settings.SetSettingValue",                     CSettingsOperations::SetSettingValue },
   { "Settings.ResetSettingValue",                   CSettingsOperations::ResetSettingValue },
 
+// Profiler operations
+  { "Profiler.GetStats",                            CProfilerOperations::GetStats },
+  { "Profiler.Reset",                               CProfilerOperations::Reset },
+
 // XBMC operations
   { "XBMC.GetInfoLabels",                           CXBMCOperations::GetInfoLabels },
   { "XBMC.GetInfoBooleans",                         CXBMCOperations::GetInfoBooleans }
@@ -1261,46 +1268,51 @@ bool JsonRpcMethod::Parse(const CVariant &value)
 
 JSONRPC_STATUS JsonRpcMethod::Check(const CVariant &requestParameters, ITransportLayer *transport, IClient *client, bool notification, MethodCall &methodCall, CVariant &outputParameters) const
 {
-  if (transport != NULL && (transport->GetCapabilities() & transportneed) == transportneed)
+  JSONRPC_STATUS status = CheckPermission(transport, client, notification);
+  if (status != OK)
+    return status;
+
+  methodCall = method;
+
+  // Count the number of actually handled (present)
+  // parameters
+  unsigned int handled = 0;
+  CVariant errorData = CVariant(CVariant::VariantTypeObject);
+  errorData["method"] = name;
+
+  // Loop through all the parameters to check
+  for (unsigned int i = 0; i < parameters.size(); i++)
   {
-    if (client != NULL && (client->GetPermissionFlags() & permission) == permission && (!notification || (permission & OPERATION_PERMISSION_NOTIFICATION) == permission))
+    // Evaluate the current parameter
+    status = checkParameter(requestParameters, parameters.at(i), i, outputParameters, handled, errorData);
+    if (status != OK)
     {
-      methodCall = method;
+      // Return the error data object in the outputParameters reference
+      outputParameters = errorData;
+      return status;
+    }
+  }
 
-      // Count the number of actually handled (present)
-      // parameters
-      unsigned int handled = 0;
-      CVariant errorData = CVariant(CVariant::VariantTypeObject);
-      errorData["method"] = name;
+  // Check if there were unnecessary parameters
+  if (handled < requestParameters.size())
+  {
+    errorData["message"] = "Too many parameters";
+    outputParameters = errorData;
+    return InvalidParams;
+  }
 
-      // Loop through all the parameters to check
-      for (unsigned int i = 0; i < parameters.size(); i++)
-      {
-        // Evaluate the current parameter
-        JSONRPC_STATUS status = checkParameter(requestParameters, parameters.at(i), i, outputParameters, handled, errorData);
-        if (status != OK)
-        {
-          // Return the error data object in the outputParameters reference
-          outputParameters = errorData;
-          return status;
-        }
-      }
+  return OK;
+}
 
-      // Check if there were unnecessary parameters
-      if (handled < requestParameters.size())
-      {
-        errorData["message"] = "Too many parameters";
-        outputParameters = errorData;
-        return InvalidParams;
-      }
+JSONRPC_STATUS JsonRpcMethod::CheckPermission(ITransportLayer *transport, IClient *client, bool notification) const
+{
+  if (transport == NULL || (transport->GetCapabilities() & transportneed) != transportneed)
+    return MethodNotFound;
 
-      return OK;
-    }
-    else
-      return BadPermission;
-  }
-  
-  return MethodNotFound;
+  if (client == NULL || (client->GetPermissionFlags() & permission) != permission || (notification && (permission & OPERATION_PERMISSION_NOTIFICATION) != permission))
+    return BadPermission;
+
+  return OK;
 }
 
 bool JsonRpcMethod::parseParameter(const CVariant &value, JSONSchemaTypeDefinitionPtr parameter)
@@ -1859,6 +1871,15 @@ JSONRPC_STATUS CJSONServiceDescription::CheckCall(const char* const method, cons
   return MethodNotFound;
 }
 
+const JsonRpcMethod* CJSONServiceDescription::GetMethod(const std::string &method)
+{
+  CJsonRpcMethodMap::JsonRpcMethodIterator iter = m_actionMap.find(method);
+  if (iter != m_actionMap.end())
+    return &iter->second;
+
+  return NULL;
+}
+
 JSONSchemaTypeDefinitionPtr CJSONServiceDescription::GetType(const std::string &identification)
 {
   std::map<std::string, JSONSchemaTypeDefinitionPtr>::iterator iter = m_types.find(identification);
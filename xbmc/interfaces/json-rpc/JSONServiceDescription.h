@@ -239,6 +239,7 @@ namespace JSONRPC
   
     bool Parse(const CVariant &value);
     JSONRPC_STATUS Check(const CVariant &requestParameters, ITransportLayer *transport, IClient *client, bool notification, MethodCall &methodCall, CVariant &outputParameters) const;
+    JSONRPC_STATUS CheckPermission(ITransportLayer *transport, IClient *client, bool notification) const;
     
     std::string missingReference;    
     
@@ -390,6 +391,13 @@ namespace JSONRPC
      */
     static JSONRPC_STATUS CheckCall(const char* method, const CVariant &requestParameters, ITransportLayer *transport, IClient *client, bool notification, MethodCall &methodCall, CVariant &outputParameters);
     
+    /*!
+     \brief Gets the definition of the given method
+     \param method Lower case name of the method
+     \return Definition of the method or NULL if there is no such method
+     */
+    static const JsonRpcMethod* GetMethod(const std::string &method);
+
     static JSONSchemaTypeDefinitionPtr GetType(const std::string &identification);
 
     static void Cleanup();
@@ -0,0 +1,58 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ProfilerOperations.h"
+#include "utils/Profiler.h"
+#include "utils/Variant.h"
+
+using namespace JSONRPC;
+
+JSONRPC_STATUS CProfilerOperations::GetStats(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  std::vector<CProfiler::SectionStats> stats;
+  uint64_t dropped = CProfiler::Get().GetStats(stats, parameterObject["reset"].asBoolean());
+
+  result["enabled"] = CProfiler::IsEnabled();
+  result["dropped"] = dropped;
+  result["sections"] = CVariant(CVariant::VariantTypeArray);
+  for (std::vector<CProfiler::SectionStats>::const_iterator it = stats.begin(); it != stats.end(); ++it)
+  {
+    // durations are reported in milliseconds
+    CVariant section(CVariant::VariantTypeObject);
+    section["name"] = it->name;
+    section["count"] = it->count;
+    section["total"] = it->total / 1000.0;
+    section["average"] = (double)it->total / it->count / 1000.0;
+    section["min"] = it->min / 1000.0;
+    section["max"] = it->max / 1000.0;
+    section["p50"] = it->p50 / 1000.0;
+    section["p95"] = it->p95 / 1000.0;
+    section["p99"] = it->p99 / 1000.0;
+    result["sections"].push_back(section);
+  }
+
+  return OK;
+}
+
+JSONRPC_STATUS CProfilerOperations::Reset(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  CProfiler::Get().Reset();
+  return ACK;
+}
@@ -25,9 +25,16 @@
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 #include "video/VideoDatabase.h"
+#include "video/VideoThumbLoader.h"
 
 using namespace JSONRPC;
 
+// properties filled by CVideoThumbLoader::FillLibraryArt()
+static bool IsArtField(const std::string &field)
+{
+  return field == "art" || field == "thumbnail" || field == "fanart";
+}
+
 JSONRPC_STATUS CVideoLibrary::GetMovies(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
@@ -193,7 +200,7 @@ JSONRPC_STATUS CVideoLibrary::GetTVShows(const std::string &method, ITransportLa
   int size = items.Size();
   if (items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("tvshowid", true, "tvshows", items, parameterObject, result, size, false);
+  StreamFileItemList("tvshowid", true, "tvshows", items, parameterObject, result, size, false);
 
   return OK;
 }
@@ -472,6 +479,33 @@ JSONRPC_STATUS CVideoLibrary::GetGenres(const std::string &method, ITransportLay
   return OK;
 }
 
+JSONRPC_STATUS CVideoLibrary::Search(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  CVideoDatabase videodatabase;
+  if (!videodatabase.Open())
+    return InternalError;
+
+  CFileItemList items;
+  if (!videodatabase.RankedSearch(parameterObject["query"].asString(), items))
+    return InternalError;
+
+  int start, end;
+  HandleLimits(parameterObject, result, items.Size(), start, end);
+
+  result["results"] = CVariant(CVariant::VariantTypeArray);
+  for (int index = start; index < end; index++)
+  {
+    const CVideoInfoTag *tag = items[index]->GetVideoInfoTag();
+    CVariant object;
+    object["type"] = tag->m_type;
+    object["id"] = tag->m_iDbId;
+    object["label"] = items[index]->GetLabel();
+    result["results"].push_back(object);
+  }
+
+  return OK;
+}
+
 JSONRPC_STATUS CVideoLibrary::SetMovieDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   int id = (int)parameterObject["movieid"].asInteger();
@@ -861,26 +895,26 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalMovieDetails(const CVariant &paramete
     return InternalError;
 
   bool additionalInfo = false;
+  bool art = false;
   for (CVariant::const_iterator_array itr = parameterObject["properties"].begin_array(); itr != parameterObject["properties"].end_array(); itr++)
   {
     std::string fieldValue = itr->asString();
     if (fieldValue == "cast" || fieldValue == "showlink" || fieldValue == "tag" || fieldValue == "streamdetails")
       additionalInfo = true;
+    else if (IsArtField(fieldValue))
+      art = true;
   }
 
+  // fetched for the whole list at once rather than item by item
   if (additionalInfo)
-  {
-    for (int index = 0; index < items.Size(); index++)
-    {
-      if (additionalInfo)
-        videodatabase.GetMovieInfo("", *(items[index]->GetVideoInfoTag()), items[index]->GetVideoInfoTag()->m_iDbId);
-    }
-  }
+    videodatabase.GetDetailsForItems(items);
+  if (art)
+    CVideoThumbLoader::FillLibraryArt(items, videodatabase);
 
   int size = items.Size();
   if (!limit && items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("movieid", true, "movies", items, parameterObject, result, size, limit);
+  StreamFileItemList("movieid", true, "movies", items, parameterObject, result, size, limit);
 
   return OK;
 }
@@ -891,26 +925,25 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalEpisodeDetails(const CVariant &parame
     return InternalError;
 
   bool additionalInfo = false;
+  bool art = false;
   for (CVariant::const_iterator_array itr = parameterObject["properties"].begin_array(); itr != parameterObject["properties"].end_array(); itr++)
   {
     std::string fieldValue = itr->asString();
     if (fieldValue == "cast" || fieldValue == "streamdetails")
       additionalInfo = true;
+    else if (IsArtField(fieldValue))
+      art = true;
   }
 
   if (additionalInfo)
-  {
-    for (int index = 0; index < items.Size(); index++)
-    {
-      if (additionalInfo)
-        videodatabase.GetEpisodeInfo("", *(items[index]->GetVideoInfoTag()), items[index]->GetVideoInfoTag()->m_iDbId);
-    }
-  }
-  
+    videodatabase.GetDetailsForItems(items);
+  if (art)
+    CVideoThumbLoader::FillLibraryArt(items, videodatabase);
+
   int size = items.Size();
   if (!limit && items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("episodeid", true, "episodes", items, parameterObject, result, size, limit);
+  StreamFileItemList("episodeid", true, "episodes", items, parameterObject, result, size, limit);
 
   return OK;
 }
@@ -921,22 +954,24 @@ JSONRPC_STATUS CVideoLibrary::GetAdditionalMusicVideoDetails(const CVariant &par
     return InternalError;
 
   bool streamdetails = false;
+  bool art = false;
   for (CVariant::const_iterator_array itr = parameterObject["properties"].begin_array(); itr != parameterObject["properties"].end_array(); itr++)
   {
     if (itr->asString() == "tag" || itr->asString() == "streamdetails")
       streamdetails = true;
+    else if (IsArtField(itr->asString()))
+      art = true;
   }
 
   if (streamdetails)
-  {
-    for (int index = 0; index < items.Size(); index++)
-      videodatabase.GetMusicVideoInfo("", *(items[index]->GetVideoInfoTag()), items[index]->GetVideoInfoTag()->m_iDbId);
-  }
+    videodatabase.GetDetailsForItems(items);
+  if (art)
+    CVideoThumbLoader::FillLibraryArt(items, videodatabase);
 
   int size = items.Size();
   if (!limit && items.HasProperty("total") && items.GetProperty("total").asInteger() > size)
     size = (int)items.GetProperty("total").asInteger();
-  HandleFileItemList("musicvideoid", true, "musicvideos", items, parameterObject, result, size, limit);
+  StreamFileItemList("musicvideoid", true, "musicvideos", items, parameterObject, result, size, limit);
 
   return OK;
 }
@@ -0,0 +1,255 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "interfaces/json-rpc/JSONRPC.h"
+#include "interfaces/json-rpc/JSONRPCRequestParser.h"
+#include "interfaces/json-rpc/JSONServiceDescription.h"
+#include "network/TCPServer.h"
+#include "threads/SystemClock.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/StringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+using namespace JSONRPC;
+
+#define LOOPBACK_PORT 9099
+
+static const char *PlayerGetProperties =
+  "{\"jsonrpc\": \"2.0\", \"method\": \"Player.GetProperties\", \"params\": "
+  "{ \"playerid\": 1, \"properties\": [ \"time\", \"totaltime\", \"percentage\", \"speed\" ] }, \"id\": 1}";
+static const char *XBMCGetInfoLabels =
+  "{\"jsonrpc\": \"2.0\", \"method\": \"XBMC.GetInfoLabels\", \"params\": "
+  "{ \"labels\": [ \"Player.Title\", \"Player.Time\", \"Player.Duration\", \"MusicPlayer.Artist\" ] }, \"id\": \"labels\"}";
+
+class CLoopbackClient : public ITransportLayer, public IClient
+{
+public:
+  virtual bool PrepareDownload(const char *path, CVariant &details, std::string &protocol) { return false; }
+  virtual bool Download(const char *path, CVariant &result) { return false; }
+  virtual int GetCapabilities() { return Response; }
+
+  virtual int GetPermissionFlags() { return OPERATION_PERMISSION_ALL; }
+  virtual int GetAnnouncementFlags() { return 0; }
+  virtual bool SetAnnouncementFlags(int flags) { return false; }
+};
+
+class TestJSONRPC : public testing::Test
+{
+protected:
+  TestJSONRPC()
+  {
+    CJSONRPC::Initialize();
+  }
+
+  // the generic path of CJSONRPC::MethodCall()
+  JSONRPC_STATUS CheckCall(const std::string &request, CVariant &parameters)
+  {
+    CVariant root = CJSONVariantParser::Parse((const unsigned char *)request.c_str(), request.size());
+    std::string method = root["method"].asString();
+    StringUtils::ToLower(method);
+
+    MethodCall methodCall;
+    return CJSONServiceDescription::CheckCall(method.c_str(), root["params"], &client, &client, !root.isMember("id"), methodCall, parameters);
+  }
+
+  CLoopbackClient client;
+};
+
+TEST_F(TestJSONRPC, RequestParser)
+{
+  const char *requests[] = {
+    PlayerGetProperties,
+    XBMCGetInfoLabels,
+    "{\"jsonrpc\": \"2.0\", \"method\": \"JSONRPC.Ping\", \"id\": { \"client\": \"remote\", \"sequence\": [ 1, 2 ] }}",
+    "{\"jsonrpc\": \"2.0\", \"method\": \"JSONRPC.Introspect\", \"params\": { \"filter\": { \"id\": \"Player.GetProperties\", \"type\": \"method\" } }, \"id\": \"introspect\"}",
+    "{\"unknown\": [ { \"a\": 1 } ], \"method\": \"VideoLibrary.GetMovies\", \"jsonrpc\": \"2.0\", \"params\": "
+    "{ \"properties\": [ \"title\", \"year\" ], \"limits\": { \"start\": 0, \"end\": 25 }, \"sort\": { \"method\": \"title\", \"ignorearticle\": true }, "
+    "\"filter\": { \"field\": \"year\", \"operator\": \"greaterthan\", \"value\": \"2000\" } }, \"id\": 2}"
+  };
+
+  for (unsigned int index = 0; index < sizeof(requests) / sizeof(requests[0]); index++)
+  {
+    std::string request = requests[index];
+    CVariant root = CJSONVariantParser::Parse((const unsigned char *)request.c_str(), request.size());
+    std::string method = root["method"].asString();
+    StringUtils::ToLower(method);
+    CVariant parameters;
+    ASSERT_EQ(OK, CheckCall(request, parameters)) << request;
+
+    CJSONRPCRequestParser parser;
+    ASSERT_TRUE(parser.Parse(request.c_str(), request.size(), &client, &client)) << request;
+    EXPECT_TRUE(parser.GetMethodCall() != NULL);
+    EXPECT_STREQ(method.c_str(), parser.GetMethodName().c_str());
+    EXPECT_EQ(!root.isMember("id"), parser.IsNotification());
+    EXPECT_TRUE(root["id"] == parser.GetId());
+    if (parameters.isNull())
+      EXPECT_TRUE(parser.GetParameters().isNull()) << request;
+    else
+      EXPECT_TRUE(parameters == parser.GetParameters()) << request;
+  }
+}
+
+TEST_F(TestJSONRPC, RequestParserFallback)
+{
+  // requests which need the generic path to be handled (or rejected) properly
+  const char *requests[] = {
+    "",
+    "{\"jsonrpc\": \"2.0\", \"method\": \"JSONRPC.Ping\"",
+    "[ {\"jsonrpc\": \"2.0\", \"method\": \"JSONRPC.Ping\", \"id\": 1} ]",
+    "{\"jsonrpc\": \"1.0\", \"method\": \"JSONRPC.Ping\", \"id\": 1}",
+    "{\"method\": \"JSONRPC.Ping\", \"id\": 1}",
+    "{\"jsonrpc\": \"2.0\", \"method\": \"JSONRPC.Unknown\", \"id\": 1}",
+    "{\"jsonrpc\": \"2.0\", \"method\": \"JSONRPC.Ping\", \"method\": \"JSONRPC.Version\", \"id\": 1}",
+    "{\"jsonrpc\": \"2.0\", \"method\": \"Player.GetProperties\", \"params\": [ 1, [ \"time\" ] ], \"id\": 1}",
+    "{\"jsonrpc\": \"2.0\", \"params\": { \"playerid\": 1, \"properties\": [ \"time\" ] }, \"method\": \"Player.GetProperties\", \"id\": 1}",
+    "{\"jsonrpc\": \"2.0\", \"method\": \"Player.GetProperties\", \"params\": { \"playerid\": 1 }, \"id\": 1}",
+    "{\"jsonrpc\": \"2.0\", \"method\": \"Player.GetProperties\", \"params\": { \"playerid\": 1, \"properties\": [ \"unknown\" ] }, \"id\": 1}",
+    "{\"jsonrpc\": \"2.0\", \"method\": \"Player.GetProperties\", \"params\": { \"playerid\": \"1\", \"properties\": [ \"time\" ] }, \"id\": 1}",
+    "{\"jsonrpc\": \"2.0\", \"method\": \"Player.GetProperties\", \"params\": { \"playerid\": 1, \"properties\": [ \"time\" ], \"extra\": 1 }, \"id\": 1}",
+    "{\"jsonrpc\": \"2.0\", \"method\": \"Player.GetProperties\", \"params\": null, \"id\": 1}"
+  };
+
+  for (unsigned int index = 0; index < sizeof(requests) / sizeof(requests[0]); index++)
+  {
+    std::string request = requests[index];
+    CJSONRPCRequestParser parser;
+    EXPECT_FALSE(parser.Parse(request.c_str(), request.size(), &client, &client)) << request;
+  }
+}
+
+// the benchmarks are run with --gtest_also_run_disabled_tests
+TEST_F(TestJSONRPC, DISABLED_RequestParserBenchmark)
+{
+  static const unsigned int iterations = 20000;
+  const char *requests[] = { PlayerGetProperties, XBMCGetInfoLabels };
+
+  for (unsigned int index = 0; index < sizeof(requests) / sizeof(requests[0]); index++)
+  {
+    std::string request = requests[index];
+
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    for (unsigned int i = 0; i < iterations; i++)
+    {
+      CVariant parameters;
+      EXPECT_EQ(OK, CheckCall(request, parameters));
+    }
+    unsigned int generic = XbmcThreads::SystemClockMillis() - start;
+
+    start = XbmcThreads::SystemClockMillis();
+    for (unsigned int i = 0; i < iterations; i++)
+    {
+      CJSONRPCRequestParser parser;
+      EXPECT_TRUE(parser.Parse(request.c_str(), request.size(), &client, &client));
+    }
+    unsigned int fused = XbmcThreads::SystemClockMillis() - start;
+
+    std::cout << "Parse and check " << testing::PrintToString(iterations) << " requests: " << request.substr(0, 60) << "..." <<
+      " generic: " << testing::PrintToString(generic) << " ms (" << testing::PrintToString(iterations * 1000ULL / std::max(generic, 1u)) << " req/s)" <<
+      " fused: " << testing::PrintToString(fused) << " ms (" << testing::PrintToString(iterations * 1000ULL / std::max(fused, 1u)) << " req/s)" << std::endl;
+  }
+}
+
+TEST_F(TestJSONRPC, DISABLED_LoopbackBenchmark)
+{
+  static const unsigned int requests = 5000;
+
+  ASSERT_TRUE(CTCPServer::StartServer(LOOPBACK_PORT, false));
+
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(sock, 0);
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(LOOPBACK_PORT);
+  addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+  bool connected = false;
+  for (int retries = 0; retries < 50 && !connected; retries++)
+  {
+    connected = connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+    if (!connected)
+      usleep(20000);
+  }
+  EXPECT_TRUE(connected);
+
+  std::string request = PlayerGetProperties;
+  unsigned int responses = 0;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (unsigned int i = 0; connected && i < requests; i++)
+  {
+    if (send(sock, request.c_str(), request.size(), 0) != (ssize_t)request.size())
+      break;
+
+    // read until the response object is complete
+    int depth = 0;
+    bool inString = false, escaped = false, started = false;
+    char buffer[1024];
+    while (!started || depth > 0)
+    {
+      ssize_t length = recv(sock, buffer, sizeof(buffer), 0);
+      if (length <= 0)
+        break;
+
+      for (ssize_t pos = 0; pos < length; pos++)
+      {
+        char c = buffer[pos];
+        if (escaped)
+          escaped = false;
+        else if (inString)
+        {
+          if (c == '\\')
+            escaped = true;
+          else if (c == '"')
+            inString = false;
+        }
+        else if (c == '"')
+          inString = true;
+        else if (c == '{')
+        {
+          depth++;
+          started = true;
+        }
+        else if (c == '}')
+          depth--;
+      }
+    }
+
+    if (!started || depth != 0)
+      break;
+    responses++;
+  }
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+  close(sock);
+  CTCPServer::StopServer(true);
+
+  EXPECT_EQ(requests, responses);
+  std::cout << "Loopback: " << testing::PrintToString(responses) << " Player.GetProperties requests in " <<
+    testing::PrintToString(elapsed) << " ms (" << testing::PrintToString(responses * 1000ULL / std::max(elapsed, 1u)) << " req/s)" << std::endl;
+}
@@ -75,6 +75,7 @@ using ADDON::AddonPtr;
 
 #define RECENTLY_PLAYED_LIMIT 25
 #define MIN_FULL_SEARCH_LENGTH 3
+#define SEARCH_RESULTS_LIMIT 1000
 
 #ifdef HAS_DVD_DRIVE
 using namespace CDDB;
@@ -103,6 +104,7 @@ static void AnnounceUpdate(const std::string& content, int id)
 
 CMusicDatabase::CMusicDatabase(void)
 {
+  m_searchIndex = -1;
 }
 
 CMusicDatabase::~CMusicDatabase(void)
@@ -112,6 +114,7 @@ CMusicDatabase::~CMusicDatabase(void)
 
 bool CMusicDatabase::Open()
 {
+  m_searchIndex = -1;
   return CDatabase::Open(g_advancedSettings.m_databaseMusic);
 }
 
@@ -178,6 +181,8 @@ void CMusicDatabase::CreateTables()
   CLog::Log(LOGINFO, "create art table");
   m_pDS->exec("CREATE TABLE art(art_id INTEGER PRIMARY KEY, media_id INTEGER, media_type TEXT, type TEXT, url TEXT)");
 
+  CreateSearchTables();
+
   // Add 'Karaoke' genre
   AddGenre( "Karaoke" );
 }
@@ -247,10 +252,68 @@ void CMusicDatabase::CreateAnalytics()
               "  DELETE FROM art WHERE media_id=old.idSong AND media_type='song';"
               " END");
 
+  CreateSearchAnalytics();
+
   // we create views last to ensure all indexes are rolled in
   CreateViews();
 }
 
+bool CMusicDatabase::CreateSearchTables()
+{
+  CLog::Log(LOGINFO, "create search tables");
+  try
+  {
+    for (int i = 0; i < MUSICSEARCH_COUNT; i++)
+      CFullTextSearch::CreateTable(*m_pDS, m_sqlite, MusicSearchIndexes[i]);
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGWARNING, "%s - full text search is not supported, searching without an index", __FUNCTION__);
+  }
+  return false;
+}
+
+void CMusicDatabase::CreateSearchAnalytics()
+{
+  try
+  {
+    for (int i = 0; i < MUSICSEARCH_COUNT; i++)
+      CFullTextSearch::CreateIndex(*m_pDS, m_sqlite, MusicSearchIndexes[i]);
+  }
+  catch (...)
+  {
+    CLog::Log(LOGWARNING, "%s - full text indexes are not supported, searching without them", __FUNCTION__);
+  }
+
+  m_searchIndex = -1;
+  if (!HasSearchIndex())
+    return;
+
+  CLog::Log(LOGINFO, "create search triggers");
+  CFullTextSearch::CreateTriggers(*m_pDS, m_sqlite, MusicSearchIndexes, MUSICSEARCH_COUNT);
+}
+
+bool CMusicDatabase::HasSearchIndex()
+{
+  if (m_searchIndex < 0)
+  {
+    m_searchIndex = 0;
+    if (NULL != m_pDB.get() && NULL != m_pDS2.get() &&
+        CFullTextSearch::IsAvailable(*m_pDB, *m_pDS2, m_sqlite, MusicSearchIndexes[MUSICSEARCH_ARTISTS]))
+      m_searchIndex = 1;
+    CLog::Log(LOGDEBUG, "%s - searching %s the full text index", __FUNCTION__, m_searchIndex ? "with" : "without");
+  }
+  return m_searchIndex > 0;
+}
+
+std::string CMusicDatabase::GetSearchFilter(MusicSearchIndex index, const std::string &search)
+{
+  if (!HasSearchIndex())
+    return "";
+  return CFullTextSearch::GetFilter(*m_pDB, m_sqlite, MusicSearchIndexes[index], search, true, false);
+}
+
 void CMusicDatabase::CreateViews()
 {
   CLog::Log(LOGINFO, "create song view");
@@ -1784,14 +1847,15 @@ bool CMusicDatabase::SearchArtists(const CStdString& search, CFileItemList &arti
     if (NULL == m_pDS.get()) return false;
 
     CStdString strVariousArtists = g_localizeStrings.Get(340).c_str();
-    CStdString strSQL;
+    CStdString strSQL = "select * from artist where ";
+    std::string filter = GetSearchFilter(MUSICSEARCH_ARTISTS, search);
+    if (!filter.empty())
+      strSQL += filter + " and ";
     if (search.size() >= MIN_FULL_SEARCH_LENGTH)
-      strSQL=PrepareSQL("select * from artist "
-                                "where (strArtist like '%s%%' or strArtist like '%% %s%%') and strArtist <> '%s' "
+      strSQL+=PrepareSQL("(strArtist like '%s%%' or strArtist like '%% %s%%') and strArtist <> '%s' "
                                 , search.c_str(), search.c_str(), strVariousArtists.c_str() );
     else
-      strSQL=PrepareSQL("select * from artist "
-                                "where strArtist like '%s%%' and strArtist <> '%s' "
+      strSQL+=PrepareSQL("strArtist like '%s%%' and strArtist <> '%s' "
                                 , search.c_str(), strVariousArtists.c_str() );
 
     if (!m_pDS->query(strSQL.c_str())) return false;
@@ -2197,6 +2261,67 @@ bool CMusicDatabase::Search(const CStdString& search, CFileItemList &items)
   return true;
 }
 
+// the items found by RankedSearch(), by search table
+static const struct
+{
+  const char *mediaType;
+  const char *path;
+} rankedSearches[MUSICSEARCH_COUNT] =
+{
+  { MediaTypeArtist, "musicdb://artists/%i/" },
+  { MediaTypeAlbum,  "musicdb://albums/%i/" },
+  { MediaTypeSong,   "musicdb://songs/%i" }
+};
+
+static bool RankBefore(const pair<int, CFileItemPtr> &left, const pair<int, CFileItemPtr> &right)
+{
+  return left.first < right.first;
+}
+
+bool CMusicDatabase::RankedSearch(const std::string& search, CFileItemList &items)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    unsigned int time = XbmcThreads::SystemClockMillis();
+    vector< pair<int, CFileItemPtr> > ranked;
+    for (int i = 0; i < MUSICSEARCH_COUNT; i++)
+    {
+      // every word has to match, the names are searched instead if the index can't match them all
+      std::string strSQL = CFullTextSearch::GetRankedQuery(*m_pDB, m_sqlite, MusicSearchIndexes[i], search, HasSearchIndex());
+      if (i == MUSICSEARCH_ARTISTS)
+        strSQL += PrepareSQL(" AND strArtist <> '%s'", g_localizeStrings.Get(340).c_str());
+      strSQL += PrepareSQL(" ORDER BY iRank, %s LIMIT %i", MusicSearchIndexes[i].nameColumn, SEARCH_RESULTS_LIMIT);
+
+      if (!m_pDS->query(strSQL.c_str()))
+        return false;
+      while (!m_pDS->eof())
+      {
+        int id = m_pDS->fv(0).get_asInt();
+        CFileItemPtr item(new CFileItem(StringUtils::Format(rankedSearches[i].path, id), i != MUSICSEARCH_SONGS));
+        item->SetLabel(m_pDS->fv(1).get_asString());
+        item->GetMusicInfoTag()->SetDatabaseId(id, rankedSearches[i].mediaType);
+        ranked.push_back(make_pair(m_pDS->fv(2).get_asInt(), item));
+        m_pDS->next();
+      }
+      m_pDS->close();
+    }
+
+    stable_sort(ranked.begin(), ranked.end(), RankBefore);
+    for (vector< pair<int, CFileItemPtr> >::const_iterator it = ranked.begin(); it != ranked.end(); ++it)
+      items.Add(it->second);
+    CLog::Log(LOGDEBUG, "%s found %u items in %u ms", __FUNCTION__, (unsigned int)ranked.size(), XbmcThreads::SystemClockMillis() - time);
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s(%s) failed", __FUNCTION__, search.c_str());
+  }
+  return false;
+}
+
 bool CMusicDatabase::SearchSongs(const CStdString& search, CFileItemList &items)
 {
   try
@@ -2208,11 +2333,14 @@ bool CMusicDatabase::SearchSongs(const CStdString& search, CFileItemList &items)
     if (!baseUrl.FromString("musicdb://songs/"))
       return false;
 
-    CStdString strSQL;
+    CStdString strSQL = "select * from songview where ";
+    std::string filter = GetSearchFilter(MUSICSEARCH_SONGS, search);
+    if (!filter.empty())
+      strSQL += filter + " and ";
     if (search.size() >= MIN_FULL_SEARCH_LENGTH)
-      strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' or strTitle like '%% %s%%' limit 1000", search.c_str(), search.c_str());
+      strSQL+=PrepareSQL("(strTitle like '%s%%' or strTitle like '%% %s%%') limit %i", search.c_str(), search.c_str(), SEARCH_RESULTS_LIMIT);
     else
-      strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' limit 1000", search.c_str());
+      strSQL+=PrepareSQL("strTitle like '%s%%' limit %i", search.c_str(), SEARCH_RESULTS_LIMIT);
 
     if (!m_pDS->query(strSQL.c_str())) return false;
     if (m_pDS->num_rows() == 0) return false;
@@ -2244,11 +2372,14 @@ bool CMusicDatabase::SearchAlbums(const CStdString& search, CFileItemList &album
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    CStdString strSQL;
+    CStdString strSQL = "select * from albumview where ";
+    std::string filter = GetSearchFilter(MUSICSEARCH_ALBUMS, search);
+    if (!filter.empty())
+      strSQL += filter + " and ";
     if (search.size() >= MIN_FULL_SEARCH_LENGTH)
-      strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%' or strAlbum like '%% %s%%'", search.c_str(), search.c_str());
+      strSQL+=PrepareSQL("(strAlbum like '%s%%' or strAlbum like '%% %s%%')", search.c_str(), search.c_str());
     else
-      strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%'", search.c_str());
+      strSQL+=PrepareSQL("strAlbum like '%s%%'", search.c_str());
 
     if (!m_pDS->query(strSQL.c_str())) return false;
 
@@ -3466,8 +3597,12 @@ bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const Filter &fi
     strSQL = PrepareSQL(strSQL, !filter.fields.empty() && filter.fields.compare("*") != 0 ? filter.fields.c_str() : "songview.*") + strSQLExtra;
 
     CLog::Log(LOGDEBUG, "%s query = %s", __FUNCTION__, strSQL.c_str());
+    // without sorting the rows are used in the order they come in, so they
+    // are fetched one at a time rather than all held in memory
+    bool streaming = sortDescription.sortBy == SortByNone;
+
     // run query
-    if (!m_pDS->query(strSQL.c_str()))
+    if (!(streaming ? m_pDS->query_stream(strSQL.c_str()) : m_pDS->query(strSQL.c_str())))
       return false;
 
     int iRowsFound = m_pDS->num_rows();
@@ -3477,24 +3612,22 @@ bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const Filter &fi
       return true;
     }
 
-    // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
-    items.SetProperty("total", total);
-    
     DatabaseResults results;
-    results.reserve(iRowsFound);
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeSong, m_pDS, results))
-      return false;
+    if (!streaming)
+    {
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sortDescription, MediaTypeSong, m_pDS, results))
+        return false;
+      items.Reserve(results.size());
+    }
 
     // get data from returned rows
-    items.Reserve(results.size());
     const dbiplus::query_data &data = m_pDS->get_result_set().records;
+    DatabaseResults::const_iterator it = results.begin();
     int count = 0;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    while (streaming ? !m_pDS->eof() : it != results.end())
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = streaming ? m_pDS->get_sql_record() : data.at((unsigned int)(it++)->at(FieldRow).asInteger());
       
       try
       {
@@ -3510,8 +3643,17 @@ bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const Filter &fi
         CLog::Log(LOGERROR, "%s: out of memory loading query: %s", __FUNCTION__, filter.where.c_str());
         return (items.Size() > 0);
       }
+
+      if (streaming)
+        m_pDS->next();
     }
 
+    // store the total value of items as a property
+    iRowsFound = m_pDS->num_rows();
+    if (total < iRowsFound)
+      total = iRowsFound;
+    items.SetProperty("total", total);
+
     // cleanup
     m_pDS->close();
     CLog::Log(LOGDEBUG, "%s(%s) - took %d ms", __FUNCTION__, filter.where.c_str(), XbmcThreads::SystemClockMillis() - time);
@@ -3922,11 +4064,20 @@ void CMusicDatabase::UpdateTables(int version)
     m_pDS->exec("UPDATE karaokedata SET strKaraLyrFileCRC=NULL");
     m_pDS->exec("UPDATE album SET idThumb=NULL");
   }
+  if (version < 49)
+  {
+    if (CreateSearchTables())
+    {
+      CLog::Log(LOGINFO, "%s - filling search tables", __FUNCTION__);
+      for (int i = 0; i < MUSICSEARCH_COUNT; i++)
+        CFullTextSearch::Fill(*m_pDS, MusicSearchIndexes[i]);
+    }
+  }
 }
 
 int CMusicDatabase::GetSchemaVersion() const
 {
-  return 48;
+  return 49;
 }
 
 unsigned int CMusicDatabase::GetSongIDs(const Filter &filter, vector<pair<int,int> > &songIDs)
@@ -5420,8 +5571,7 @@ bool CMusicDatabase::GetArtForItem(int mediaId, const string &mediaType, map<str
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS2.get()) return false; // using dataset 2 as we're likely called in loops on dataset 1
 
-    CStdString sql = PrepareSQL("SELECT type,url FROM art WHERE media_id=%i AND media_type='%s'", mediaId, mediaType.c_str());
-    m_pDS2->query(sql.c_str());
+    m_pDS2->query_bind("SELECT type,url FROM art WHERE media_id=? AND media_type=?", dbiplus::BindParams().add(mediaId).add(mediaType));
     while (!m_pDS2->eof())
     {
       art.insert(make_pair(m_pDS2->fv(0).get_asString(), m_pDS2->fv(1).get_asString()));
@@ -5439,8 +5589,22 @@ bool CMusicDatabase::GetArtForItem(int mediaId, const string &mediaType, map<str
 
 string CMusicDatabase::GetArtForItem(int mediaId, const string &mediaType, const string &artType)
 {
-  std::string query = PrepareSQL("SELECT url FROM art WHERE media_id=%i AND media_type='%s' AND type='%s'", mediaId, mediaType.c_str(), artType.c_str());
-  return GetSingleValue(query, m_pDS2);
+  std::string url;
+  try
+  {
+    if (NULL == m_pDB.get()) return url;
+    if (NULL == m_pDS2.get()) return url;
+
+    m_pDS2->query_bind("SELECT url FROM art WHERE media_id=? AND media_type=? AND type=?", dbiplus::BindParams().add(mediaId).add(mediaType).add(artType));
+    if (!m_pDS2->eof())
+      url = m_pDS2->fv(0).get_asString();
+    m_pDS2->close();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s(%d, '%s', '%s') failed", __FUNCTION__, mediaId, mediaType.c_str(), artType.c_str());
+  }
+  return url;
 }
 
 bool CMusicDatabase::GetArtistArtForItem(int mediaId, const std::string &mediaType, std::map<std::string, std::string> &art)
@@ -27,14 +27,14 @@
 #include "addons/Scraper.h"
 #include "utils/SortUtils.h"
 #include "MusicDbUrl.h"
+#include "MusicSearchIndex.h"
 
 class CArtist;
 class CFileItem;
 
 namespace dbiplus
 {
-  class field_value;
-  typedef std::vector<field_value> sql_record;
+  class sql_record;
 }
 
 #include <set>
@@ -184,6 +184,17 @@ public:
   bool GetSongByFileName(const CStdString& strFileName, CSong& song, int startOffset = 0);
   bool GetSongsByPath(const CStdString& strPath, MAPSONGS& songs, bool bAppendToMap = false);
   bool Search(const CStdString& search, CFileItemList &items);
+
+  /*! \brief Search artists, albums and songs, best matches first
+   Every word of the search has to start a word of the name, the artists, the album or the genres of an item.
+   Items named like the search come first, then those whose name starts with it, those with a word of the name
+   starting with it and last the ones matching on the other fields. Ties keep artists before albums before songs.
+   Only the names are searched without the full text index, or if it can't match every word.
+   \param search the words to search for.
+   \param items [out] the artists, albums and songs found, labelled with their name.
+   \return true if the search succeeded, false otherwise.
+   */
+  bool RankedSearch(const std::string& search, CFileItemList &items);
   bool RemoveSongsFromPath(const CStdString &path, MAPSONGS& songs, bool exact=true);
   bool SetSongRating(const CStdString &filePath, char rating);
   int  GetSongByArtistAndAlbumAndTitle(const CStdString& strArtist, const CStdString& strAlbum, const CStdString& strTitle);
@@ -464,6 +475,7 @@ protected:
   std::map<CStdString, int> m_pathCache;
   std::map<CStdString, int> m_thumbCache;
   std::map<CStdString, CAlbum> m_albumCache;
+  int m_searchIndex; ///< whether the full text search index can be used, -1 until checked
 
   virtual void CreateTables();
   virtual void CreateAnalytics();
@@ -498,6 +510,28 @@ private:
   bool SearchArtists(const CStdString& search, CFileItemList &artists);
   bool SearchAlbums(const CStdString& search, CFileItemList &albums);
   bool SearchSongs(const CStdString& strSearch, CFileItemList &songs);
+
+  /*! \brief Create the tables of the full text search index
+   \return false if the database doesn't support full text search, searches go without the index then.
+   */
+  bool CreateSearchTables();
+
+  /*! \brief Create the triggers keeping the full text search index up to date, and its FULLTEXT indexes on MySQL
+   */
+  void CreateSearchAnalytics();
+
+  /*! \brief Whether the full text search index can be used, checked once per connection
+   */
+  bool HasSearchIndex();
+
+  /*! \brief Get a condition narrowing down the artists, albums or songs for a search with the full text index
+   Every word of the search has to start a word of the indexed columns, the items found are a superset of the
+   ones found by the LIKE conditions on their name.
+   \param index the search table of the items.
+   \param search the words to search for.
+   \return the condition for the WHERE clause, empty if the index can't be used for the search.
+   */
+  std::string GetSearchFilter(MusicSearchIndex index, const std::string &search);
   int GetSongIDFromPath(const CStdString &filePath);
 
   // Fields should be ordered as they
@@ -0,0 +1,61 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MusicSearchIndex.h"
+
+#include <stddef.h>
+
+static const FullTextColumn artistSearchColumns[] =
+{
+  { "strArtist", "varchar(256)", "new.strArtist" },
+  { "strGenres", "text",         "new.strGenres" },
+  { NULL, NULL, NULL }
+};
+
+static const FullTextColumn albumSearchColumns[] =
+{
+  { "strAlbum",   "varchar(256)", "new.strAlbum" },
+  { "strArtists", "text",         "new.strArtists" },
+  { "strGenres",  "text",         "new.strGenres" },
+  { NULL, NULL, NULL }
+};
+
+static const FullTextColumn songSearchColumns[] =
+{
+  { "strTitle",   "varchar(512)", "new.strTitle" },
+  { "strArtists", "text",         "new.strArtists" },
+  { "strAlbum",   "varchar(256)", "(SELECT strAlbum FROM album WHERE album.idAlbum = new.idAlbum)" },
+  { "strGenres",  "text",         "new.strGenres" },
+  { NULL, NULL, NULL }
+};
+
+// renaming an album renames it in its songs
+static const FullTextDependency songSearchDependencies[] =
+{
+  { "album", "strAlbum", "SELECT idSong FROM song WHERE song.idAlbum = new.idAlbum", "strAlbum" },
+  { NULL, NULL, NULL, NULL }
+};
+
+const FullTextIndex MusicSearchIndexes[MUSICSEARCH_COUNT] =
+{
+  { "artistsearch", "artist", "idArtist", "strArtist", "strArtist, strGenres", artistSearchColumns, NULL },
+  { "albumsearch",  "album",  "idAlbum",  "strAlbum",  "strAlbum, strArtists, strGenres", albumSearchColumns, NULL },
+  { "songsearch",   "song",   "idSong",   "strTitle",  "strTitle, strArtists, idAlbum, strGenres", songSearchColumns, songSearchDependencies }
+};
@@ -51,6 +51,10 @@
 
 #define CONTENT_RANGE_FORMAT  "bytes %" PRId64 "-%" PRId64 "/%" PRId64
 
+#ifndef MHD_SIZE_UNKNOWN
+#define MHD_SIZE_UNKNOWN  -1
+#endif
+
 using namespace XFILE;
 using namespace std;
 using namespace JSONRPC;
@@ -337,6 +341,10 @@ int CWebServer::HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &r
       ret = CreateMemoryDownloadResponse(request.connection, handler->GetHTTPResponseData(), handler->GetHTTPResonseDataLength(), true, true, response);
       break;
 
+    case HTTPStreamedDownload:
+      ret = CreateStreamedDownloadResponse(request.connection, handler, response);
+      break;
+
     case HTTPError:
       ret = CreateErrorResponse(request.connection, handler->GetHTTPResonseCode(), request.method, response);
       break;
@@ -356,9 +364,13 @@ int CWebServer::HandleRequest(IHTTPRequestHandler *handler, const HTTPRequest &r
   for (multimap<string, string>::const_iterator it = header.begin(); it != header.end(); it++)
     AddHeader(response, it->first.c_str(), it->second.c_str());
 
+  // streamed responses own the handler until they have been sent
+  bool streamed = handler->GetHTTPResponseType() == HTTPStreamedDownload;
+
   MHD_queue_response(request.connection, responseCode, response);
   MHD_destroy_response(response);
-  delete handler;
+  if (!streamed)
+    delete handler;
 
   return MHD_YES;
 }
@@ -620,6 +632,18 @@ int CWebServer::CreateMemoryDownloadResponse(struct MHD_Connection *connection,
   return MHD_NO;
 }
 
+int CWebServer::CreateStreamedDownloadResponse(struct MHD_Connection *connection, IHTTPRequestHandler *handler, struct MHD_Response *&response)
+{
+  // with an unknown size libmicrohttpd uses chunked transfer encoding
+  response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN,
+                                               16 * 1024,
+                                               &CWebServer::StreamReaderCallback, handler,
+                                               &CWebServer::StreamReaderFreeCallback);
+  if (response)
+    return MHD_YES;
+  return MHD_NO;
+}
+
 int CWebServer::SendErrorResponse(struct MHD_Connection *connection, int errorType, HTTPMethod method)
 {
   struct MHD_Response *response = NULL;
@@ -738,6 +762,40 @@ void CWebServer::ContentReaderFreeCallback(void *cls)
 #endif
 }
 
+#if (MHD_VERSION >= 0x00090200)
+ssize_t CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, size_t max)
+#elif (MHD_VERSION >= 0x00040001)
+int CWebServer::StreamReaderCallback(void *cls, uint64_t pos, char *buf, int max)
+#else   //libmicrohttpd < 0.4.0
+int CWebServer::StreamReaderCallback(void *cls, size_t pos, char *buf, int max)
+#endif
+{
+  IHTTPRequestHandler *handler = (IHTTPRequestHandler *)cls;
+  if (handler == NULL)
+    return -1;
+
+  int written = handler->ReadHTTPResponseStream(buf, max);
+#ifdef WEBSERVER_DEBUG
+  CLog::Log(LOGDEBUG, "webserver [OUT] streamed %d bytes", written);
+#endif
+  if (written > 0)
+    return written;
+
+#ifdef MHD_CONTENT_READER_END_WITH_ERROR
+  if (written < 0)
+    return MHD_CONTENT_READER_END_WITH_ERROR;
+#endif
+
+  // end of stream
+  return -1;
+}
+
+void CWebServer::StreamReaderFreeCallback(void *cls)
+{
+  IHTTPRequestHandler *handler = (IHTTPRequestHandler *)cls;
+  delete handler;
+}
+
 struct MHD_Daemon* CWebServer::StartMHD(unsigned int flags, int port)
 {
   unsigned int timeout = 60 * 60 * 24;
@@ -27,10 +27,17 @@
 #include "utils/log.h"
 
 #define MAX_STRING_POST_SIZE 20000
+// responses larger than this are sent with chunked transfer encoding
+#define MAX_BUFFERED_RESPONSE_SIZE 65536
 
 using namespace std;
 using namespace JSONRPC;
 
+CHTTPJsonRpcHandler::~CHTTPJsonRpcHandler()
+{
+  delete m_streamedResponse;
+}
+
 bool CHTTPJsonRpcHandler::CheckHTTPRequest(const HTTPRequest &request)
 {
   return (request.url.compare("/jsonrpc") == 0);
@@ -69,8 +76,29 @@ int CHTTPJsonRpcHandler::HandleHTTPRequest(const HTTPRequest &request)
     }
   }
 
+  m_responseType = HTTPMemoryDownloadNoFreeCopy;
   if (isRequest)
-    m_response = CJSONRPC::MethodCall(m_request, request.webserver, &client);
+  {
+    m_streamedResponse = CJSONRPC::MethodCallStreamed(m_request, request.webserver, &client);
+    if (m_streamedResponse != NULL)
+    {
+      // small responses are still sent in one piece with a Content-Length
+      char buffer[16384];
+      int read;
+      while (m_response.size() < MAX_BUFFERED_RESPONSE_SIZE && (read = m_streamedResponse->Read(buffer, sizeof(buffer))) > 0)
+        m_response.append(buffer, read);
+
+      if (m_response.size() < MAX_BUFFERED_RESPONSE_SIZE)
+      {
+        if (read < 0)
+          m_response.clear();
+        delete m_streamedResponse;
+        m_streamedResponse = NULL;
+      }
+      else
+        m_responseType = HTTPStreamedDownload;
+    }
+  }
   else
   {
     // get the whole output of JSONRPC.Introspect
@@ -83,12 +111,33 @@ int CHTTPJsonRpcHandler::HandleHTTPRequest(const HTTPRequest &request)
 
   m_request.clear();
   
-  m_responseType = HTTPMemoryDownloadNoFreeCopy;
   m_responseCode = MHD_HTTP_OK;
 
   return MHD_YES;
 }
 
+int CHTTPJsonRpcHandler::ReadHTTPResponseStream(char *buffer, size_t size)
+{
+  // first hand out what has already been serialized
+  if (m_responsePosition < m_response.size())
+  {
+    size_t length = std::min(size, m_response.size() - m_responsePosition);
+    memcpy(buffer, m_response.c_str() + m_responsePosition, length);
+    m_responsePosition += length;
+    if (m_responsePosition == m_response.size())
+    {
+      m_response.clear();
+      m_responsePosition = 0;
+    }
+    return (int)length;
+  }
+
+  if (m_streamedResponse == NULL)
+    return 0;
+
+  return m_streamedResponse->Read(buffer, size);
+}
+
 #if (MHD_VERSION >= 0x00040001)
 bool CHTTPJsonRpcHandler::appendPostData(const char *data, size_t size)
 #else
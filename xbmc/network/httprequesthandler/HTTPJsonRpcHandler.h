@@ -22,10 +22,16 @@
 #include "IHTTPRequestHandler.h"
 #include "interfaces/json-rpc/IClient.h"
 
+namespace JSONRPC
+{
+  class CJSONRPCResponse;
+}
+
 class CHTTPJsonRpcHandler : public IHTTPRequestHandler
 {
 public:
-  CHTTPJsonRpcHandler() { };
+  CHTTPJsonRpcHandler() : m_responsePosition(0), m_streamedResponse(NULL) { };
+  virtual ~CHTTPJsonRpcHandler();
   
   virtual IHTTPRequestHandler* GetInstance() { return new CHTTPJsonRpcHandler(); }
   virtual bool CheckHTTPRequest(const HTTPRequest &request);
@@ -33,6 +39,7 @@ public:
 
   virtual void* GetHTTPResponseData() const { return (void *)m_response.c_str(); };
   virtual size_t GetHTTPResonseDataLength() const { return m_response.size(); }
+  virtual int ReadHTTPResponseStream(char *buffer, size_t size);
 
   virtual int GetPriority() const { return 2; }
 
@@ -46,6 +53,8 @@ protected:
 private:
   std::string m_request;
   std::string m_response;
+  size_t m_responsePosition;
+  JSONRPC::CJSONRPCResponse *m_streamedResponse;
 
   class CHTTPClient : public JSONRPC::IClient
   {
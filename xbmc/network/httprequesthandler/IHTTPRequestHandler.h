@@ -50,7 +50,8 @@ enum HTTPResponseType
   HTTPMemoryDownloadNoFreeNoCopy,
   HTTPMemoryDownloadNoFreeCopy,
   HTTPMemoryDownloadFreeNoCopy,
-  HTTPMemoryDownloadFreeCopy
+  HTTPMemoryDownloadFreeCopy,
+  HTTPStreamedDownload
 };
 
 typedef struct HTTPRequest
@@ -75,6 +76,17 @@ public:
   virtual size_t GetHTTPResonseDataLength() const { return 0; }
   virtual std::string GetHTTPRedirectUrl() const { return ""; }
   virtual std::string GetHTTPResponseFile() const { return ""; }
+  /*!
+   \brief Reads the next part of a HTTPStreamedDownload response
+
+   The handler is kept alive (and owned by the webserver) until the whole
+   response has been sent. The response is sent with chunked transfer
+   encoding as its length isn't known in advance.
+
+   \return Number of bytes written into the buffer, 0 once the response is
+   complete or -1 on errors
+   */
+  virtual int ReadHTTPResponseStream(char *buffer, size_t size) { return -1; }
 
   // The higher the more important
   virtual int GetPriority() const { return 0; }
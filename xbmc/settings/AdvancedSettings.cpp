@@ -26,6 +26,7 @@
 #include "network/DNSNameCache.h"
 #include "filesystem/File.h"
 #include "utils/LangCodeExpander.h"
+#include "utils/Profiler.h"
 #include "LangInfo.h"
 #include "profiles/ProfilesManager.h"
 #include "settings/lib/Setting.h"
@@ -283,6 +284,7 @@ void CAdvancedSettings::Initialize()
   m_bVideoLibraryExportAutoThumbs = false;
   m_bVideoLibraryImportWatchedState = false;
   m_bVideoLibraryImportResumePoint = false;
+  m_bVideoLibraryKeyframeIndex = false;
   m_bVideoScannerIgnoreErrors = false;
   m_iVideoLibraryDateAdded = 1; // prefer mtime over ctime and current time
 
@@ -365,12 +367,22 @@ void CAdvancedSettings::Initialize()
   m_iPVRNumericChannelSwitchTimeout = 1000;
 
   m_cacheMemBufferSize = 1024 * 1024 * 20;
+  m_directoryCacheMemorySize = 1024 * 1024 * 32;
+  m_directoryCacheTTLs.clear();
+  m_directoryCacheTTLs["smb"] = 300;
+  m_directoryCacheTTLs["nfs"] = 300;
+  m_directoryCacheTTLs["upnp"] = 120;
+  m_directoryCacheTTLs["plugin"] = 60;
   m_networkBufferMode = 0; // Default (buffer all internet streams/filesystems)
+  m_cacheReadAheadConnections = 4;
   // the following setting determines the readRate of a player data
   // as multiply of the default data read rate
   m_readBufferFactor = 1.0f;
   m_addonPackageFolderSize = 200;
 
+  m_jobManagerWorkStealing = false;
+  m_jobManagerWorkers = 0;
+
   m_jsonOutputCompact = true;
   m_jsonTcpPort = 9090;
 
@@ -380,6 +392,7 @@ void CAdvancedSettings::Initialize()
   m_guiVisualizeDirtyRegions = false;
   m_guiAlgorithmDirtyRegions = 3;
   m_guiDirtyRegionNoFlipTimeout = 0;
+  m_guiPreloadSkin = true;
   m_airTunesPort = 36666;
   m_airPlayPort = 36667;
 
@@ -403,6 +416,8 @@ void CAdvancedSettings::Initialize()
   m_logLevelHint = m_logLevel = LOG_LEVEL_NORMAL;
   m_extraLogEnabled = false;
   m_extraLogLevels = 0;
+  m_asyncLogging = false;
+  m_enableProfiler = true;
 
   #if defined(TARGET_DARWIN)
     CStdString logDir = getenv("HOME");
@@ -764,6 +779,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetBoolean(pElement, "exportautothumbs", m_bVideoLibraryExportAutoThumbs);
     XMLUtils::GetBoolean(pElement, "importwatchedstate", m_bVideoLibraryImportWatchedState);
     XMLUtils::GetBoolean(pElement, "importresumepoint", m_bVideoLibraryImportResumePoint);
+    XMLUtils::GetBoolean(pElement, "keyframeindex", m_bVideoLibraryKeyframeIndex);
     XMLUtils::GetInt(pElement, "dateadded", m_iVideoLibraryDateAdded);
   }
 
@@ -796,9 +812,33 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetBoolean(pElement,"disableipv6", m_curlDisableIPV6);
     XMLUtils::GetUInt(pElement, "cachemembuffersize", m_cacheMemBufferSize);
     XMLUtils::GetUInt(pElement, "buffermode", m_networkBufferMode, 0, 3);
+    XMLUtils::GetUInt(pElement, "readaheadconnections", m_cacheReadAheadConnections, 1, 16);
     XMLUtils::GetFloat(pElement, "readbufferfactor", m_readBufferFactor);
   }
 
+  pElement = pRootElement->FirstChildElement("directorycache");
+  if (pElement)
+  {
+    XMLUtils::GetUInt(pElement, "memorysize", m_directoryCacheMemorySize);
+
+    // <ttl protocol="smb">300</ttl>, 0 caches listings of the protocol until they are evicted
+    const TiXmlElement* pTTL = pElement->FirstChildElement("ttl");
+    while (pTTL)
+    {
+      const char* protocol = pTTL->Attribute("protocol");
+      if (protocol && pTTL->FirstChild())
+        m_directoryCacheTTLs[protocol] = strtoul(pTTL->FirstChild()->Value(), NULL, 10);
+      pTTL = pTTL->NextSiblingElement("ttl");
+    }
+  }
+
+  pElement = pRootElement->FirstChildElement("jobmanager");
+  if (pElement)
+  {
+    XMLUtils::GetBoolean(pElement, "workstealing", m_jobManagerWorkStealing);
+    XMLUtils::GetUInt(pElement, "workers", m_jobManagerWorkers, 0, 64);
+  }
+
   pElement = pRootElement->FirstChildElement("jsonrpc");
   if (pElement)
   {
@@ -840,6 +880,12 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     CLog::SetLogLevel(g_advancedSettings.m_logLevel);
   }
 
+  if (XMLUtils::GetBoolean(pRootElement, "asynclogging", m_asyncLogging))
+    CLog::SetAsync(m_asyncLogging);
+
+  if (XMLUtils::GetBoolean(pRootElement, "enableprofiler", m_enableProfiler))
+    CProfiler::SetEnabled(m_enableProfiler);
+
   XMLUtils::GetString(pRootElement, "cddbaddress", m_cddbAddress);
 
   //airtunes + airplay
@@ -1170,6 +1216,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetBoolean(pElement, "visualizedirtyregions", m_guiVisualizeDirtyRegions);
     XMLUtils::GetInt(pElement, "algorithmdirtyregions",     m_guiAlgorithmDirtyRegions);
     XMLUtils::GetInt(pElement, "nofliptimeout",             m_guiDirtyRegionNoFlipTimeout);
+    XMLUtils::GetBoolean(pElement, "preloadskin",           m_guiPreloadSkin);
   }
 
   // load in the settings overrides
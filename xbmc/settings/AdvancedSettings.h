@@ -19,6 +19,8 @@
  *
  */
 
+#include <map>
+#include <string>
 #include <vector>
 
 #include "settings/lib/ISettingCallback.h"
@@ -211,6 +213,8 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_logLevelHint;
     bool m_extraLogEnabled;
     int m_extraLogLevels;
+    bool m_asyncLogging;
+    bool m_enableProfiler;
     CStdString m_cddbAddress;
 
     //airtunes + airplay
@@ -281,6 +285,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_bVideoLibraryExportAutoThumbs;
     bool m_bVideoLibraryImportWatchedState;
     bool m_bVideoLibraryImportResumePoint;
+    bool m_bVideoLibraryKeyframeIndex; ///< build the keyframe index of files added to the library in the background
 
     bool m_bVideoScannerIgnoreErrors;
     int m_iVideoLibraryDateAdded;
@@ -374,12 +379,20 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_guiVisualizeDirtyRegions;
     int  m_guiAlgorithmDirtyRegions;
     int  m_guiDirtyRegionNoFlipTimeout;
+    bool m_guiPreloadSkin;
     unsigned int m_addonPackageFolderSize;
 
     unsigned int m_cacheMemBufferSize;
     unsigned int m_networkBufferMode;
+    unsigned int m_cacheReadAheadConnections; // connections the cache reads remote files through, 1 for a single one
     float m_readBufferFactor;
 
+    unsigned int m_directoryCacheMemorySize; // memory budget of the directory cache in bytes
+    std::map<std::string, unsigned int> m_directoryCacheTTLs; // seconds after which cached listings of a protocol are revalidated
+
+    bool m_jobManagerWorkStealing; // whether the job manager gives every worker its own queues, applied at startup
+    unsigned int m_jobManagerWorkers; // maximal number of job workers, 0 for the default
+
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
 
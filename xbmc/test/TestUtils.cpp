@@ -98,6 +98,7 @@ private:
 CXBMCTestUtils::CXBMCTestUtils()
 {
   probability = 0.01;
+  PlayerBenchmarkUnpaced = false;
 }
 
 CXBMCTestUtils &CXBMCTestUtils::Instance()
@@ -230,6 +231,21 @@ std::vector<std::string> &CXBMCTestUtils::getGUISettingsFiles()
   return GUISettingsFiles;
 }
 
+std::string &CXBMCTestUtils::getPlayerBenchmarkFile()
+{
+  return PlayerBenchmarkFile;
+}
+
+std::string &CXBMCTestUtils::getPlayerBenchmarkOutput()
+{
+  return PlayerBenchmarkOutput;
+}
+
+bool CXBMCTestUtils::getPlayerBenchmarkUnpaced() const
+{
+  return PlayerBenchmarkUnpaced;
+}
+
 static const char usage[] =
 "XBMC Test Suite\n"
 "Usage: xbmc-test [options]\n"
@@ -272,6 +288,18 @@ static const char usage[] =
 "    The variable should be a double type from 0.0 to 1.0. Values given\n"
 "    less than 0.0 are treated as 0.0. Values greater than 1.0 are treated\n"
 "    as 1.0. The default probability is 0.01.\n"
+"\n"
+"  --set-playerbenchmark-file [FILE]\n"
+"    Set the media file played by the DVDPlayer benchmark. The benchmark\n"
+"    is skipped if no file is given.\n"
+"\n"
+"  --set-playerbenchmark-output [FILE]\n"
+"    Set the file the DVDPlayer benchmark writes its results to as JSON.\n"
+"    The results are written to stdout by default.\n"
+"\n"
+"  --set-playerbenchmark-unpaced\n"
+"    Let the DVDPlayer benchmark decode as fast as possible instead of\n"
+"    playing the file at wall clock speed.\n"
 ;
 
 void CXBMCTestUtils::ParseArgs(int argc, char **argv)
@@ -341,6 +369,18 @@ void CXBMCTestUtils::ParseArgs(int argc, char **argv)
       else if (probability > 1.0)
         probability = 1.0;
     }
+    else if (arg == "--set-playerbenchmark-file")
+    {
+      PlayerBenchmarkFile = argv[++i];
+    }
+    else if (arg == "--set-playerbenchmark-output")
+    {
+      PlayerBenchmarkOutput = argv[++i];
+    }
+    else if (arg == "--set-playerbenchmark-unpaced")
+    {
+      PlayerBenchmarkUnpaced = true;
+    }
     else
     {
       std::cerr << usage;
@@ -76,6 +76,17 @@ public:
   /* Function to get GUI settings files. */
   std::vector<std::string> &getGUISettingsFiles();
 
+  /* Function to get the media file played by the DVDPlayer benchmark. */
+  std::string &getPlayerBenchmarkFile();
+
+  /* Function to get the file the DVDPlayer benchmark writes its results to. */
+  std::string &getPlayerBenchmarkOutput();
+
+  /* Function to get whether the DVDPlayer benchmark decodes as fast as
+   * possible instead of playing at wall clock speed.
+   */
+  bool getPlayerBenchmarkUnpaced() const;
+
   /* Function used in creating a corrupted file. The parameters are a URL
    * to the original file to be corrupted and a suffix to append to the
    * path of the newly created file. This will return a XFILE::CFile
@@ -102,6 +113,10 @@ private:
   std::vector<std::string> AdvancedSettingsFiles;
   std::vector<std::string> GUISettingsFiles;
 
+  std::string PlayerBenchmarkFile;
+  std::string PlayerBenchmarkOutput;
+  bool PlayerBenchmarkUnpaced;
+
   double probability;
 };
 
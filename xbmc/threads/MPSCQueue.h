@@ -0,0 +1,135 @@
+/*
+ *      Copyright (C) 2005-2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "threads/Atomics.h"
+#include "threads/Helpers.h"
+
+namespace XbmcThreads
+{
+  /**
+   * A bounded, lock-free queue for any number of producers and a single
+   *  consumer.
+   *
+   * The queue is a ring of preallocated cells, each tagged with a sequence
+   *  number telling whether the cell is free for the producer of a given
+   *  position or holds a value for the consumer. Producers claim a position
+   *  with a single compare-and-swap, so pushing never blocks and never
+   *  allocates (values are assigned into the cells, which lets e.g. strings
+   *  reuse their buffers). When the ring is full Push fails instead of
+   *  waiting.
+   *
+   * Pop may only be called from one thread at a time, the caller has to
+   *  serialize consumers itself.
+   */
+  template<class T> class MPSCQueue : public NonCopyable
+  {
+    struct Cell
+    {
+      volatile long sequence;
+      T value;
+    };
+
+    Cell* cells;
+    long mask;
+    char pad1[64];
+    volatile long enqueuePos;
+    char pad2[64];
+    volatile long dequeuePos;
+
+    static inline long distance(long a, long b) { return (long)((unsigned long)a - (unsigned long)b); }
+
+  public:
+    /**
+     * The capacity is rounded up to the next power of two.
+     */
+    inline explicit MPSCQueue(unsigned int capacity) : enqueuePos(0), dequeuePos(0)
+    {
+      unsigned long size = 2;
+      while (size < capacity)
+        size <<= 1;
+      mask = (long)size - 1;
+      cells = new Cell[size];
+      for (unsigned long i = 0; i < size; i++)
+        cells[i].sequence = (long)i;
+    }
+
+    inline ~MPSCQueue() { delete[] cells; }
+
+    /**
+     * Copies the value into the queue. Returns false if the queue is full.
+     */
+    bool Push(const T& value)
+    {
+      Cell* cell;
+      long pos = enqueuePos;
+      for (;;)
+      {
+        cell = &cells[pos & mask];
+        long dif = distance(AtomicAdd(&cell->sequence, 0), pos);
+        if (dif == 0)
+        {
+          // the cell is free, try to claim the position
+          long prev = cas(&enqueuePos, pos, distance(pos, -1));
+          if (prev == pos)
+            break;
+          pos = prev;
+        }
+        else if (dif < 0)
+          return false; // the consumer didn't release this cell yet, we're full
+        else
+          pos = enqueuePos; // another producer was faster
+      }
+
+      cell->value = value;
+      AtomicIncrement(&cell->sequence); // publish to the consumer
+      return true;
+    }
+
+    /**
+     * Assigns the oldest value to the given reference and removes it from the
+     *  queue. Returns false if the queue is empty. Single consumer only.
+     */
+    bool Pop(T& value)
+    {
+      Cell* cell = &cells[dequeuePos & mask];
+      if (distance(AtomicAdd(&cell->sequence, 0), distance(dequeuePos, -1)) < 0)
+        return false;
+
+      value = cell->value;
+      dequeuePos = distance(dequeuePos, -1);
+      AtomicAdd(&cell->sequence, mask); // hand the cell back to the producers
+      return true;
+    }
+
+    /**
+     * Approximate number of values in the queue, including ones which are
+     *  still being pushed.
+     */
+    inline unsigned int Size() const
+    {
+      long size = distance(enqueuePos, dequeuePos);
+      return size > 0 ? (unsigned int)size : 0;
+    }
+
+    inline unsigned int Capacity() const { return (unsigned int)mask + 1; }
+  };
+}
@@ -0,0 +1,75 @@
+/*
+ *      Copyright (C) 2005-2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "threads/Atomics.h"
+#include "threads/CriticalSection.h"
+#include "threads/Helpers.h"
+#include "threads/SingleLock.h"
+
+#include <string.h>
+
+namespace XbmcThreads
+{
+  /**
+   * Holds a plain value which any number of threads can take a consistent
+   *  copy of without taking a lock, while another thread replaces it.
+   *
+   * A writer makes the sequence number odd, copies the value in and makes
+   *  it even again. Readers copy the value out and try again if the
+   *  sequence number was odd or has changed meanwhile, so they never block
+   *  a writer and only ever spin for the time a writer needs to copy the
+   *  value. Writers are serialized by a lock of their own.
+   *
+   * T has to be copyable with memcpy (no pointers to owned memory, no
+   *  std::string), as readers may copy it while it is being written.
+   */
+  template<class T> class SeqLock : public NonCopyable
+  {
+    mutable volatile long sequence;
+    T value;
+    CCriticalSection writeLock;
+
+  public:
+    inline SeqLock() : sequence(0) { memset(&value, 0, sizeof(value)); }
+
+    void Store(const T& newValue)
+    {
+      CSingleLock lock(writeLock);
+      AtomicIncrement(&sequence); // odd, readers retry
+      memcpy((void*)&value, &newValue, sizeof(T));
+      AtomicIncrement(&sequence); // even, the value is complete
+    }
+
+    void Load(T& copy) const
+    {
+      for (;;)
+      {
+        long before = AtomicAdd(&sequence, 0);
+        if (before & 1)
+          continue; // a writer is busy
+
+        memcpy(&copy, (const void*)&value, sizeof(T));
+        if (AtomicAdd(&sequence, 0) == before)
+          return;
+      }
+    }
+  };
+}
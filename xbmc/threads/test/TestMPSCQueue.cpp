@@ -0,0 +1,112 @@
+/*
+ *      Copyright (C) 2005-2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "TestHelpers.h"
+#include "threads/MPSCQueue.h"
+
+#include <boost/shared_array.hpp>
+#include <vector>
+
+#define TESTNUM 100000l
+#define NUMTHREADS 4l
+
+using namespace XbmcThreads;
+
+class DoPush : public IRunnable
+{
+  MPSCQueue<long>* queue;
+  long id;
+public:
+  inline DoPush(MPSCQueue<long>* q, long i) : queue(q), id(i) {}
+
+  virtual void Run()
+  {
+    for (long i = 0; i<TESTNUM; i++)
+    {
+      // spin until the consumer made room
+      while (!queue->Push(id * TESTNUM + i))
+        SleepMillis(0);
+    }
+  }
+};
+
+TEST(TestMPSCQueue, FIFO)
+{
+  MPSCQueue<long> queue(8);
+  long value;
+
+  EXPECT_EQ(8U, queue.Capacity());
+  EXPECT_FALSE(queue.Pop(value));
+
+  for (long i = 0; i < 8; i++)
+    EXPECT_TRUE(queue.Push(i));
+  EXPECT_FALSE(queue.Push(8));
+  EXPECT_EQ(8U, queue.Size());
+
+  for (long i = 0; i < 8; i++)
+  {
+    EXPECT_TRUE(queue.Pop(value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(queue.Pop(value));
+  EXPECT_EQ(0U, queue.Size());
+}
+
+TEST(TestMPSCQueue, CapacityRoundedUp)
+{
+  MPSCQueue<long> queue(100);
+  EXPECT_EQ(128U, queue.Capacity());
+}
+
+TEST(TestMassMPSCQueue, Push)
+{
+  MPSCQueue<long> queue(1024);
+  std::vector<DoPush*> pushers;
+  boost::shared_array<thread> t;
+  t.reset(new thread[NUMTHREADS]);
+  for(size_t i=0; i<NUMTHREADS; i++)
+  {
+    pushers.push_back(new DoPush(&queue, i));
+    t[i] = thread(*pushers[i]);
+  }
+
+  // every producer's values have to arrive complete and in order
+  std::vector<long> next(NUMTHREADS, 0);
+  long value;
+  for (long received = 0; received < NUMTHREADS * TESTNUM; )
+  {
+    if (!queue.Pop(value))
+      continue;
+    long id = value / TESTNUM;
+    ASSERT_GE(id, 0);
+    ASSERT_LT(id, NUMTHREADS);
+    EXPECT_EQ(next[id], value % TESTNUM);
+    next[id] = value % TESTNUM + 1;
+    received++;
+  }
+
+  for(size_t i=0; i<NUMTHREADS; i++)
+  {
+    t[i].join();
+    delete pushers[i];
+  }
+
+  EXPECT_FALSE(queue.Pop(value));
+}
@@ -0,0 +1,103 @@
+/*
+ *      Copyright (C) 2005-2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "TestHelpers.h"
+#include "threads/SeqLock.h"
+
+#include <boost/shared_array.hpp>
+#include <vector>
+
+#define TESTNUM 100000l
+#define NUMTHREADS 4l
+
+using namespace XbmcThreads;
+
+// big enough that copying it isn't a single store
+struct Value
+{
+  long numbers[32];
+};
+
+class DoStore : public IRunnable
+{
+  SeqLock<Value>* seqLock;
+  long id;
+public:
+  inline DoStore(SeqLock<Value>* l, long i) : seqLock(l), id(i) {}
+
+  virtual void Run()
+  {
+    Value value;
+    for (long i = 1; i <= TESTNUM; i++)
+    {
+      for (size_t j = 0; j < sizeof(value.numbers) / sizeof(value.numbers[0]); j++)
+        value.numbers[j] = id * TESTNUM + i;
+      seqLock->Store(value);
+    }
+  }
+};
+
+TEST(TestSeqLock, StoreLoad)
+{
+  SeqLock<Value> seqLock;
+  Value value;
+
+  seqLock.Load(value);
+  EXPECT_EQ(0, value.numbers[0]);
+
+  value.numbers[0] = 1;
+  value.numbers[31] = 2;
+  seqLock.Store(value);
+
+  Value copy;
+  seqLock.Load(copy);
+  EXPECT_EQ(1, copy.numbers[0]);
+  EXPECT_EQ(2, copy.numbers[31]);
+}
+
+TEST(TestMassSeqLock, Consistent)
+{
+  SeqLock<Value> seqLock;
+  std::vector<DoStore*> writers;
+  boost::shared_array<thread> t;
+  t.reset(new thread[NUMTHREADS]);
+  for(size_t i=0; i<NUMTHREADS; i++)
+  {
+    writers.push_back(new DoStore(&seqLock, i));
+    t[i] = thread(*writers[i]);
+  }
+
+  // a copy is never mixed from two stores
+  Value value;
+  for (long i = 0; i < TESTNUM; i++)
+  {
+    seqLock.Load(value);
+    for (size_t j = 1; j < sizeof(value.numbers) / sizeof(value.numbers[0]); j++)
+      ASSERT_EQ(value.numbers[0], value.numbers[j]);
+  }
+
+  for(size_t i=0; i<NUMTHREADS; i++)
+  {
+    t[i].join();
+    delete writers[i];
+  }
+
+  seqLock.Load(value);
+  EXPECT_EQ(0, value.numbers[0] % TESTNUM);
+}
@@ -27,6 +27,12 @@
 
 #include "BitstreamConverter.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 enum {
     NAL_SLICE=1,
     NAL_DPA,
@@ -130,6 +136,34 @@ static int nal_bs_read_ue(nal_bitstream *bs)
 
 static const uint8_t* avc_find_startcode_internal(const uint8_t *p, const uint8_t *end)
 {
+#if defined(__SSE2__)
+  // 16 positions at a time, each looks at the two bytes following it
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one  = _mm_set1_epi8(1);
+  for (; end - p >= 18; p += 16)
+  {
+    __m128i b0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), zero);
+    __m128i b1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 1)), zero);
+    __m128i b2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 2)), one);
+    int mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(b0, b1), b2));
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+#elif defined(__ARM_NEON__)
+  // 16 positions at a time, the byte loop below pins down a hit
+  const uint8x16_t zero = vdupq_n_u8(0);
+  const uint8x16_t one  = vdupq_n_u8(1);
+  for (; end - p >= 18; p += 16)
+  {
+    uint8x16_t b0 = vceqq_u8(vld1q_u8(p), zero);
+    uint8x16_t b1 = vceqq_u8(vld1q_u8(p + 1), zero);
+    uint8x16_t b2 = vceqq_u8(vld1q_u8(p + 2), one);
+    uint64x2_t hit = vreinterpretq_u64_u8(vandq_u8(vandq_u8(b0, b1), b2));
+    if (vgetq_lane_u64(hit, 0) | vgetq_lane_u64(hit, 1))
+      break;
+  }
+#endif
+
   const uint8_t *a = p + 4 - ((intptr_t)p & 3);
 
   for (end -= 3; p < a && p < end; p++)
@@ -282,6 +316,8 @@ CBitstreamConverter::CBitstreamConverter()
   m_convert_bitstream = false;
   m_convertBuffer     = NULL;
   m_convertSize       = 0;
+  m_convertBufferSize = 0;
+  m_convertInPlace    = false;
   m_inputBuffer       = NULL;
   m_inputSize         = 0;
   m_to_annexb         = false;
@@ -397,6 +433,9 @@ void CBitstreamConverter::Close(void)
   if (m_convertBuffer)
     av_free(m_convertBuffer), m_convertBuffer = NULL;
   m_convertSize = 0;
+  m_convertBufferSize = 0;
+  m_convertInPlace = false;
+  m_nal_units.clear();
 
   if (m_extradata)
     av_free(m_extradata), m_extradata = NULL;
@@ -412,13 +451,9 @@ void CBitstreamConverter::Close(void)
 
 bool CBitstreamConverter::Convert(uint8_t *pData, int iSize)
 {
-  if (m_convertBuffer)
-  {  
-    av_free(m_convertBuffer);
-    m_convertBuffer = NULL;
-  }
   m_inputSize = 0;
   m_convertSize = 0;
+  m_convertInPlace = false;
   m_inputBuffer = NULL;
 
   if (pData)
@@ -427,29 +462,14 @@ bool CBitstreamConverter::Convert(uint8_t *pData, int iSize)
     {
       if (m_to_annexb)
       {
-        int demuxer_bytes = iSize;
-        uint8_t *demuxer_content = pData;
-
         if (m_convert_bitstream)
         {
           // convert demuxer packet from bitstream to bytestream (AnnexB)
-          int bytestream_size = 0;
-          uint8_t *bytestream_buff = NULL;
-
-          BitstreamConvert(demuxer_content, demuxer_bytes, &bytestream_buff, &bytestream_size);
-          if (bytestream_buff && (bytestream_size > 0))
-          {
-            m_convertSize   = bytestream_size;
-            m_convertBuffer = bytestream_buff;
+          if (BitstreamConvert(pData, iSize))
             return true;
-          }
-          else
-          {
-            m_convertSize = 0;
-            m_convertBuffer = NULL;
-            CLog::Log(LOGERROR, "CBitstreamConverter::Convert: error converting.");
-            return false;
-          }
+
+          CLog::Log(LOGERROR, "CBitstreamConverter::Convert: error converting.");
+          return false;
         }
         else
         {
@@ -465,50 +485,13 @@ bool CBitstreamConverter::Convert(uint8_t *pData, int iSize)
   
         if (m_convert_bytestream)
         {
-          if(m_convertBuffer)
-          {
-            av_free(m_convertBuffer);
-            m_convertBuffer = NULL;
-          }
-          m_convertSize = 0;
-
           // convert demuxer packet from bytestream (AnnexB) to bitstream
-          AVIOContext *pb;
-
-          if(avio_open_dyn_buf(&pb) < 0)
-          {
-            return false;
-          }
-          m_convertSize = avc_parse_nal_units(pb, pData, iSize);
-          m_convertSize = avio_close_dyn_buf(pb, &m_convertBuffer);
+          return BytestreamConvert(pData, iSize);
         }
         else if (m_convert_3byteTo4byteNALSize)
         {
-          if(m_convertBuffer)
-          {
-            av_free(m_convertBuffer);
-            m_convertBuffer = NULL;
-          }
-          m_convertSize = 0;
-
           // convert demuxer packet from 3 byte NAL sizes to 4 byte
-          AVIOContext *pb;
-          if (avio_open_dyn_buf(&pb) < 0)
-            return false;
-
-          uint32_t nal_size;
-          uint8_t *end = pData + iSize;
-          uint8_t *nal_start = pData;
-          while (nal_start < end)
-          {
-            nal_size = BS_RB24(nal_start);
-            avio_wb16(pb, nal_size);
-            nal_start += 3;
-            avio_write(pb, nal_start, nal_size);
-            nal_start += nal_size;
-          }
-
-          m_convertSize = avio_close_dyn_buf(pb, &m_convertBuffer);
+          return NALSize3To4Convert(pData, iSize);
         }
         return true;
       }
@@ -521,7 +504,7 @@ bool CBitstreamConverter::Convert(uint8_t *pData, int iSize)
 
 uint8_t *CBitstreamConverter::GetConvertBuffer() const
 {
-  if((m_convert_bitstream || m_convert_bytestream || m_convert_3byteTo4byteNALSize) && m_convertBuffer != NULL)
+  if((m_convert_bitstream || m_convert_bytestream || m_convert_3byteTo4byteNALSize) && m_convertBuffer != NULL && !m_convertInPlace)
     return m_convertBuffer;
   else
     return m_inputBuffer;
@@ -529,7 +512,7 @@ uint8_t *CBitstreamConverter::GetConvertBuffer() const
 
 int CBitstreamConverter::GetConvertSize() const
 {
-  if((m_convert_bitstream || m_convert_bytestream || m_convert_3byteTo4byteNALSize) && m_convertBuffer != NULL)
+  if((m_convert_bitstream || m_convert_bytestream || m_convert_3byteTo4byteNALSize) && m_convertBuffer != NULL && !m_convertInPlace)
     return m_convertSize;
   else
     return m_inputSize;
@@ -632,97 +615,234 @@ pps:
   return true;
 }
 
-bool CBitstreamConverter::BitstreamConvert(uint8_t* pData, int iSize, uint8_t **poutbuf, int *poutbuf_size)
+bool CBitstreamConverter::BitstreamConvert(uint8_t* pData, int iSize)
 {
   // based on h264_mp4toannexb_bsf.c (ffmpeg)
   // which is Copyright (c) 2007 Benoit Fouet <benoit.fouet@free.fr>
   // and Licensed GPL 2.1 or greater
 
-  int i;
-  uint8_t *buf = pData;
-  uint32_t buf_size = iSize;
-  uint8_t  unit_type;
-  int32_t  nal_size;
-  uint32_t cumul_size = 0;
-  const uint8_t *buf_end = buf + buf_size;
-
-  do
+  int i, nal_count;
+  uint8_t *buf;
+  uint8_t *buf_end = pData + iSize;
+  uint32_t nal_size;
+  uint8_t  first_idr = m_sps_pps_context.first_idr;
+  uint8_t  idr_sps_pps_seen = m_sps_pps_context.idr_sps_pps_seen;
+  bool     sps_pps_added = false;
+  uint64_t out_size = 0;
+  const int length_size = m_sps_pps_context.length_size;
+
+  // check the units and size up the output before anything is written
+  for (buf = pData, nal_count = 0; buf < buf_end; nal_count++)
   {
-    if (buf + m_sps_pps_context.length_size > buf_end)
-      goto fail;
+    if (buf + length_size > buf_end)
+      return false;
 
-    for (nal_size = 0, i = 0; i < m_sps_pps_context.length_size; i++)
+    for (nal_size = 0, i = 0; i < length_size; i++)
       nal_size = (nal_size << 8) | buf[i];
+    buf += length_size;
 
-    buf += m_sps_pps_context.length_size;
-    unit_type = *buf & 0x1f;
+    if (nal_size > (uint32_t)(buf_end - buf))
+      return false;
 
-    if (buf + nal_size > buf_end || nal_size < 0)
-      goto fail;
+    if (nal_size && AddSpsPps(*buf & 0x1f, first_idr, idr_sps_pps_seen))
+    {
+      out_size += m_sps_pps_context.size;
+      sps_pps_added = true;
+    }
+    out_size += nal_size + (nal_count ? 3 : 4);
+    buf += nal_size;
+  }
 
-    // Don't add sps/pps if the unit already contain them
-    if (m_sps_pps_context.first_idr && (unit_type == 7 || unit_type == 8))
-      m_sps_pps_context.idr_sps_pps_seen = 1;
+  if (!nal_count || out_size > INT_MAX / 2)
+    return false;
 
-      // prepend only to the first access unit of an IDR picture, if no sps/pps already present
-    if (m_sps_pps_context.first_idr && unit_type == 5 && !m_sps_pps_context.idr_sps_pps_seen)
+  if (length_size == 4 && !sps_pps_added)
+  {
+    // each size field turns into a 4 byte start code, so the packet is rewritten where it is
+    for (buf = pData; buf < buf_end; buf += 4 + nal_size)
     {
-      BitstreamAllocAndCopy(poutbuf, poutbuf_size,
-        m_sps_pps_context.sps_pps_data, m_sps_pps_context.size, buf, nal_size);
-      m_sps_pps_context.first_idr = 0;
+      nal_size = BS_RB32(buf);
+      BS_WB32(buf, 1);
     }
-    else
+    m_inputBuffer = pData;
+    m_inputSize = iSize;
+    m_convertInPlace = true;
+  }
+  else
+  {
+    if (!ReserveConvertBuffer((int)out_size))
+      return false;
+
+    uint8_t *out = m_convertBuffer;
+    first_idr = m_sps_pps_context.first_idr;
+    idr_sps_pps_seen = m_sps_pps_context.idr_sps_pps_seen;
+    for (buf = pData, nal_count = 0; buf < buf_end; nal_count++)
     {
-      BitstreamAllocAndCopy(poutbuf, poutbuf_size, NULL, 0, buf, nal_size);
-      if (!m_sps_pps_context.first_idr && unit_type == 1)
+      for (nal_size = 0, i = 0; i < length_size; i++)
+        nal_size = (nal_size << 8) | buf[i];
+      buf += length_size;
+
+      // prepend only to the first access unit of an IDR picture, if no sps/pps already present
+      if (nal_size && AddSpsPps(*buf & 0x1f, first_idr, idr_sps_pps_seen) && m_sps_pps_context.size)
       {
-          m_sps_pps_context.first_idr = 1;
-          m_sps_pps_context.idr_sps_pps_seen = 0;
+        memcpy(out, m_sps_pps_context.sps_pps_data, m_sps_pps_context.size);
+        out += m_sps_pps_context.size;
       }
-    }
 
-    buf += nal_size;
-    cumul_size += nal_size + m_sps_pps_context.length_size;
-  } while (cumul_size < buf_size);
+      if (!nal_count)
+      {
+        BS_WB32(out, 1);
+        out += 4;
+      }
+      else
+      {
+        out[0] = 0;
+        out[1] = 0;
+        out[2] = 1;
+        out += 3;
+      }
+      memcpy(out, buf, nal_size);
+      out += nal_size;
+      buf += nal_size;
+    }
+    m_convertSize = out - m_convertBuffer;
+  }
 
+  m_sps_pps_context.first_idr = first_idr;
+  m_sps_pps_context.idr_sps_pps_seen = idr_sps_pps_seen;
   return true;
+}
+
+bool CBitstreamConverter::AddSpsPps(uint8_t unit_type, uint8_t &first_idr, uint8_t &idr_sps_pps_seen)
+{
+  // Don't add sps/pps if the unit already contain them
+  if (first_idr && (unit_type == NAL_SPS || unit_type == NAL_PPS))
+    idr_sps_pps_seen = 1;
+
+  if (first_idr && unit_type == NAL_IDR_SLICE && !idr_sps_pps_seen)
+  {
+    first_idr = 0;
+    return true;
+  }
 
-fail:
-  av_free(*poutbuf), *poutbuf = NULL;
-  *poutbuf_size = 0;
+  if (!first_idr && unit_type == NAL_SLICE)
+  {
+    first_idr = 1;
+    idr_sps_pps_seen = 0;
+  }
   return false;
 }
 
-void CBitstreamConverter::BitstreamAllocAndCopy( uint8_t **poutbuf, int *poutbuf_size,
-    const uint8_t *sps_pps, uint32_t sps_pps_size, const uint8_t *in, uint32_t in_size)
+bool CBitstreamConverter::BytestreamConvert(uint8_t* pData, int iSize)
 {
-  // based on h264_mp4toannexb_bsf.c (ffmpeg)
-  // which is Copyright (c) 2007 Benoit Fouet <benoit.fouet@free.fr>
-  // and Licensed GPL 2.1 or greater
+  const uint8_t *end = pData + iSize;
+  const uint8_t *unit_end = pData;
+  const uint8_t *nal_start, *nal_end;
+  int64_t out_size = 0;
+  bool in_place = true;
+
+  // find the units first, as in avc_parse_nal_units. As long as no start code
+  // is shorter than the 4 byte size replacing it, they're moved within the packet.
+  m_nal_units.clear();
+  nal_start = avc_find_startcode(pData, end);
+  for (;;)
+  {
+    while (nal_start < end && !*(nal_start++));
+    if (nal_start == end)
+      break;
 
-  uint32_t offset = *poutbuf_size;
-  uint8_t nal_header_size = offset ? 3 : 4;
-  void *tmp;
+    nal_end = avc_find_startcode(nal_start, end);
+    if (nal_start - unit_end < 4)
+      in_place = false;
+
+    nal_unit unit;
+    unit.offset = nal_start - pData;
+    unit.size = nal_end - nal_start;
+    m_nal_units.push_back(unit);
+    out_size += 4 + unit.size;
+    unit_end = nal_start = nal_end;
+  }
 
-  *poutbuf_size += sps_pps_size + in_size + nal_header_size;
-  tmp = av_realloc(*poutbuf, *poutbuf_size);
-  if (!tmp)
-    return;
-  *poutbuf = (uint8_t*)tmp;
-  if (sps_pps)
-    memcpy(*poutbuf + offset, sps_pps, sps_pps_size);
+  if (in_place)
+  {
+    uint8_t *out = pData;
+    for (std::vector<nal_unit>::const_iterator it = m_nal_units.begin(); it != m_nal_units.end(); ++it)
+    {
+      BS_WB32(out, it->size);
+      out += 4;
+      if (out != pData + it->offset)
+        memmove(out, pData + it->offset, it->size);
+      out += it->size;
+    }
+    m_inputSize = out - pData;
+    m_convertInPlace = true;
+    return true;
+  }
 
-  memcpy(*poutbuf + sps_pps_size + nal_header_size + offset, in, in_size);
-  if (!offset)
+  if (out_size > INT_MAX / 2 || !ReserveConvertBuffer((int)out_size))
+    return false;
+
+  uint8_t *out = m_convertBuffer;
+  for (std::vector<nal_unit>::const_iterator it = m_nal_units.begin(); it != m_nal_units.end(); ++it)
   {
-    BS_WB32(*poutbuf + sps_pps_size, 1);
+    BS_WB32(out, it->size);
+    memcpy(out + 4, pData + it->offset, it->size);
+    out += 4 + it->size;
   }
-  else
+  m_convertSize = out - m_convertBuffer;
+  return true;
+}
+
+bool CBitstreamConverter::NALSize3To4Convert(const uint8_t* pData, int iSize)
+{
+  // every unit grows by a byte, so this one always needs the buffer
+  const uint8_t *end = pData + iSize;
+  const uint8_t *nal_start;
+  uint32_t nal_size;
+  int64_t out_size = 0;
+
+  for (nal_start = pData; end - nal_start >= 3; nal_start += nal_size)
+  {
+    nal_size = BS_RB24(nal_start);
+    nal_start += 3;
+    if (nal_size > (uint32_t)(end - nal_start))
+      break;
+    out_size += 4 + nal_size;
+  }
+
+  if (out_size > INT_MAX / 2 || !ReserveConvertBuffer((int)out_size))
+    return false;
+
+  uint8_t *out = m_convertBuffer;
+  for (nal_start = pData; out - m_convertBuffer < out_size; nal_start += nal_size)
+  {
+    nal_size = BS_RB24(nal_start);
+    nal_start += 3;
+    BS_WB32(out, nal_size);
+    memcpy(out + 4, nal_start, nal_size);
+    out += 4 + nal_size;
+  }
+  m_convertSize = out - m_convertBuffer;
+  return true;
+}
+
+bool CBitstreamConverter::ReserveConvertBuffer(int size)
+{
+  if (size + FF_INPUT_BUFFER_PADDING_SIZE > m_convertBufferSize)
   {
-    (*poutbuf + offset + sps_pps_size)[0] = 0;
-    (*poutbuf + offset + sps_pps_size)[1] = 0;
-    (*poutbuf + offset + sps_pps_size)[2] = 1;
+    // some room to spare, packet sizes vary from picture to picture
+    int alloc_size = size + size / 2 + FF_INPUT_BUFFER_PADDING_SIZE;
+    av_free(m_convertBuffer);
+    m_convertBuffer = (uint8_t*)av_malloc(alloc_size);
+    if (!m_convertBuffer)
+    {
+      m_convertBufferSize = 0;
+      return false;
+    }
+    m_convertBufferSize = alloc_size;
   }
+  memset(m_convertBuffer + size, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+  return true;
 }
 
 const int CBitstreamConverter::avc_parse_nal_units(AVIOContext *pb, const uint8_t *buf_in, int size)
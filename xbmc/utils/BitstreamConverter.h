@@ -22,6 +22,7 @@
 #define _BITSTREAMCONVERTER_H_
 
 #include <stdint.h>
+#include <vector>
 
 extern "C" {
 #include "libavutil/avutil.h"
@@ -153,6 +154,11 @@ public:
   bool              Open(enum AVCodecID codec, uint8_t *in_extradata, int in_extrasize, bool to_annexb);
   void              Close(void);
   bool              NeedConvert(void) const { return m_convert_bitstream; };
+  /*!
+   \brief Convert a demuxer packet, the result is fetched with GetConvertBuffer() and GetConvertSize()
+   Where the converted packet is no larger than pData it's written over it, so a packet is to
+   be converted once only. Otherwise it goes into a buffer which is kept for the next packets.
+   */
   bool              Convert(uint8_t *pData, int iSize);
   uint8_t*          GetConvertBuffer(void) const;
   int               GetConvertSize() const;
@@ -178,9 +184,12 @@ protected:
   const int         isom_write_avcc(AVIOContext *pb, const uint8_t *data, int len);
   // bitstream to bytestream (Annex B) conversion support.
   bool              BitstreamConvertInit(void *in_extradata, int in_extrasize);
-  bool              BitstreamConvert(uint8_t* pData, int iSize, uint8_t **poutbuf, int *poutbuf_size);
-  static void       BitstreamAllocAndCopy(uint8_t **poutbuf, int *poutbuf_size,
-                      const uint8_t *sps_pps, uint32_t sps_pps_size, const uint8_t *in, uint32_t in_size);
+  bool              BitstreamConvert(uint8_t* pData, int iSize);
+  static bool       AddSpsPps(uint8_t unit_type, uint8_t &first_idr, uint8_t &idr_sps_pps_seen);
+  // bytestream (Annex B) to bitstream conversion support.
+  bool              BytestreamConvert(uint8_t* pData, int iSize);
+  bool              NALSize3To4Convert(const uint8_t* pData, int iSize);
+  bool              ReserveConvertBuffer(int size);
 
   typedef struct omx_bitstream_ctx {
       uint8_t  length_size;
@@ -190,8 +199,16 @@ protected:
       uint32_t size;
   } omx_bitstream_ctx;
 
+  typedef struct nal_unit {
+      int offset;
+      int size;
+  } nal_unit;
+
   uint8_t          *m_convertBuffer;
   int               m_convertSize;
+  int               m_convertBufferSize; // allocated, the buffer is kept from packet to packet
+  bool              m_convertInPlace;    // the packet was converted over the input
+  std::vector<nal_unit> m_nal_units;
   uint8_t          *m_inputBuffer;
   int               m_inputSize;
 
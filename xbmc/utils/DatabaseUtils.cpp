@@ -303,7 +303,9 @@ bool DatabaseUtils::GetSelectFields(const Fields &fields, const MediaType &media
   return !selectFields.empty();
 }
 
-bool DatabaseUtils::GetFieldValue(const dbiplus::field_value &fieldValue, CVariant &variantValue)
+// for both stored values and the cells of a result set
+template<class T>
+static bool GetValue(const T &fieldValue, CVariant &variantValue)
 {
   if (fieldValue.get_isNull())
   {
@@ -352,6 +354,16 @@ bool DatabaseUtils::GetFieldValue(const dbiplus::field_value &fieldValue, CVaria
   return false;
 }
 
+bool DatabaseUtils::GetFieldValue(const dbiplus::field_value &fieldValue, CVariant &variantValue)
+{
+  return GetValue(fieldValue, variantValue);
+}
+
+bool DatabaseUtils::GetFieldValue(const dbiplus::field_ref &fieldValue, CVariant &variantValue)
+{
+  return GetValue(fieldValue, variantValue);
+}
+
 bool DatabaseUtils::GetDatabaseResults(const MediaType &mediaType, const FieldList &fields, const std::auto_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results)
 {
   if (dataset->num_rows() == 0)
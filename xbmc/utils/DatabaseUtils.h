@@ -33,6 +33,7 @@ namespace dbiplus
 {
   class Dataset;
   class field_value;
+  class field_ref;
 }
 
 typedef enum {
@@ -152,6 +153,7 @@ public:
   static bool GetSelectFields(const Fields &fields, const MediaType &mediaType, FieldList &selectFields);
   
   static bool GetFieldValue(const dbiplus::field_value &fieldValue, CVariant &variantValue);
+  static bool GetFieldValue(const dbiplus::field_ref &fieldValue, CVariant &variantValue);
   static bool GetDatabaseResults(const MediaType &mediaType, const FieldList &fields, const std::auto_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results);
 
   static std::string BuildLimitClause(int end, int start = 0);
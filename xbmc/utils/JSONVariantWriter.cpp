@@ -24,53 +24,137 @@
 
 using namespace std;
 
-string CJSONVariantWriter::Write(const CVariant &value, bool compact)
+namespace
 {
-  string output;
+  // Set locale to classic ("C") to ensure valid JSON numbers
+  class CClassicNumericLocale
+  {
+  public:
+    CClassicNumericLocale()
+    {
+      const char *currentLocale = setlocale(LC_NUMERIC, NULL);
+      if (currentLocale != NULL)
+      {
+        m_backupLocale = currentLocale;
+        setlocale(LC_NUMERIC, "C");
+      }
+    }
+
+    ~CClassicNumericLocale()
+    {
+      // Re-set locale to what it was before using yajl
+      if (!m_backupLocale.empty())
+        setlocale(LC_NUMERIC, m_backupLocale.c_str());
+    }
 
+  private:
+    std::string m_backupLocale;
+  };
+}
+
+CJSONStreamWriter::CJSONStreamWriter(IJSONOutputSink &sink, bool compact, size_t chunkSize /* = 16384 */)
+  : m_sink(sink),
+    m_chunkSize(chunkSize),
+    m_failed(false)
+{
 #if YAJL_MAJOR == 2
-  yajl_gen g = yajl_gen_alloc(NULL);
-  yajl_gen_config(g, yajl_gen_beautify, compact ? 0 : 1);
-  yajl_gen_config(g, yajl_gen_indent_string, "\t");
+  m_generator = yajl_gen_alloc(NULL);
+  yajl_gen_config(m_generator, yajl_gen_beautify, compact ? 0 : 1);
+  yajl_gen_config(m_generator, yajl_gen_indent_string, "\t");
 #else
   yajl_gen_config conf = { compact ? 0 : 1, "\t" };
-  yajl_gen g = yajl_gen_alloc(&conf, NULL);
+  m_generator = yajl_gen_alloc(&conf, NULL);
 #endif
+}
 
-  // Set locale to classic ("C") to ensure valid JSON numbers
-  const char *currentLocale = setlocale(LC_NUMERIC, NULL);
-  std::string backupLocale;
-  if (currentLocale != NULL)
-  {
-    backupLocale = currentLocale;
-    setlocale(LC_NUMERIC, "C");
-  }
+CJSONStreamWriter::~CJSONStreamWriter()
+{
+  yajl_gen_clear(m_generator);
+  yajl_gen_free(m_generator);
+}
 
-  if (InternalWrite(g, value))
-  {
-    const unsigned char * buffer;
+bool CJSONStreamWriter::StartObject()
+{
+  return Check(yajl_gen_map_open(m_generator));
+}
+
+bool CJSONStreamWriter::EndObject()
+{
+  return Check(yajl_gen_map_close(m_generator));
+}
+
+bool CJSONStreamWriter::StartArray()
+{
+  return Check(yajl_gen_array_open(m_generator));
+}
+
+bool CJSONStreamWriter::EndArray()
+{
+  return Check(yajl_gen_array_close(m_generator));
+}
 
+bool CJSONStreamWriter::Key(const std::string &key)
+{
 #if YAJL_MAJOR == 2
-    size_t length;
-    yajl_gen_get_buf(g, &buffer, &length);
+  return Check(yajl_gen_string(m_generator, (const unsigned char*)key.c_str(), (size_t)key.length()));
 #else
-    unsigned int length;
-    yajl_gen_get_buf(g, &buffer, &length);
+  return Check(yajl_gen_string(m_generator, (const unsigned char*)key.c_str(), key.length()));
 #endif
-    output = string((const char *)buffer, length);
-  }
+}
 
-  // Re-set locale to what it was before using yajl
-  if (!backupLocale.empty())
-    setlocale(LC_NUMERIC, backupLocale.c_str());
+bool CJSONStreamWriter::Value(const CVariant &value)
+{
+  if (m_failed)
+    return false;
 
-  yajl_gen_clear(g);
-  yajl_gen_free(g);
+  CClassicNumericLocale locale;
+  return InternalWrite(value);
+}
 
-  return output;
+bool CJSONStreamWriter::Flush()
+{
+  if (m_failed)
+    return false;
+
+  const unsigned char *buffer;
+#if YAJL_MAJOR == 2
+  size_t length;
+#else
+  unsigned int length;
+#endif
+  yajl_gen_get_buf(m_generator, &buffer, &length);
+  if (length == 0)
+    return true;
+
+  if (!m_sink.Write((const char *)buffer, length))
+    m_failed = true;
+
+  yajl_gen_clear(m_generator);
+  return !m_failed;
 }
 
-bool CJSONVariantWriter::InternalWrite(yajl_gen g, const CVariant &value)
+bool CJSONStreamWriter::Check(yajl_gen_status status)
+{
+  if (m_failed || status != yajl_gen_status_ok)
+  {
+    m_failed = true;
+    return false;
+  }
+
+  const unsigned char *buffer;
+#if YAJL_MAJOR == 2
+  size_t length;
+#else
+  unsigned int length;
+#endif
+  yajl_gen_get_buf(m_generator, &buffer, &length);
+  if (length >= m_chunkSize)
+    return Flush();
+
+  return true;
+}
+
+bool CJSONStreamWriter::InternalWrite(const CVariant &value)
 {
   bool success = false;
 
@@ -78,65 +162,77 @@ bool CJSONVariantWriter::InternalWrite(yajl_gen g, const CVariant &value)
   {
   case CVariant::VariantTypeInteger:
 #if YAJL_MAJOR == 2
-    success = yajl_gen_status_ok == yajl_gen_integer(g, (long long int)value.asInteger());
+    success = Check(yajl_gen_integer(m_generator, (long long int)value.asInteger()));
 #else
-    success = yajl_gen_status_ok == yajl_gen_integer(g, (long int)value.asInteger());
+    success = Check(yajl_gen_integer(m_generator, (long int)value.asInteger()));
 #endif
     break;
   case CVariant::VariantTypeUnsignedInteger:
 #if YAJL_MAJOR == 2
-    success = yajl_gen_status_ok == yajl_gen_integer(g, (long long int)value.asUnsignedInteger());
+    success = Check(yajl_gen_integer(m_generator, (long long int)value.asUnsignedInteger()));
 #else
-    success = yajl_gen_status_ok == yajl_gen_integer(g, (long int)value.asUnsignedInteger());
+    success = Check(yajl_gen_integer(m_generator, (long int)value.asUnsignedInteger()));
 #endif
     break;
   case CVariant::VariantTypeDouble:
-    success = yajl_gen_status_ok == yajl_gen_double(g, value.asDouble());
+    success = Check(yajl_gen_double(m_generator, value.asDouble()));
     break;
   case CVariant::VariantTypeBoolean:
-    success = yajl_gen_status_ok == yajl_gen_bool(g, value.asBoolean() ? 1 : 0);
+    success = Check(yajl_gen_bool(m_generator, value.asBoolean() ? 1 : 0));
     break;
   case CVariant::VariantTypeString:
 #if YAJL_MAJOR == 2
-    success = yajl_gen_status_ok == yajl_gen_string(g, (const unsigned char*)value.c_str(), (size_t)value.size());
+    success = Check(yajl_gen_string(m_generator, (const unsigned char*)value.c_str(), (size_t)value.size()));
 #else
-    success = yajl_gen_status_ok == yajl_gen_string(g, (const unsigned char*)value.c_str(), value.size());
+    success = Check(yajl_gen_string(m_generator, (const unsigned char*)value.c_str(), value.size()));
 #endif
     break;
   case CVariant::VariantTypeArray:
-    success = yajl_gen_status_ok == yajl_gen_array_open(g);
+    success = StartArray();
 
     for (CVariant::const_iterator_array itr = value.begin_array(); itr != value.end_array() && success; ++itr)
-      success &= InternalWrite(g, *itr);
+      success &= InternalWrite(*itr);
 
     if (success)
-      success = yajl_gen_status_ok == yajl_gen_array_close(g);
+      success = EndArray();
 
     break;
   case CVariant::VariantTypeObject:
-    success = yajl_gen_status_ok == yajl_gen_map_open(g);
+    success = StartObject();
 
     for (CVariant::const_iterator_map itr = value.begin_map(); itr != value.end_map() && success; ++itr)
     {
-#if YAJL_MAJOR == 2
-      success &= yajl_gen_status_ok == yajl_gen_string(g, (const unsigned char*)itr->first.c_str(), (size_t)itr->first.length());
-#else
-      success &= yajl_gen_status_ok == yajl_gen_string(g, (const unsigned char*)itr->first.c_str(), itr->first.length());
-#endif
+      success &= Key(itr->first);
       if (success)
-        success &= InternalWrite(g, itr->second);
+        success &= InternalWrite(itr->second);
     }
 
     if (success)
-      success &= yajl_gen_status_ok == yajl_gen_map_close(g);
+      success &= EndObject();
 
     break;
   case CVariant::VariantTypeConstNull:
   case CVariant::VariantTypeNull:
   default:
-    success = yajl_gen_status_ok == yajl_gen_null(g);
+    success = Check(yajl_gen_null(m_generator));
     break;
   }
 
   return success;
 }
+
+string CJSONVariantWriter::Write(const CVariant &value, bool compact)
+{
+  string output;
+  CJSONStringSink sink(output);
+  if (!Write(value, sink, compact))
+    output.clear();
+
+  return output;
+}
+
+bool CJSONVariantWriter::Write(const CVariant &value, IJSONOutputSink &sink, bool compact)
+{
+  CJSONStreamWriter writer(sink, compact);
+  return writer.Value(value) && writer.Flush();
+}
@@ -26,10 +26,68 @@
 #include <yajl/yajl_version.h>
 #endif
 
+/*!
+ \brief Destination for the output of a CJSONStreamWriter
+ */
+class IJSONOutputSink
+{
+public:
+  virtual ~IJSONOutputSink() { }
+
+  virtual bool Write(const char *data, size_t length) = 0;
+};
+
+class CJSONStringSink : public IJSONOutputSink
+{
+public:
+  CJSONStringSink(std::string &output) : m_output(output) { }
+
+  virtual bool Write(const char *data, size_t length) { m_output.append(data, length); return true; }
+
+private:
+  std::string &m_output;
+};
+
+/*!
+ \brief Incremental JSON generator
+
+ Values are rendered into an internal buffer which is handed to the sink
+ whenever it grows beyond the given chunk size (and on Flush()), so large
+ documents can be written piece by piece without ever building the whole
+ CVariant tree or the complete output string in memory.
+ */
+class CJSONStreamWriter
+{
+public:
+  CJSONStreamWriter(IJSONOutputSink &sink, bool compact, size_t chunkSize = 16384);
+  ~CJSONStreamWriter();
+
+  bool StartObject();
+  bool EndObject();
+  bool StartArray();
+  bool EndArray();
+  bool Key(const std::string &key);
+  bool Value(const CVariant &value);
+
+  /*!
+   \brief Hands all buffered output to the sink
+   */
+  bool Flush();
+  bool Failed() const { return m_failed; }
+
+private:
+  bool Check(yajl_gen_status status);
+  bool InternalWrite(const CVariant &value);
+
+  yajl_gen m_generator;
+  IJSONOutputSink &m_sink;
+  size_t m_chunkSize;
+  bool m_failed;
+};
+
 class CJSONVariantWriter
 {
 public:
   static std::string Write(const CVariant &value, bool compact);
-private:
-  static bool InternalWrite(yajl_gen g, const CVariant &value);
+  static bool Write(const CVariant &value, IJSONOutputSink &sink, bool compact);
 };
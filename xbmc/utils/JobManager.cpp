@@ -21,8 +21,11 @@
 #include "JobManager.h"
 #include <algorithm>
 #include <stdexcept>
+#include "threads/Atomics.h"
 #include "threads/SingleLock.h"
+#include "utils/CPUInfo.h"
 #include "utils/log.h"
+#include "utils/Profiler.h"
 
 #include "system.h"
 
@@ -36,9 +39,10 @@ bool CJob::ShouldCancel(unsigned int progress, unsigned int total) const
   return false;
 }
 
-CJobWorker::CJobWorker(CJobManager *manager) : CThread("JobWorker")
+CJobWorker::CJobWorker(CJobManager *manager, unsigned int slot) : CThread("JobWorker")
 {
   m_jobManager = manager;
+  m_slot = slot;
   Create(true); // start work immediately, and kill ourselves when we're done
 }
 
@@ -65,13 +69,20 @@ void CJobWorker::Process()
     bool success = false;
     try
     {
-      success = job->DoWork();
+      // jobs are coarse enough to look up their section every time, but only when it's needed
+      if (CProfiler::IsEnabled())
+      {
+        CProfilerScope scope(CProfiler::Get().RegisterSection(std::string("Job.") + job->GetType()));
+        success = job->DoWork();
+      }
+      else
+        success = job->DoWork();
     }
     catch (...)
     {
       CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, job->GetType());
     }
-    m_jobManager->OnJobComplete(success, job);
+    m_jobManager->OnJobComplete(success, job, this);
   }
 }
 
@@ -175,9 +186,15 @@ CJobManager &CJobManager::GetInstance()
 CJobManager::CJobManager()
 {
   m_jobCounter = 0;
+  m_maxWorkers = 5;
   m_running = true;
   m_pauseJobs = false;
   m_tangle = 0;
+  m_slotCounter = 0;
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    m_queued[priority] = 0;
+  m_active = 0;
+  m_idle = 0;
 }
 
 void CJobManager::Restart()
@@ -204,6 +221,20 @@ void CJobManager::CancelJobs()
   // cancel any callbacks on jobs still processing
   for_each(m_processing.begin(), m_processing.end(), mem_fun_ref(&CWorkItem::Cancel));
 
+  // same for the local queues of our workers
+  for (Slots::iterator slot = m_slots.begin(); slot != m_slots.end(); ++slot)
+  {
+    CSingleLock slotLock((*slot)->m_section);
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    {
+      JobQueue &queue = (*slot)->m_jobQueue[priority];
+      for_each(queue.begin(), queue.end(), mem_fun_ref(&CWorkItem::FreeJob));
+      AtomicSubtract(&m_queued[priority], queue.size());
+      queue.clear();
+    }
+    for_each((*slot)->m_processing.begin(), (*slot)->m_processing.end(), mem_fun_ref(&CWorkItem::Cancel));
+  }
+
   // tell our workers to finish
   while (m_workers.size())
   {
@@ -216,22 +247,76 @@ void CJobManager::CancelJobs()
 
 CJobManager::~CJobManager()
 {
+  // our workers auto-delete, so only free the slots if they're all gone
+  if (m_workers.empty())
+    FreeSlots();
+}
+
+void CJobManager::SetWorkStealing(bool enable, unsigned int maxWorkers)
+{
+  CSingleLock lock(m_section);
+
+  if (m_running || !m_workers.empty())
+    throw std::logic_error("CJobManager must be cancelled to change the worker mode");
+
+  FreeSlots();
+
+  if (maxWorkers == 0)
+  {
+    maxWorkers = 5;
+    if (enable && g_cpuInfo.getCPUCount() > (int)maxWorkers)
+      maxWorkers = g_cpuInfo.getCPUCount();
+  }
+  m_maxWorkers = maxWorkers;
+
+  if (enable)
+  {
+    for (unsigned int i = 0; i < m_maxWorkers; ++i)
+      m_slots.push_back(new CWorkerSlot);
+  }
+  CLog::Log(LOGDEBUG, "CJobManager::SetWorkStealing - %s with up to %u workers", enable ? "work stealing" : "shared queue", m_maxWorkers);
+}
+
+void CJobManager::FreeSlots()
+{
+  for (Slots::iterator slot = m_slots.begin(); slot != m_slots.end(); ++slot)
+  {
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+      for_each((*slot)->m_jobQueue[priority].begin(), (*slot)->m_jobQueue[priority].end(), mem_fun_ref(&CWorkItem::FreeJob));
+    delete *slot;
+  }
+  m_slots.clear();
+
+  m_slotCounter = 0;
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    m_queued[priority] = 0;
+  m_active = 0;
+  m_idle = 0;
+}
+
+unsigned int CJobManager::NextJobId()
+{
+  // increment the job counter, ensuring 0 (invalid job) is never hit
+  unsigned int id;
+  do
+  {
+    id = (unsigned int)AtomicIncrement(&m_jobCounter);
+  } while (id == 0);
+  return id;
 }
 
 unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority)
 {
+  if (IsWorkStealing())
+    return AddJobLocal(CWorkItem(job, NextJobId(), priority, callback));
+
   CSingleLock lock(m_section);
 
   if (!m_running)
     return 0;
 
-  // increment the job counter, ensuring 0 (invalid job) is never hit
-  m_jobCounter++;
-  if (m_jobCounter == 0)
-    m_jobCounter++;
-
   // create a work item for this job
-  CWorkItem work(job, m_jobCounter, priority, callback);
+  CWorkItem work(job, NextJobId(), priority, callback);
   m_jobQueue[priority].push_back(work);
 
   StartWorkers(priority);
@@ -240,6 +325,12 @@ unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORI
 
 void CJobManager::CancelJob(unsigned int jobID)
 {
+  if (IsWorkStealing())
+  {
+    CancelJobLocal(jobID);
+    return;
+  }
+
   CSingleLock lock(m_section);
 
   // check whether we have this job in the queue
@@ -268,6 +359,35 @@ void CJobManager::CancelJob(unsigned int jobID)
 
 void CJobManager::StartWorkers(CJob::PRIORITY priority)
 {
+  if (IsWorkStealing())
+  {
+    // check how many free threads we have
+    if (AtomicAdd(&m_active, 0) >= (long)GetMaxWorkers(priority))
+      return;
+
+    // do we have any sleeping threads?
+    if (AtomicAdd(&m_idle, 0) > 0)
+    {
+      m_jobEvent.Set();
+      return;
+    }
+
+    // everyone is busy - we need more workers, attached to a slot without a worker
+    CSingleLock lock(m_section);
+    if (!m_running || m_workers.size() >= m_maxWorkers)
+      return;
+    for (unsigned int i = 0; i < m_slots.size(); ++i)
+    {
+      if (!m_slots[i]->m_worker)
+      {
+        m_slots[i]->m_worker = new CJobWorker(this, i);
+        m_workers.push_back(m_slots[i]->m_worker);
+        return;
+      }
+    }
+    return;
+  }
+
   CSingleLock lock(m_section);
 
   // check how many free threads we have
@@ -319,6 +439,10 @@ void CJobManager::UnPauseJobs()
 {
   CSingleLock lock(m_section);
   m_pauseJobs = false;
+
+  // jobs may have piled up in the local queues while paused
+  if (IsWorkStealing() && AtomicAdd(&m_queued[CJob::PRIORITY_LOW_PAUSABLE], 0) > 0)
+    StartWorkers(CJob::PRIORITY_LOW_PAUSABLE);
 }
 
 bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
@@ -333,6 +457,16 @@ bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
     if (priority == it->m_priority)
       return true;
   }
+
+  for (Slots::const_iterator slot = m_slots.begin(); slot != m_slots.end(); ++slot)
+  {
+    CSingleLock slotLock((*slot)->m_section);
+    for(Processing::const_iterator it = (*slot)->m_processing.begin(); it < (*slot)->m_processing.end(); ++it)
+    {
+      if (priority == it->m_priority)
+        return true;
+    }
+  }
   return false;
 }
 
@@ -349,11 +483,24 @@ int CJobManager::IsProcessing(const std::string &type) const
     if (type == std::string(it->m_job->GetType()))
       jobsMatched++;
   }
+
+  for (Slots::const_iterator slot = m_slots.begin(); slot != m_slots.end(); ++slot)
+  {
+    CSingleLock slotLock((*slot)->m_section);
+    for(Processing::const_iterator it = (*slot)->m_processing.begin(); it < (*slot)->m_processing.end(); ++it)
+    {
+      if (type == std::string(it->m_job->GetType()))
+        jobsMatched++;
+    }
+  }
   return jobsMatched;
 }
 
 CJob *CJobManager::GetNextJob(const CJobWorker *worker)
 {
+  if (IsWorkStealing())
+    return GetNextJobLocal(worker);
+
   CSingleLock lock(m_section);
   while (m_running)
   {
@@ -380,6 +527,9 @@ CJob *CJobManager::GetNextJob(const CJobWorker *worker)
 
 bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const CJob *job)
 {
+  if (IsWorkStealing())
+    return OnJobProgressLocal(progress, total, job);
+
   CSingleLock lock(m_section);
 
   // find the job in the processing queue, and check whether it's cancelled (no callback)
@@ -402,8 +552,14 @@ bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const
   return true; // couldn't find the job, or it's been cancelled
 }
 
-void CJobManager::OnJobComplete(bool success, CJob *job)
+void CJobManager::OnJobComplete(bool success, CJob *job, const CJobWorker *worker)
 {
+  if (IsWorkStealing())
+  {
+    OnJobCompleteLocal(success, job, worker);
+    return;
+  }
+
   CSingleLock lock(m_section);
   // remove the job from the processing queue
   Processing::iterator i = find(m_processing.begin(), m_processing.end(), job);
@@ -442,10 +598,285 @@ void CJobManager::RemoveWorker(const CJobWorker *worker)
   Workers::iterator i = find(m_workers.begin(), m_workers.end(), worker);
   if (i != m_workers.end())
     m_workers.erase(i); // workers auto-delete
+
+  // and detach it from its local queue, which stays around for the other workers
+  for (Slots::iterator slot = m_slots.begin(); slot != m_slots.end(); ++slot)
+  {
+    if ((*slot)->m_worker == worker)
+      (*slot)->m_worker = NULL;
+  }
 }
 
-unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority)
+unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority) const
 {
-  static const unsigned int max_workers = 5;
-  return max_workers - (CJob::PRIORITY_HIGH - priority);
+  // lower priorities leave a worker free for each higher priority, but always get at least one
+  unsigned int reserved = CJob::PRIORITY_HIGH - priority;
+  if (m_maxWorkers <= reserved)
+    return 1;
+  return m_maxWorkers - reserved;
+}
+
+unsigned int CJobManager::AddJobLocal(const CWorkItem &work)
+{
+  // jobs queued from within a job (or its callbacks) stay on the queue of the
+  // calling worker, everything else is spread round robin over the local queues
+  CWorkerSlot *slot = NULL;
+  CJobWorker *worker = dynamic_cast<CJobWorker*>(CThread::GetCurrentThread());
+  if (worker && worker->GetSlot() < m_slots.size())
+    slot = m_slots[worker->GetSlot()];
+  else
+    slot = m_slots[(unsigned long)AtomicIncrement(&m_slotCounter) % m_slots.size()];
+
+  {
+    CSingleLock lock(slot->m_section);
+    // checked with the slot locked, so CancelJobs() either sees this job or we see it cancelled
+    if (!m_running)
+      return 0;
+    slot->m_jobQueue[work.m_priority].push_back(work);
+  }
+
+  // announce the job only after queueing it, workers going idle check m_queued after m_idle
+  AtomicIncrement(&m_queued[work.m_priority]);
+  StartWorkers(work.m_priority);
+  return work.m_id;
+}
+
+bool CJobManager::TakeJob(CWorkerSlot &slot, CWorkerSlot &victim, int priority)
+{
+  // always lock the slot with the lower address first, so two workers stealing
+  // from each other can't deadlock
+  CSingleLock lock1(&slot < &victim ? slot.m_section : victim.m_section);
+  CSingleLock lock2(&slot < &victim ? victim.m_section : slot.m_section);
+
+  JobQueue &queue = victim.m_jobQueue[priority];
+  if (queue.empty())
+    return false;
+
+  // take the oldest job from both our own and foreign queues, to keep jobs of
+  // the same priority roughly in the order they have been added
+  CWorkItem job = queue.front();
+  queue.pop_front();
+  AtomicDecrement(&m_queued[priority]);
+
+  slot.m_processing.push_back(job);
+  job.m_job->m_callback = this;
+  return true;
+}
+
+CJob *CJobManager::PopJobLocal(unsigned int index)
+{
+  CWorkerSlot &slot = *m_slots[index];
+  for (int priority = CJob::PRIORITY_HIGH; priority >= CJob::PRIORITY_LOW_PAUSABLE; --priority)
+  {
+    // Check whether we're pausing pausable jobs
+    if (priority == CJob::PRIORITY_LOW_PAUSABLE && m_pauseJobs)
+      continue;
+
+    if (AtomicAdd(&m_queued[priority], 0) <= 0)
+      continue;
+
+    // reserve one of the workers allowed for this priority
+    long active = AtomicAdd(&m_active, 0);
+    bool reserved = false;
+    while (active < (long)GetMaxWorkers(CJob::PRIORITY(priority)))
+    {
+      long previous = cas(&m_active, active, active + 1);
+      if (previous == active)
+      {
+        reserved = true;
+        break;
+      }
+      active = previous;
+    }
+    if (!reserved)
+      continue;
+
+    // our own queue first, then steal from the others
+    bool found = TakeJob(slot, slot, priority);
+    for (unsigned int i = 1; !found && i < m_slots.size(); ++i)
+    {
+      CWorkerSlot &victim = *m_slots[(index + i) % m_slots.size()];
+      found = TakeJob(slot, victim, priority);
+    }
+
+    if (found)
+    {
+      // wake up (or start) another worker if there is more work left
+      if (AtomicAdd(&m_queued[priority], 0) > 0)
+        StartWorkers(CJob::PRIORITY(priority));
+      return slot.m_processing.back().m_job;
+    }
+    AtomicDecrement(&m_active);
+  }
+  return NULL;
+}
+
+bool CJobManager::HasQueuedJobs()
+{
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+  {
+    if (AtomicAdd(&m_queued[priority], 0) > 0)
+      return true;
+  }
+  return false;
+}
+
+CJob *CJobManager::GetNextJobLocal(const CJobWorker *worker)
+{
+  while (true)
+  {
+    if (m_running)
+    {
+      // grab a job off the queues if we have one
+      CJob *job = PopJobLocal(worker->GetSlot());
+      if (job)
+        return job;
+
+      // announce that we're idle and check again, so that a job added in between
+      // either shows up here or wakes us up
+      AtomicIncrement(&m_idle);
+      job = PopJobLocal(worker->GetSlot());
+      if (job)
+      {
+        AtomicDecrement(&m_idle);
+        return job;
+      }
+
+      // no jobs are left - sleep for 30 seconds to allow new jobs to come in
+      bool newJob = m_jobEvent.WaitMSec(30000);
+      AtomicDecrement(&m_idle);
+      if (newJob)
+        continue;
+    }
+
+    // no new workers can be started while we hold the lock, so make
+    // sure no jobs have come in before we go away
+    CSingleLock lock(m_section);
+    if (m_running && HasQueuedJobs())
+      continue;
+    RemoveWorker(worker);
+    return NULL;
+  }
+}
+
+CJobManager::CWorkerSlot *CJobManager::FindProcessingSlot(const CJob *job)
+{
+  // usually the job reports from its own worker thread, so check its slot first
+  CJobWorker *worker = dynamic_cast<CJobWorker*>(CThread::GetCurrentThread());
+  if (worker && worker->GetSlot() < m_slots.size())
+  {
+    CWorkerSlot *slot = m_slots[worker->GetSlot()];
+    CSingleLock lock(slot->m_section);
+    if (find(slot->m_processing.begin(), slot->m_processing.end(), job) != slot->m_processing.end())
+      return slot;
+  }
+
+  for (Slots::iterator slot = m_slots.begin(); slot != m_slots.end(); ++slot)
+  {
+    CSingleLock lock((*slot)->m_section);
+    if (find((*slot)->m_processing.begin(), (*slot)->m_processing.end(), job) != (*slot)->m_processing.end())
+      return *slot;
+  }
+  return NULL;
+}
+
+void CJobManager::CancelJobLocal(unsigned int jobID)
+{
+  for (Slots::iterator it = m_slots.begin(); it != m_slots.end(); ++it)
+  {
+    CWorkerSlot *slot = *it;
+    CSingleLock lock(slot->m_section);
+
+    // check whether we have this job in the queue
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_HIGH; ++priority)
+    {
+      JobQueue::iterator i = find(slot->m_jobQueue[priority].begin(), slot->m_jobQueue[priority].end(), jobID);
+      if (i != slot->m_jobQueue[priority].end())
+      {
+        delete i->m_job;
+        slot->m_jobQueue[priority].erase(i);
+        AtomicDecrement(&m_queued[priority]);
+        return;
+      }
+    }
+
+    // or if we're processing it
+    Processing::iterator i = find(slot->m_processing.begin(), slot->m_processing.end(), jobID);
+    if (i != slot->m_processing.end())
+    {
+      i->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
+
+      // wait for tangled callbacks to finish
+      while (slot->m_tangle)
+      {
+        CLog::Log(LOGDEBUG, "CJobManager::CancelJob - waiting for tangled callbacks");
+        slot->m_tangle_cond.wait(slot->m_section);
+      }
+      return;
+    }
+  }
+}
+
+bool CJobManager::OnJobProgressLocal(unsigned int progress, unsigned int total, const CJob *job)
+{
+  CWorkerSlot *slot = FindProcessingSlot(job);
+  if (!slot)
+    return true; // couldn't find the job
+
+  CSingleLock lock(slot->m_section);
+
+  // check whether it's cancelled (no callback)
+  Processing::const_iterator i = find(slot->m_processing.begin(), slot->m_processing.end(), job);
+  if (i != slot->m_processing.end())
+  {
+    CWorkItem item(*i);
+
+    if (item.m_callback)
+    {
+      slot->m_tangle++;
+      lock.Leave(); // leave section prior to call
+      item.m_callback->OnJobProgress(item.m_id, progress, total, job);
+      lock.Enter();
+      slot->m_tangle--;
+      slot->m_tangle_cond.notifyAll();
+      return false;
+    }
+  }
+  return true; // couldn't find the job, or it's been cancelled
+}
+
+void CJobManager::OnJobCompleteLocal(bool success, CJob *job, const CJobWorker *worker)
+{
+  CWorkerSlot &slot = *m_slots[worker->GetSlot()];
+  CSingleLock lock(slot.m_section);
+  // remove the job from the processing queue
+  Processing::iterator i = find(slot.m_processing.begin(), slot.m_processing.end(), job);
+  if (i != slot.m_processing.end())
+  {
+    // tell any listeners we're done with the job, then delete it
+    CWorkItem item(*i);
+
+    slot.m_tangle++;
+    lock.Leave();
+    try
+    {
+      if (item.m_callback)
+        item.m_callback->OnJobComplete(item.m_id, success, item.m_job);
+    }
+    catch (...)
+    {
+      CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, item.m_job->GetType());
+    }
+    lock.Enter();
+    slot.m_tangle--;
+    slot.m_tangle_cond.notifyAll();
+
+    Processing::iterator j = find(slot.m_processing.begin(), slot.m_processing.end(), job);
+    if (j != slot.m_processing.end())
+      slot.m_processing.erase(j);
+    lock.Leave();
+    item.FreeJob();
+  }
+  // release the worker reserved in PopJobLocal()
+  AtomicDecrement(&m_active);
 }
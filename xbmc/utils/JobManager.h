@@ -22,6 +22,7 @@
 #include <queue>
 #include <vector>
 #include <string>
+#include "threads/Condition.h"
 #include "threads/CriticalSection.h"
 #include "threads/Thread.h"
 #include "Job.h"
@@ -31,12 +32,19 @@ class CJobManager;
 class CJobWorker : public CThread
 {
 public:
-  CJobWorker(CJobManager *manager);
+  CJobWorker(CJobManager *manager, unsigned int slot = 0);
   virtual ~CJobWorker();
 
   void Process();
+
+  /*!
+   \brief Index of the local job queue owned by this worker when work stealing is enabled.
+   \sa CJobManager::SetWorkStealing()
+   */
+  unsigned int GetSlot() const { return m_slot; }
 private:
   CJobManager  *m_jobManager;
+  unsigned int  m_slot;
 };
 
 /*!
@@ -165,6 +173,12 @@ private:
  priority levels.  Lower priority jobs are executed only if there are sufficient
  spare worker threads free to allow for higher priority jobs that may arise.
 
+ By default all queued jobs live in a single set of priority queues guarded by one
+ lock.  In work stealing mode (see SetWorkStealing()) each worker instead owns a
+ local set of priority queues.  New jobs are distributed over the local queues and
+ idle workers steal from the queues of busy workers, so that adding, fetching and
+ completing jobs only contends on the lock of a single local queue.
+
  \sa CJob and IJobCallback
  */
 class CJobManager
@@ -202,6 +216,27 @@ class CJobManager
     CJob::PRIORITY m_priority;
   };
 
+  typedef std::deque<CWorkItem>    JobQueue;
+  typedef std::vector<CWorkItem>   Processing;
+
+  /*!
+   \brief Local job queues and processing state of a single worker, used in work stealing mode.
+   Slots outlive the workers attached to them, so jobs queued in a slot whose worker has
+   exited are still picked up by the other workers.
+   */
+  class CWorkerSlot
+  {
+  public:
+    CWorkerSlot() : m_worker(NULL), m_tangle(0) {}
+
+    CCriticalSection m_section;
+    JobQueue         m_jobQueue[CJob::PRIORITY_HIGH+1];
+    Processing       m_processing; ///< the job currently processed by the attached worker, if any
+    CJobWorker      *m_worker;
+    XbmcThreads::ConditionVariable m_tangle_cond;
+    unsigned int     m_tangle;     ///< active callbacks currently running for this slot
+  };
+
 public:
   /*!
    \brief The only way through which the global instance of the CJobManager should be accessed.
@@ -269,6 +304,24 @@ public:
    */
   bool IsProcessing(const CJob::PRIORITY &priority) const;
 
+  /*!
+   \brief Switch between the shared job queue and per worker queues with work stealing
+   May only be called while the manager is cancelled, i.e. after CancelJobs() and before Restart().
+   \param enable true to give each worker its own job queues and let idle workers steal jobs
+   from busy ones, false to use a single shared job queue.
+   \param maxWorkers maximal number of concurrent workers.  0 uses the default of 5 for the shared
+   queue, or the number of CPU cores (but at least 5) in work stealing mode.
+   \throws std::logic_error if the manager is running
+   \sa CancelJobs(), Restart()
+   */
+  void SetWorkStealing(bool enable, unsigned int maxWorkers = 0);
+
+  /*!
+   \brief Whether work stealing mode is enabled
+   \sa SetWorkStealing()
+   */
+  bool IsWorkStealing() const { return !m_slots.empty(); }
+
 protected:
   friend class CJobWorker;
   friend class CJob;
@@ -285,9 +338,10 @@ protected:
    Calls IJobCallback::OnJobComplete(), and then destroys job.
    \param job a pointer to the calling subclassed CJob instance.
    \param success the result from the DoWork call
+   \param worker the worker that processed the job.
    \sa IJobCallback, CJob
    */
-  void  OnJobComplete(bool success, CJob *job);
+  void  OnJobComplete(bool success, CJob *job, const CJobWorker *worker);
 
   /*!
    \brief Callback from CJob to report progress and check for cancellation.
@@ -314,22 +368,47 @@ private:
 
   void StartWorkers(CJob::PRIORITY priority);
   void RemoveWorker(const CJobWorker *worker);
-  static unsigned int GetMaxWorkers(CJob::PRIORITY priority);
+  unsigned int GetMaxWorkers(CJob::PRIORITY priority) const;
 
-  unsigned int m_jobCounter;
+  /*! \name Work stealing mode
+   The counters below are only modified through the atomic helpers, so that the hot paths
+   never need to take m_section.
+   */
+  //@{
+  unsigned int AddJobLocal(const CWorkItem &work);
+  CJob *PopJobLocal(unsigned int index);
+  bool TakeJob(CWorkerSlot &slot, CWorkerSlot &victim, int priority);
+  CWorkerSlot *FindProcessingSlot(const CJob *job);
+  CJob *GetNextJobLocal(const CJobWorker *worker);
+  void CancelJobLocal(unsigned int jobID);
+  bool OnJobProgressLocal(unsigned int progress, unsigned int total, const CJob *job);
+  void OnJobCompleteLocal(bool success, CJob *job, const CJobWorker *worker);
+  bool HasQueuedJobs();
+  void FreeSlots();
+
+  typedef std::vector<CWorkerSlot*> Slots;
+  Slots         m_slots;
+  volatile long m_slotCounter;                       ///< round robin counter to distribute new jobs
+  volatile long m_queued[CJob::PRIORITY_HIGH+1];     ///< jobs waiting in the local queues, per priority
+  volatile long m_active;                            ///< jobs currently processing
+  volatile long m_idle;                              ///< workers waiting for a new job
+  //@}
+
+  unsigned int NextJobId();
+
+  volatile long m_jobCounter;
+  unsigned int  m_maxWorkers;
 
-  typedef std::deque<CWorkItem>    JobQueue;
-  typedef std::vector<CWorkItem>   Processing;
   typedef std::vector<CJobWorker*> Workers;
 
   JobQueue   m_jobQueue[CJob::PRIORITY_HIGH+1];
-  bool       m_pauseJobs;
+  volatile bool m_pauseJobs;
   Processing m_processing;
   Workers    m_workers;
 
   CCriticalSection m_section;
   CEvent           m_jobEvent;
-  bool             m_running;
+  volatile bool    m_running;
 
   XbmcThreads::ConditionVariable m_tangle_cond;
   unsigned int     m_tangle;  /*!< Active callbacks currently running */
@@ -0,0 +1,239 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "Profiler.h"
+#include "threads/Atomics.h"
+#include "threads/SingleLock.h"
+
+// with samples drained every 500ms a ring holds ~2000 samples/s of a thread
+#define PROFILER_RING_SIZE  1024
+#define PROFILER_MAX_RINGS  16
+
+CProfilerHistogram::CProfilerHistogram()
+{
+  Reset();
+}
+
+void CProfilerHistogram::Add(unsigned int duration)
+{
+  m_buckets[GetBucket(duration)]++;
+  if (m_count == 0 || duration < m_min)
+    m_min = duration;
+  if (duration > m_max)
+    m_max = duration;
+  m_count++;
+  m_total += duration;
+}
+
+void CProfilerHistogram::Reset()
+{
+  memset(m_buckets, 0, sizeof(m_buckets));
+  m_count = 0;
+  m_total = 0;
+  m_min = 0;
+  m_max = 0;
+}
+
+unsigned int CProfilerHistogram::GetPercentile(double fraction) const
+{
+  if (m_count == 0)
+    return 0;
+
+  uint64_t rank = (uint64_t)ceil(fraction * m_count);
+  if (rank < 1)
+    rank = 1;
+  else if (rank >= m_count)
+    return m_max;
+
+  uint64_t count = 0;
+  for (unsigned int bucket = 0; bucket < Buckets; bucket++)
+  {
+    count += m_buckets[bucket];
+    if (count >= rank)
+    {
+      unsigned int value = GetBucketMidpoint(bucket);
+      if (value < m_min)
+        return m_min;
+      if (value > m_max)
+        return m_max;
+      return value;
+    }
+  }
+  return m_max;
+}
+
+unsigned int CProfilerHistogram::GetBucket(unsigned int duration)
+{
+  if (duration < SubBuckets)
+    return duration;
+
+  // 8 sub buckets between each power of two
+  unsigned int exponent = 3;
+  while (exponent < 31 && (duration >> (exponent + 1)) != 0)
+    exponent++;
+  unsigned int sub = (duration >> (exponent - 3)) & (SubBuckets - 1);
+  return SubBuckets + (exponent - 3) * SubBuckets + sub;
+}
+
+unsigned int CProfilerHistogram::GetBucketMidpoint(unsigned int bucket)
+{
+  if (bucket < SubBuckets)
+    return bucket;
+
+  unsigned int shift = (bucket - SubBuckets) / SubBuckets;
+  uint64_t lower = (uint64_t)(SubBuckets + (bucket - SubBuckets) % SubBuckets) << shift;
+  return (unsigned int)(lower + (((uint64_t)1 << shift) >> 1));
+}
+
+volatile bool CProfiler::m_enabled = true;
+
+CProfiler& CProfiler::Get()
+{
+  static CProfiler sProfiler;
+  return sProfiler;
+}
+
+CProfiler::CProfiler()
+  : m_threads(0),
+    m_dropped(0)
+{
+  m_ticksPerUs = (double)CurrentHostFrequency() / 1000000.0;
+}
+
+CProfiler::~CProfiler()
+{
+  for (std::vector<SampleRing*>::iterator ring = m_rings.begin(); ring != m_rings.end(); ++ring)
+    delete *ring;
+}
+
+unsigned int CProfiler::RegisterSection(const std::string &name)
+{
+  CSingleLock lock(m_section);
+  std::map<std::string, unsigned int>::const_iterator it = m_sectionIds.find(name);
+  if (it != m_sectionIds.end())
+    return it->second;
+
+  unsigned int id = m_sections.size();
+  m_sections.push_back(Section());
+  m_sections.back().name = name;
+  m_sectionIds.insert(std::make_pair(name, id));
+  return id;
+}
+
+void CProfiler::AddSample(unsigned int section, int64_t ticks)
+{
+  Sample sample;
+  sample.section = section;
+  double duration = ticks > 0 ? ticks / m_ticksPerUs : 0.0;
+  sample.duration = duration < 4294967295.0 ? (unsigned int)duration : 4294967295U;
+
+  if (!GetRing()->Push(sample))
+    AtomicIncrement(&m_dropped);
+}
+
+void CProfiler::Process()
+{
+  CSingleLock lock(m_section);
+  DrainRings();
+}
+
+uint64_t CProfiler::GetStats(std::vector<SectionStats> &stats, bool reset /* = false */)
+{
+  CSingleLock lock(m_section);
+  DrainRings();
+
+  stats.clear();
+  // the map is sorted by name
+  for (std::map<std::string, unsigned int>::const_iterator it = m_sectionIds.begin(); it != m_sectionIds.end(); ++it)
+  {
+    const CProfilerHistogram &histogram = m_sections[it->second].histogram;
+    if (histogram.GetCount() == 0)
+      continue;
+
+    SectionStats section;
+    section.name = it->first;
+    section.count = histogram.GetCount();
+    section.total = histogram.GetTotal();
+    section.min = histogram.GetMin();
+    section.max = histogram.GetMax();
+    section.p50 = histogram.GetPercentile(0.50);
+    section.p95 = histogram.GetPercentile(0.95);
+    section.p99 = histogram.GetPercentile(0.99);
+    stats.push_back(section);
+  }
+
+  if (reset)
+    return ResetSections();
+  return (uint64_t)AtomicAdd(&m_dropped, 0);
+}
+
+void CProfiler::Reset()
+{
+  CSingleLock lock(m_section);
+  DrainRings();
+  ResetSections();
+}
+
+CProfiler::SampleRing* CProfiler::GetRing()
+{
+  SampleRing *ring = m_threadRing.get();
+  if (ring != NULL)
+    return ring;
+
+  CSingleLock lock(m_section);
+  if (m_rings.size() < PROFILER_MAX_RINGS)
+  {
+    ring = new SampleRing(PROFILER_RING_SIZE);
+    m_rings.push_back(ring);
+  }
+  else
+    ring = m_rings[m_threads % PROFILER_MAX_RINGS]; // the rings allow several producers
+  m_threads++;
+
+  m_threadRing.set(ring);
+  return ring;
+}
+
+uint64_t CProfiler::ResetSections()
+{
+  for (std::vector<Section>::iterator section = m_sections.begin(); section != m_sections.end(); ++section)
+    section->histogram.Reset();
+
+  // samples may be dropped concurrently, only take away the ones we've seen
+  long dropped = AtomicAdd(&m_dropped, 0);
+  AtomicAdd(&m_dropped, -dropped);
+  return (uint64_t)dropped;
+}
+
+void CProfiler::DrainRings()
+{
+  Sample sample;
+  for (std::vector<SampleRing*>::iterator ring = m_rings.begin(); ring != m_rings.end(); ++ring)
+  {
+    while ((*ring)->Pop(sample))
+    {
+      if (sample.section < m_sections.size())
+        m_sections[sample.section].histogram.Add(sample.duration);
+    }
+  }
+}
@@ -0,0 +1,193 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "threads/CriticalSection.h"
+#include "threads/MPSCQueue.h"
+#include "threads/ThreadLocal.h"
+#include "utils/TimeUtils.h"
+
+#define PROFILER_CONCAT2(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT2(a, b)
+
+/*!
+ \brief Time the rest of the enclosing scope as the section with the given name
+ The section is registered once per call site, so name has to be constant.
+ */
+#define PROFILE_SCOPE(name) \
+  static const unsigned int PROFILER_CONCAT(profilerSection, __LINE__) = CProfiler::Get().RegisterSection(name); \
+  CProfilerScope PROFILER_CONCAT(profilerScope, __LINE__)(PROFILER_CONCAT(profilerSection, __LINE__))
+
+/*!
+ \brief Histogram of durations in microseconds
+ Durations below 8us are counted exactly, larger ones in 8 buckets per power
+ of two, so percentiles are accurate to about 6% at a fixed size.
+ */
+class CProfilerHistogram
+{
+public:
+  CProfilerHistogram();
+
+  void Add(unsigned int duration);
+  void Reset();
+
+  /*! \brief Get the duration below which the given fraction (0..1) of the samples lie */
+  unsigned int GetPercentile(double fraction) const;
+
+  uint64_t GetCount() const { return m_count; }
+  uint64_t GetTotal() const { return m_total; }
+  unsigned int GetMin() const { return m_count ? m_min : 0; }
+  unsigned int GetMax() const { return m_max; }
+
+private:
+  static const unsigned int SubBuckets = 8;
+  static const unsigned int Buckets = SubBuckets + 29 * SubBuckets; // up to 2^32us
+
+  static unsigned int GetBucket(unsigned int duration);
+  static unsigned int GetBucketMidpoint(unsigned int bucket);
+
+  uint64_t m_buckets[Buckets];
+  uint64_t m_count;
+  uint64_t m_total;
+  unsigned int m_min;
+  unsigned int m_max;
+};
+
+/*!
+ \brief Continuously running profiler of named code sections
+
+ Timed sections (see PROFILE_SCOPE and CProfilerScope) push their durations
+ into a small ring buffer of the calling thread without taking any locks.
+ The rings are drained into a histogram per section from time to time (see
+ Process()) and whenever the statistics are requested, e.g. through the
+ Profiler namespace of JSON-RPC.
+
+ Every thread gets a ring of its own as long as there are free ones, after
+ that threads share them. A sample is dropped (and counted) if its ring is
+ full when it's added.
+ */
+class CProfiler
+{
+public:
+  static CProfiler& Get();
+
+  struct SectionStats
+  {
+    std::string name;
+    uint64_t count;
+    uint64_t total;    ///< total duration in us
+    unsigned int min;  ///< shortest duration in us
+    unsigned int max;  ///< longest duration in us
+    unsigned int p50;
+    unsigned int p95;
+    unsigned int p99;
+  };
+
+  /*!
+   \brief Get the id of the section with the given name, registering it if needed
+   */
+  unsigned int RegisterSection(const std::string &name);
+
+  /*!
+   \brief Add a sample of a section
+   \param section id of the section as returned by RegisterSection().
+   \param ticks duration in CurrentHostCounter() ticks.
+   */
+  void AddSample(unsigned int section, int64_t ticks);
+
+  /*!
+   \brief Move the samples of all threads into the histograms of their sections
+   */
+  void Process();
+
+  /*!
+   \brief Get the statistics of all sections which have samples
+   \param stats the statistics, sorted by section name.
+   \param reset whether to drop the samples afterwards (see Reset()).
+   \return the number of samples dropped since the last reset.
+   */
+  uint64_t GetStats(std::vector<SectionStats> &stats, bool reset = false);
+
+  /*!
+   \brief Drop all samples collected so far, sections stay registered
+   */
+  void Reset();
+
+  static void SetEnabled(bool enabled) { m_enabled = enabled; }
+  static bool IsEnabled() { return m_enabled; }
+
+private:
+  CProfiler();
+  virtual ~CProfiler();
+
+  struct Sample
+  {
+    unsigned int section;
+    unsigned int duration; ///< in us
+  };
+  typedef XbmcThreads::MPSCQueue<Sample> SampleRing;
+
+  struct Section
+  {
+    std::string name;
+    CProfilerHistogram histogram;
+  };
+
+  SampleRing* GetRing();
+  void DrainRings();
+  uint64_t ResetSections();
+
+  static volatile bool m_enabled;
+
+  CCriticalSection m_section;
+  std::vector<Section> m_sections;
+  std::map<std::string, unsigned int> m_sectionIds;
+  std::vector<SampleRing*> m_rings;
+  unsigned int m_threads;           ///< number of threads which got a ring
+  XbmcThreads::ThreadLocal<SampleRing> m_threadRing;
+  volatile long m_dropped;
+  double m_ticksPerUs;
+};
+
+/*!
+ \brief Times its own lifetime as a section of CProfiler
+ */
+class CProfilerScope
+{
+public:
+  explicit CProfilerScope(unsigned int section)
+    : m_section(section),
+      m_start(CProfiler::IsEnabled() ? CurrentHostCounter() : 0)
+  { }
+
+  ~CProfilerScope()
+  {
+    if (m_start != 0)
+      CProfiler::Get().AddSample(m_section, CurrentHostCounter() - m_start);
+  }
+
+private:
+  unsigned int m_section;
+  int64_t m_start;
+};
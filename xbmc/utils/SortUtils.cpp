@@ -18,16 +18,28 @@
  *
  */
 
+#include <algorithm>
+#include <locale>
+#include <math.h>
+
 #include "SortUtils.h"
 #include "URL.h"
 #include "Util.h"
 #include "XBDateTime.h"
 #include "settings/AdvancedSettings.h"
+#include "threads/Thread.h"
 #include "utils/CharsetConverter.h"
+#include "utils/CPUInfo.h"
 #include "utils/StdString.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
+// lists with fewer items are only sorted by the calling thread
+#define PARALLEL_SORT_MIN_ITEMS   8192
+// minimum number of items sorted by every thread of a parallel sort
+#define PARALLEL_SORT_MIN_CHUNK   4096
+#define PARALLEL_SORT_MAX_THREADS 8
+
 using namespace std;
 
 string ArrayToString(SortAttribute attributes, const CVariant &variant, const string &seperator = " / ")
@@ -378,130 +390,380 @@ string ByDateTaken(SortAttribute attributes, const SortItem &values)
   return values.at(FieldDateTaken).asString();
 }
 
-bool preliminarySort(const SortItem &left, const SortItem &right, bool handleFolder, bool &result, std::wstring &labelLeft, std::wstring &labelRight)
+/* The following functions provide the leading numeric value of the sort labels
+   built by the preparators above so that it can be compared natively. The rest
+   of the sort label (everything after the first space) is only compared if the
+   values are equal. */
+
+CVariant ValueBySize(const SortItem &values)
+{
+  return values.at(FieldSize).asInteger();
+}
+
+CVariant ValueByDriveType(const SortItem &values)
+{
+  return (int)values.at(FieldDriveType).asInteger();
+}
+
+CVariant ValueByTrackNumber(const SortItem &values)
+{
+  return (int)values.at(FieldTrackNumber).asInteger();
+}
+
+CVariant ValueByProgramCount(const SortItem &values)
+{
+  return (int)values.at(FieldProgramCount).asInteger();
+}
+
+CVariant ValueByRating(const SortItem &values)
+{
+  return values.at(FieldRating).asFloat();
+}
+
+CVariant ValueByVotes(const SortItem &values)
+{
+  return (int)values.at(FieldVotes).asInteger();
+}
+
+CVariant ValueByTop250(const SortItem &values)
+{
+  return (int)values.at(FieldTop250).asInteger();
+}
+
+CVariant ValueByEpisodeNumber(const SortItem &values)
+{
+  // see ByEpisodeNumber()
+  uint64_t num;
+  const CVariant &episodeSpecial = values.at(FieldEpisodeNumberSpecialSort);
+  const CVariant &seasonSpecial = values.at(FieldSeasonSpecialSort);
+  if (!episodeSpecial.isNull() && !seasonSpecial.isNull() &&
+     (episodeSpecial.asInteger() > 0 || seasonSpecial.asInteger() > 0))
+    num = ((uint64_t)seasonSpecial.asInteger() << 32) + (episodeSpecial.asInteger() << 16) - ((2 << 15) - values.at(FieldEpisodeNumber).asInteger());
+  else
+    num = ((uint64_t)values.at(FieldSeason).asInteger() << 32) + (values.at(FieldEpisodeNumber).asInteger() << 16);
+
+  return num;
+}
+
+CVariant ValueBySeason(const SortItem &values)
+{
+  const CVariant &specialSeason = values.at(FieldSeasonSpecialSort);
+  if (!specialSeason.isNull())
+    return (int)specialSeason.asInteger();
+
+  return (int)values.at(FieldSeason).asInteger();
+}
+
+CVariant ValueByNumberOfEpisodes(const SortItem &values)
+{
+  return (int)values.at(FieldNumberOfEpisodes).asInteger();
+}
+
+CVariant ValueByNumberOfWatchedEpisodes(const SortItem &values)
 {
-  // make sure both items have the necessary data to do the sorting
-  SortItem::const_iterator itLeftSort, itRightSort;
-  if ((itLeftSort = left.find(FieldSort)) == left.end())
+  return (int)values.at(FieldNumberOfWatchedEpisodes).asInteger();
+}
+
+CVariant ValueByVideoResolution(const SortItem &values)
+{
+  return (int)values.at(FieldVideoResolution).asInteger();
+}
+
+CVariant ValueByVideoAspectRatio(const SortItem &values)
+{
+  // ByVideoAspectRatio() only uses three decimals
+  return floor(values.at(FieldVideoAspectRatio).asFloat() * 1000.0 + 0.5) / 1000.0;
+}
+
+CVariant ValueByAudioChannels(const SortItem &values)
+{
+  return (int)values.at(FieldAudioChannels).asInteger();
+}
+
+CVariant ValueByPlaycount(const SortItem &values)
+{
+  return (int)values.at(FieldPlaycount).asInteger();
+}
+
+CVariant ValueByListeners(const SortItem &values)
+{
+  return values.at(FieldListeners).asInteger();
+}
+
+CVariant ValueByBitrate(const SortItem &values)
+{
+  return values.at(FieldBitrate).asInteger();
+}
+
+CVariant ValueByChannelNumber(const SortItem &values)
+{
+  return (int)values.at(FieldChannelNumber).asInteger();
+}
+
+/*! \brief Everything needed to compare an item with other items of the same list.
+ Built once per item before sorting so that comparing two items neither has to
+ look up any fields nor convert or copy any strings.
+ */
+typedef struct SortKey
+{
+  size_t position;        // position of the item in the list being sorted
+  SortSpecial special;
+  int folder;             // -1 if the item doesn't say whether it's a folder
+  CVariant::VariantType valueType;
+  union
+  {
+    int64_t integer;
+    uint64_t unsignedinteger;
+    double dvalue;
+  } value;
+  std::wstring label;     // sort label (following the value) with A-Z lowercased
+} SortKey;
+
+typedef std::vector<SortKey*> SortKeys;
+
+void prepareSortKey(SortKey &key, size_t position, const SortItem &item, const std::wstring &sortLabel, SortUtils::SortValuePreparator valuePreparator)
+{
+  key.position = position;
+
+  key.special = SortSpecialNone;
+  SortItem::const_iterator it = item.find(FieldSortSpecial);
+  if (it != item.end() && it->second.asInteger() <= (int64_t)SortSpecialOnBottom)
+    key.special = (SortSpecial)it->second.asInteger();
+
+  key.folder = -1;
+  it = item.find(FieldFolder);
+  if (it != item.end())
+    key.folder = it->second.asBoolean() ? 1 : 0;
+
+  key.valueType = CVariant::VariantTypeNull;
+  size_t labelStart = 0;
+  if (valuePreparator != NULL)
   {
-    result = false;
-    return true;
+    CVariant value = valuePreparator(item);
+    key.valueType = value.type();
+    if (value.isDouble())
+      key.value.dvalue = value.asDouble();
+    else if (value.isUnsignedInteger())
+      key.value.unsignedinteger = value.asUnsignedInteger();
+    else
+      key.value.integer = value.asInteger();
+
+    labelStart = sortLabel.find(L' ');
+    if (labelStart == std::wstring::npos)
+      labelStart = sortLabel.size();
   }
-  if ((itRightSort = right.find(FieldSort)) == right.end())
+
+  // StringUtils::AlphaNumericCompare() ignores the case of A-Z
+  key.label.assign(sortLabel, labelStart, std::wstring::npos);
+  for (std::wstring::iterator c = key.label.begin(); c != key.label.end(); ++c)
   {
-    result = true;
-    return true;
+    if (*c >= L'A' && *c <= L'Z')
+      *c += L'a' - L'A';
   }
+}
 
-  // look at special sorting behaviour
-  SortItem::const_iterator itLeft, itRight;
-  SortSpecial leftSortSpecial = SortSpecialNone;
-  SortSpecial rightSortSpecial = SortSpecialNone;
-  if ((itLeft = left.find(FieldSortSpecial)) != left.end() && itLeft->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    leftSortSpecial = (SortSpecial)itLeft->second.asInteger();
-  if ((itRight = right.find(FieldSortSpecial)) != right.end() && itRight->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    rightSortSpecial = (SortSpecial)itRight->second.asInteger();
-  
-  // one has a special sort
-  if (leftSortSpecial != rightSortSpecial)
+/*! \brief Same as StringUtils::AlphaNumericCompare() for labels which have
+ already been lowercased by prepareSortKey(). If coll is NULL the characters
+ are compared by their value (as the classic locale does).
+ */
+int64_t compareSortLabels(const wchar_t *l, const wchar_t *r, const collate<wchar_t> *coll)
+{
+  while (*l != 0 && *r != 0)
   {
-    // left should be sorted on top
-    // or right should be sorted on bottom
-    // => left is sorted above right
-    if (leftSortSpecial == SortSpecialOnTop ||
-        rightSortSpecial == SortSpecialOnBottom)
+    // check if we have a numerical value
+    if (*l >= L'0' && *l <= L'9' && *r >= L'0' && *r <= L'9')
     {
-      result = true;
-      return true;
+      const wchar_t *ld = l;
+      int64_t lnum = 0;
+      while (*ld >= L'0' && *ld <= L'9' && ld < l + 15)
+      { // compare only up to 15 digits
+        lnum *= 10;
+        lnum += *ld++ - L'0';
+      }
+      const wchar_t *rd = r;
+      int64_t rnum = 0;
+      while (*rd >= L'0' && *rd <= L'9' && rd < r + 15)
+      { // compare only up to 15 digits
+        rnum *= 10;
+        rnum += *rd++ - L'0';
+      }
+      if (lnum != rnum)
+        return lnum - rnum;
+
+      l = ld;
+      r = rd;
+      continue;
     }
-    
-    // otherwise right is sorted above left
-    result = false;
-    return true;
+
+    if (*l != *r)
+    {
+      if (coll == NULL)
+        return *l < *r ? -1 : 1;
+
+      int result = coll->compare(l, l + 1, r, r + 1);
+      if (result != 0)
+        return result;
+    }
+    l++; r++;
   }
-  // both have either sort on top or sort on bottom -> leave as-is
-  else if (leftSortSpecial != SortSpecialNone && leftSortSpecial == rightSortSpecial)
+
+  if (*r)
+    return -1;
+  if (*l)
+    return 1;
+  return 0;
+}
+
+class SortKeyLess
+{
+public:
+  SortKeyLess(SortOrder sortOrder, SortAttribute attributes)
+    : m_descending(sortOrder == SortOrderDescending),
+      m_handleFolders((attributes & SortAttributeIgnoreFolders) == 0),
+      m_collate(NULL)
   {
-    result = false;
-    return true;
+    if (!(m_locale == locale::classic()))
+      m_collate = &use_facet< collate<wchar_t> >(m_locale);
   }
 
-  if (handleFolder)
+  bool operator()(const SortKey *left, const SortKey *right) const
   {
-    itLeft = left.find(FieldFolder);
-    itRight = right.find(FieldFolder);
-    if (itLeft != left.end() && itRight != right.end() &&
-        itLeft->second.asBoolean() != itRight->second.asBoolean())
+    // one has a special sort
+    if (left->special != right->special)
     {
-      result = itLeft->second.asBoolean();
-      return true;
+      // left should be sorted on top
+      // or right should be sorted on bottom
+      // => left is sorted above right
+      return left->special == SortSpecialOnTop || right->special == SortSpecialOnBottom;
     }
+    // both have either sort on top or sort on bottom -> leave as-is
+    else if (left->special != SortSpecialNone)
+      return false;
+
+    if (m_handleFolders && left->folder >= 0 && right->folder >= 0 && left->folder != right->folder)
+      return left->folder == 1;
+
+    int64_t result = compareValues(*left, *right);
+    if (result == 0)
+      result = compareSortLabels(left->label.c_str(), right->label.c_str(), m_collate);
+
+    return m_descending ? result > 0 : result < 0;
   }
 
-  labelLeft = itLeftSort->second.asWideString();
-  labelRight = itRightSort->second.asWideString();
+private:
+  static int64_t compareValues(const SortKey &left, const SortKey &right)
+  {
+    switch (left.valueType)
+    {
+      case CVariant::VariantTypeInteger:
+        return left.value.integer < right.value.integer ? -1 : (left.value.integer > right.value.integer ? 1 : 0);
 
-  return false;
-}
+      case CVariant::VariantTypeUnsignedInteger:
+        return left.value.unsignedinteger < right.value.unsignedinteger ? -1 : (left.value.unsignedinteger > right.value.unsignedinteger ? 1 : 0);
 
-bool SorterAscending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
+      case CVariant::VariantTypeDouble:
+        return left.value.dvalue < right.value.dvalue ? -1 : (left.value.dvalue > right.value.dvalue ? 1 : 0);
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
+      default:
+        return 0;
+    }
+  }
 
-bool SorterDescending(const SortItem &left, const SortItem &right)
+  bool m_descending;
+  bool m_handleFolders;
+  locale m_locale; // keeps the facet m_collate points to alive
+  const collate<wchar_t> *m_collate;
+};
+
+/*! \brief Sorts or merges a part of the keys of a parallel sort */
+class CSortKeysRunnable : public IRunnable
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
+public:
+  CSortKeysRunnable(const SortKeyLess &less, SortKeys::iterator begin, SortKeys::iterator middle, SortKeys::iterator end)
+    : m_less(less), m_begin(begin), m_middle(middle), m_end(end)
+  { }
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
-}
+  virtual void Run()
+  {
+    // sort a chunk or merge two neighbouring chunks sorted before
+    if (m_middle == m_end)
+      std::stable_sort(m_begin, m_end, m_less);
+    else
+      std::inplace_merge(m_begin, m_middle, m_end, m_less);
+  }
+
+private:
+  SortKeyLess m_less;
+  SortKeys::iterator m_begin;
+  SortKeys::iterator m_middle;
+  SortKeys::iterator m_end;
+};
 
-bool SorterIgnoreFoldersAscending(const SortItem &left, const SortItem &right)
+void runSortKeysRunnables(std::vector<CSortKeysRunnable> &runnables)
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
+  // the calling thread takes care of the first runnable itself
+  std::vector<CThread*> threads;
+  for (size_t i = 1; i < runnables.size(); i++)
+  {
+    CThread *thread = new CThread(&runnables[i], "SortUtils");
+    thread->Create();
+    threads.push_back(thread);
+  }
+
+  runnables[0].Run();
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
+  for (std::vector<CThread*>::iterator thread = threads.begin(); thread != threads.end(); ++thread)
+  {
+    (*thread)->StopThread(true);
+    delete *thread;
+  }
 }
 
-bool SorterIgnoreFoldersDescending(const SortItem &left, const SortItem &right)
+/*! \brief Stable sort which splits large lists into chunks which are sorted
+ by separate threads and merged afterwards (again in parallel as long as there
+ are several pairs of chunks to be merged).
+ */
+void stableSortKeys(SortKeys &keys, const SortKeyLess &less)
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
+  size_t chunks = 1;
+  if (keys.size() >= PARALLEL_SORT_MIN_ITEMS)
+    chunks = std::min(std::min((size_t)std::max(g_cpuInfo.getCPUCount(), 1), (size_t)PARALLEL_SORT_MAX_THREADS),
+                      keys.size() / PARALLEL_SORT_MIN_CHUNK);
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
-}
+  if (chunks < 2)
+  {
+    std::stable_sort(keys.begin(), keys.end(), less);
+    return;
+  }
 
-bool SorterIndirectAscending(const SortItemPtr &left, const SortItemPtr &right)
-{
-  return SorterAscending(*left, *right);
-}
+  std::vector<SortKeys::iterator> bounds;
+  for (size_t chunk = 0; chunk < chunks; chunk++)
+    bounds.push_back(keys.begin() + chunk * keys.size() / chunks);
+  bounds.push_back(keys.end());
 
-bool SorterIndirectDescending(const SortItemPtr &left, const SortItemPtr &right)
-{
-  return SorterDescending(*left, *right);
-}
+  std::vector<CSortKeysRunnable> runnables;
+  for (size_t chunk = 0; chunk < chunks; chunk++)
+    runnables.push_back(CSortKeysRunnable(less, bounds[chunk], bounds[chunk + 1], bounds[chunk + 1]));
+  runSortKeysRunnables(runnables);
 
-bool SorterIndirectIgnoreFoldersAscending(const SortItemPtr &left, const SortItemPtr &right)
-{
-  return SorterIgnoreFoldersAscending(*left, *right);
-}
+  // merge neighbouring chunks until only one is left
+  while (bounds.size() > 2)
+  {
+    std::vector<SortKeys::iterator> merged;
+    runnables.clear();
+    for (size_t chunk = 0; chunk + 2 < bounds.size(); chunk += 2)
+    {
+      runnables.push_back(CSortKeysRunnable(less, bounds[chunk], bounds[chunk + 1], bounds[chunk + 2]));
+      merged.push_back(bounds[chunk]);
+    }
+    // an odd chunk out is merged in the next round
+    if (bounds.size() % 2 == 0)
+      merged.push_back(bounds[bounds.size() - 2]);
+    merged.push_back(keys.end());
 
-bool SorterIndirectIgnoreFoldersDescending(const SortItemPtr &left, const SortItemPtr &right)
-{
-  return SorterIgnoreFoldersDescending(*left, *right);
+    runSortKeysRunnables(runnables);
+    bounds.swap(merged);
+  }
 }
 
 map<SortBy, SortUtils::SortPreparator> fillPreparators()
@@ -559,6 +821,33 @@ map<SortBy, SortUtils::SortPreparator> fillPreparators()
   return preparators;
 }
 
+map<SortBy, SortUtils::SortValuePreparator> fillValuePreparators()
+{
+  map<SortBy, SortUtils::SortValuePreparator> preparators;
+
+  preparators[SortBySize]                     = ValueBySize;
+  preparators[SortByDriveType]                = ValueByDriveType;
+  preparators[SortByTrackNumber]              = ValueByTrackNumber;
+  preparators[SortByRating]                   = ValueByRating;
+  preparators[SortByVotes]                    = ValueByVotes;
+  preparators[SortByTop250]                   = ValueByTop250;
+  preparators[SortByProgramCount]             = ValueByProgramCount;
+  preparators[SortByPlaylistOrder]            = ValueByProgramCount;
+  preparators[SortByEpisodeNumber]            = ValueByEpisodeNumber;
+  preparators[SortBySeason]                   = ValueBySeason;
+  preparators[SortByNumberOfEpisodes]         = ValueByNumberOfEpisodes;
+  preparators[SortByNumberOfWatchedEpisodes]  = ValueByNumberOfWatchedEpisodes;
+  preparators[SortByVideoResolution]          = ValueByVideoResolution;
+  preparators[SortByVideoAspectRatio]         = ValueByVideoAspectRatio;
+  preparators[SortByAudioChannels]            = ValueByAudioChannels;
+  preparators[SortByPlaycount]                = ValueByPlaycount;
+  preparators[SortByListeners]                = ValueByListeners;
+  preparators[SortByBitrate]                  = ValueByBitrate;
+  preparators[SortByChannelNumber]            = ValueByChannelNumber;
+
+  return preparators;
+}
+
 map<SortBy, Fields> fillSortingFields()
 {
   map<SortBy, Fields> sortingFields;
@@ -634,36 +923,24 @@ map<SortBy, Fields> fillSortingFields()
 }
 
 map<SortBy, SortUtils::SortPreparator> SortUtils::m_preparators = fillPreparators();
+map<SortBy, SortUtils::SortValuePreparator> SortUtils::m_valuePreparators = fillValuePreparators();
 map<SortBy, Fields> SortUtils::m_sortingFields = fillSortingFields();
 
 void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, DatabaseResults& items, int limitEnd /* = -1 */, int limitStart /* = 0 */)
 {
-  if (sortBy != SortByNone)
-  {
-    // get the matching SortPreparator
-    SortPreparator preparator = getPreparator(sortBy);
-    if (preparator != NULL)
-    {
-      Fields sortingFields = GetFieldsForSorting(sortBy);
-
-      // Prepare the string used for sorting and store it under FieldSort
-      for (DatabaseResults::iterator item = items.begin(); item != items.end(); ++item)
-      {
-        // add all fields to the item that are required for sorting if they are currently missing
-        for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
-        {
-          if (item->find(*field) == item->end())
-            item->insert(pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
-        }
-
-        CStdStringW sortLabel;
-        g_charsetConverter.utf8ToW(preparator(attributes, *item), sortLabel, false);
-        item->insert(pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
-      }
+  vector<SortItem*> sortItems;
+  sortItems.reserve(items.size());
+  for (DatabaseResults::iterator item = items.begin(); item != items.end(); ++item)
+    sortItems.push_back(&*item);
 
-      // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorter(sortOrder, attributes));
-    }
+  vector<size_t> positions;
+  if (sortPositions(sortBy, sortOrder, attributes, sortItems, positions))
+  {
+    // move the items into their new order
+    DatabaseResults sorted(items.size());
+    for (size_t i = 0; i < positions.size(); i++)
+      sorted[i].swap(items[positions[i]]);
+    items.swap(sorted);
   }
 
   if (limitStart > 0 && (size_t)limitStart < items.size())
@@ -677,32 +954,19 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
 
 void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, SortItems& items, int limitEnd /* = -1 */, int limitStart /* = 0 */)
 {
-  if (sortBy != SortByNone)
-  {
-    // get the matching SortPreparator
-    SortPreparator preparator = getPreparator(sortBy);
-    if (preparator != NULL)
-    {
-      Fields sortingFields = GetFieldsForSorting(sortBy);
-
-      // Prepare the string used for sorting and store it under FieldSort
-      for (SortItems::iterator item = items.begin(); item != items.end(); ++item)
-      {
-        // add all fields to the item that are required for sorting if they are currently missing
-        for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
-        {
-          if ((*item)->find(*field) == (*item)->end())
-            (*item)->insert(pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
-        }
-
-        CStdStringW sortLabel;
-        g_charsetConverter.utf8ToW(preparator(attributes, **item), sortLabel, false);
-        (*item)->insert(pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
-      }
+  vector<SortItem*> sortItems;
+  sortItems.reserve(items.size());
+  for (SortItems::iterator item = items.begin(); item != items.end(); ++item)
+    sortItems.push_back(item->get());
 
-      // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorterIndirect(sortOrder, attributes));
-    }
+  vector<size_t> positions;
+  if (sortPositions(sortBy, sortOrder, attributes, sortItems, positions))
+  {
+    // move the items into their new order
+    SortItems sorted(items.size());
+    for (size_t i = 0; i < positions.size(); i++)
+      sorted[i].swap(items[positions[i]]);
+    items.swap(sorted);
   }
 
   if (limitStart > 0 && (size_t)limitStart < items.size())
@@ -754,20 +1018,59 @@ const SortUtils::SortPreparator& SortUtils::getPreparator(SortBy sortBy)
   return m_preparators[SortByNone];
 }
 
-SortUtils::Sorter SortUtils::getSorter(SortOrder sortOrder, SortAttribute attributes)
+SortUtils::SortValuePreparator SortUtils::getValuePreparator(SortBy sortBy)
 {
-  if (attributes & SortAttributeIgnoreFolders)
-    return sortOrder == SortOrderDescending ? SorterIgnoreFoldersDescending : SorterIgnoreFoldersAscending;
+  map<SortBy, SortValuePreparator>::const_iterator it = m_valuePreparators.find(sortBy);
+  if (it != m_valuePreparators.end())
+    return it->second;
 
-  return sortOrder == SortOrderDescending ? SorterDescending : SorterAscending;
+  return NULL;
 }
 
-SortUtils::SorterIndirect SortUtils::getSorterIndirect(SortOrder sortOrder, SortAttribute attributes)
+bool SortUtils::sortPositions(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, const vector<SortItem*> &items, vector<size_t> &positions)
 {
-  if (attributes & SortAttributeIgnoreFolders)
-    return sortOrder == SortOrderDescending ? SorterIndirectIgnoreFoldersDescending : SorterIndirectIgnoreFoldersAscending;
+  if (sortBy == SortByNone)
+    return false;
+
+  // get the matching SortPreparator
+  SortPreparator preparator = getPreparator(sortBy);
+  if (preparator == NULL)
+    return false;
+
+  SortValuePreparator valuePreparator = getValuePreparator(sortBy);
+  const Fields &sortingFields = GetFieldsForSorting(sortBy);
+
+  // Prepare the string used for sorting (stored under FieldSort) and the key
+  // used to compare the item with the others
+  vector<SortKey> keys(items.size());
+  SortKeys sortKeys(items.size());
+  for (size_t i = 0; i < items.size(); i++)
+  {
+    SortItem &item = *items[i];
+
+    // add all fields to the item that are required for sorting if they are currently missing
+    for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); ++field)
+    {
+      if (item.find(*field) == item.end())
+        item.insert(pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
+    }
+
+    CStdStringW sortLabel;
+    g_charsetConverter.utf8ToW(preparator(attributes, item), sortLabel, false);
+    item[FieldSort] = CVariant(sortLabel);
 
-  return sortOrder == SortOrderDescending ? SorterIndirectDescending : SorterIndirectAscending;
+    prepareSortKey(keys[i], i, item, sortLabel, valuePreparator);
+    sortKeys[i] = &keys[i];
+  }
+
+  // Do the sorting
+  stableSortKeys(sortKeys, SortKeyLess(sortOrder, attributes));
+
+  positions.resize(sortKeys.size());
+  for (size_t i = 0; i < sortKeys.size(); i++)
+    positions[i] = sortKeys[i]->position;
+
+  return true;
 }
 
 const Fields& SortUtils::GetFieldsForSorting(SortBy sortBy)
@@ -141,14 +141,17 @@ public:
   static std::string RemoveArticles(const std::string &label);
   
   typedef std::string (*SortPreparator) (SortAttribute, const SortItem&);
-  typedef bool (*Sorter) (const DatabaseResult &, const DatabaseResult &);
-  typedef bool (*SorterIndirect) (const SortItemPtr &, const SortItemPtr &);
+  /*! \brief Provides the value at the start of the string built by a SortPreparator
+   (e.g. the size or the rating) as an integer or double to be compared natively.
+   */
+  typedef CVariant (*SortValuePreparator) (const SortItem&);
   
 private:
   static const SortPreparator& getPreparator(SortBy sortBy);
-  static Sorter getSorter(SortOrder sortOrder, SortAttribute attributes);
-  static SorterIndirect getSorterIndirect(SortOrder sortOrder, SortAttribute attributes);
+  static SortValuePreparator getValuePreparator(SortBy sortBy);
+  static bool sortPositions(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, const std::vector<SortItem*> &items, std::vector<size_t> &positions);
 
   static std::map<SortBy, SortPreparator> m_preparators;
+  static std::map<SortBy, SortValuePreparator> m_valuePreparators;
   static std::map<SortBy, Fields> m_sortingFields;
 };
@@ -20,6 +20,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 #include <sstream>
 
 #include "Variant.h"
@@ -128,11 +129,68 @@ double str2double(const wstring &str, double fallback /* = 0.0 */)
   return fallback;
 }
 
+namespace
+{
+  typedef pair<string, CVariant> MemberEntry;
+
+  struct MemberKeyLess
+  {
+    bool operator()(const MemberEntry &lhs, const string &rhs) const { return lhs.first < rhs; }
+    bool operator()(const string &lhs, const MemberEntry &rhs) const { return lhs < rhs.first; }
+    bool operator()(const MemberEntry &lhs, const MemberEntry &rhs) const { return lhs.first < rhs.first; }
+  };
+
+  inline void swapElement(CVariant &lhs, CVariant &rhs)
+  {
+    lhs.swap(rhs);
+  }
+
+  inline void swapElement(MemberEntry &lhs, MemberEntry &rhs)
+  {
+    lhs.first.swap(rhs.first);
+    lhs.second.swap(rhs.second);
+  }
+
+  // std::vector copies its elements when it grows or shifts them around,
+  // which for variants means a deep copy of every nested array and object.
+  // The helpers below relocate elements by swapping them instead.
+  template<class T> void growContainer(vector<T> &container)
+  {
+    if (container.size() < container.capacity())
+      return;
+
+    vector<T> grown;
+    grown.reserve(container.empty() ? 4 : container.size() * 2);
+    grown.resize(container.size());
+    for (size_t i = 0; i < container.size(); i++)
+      swapElement(grown[i], container[i]);
+    container.swap(grown);
+  }
+
+  template<class T> T &insertElement(vector<T> &container, size_t position)
+  {
+    growContainer(container);
+    container.push_back(T());
+    for (size_t i = container.size() - 1; i > position; i--)
+      swapElement(container[i], container[i - 1]);
+
+    return container[position];
+  }
+
+  template<class T> void eraseElement(vector<T> &container, size_t position)
+  {
+    for (size_t i = position + 1; i < container.size(); i++)
+      swapElement(container[i - 1], container[i]);
+    container.pop_back();
+  }
+}
+
 CVariant CVariant::ConstNullVariant = CVariant::VariantTypeConstNull;
 
 CVariant::CVariant(VariantType type)
 {
   m_type = type;
+  m_isShortString = false;
 
   switch (type)
   {
@@ -149,7 +207,7 @@ CVariant::CVariant(VariantType type)
       m_data.dvalue = 0.0;
       break;
     case VariantTypeString:
-      m_data.string = new string();
+      setString("", 0);
       break;
     case VariantTypeWideString:
       m_data.wstring = new wstring();
@@ -169,84 +227,92 @@ CVariant::CVariant(VariantType type)
 CVariant::CVariant(int integer)
 {
   m_type = VariantTypeInteger;
+  m_isShortString = false;
   m_data.integer = integer;
 }
 
 CVariant::CVariant(int64_t integer)
 {
   m_type = VariantTypeInteger;
+  m_isShortString = false;
   m_data.integer = integer;
 }
 
 CVariant::CVariant(unsigned int unsignedinteger)
 {
   m_type = VariantTypeUnsignedInteger;
+  m_isShortString = false;
   m_data.unsignedinteger = unsignedinteger;
 }
 
 CVariant::CVariant(uint64_t unsignedinteger)
 {
   m_type = VariantTypeUnsignedInteger;
+  m_isShortString = false;
   m_data.unsignedinteger = unsignedinteger;
 }
 
 CVariant::CVariant(double value)
 {
   m_type = VariantTypeDouble;
+  m_isShortString = false;
   m_data.dvalue = value;
 }
 
 CVariant::CVariant(float value)
 {
   m_type = VariantTypeDouble;
+  m_isShortString = false;
   m_data.dvalue = (double)value;
 }
 
 CVariant::CVariant(bool boolean)
 {
   m_type = VariantTypeBoolean;
+  m_isShortString = false;
   m_data.boolean = boolean;
 }
 
 CVariant::CVariant(const char *str)
 {
-  m_type = VariantTypeString;
-  m_data.string = new string(str);
+  setString(str, strlen(str));
 }
 
 CVariant::CVariant(const char *str, unsigned int length)
 {
-  m_type = VariantTypeString;
-  m_data.string = new string(str, length);
+  setString(str, length);
 }
 
 CVariant::CVariant(const string &str)
 {
-  m_type = VariantTypeString;
-  m_data.string = new string(str);
+  setString(str.c_str(), str.size());
 }
 
 CVariant::CVariant(const wchar_t *str)
 {
   m_type = VariantTypeWideString;
+  m_isShortString = false;
   m_data.wstring = new wstring(str);
 }
 
 CVariant::CVariant(const wchar_t *str, unsigned int length)
 {
   m_type = VariantTypeWideString;
+  m_isShortString = false;
   m_data.wstring = new wstring(str, length);
 }
 
 CVariant::CVariant(const wstring &str)
 {
   m_type = VariantTypeWideString;
+  m_isShortString = false;
   m_data.wstring = new wstring(str);
 }
 
 CVariant::CVariant(const std::vector<std::string> &strArray)
 {
   m_type = VariantTypeArray;
+  m_isShortString = false;
   m_data.array = new VariantArray;
   m_data.array->reserve(strArray.size());
   for (unsigned int index = 0; index < strArray.size(); index++)
@@ -256,20 +322,21 @@ CVariant::CVariant(const std::vector<std::string> &strArray)
 CVariant::CVariant(const std::map<std::string, std::string> &strMap)
 {
   m_type = VariantTypeObject;
-  m_data.map = new VariantMap;
-  for (std::map<std::string, std::string>::const_iterator it = strMap.begin(); it != strMap.end(); ++it)
-    m_data.map->insert(make_pair(it->first, CVariant(it->second)));
+  m_isShortString = false;
+  m_data.map = new VariantMap(strMap.begin(), strMap.end());
 }
 
 CVariant::CVariant(const std::map<std::string, CVariant> &variantMap)
 {
   m_type = VariantTypeObject;
+  m_isShortString = false;
   m_data.map = new VariantMap(variantMap.begin(), variantMap.end());
 }
 
 CVariant::CVariant(const CVariant &variant)
 {
   m_type = VariantTypeNull;
+  m_isShortString = false;
   *this = variant;
 }
 
@@ -280,7 +347,7 @@ CVariant::~CVariant()
 
 void CVariant::cleanup()
 {
-  if (m_type == VariantTypeString)
+  if (m_type == VariantTypeString && !m_isShortString)
     delete m_data.string;
   else if (m_type == VariantTypeWideString)
     delete m_data.wstring;
@@ -289,6 +356,52 @@ void CVariant::cleanup()
   else if (m_type == VariantTypeObject)
     delete m_data.map;
   m_type = VariantTypeNull;
+  m_isShortString = false;
+}
+
+void CVariant::setString(const char *str, size_t length)
+{
+  m_type = VariantTypeString;
+  m_isShortString = length <= MaxShortStringLength;
+  if (m_isShortString)
+  {
+    memcpy(m_data.shortString.data, str, length);
+    m_data.shortString.data[length] = '\0';
+    m_data.shortString.length = (unsigned char)length;
+  }
+  else
+    m_data.string = new string(str, length);
+}
+
+const char *CVariant::stringData() const
+{
+  return m_isShortString ? m_data.shortString.data : m_data.string->c_str();
+}
+
+size_t CVariant::stringLength() const
+{
+  return m_isShortString ? m_data.shortString.length : m_data.string->size();
+}
+
+std::string CVariant::stringValue() const
+{
+  return std::string(stringData(), stringLength());
+}
+
+CVariant::VariantMap::iterator CVariant::findMember(const std::string &key)
+{
+  VariantMap::iterator it = lower_bound(m_data.map->begin(), m_data.map->end(), key, MemberKeyLess());
+  if (it != m_data.map->end() && it->first == key)
+    return it;
+  return m_data.map->end();
+}
+
+CVariant::VariantMap::const_iterator CVariant::findMember(const std::string &key) const
+{
+  VariantMap::const_iterator it = lower_bound(m_data.map->begin(), m_data.map->end(), key, MemberKeyLess());
+  if (it != m_data.map->end() && it->first == key)
+    return it;
+  return m_data.map->end();
 }
 
 bool CVariant::isInteger() const
@@ -352,7 +465,7 @@ int64_t CVariant::asInteger(int64_t fallback) const
     case VariantTypeDouble:
       return (int64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2int64(*m_data.string, fallback);
+      return str2int64(stringValue(), fallback);
     case VariantTypeWideString:
       return str2int64(*m_data.wstring, fallback);
     default:
@@ -373,7 +486,7 @@ uint64_t CVariant::asUnsignedInteger(uint64_t fallback) const
     case VariantTypeDouble:
       return (uint64_t)m_data.dvalue;
     case VariantTypeString:
-      return str2uint64(*m_data.string, fallback);
+      return str2uint64(stringValue(), fallback);
     case VariantTypeWideString:
       return str2uint64(*m_data.wstring, fallback);
     default:
@@ -394,7 +507,7 @@ double CVariant::asDouble(double fallback) const
     case VariantTypeUnsignedInteger:
       return (double)m_data.unsignedinteger;
     case VariantTypeString:
-      return str2double(*m_data.string, fallback);
+      return str2double(stringValue(), fallback);
     case VariantTypeWideString:
       return str2double(*m_data.wstring, fallback);
     default:
@@ -415,7 +528,7 @@ float CVariant::asFloat(float fallback) const
     case VariantTypeUnsignedInteger:
       return (float)m_data.unsignedinteger;
     case VariantTypeString:
-      return (float)str2double(*m_data.string, fallback);
+      return (float)str2double(stringValue(), fallback);
     case VariantTypeWideString:
       return (float)str2double(*m_data.wstring, fallback);
     default:
@@ -438,9 +551,13 @@ bool CVariant::asBoolean(bool fallback) const
     case VariantTypeDouble:
       return (m_data.dvalue != 0);
     case VariantTypeString:
-      if (m_data.string->empty() || m_data.string->compare("0") == 0 || m_data.string->compare("false") == 0)
+    {
+      const char *str = stringData();
+      size_t length = stringLength();
+      if (length == 0 || (length == 1 && str[0] == '0') || (length == 5 && memcmp(str, "false", 5) == 0))
         return false;
       return true;
+    }
     case VariantTypeWideString:
       if (m_data.wstring->empty() || m_data.wstring->compare(L"0") == 0 || m_data.wstring->compare(L"false") == 0)
         return false;
@@ -457,7 +574,7 @@ std::string CVariant::asString(const std::string &fallback /* = "" */) const
   switch (m_type)
   {
     case VariantTypeString:
-      return *m_data.string;
+      return stringValue();
     case VariantTypeBoolean:
       return m_data.boolean ? "true" : "false";
     case VariantTypeInteger:
@@ -517,7 +634,15 @@ CVariant &CVariant::operator[](const std::string &key)
   }
 
   if (m_type == VariantTypeObject)
-    return (*m_data.map)[key];
+  {
+    VariantMap::iterator it = lower_bound(m_data.map->begin(), m_data.map->end(), key, MemberKeyLess());
+    if (it != m_data.map->end() && it->first == key)
+      return it->second;
+
+    VariantMapEntry &entry = insertElement(*m_data.map, it - m_data.map->begin());
+    entry.first = key;
+    return entry.second;
+  }
   else
     return ConstNullVariant;
 }
@@ -525,7 +650,7 @@ CVariant &CVariant::operator[](const std::string &key)
 const CVariant &CVariant::operator[](const std::string &key) const
 {
   VariantMap::const_iterator it;
-  if (m_type == VariantTypeObject && (it = m_data.map->find(key)) != m_data.map->end())
+  if (m_type == VariantTypeObject && (it = findMember(key)) != m_data.map->end())
     return it->second;
   else
     return ConstNullVariant;
@@ -571,7 +696,11 @@ CVariant &CVariant::operator=(const CVariant &rhs)
     m_data.dvalue = rhs.m_data.dvalue;
     break;
   case VariantTypeString:
-    m_data.string = new string(*rhs.m_data.string);
+    m_isShortString = rhs.m_isShortString;
+    if (m_isShortString)
+      m_data.shortString = rhs.m_data.shortString;
+    else
+      m_data.string = new string(*rhs.m_data.string);
     break;
   case VariantTypeWideString:
     m_data.wstring = new wstring(*rhs.m_data.wstring);
@@ -604,7 +733,7 @@ bool CVariant::operator==(const CVariant &rhs) const
     case VariantTypeDouble:
       return m_data.dvalue == rhs.m_data.dvalue;
     case VariantTypeString:
-      return *m_data.string == *rhs.m_data.string;
+      return stringLength() == rhs.stringLength() && memcmp(stringData(), rhs.stringData(), stringLength()) == 0;
     case VariantTypeWideString:
       return *m_data.wstring == *rhs.m_data.wstring;
     case VariantTypeArray:
@@ -628,7 +757,19 @@ void CVariant::push_back(const CVariant &variant)
   }
 
   if (m_type == VariantTypeArray)
-    m_data.array->push_back(variant);
+  {
+    VariantArray &array = *m_data.array;
+    // growing relocates the elements, so copy the value first if it is one of them
+    if (array.size() == array.capacity() && !array.empty() && &variant >= &array.front() && &variant <= &array.back())
+    {
+      CVariant copy(variant);
+      push_back(copy);
+      return;
+    }
+
+    growContainer(array);
+    array.push_back(variant);
+  }
 }
 
 void CVariant::append(const CVariant &variant)
@@ -639,7 +780,7 @@ void CVariant::append(const CVariant &variant)
 const char *CVariant::c_str() const
 {
   if (m_type == VariantTypeString)
-    return m_data.string->c_str();
+    return stringData();
   else
     return NULL;
 }
@@ -647,12 +788,15 @@ const char *CVariant::c_str() const
 void CVariant::swap(CVariant &rhs)
 {
   VariantType  temp_type = m_type;
+  bool         temp_short = m_isShortString;
   VariantUnion temp_data = m_data;
 
   m_type = rhs.m_type;
+  m_isShortString = rhs.m_isShortString;
   m_data = rhs.m_data;
 
   rhs.m_type = temp_type;
+  rhs.m_isShortString = temp_short;
   rhs.m_data = temp_data;
 }
 
@@ -727,7 +871,7 @@ unsigned int CVariant::size() const
   else if (m_type == VariantTypeArray)
     return m_data.array->size();
   else if (m_type == VariantTypeString)
-    return m_data.string->size();
+    return stringLength();
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->size();
   else
@@ -741,7 +885,7 @@ bool CVariant::empty() const
   else if (m_type == VariantTypeArray)
     return m_data.array->empty();
   else if (m_type == VariantTypeString)
-    return m_data.string->empty();
+    return stringLength() == 0;
   else if (m_type == VariantTypeWideString)
     return m_data.wstring->empty();
   else if (m_type == VariantTypeNull)
@@ -757,7 +901,10 @@ void CVariant::clear()
   else if (m_type == VariantTypeArray)
     m_data.array->clear();
   else if (m_type == VariantTypeString)
-    m_data.string->clear();
+  {
+    cleanup();
+    setString("", 0);
+  }
   else if (m_type == VariantTypeWideString)
     m_data.wstring->clear();
 }
@@ -770,7 +917,11 @@ void CVariant::erase(const std::string &key)
     m_data.map = new VariantMap;
   }
   else if (m_type == VariantTypeObject)
-    m_data.map->erase(key);
+  {
+    VariantMap::iterator it = findMember(key);
+    if (it != m_data.map->end())
+      eraseElement(*m_data.map, it - m_data.map->begin());
+  }
 }
 
 void CVariant::erase(unsigned int position)
@@ -782,13 +933,13 @@ void CVariant::erase(unsigned int position)
   }
 
   if (m_type == VariantTypeArray && position < size())
-    m_data.array->erase(m_data.array->begin() + position);
+    eraseElement(*m_data.array, position);
 }
 
 bool CVariant::isMember(const std::string &key) const
 {
   if (m_type == VariantTypeObject)
-    return m_data.map->find(key) != m_data.map->end();
+    return findMember(key) != m_data.map->end();
 
   return false;
 }
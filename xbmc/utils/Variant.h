@@ -106,7 +106,12 @@ public:
 
 private:
   typedef std::vector<CVariant> VariantArray;
-  typedef std::map<std::string, CVariant> VariantMap;
+  /* Objects are kept as a vector of key/value pairs sorted by key. This keeps
+     all members in one allocation and iterates in the same order a std::map
+     would, but (like any vector) adding a new key invalidates references and
+     iterators to the other members of the same object. */
+  typedef std::pair<std::string, CVariant> VariantMapEntry;
+  typedef std::vector<VariantMapEntry> VariantMap;
 
 public:
   typedef VariantArray::iterator        iterator_array;
@@ -137,6 +142,15 @@ public:
 
 private:
   void cleanup();
+  void setString(const char *str, size_t length);
+  const char *stringData() const;
+  size_t stringLength() const;
+  std::string stringValue() const;
+  VariantMap::iterator findMember(const std::string &key);
+  VariantMap::const_iterator findMember(const std::string &key) const;
+
+  enum { MaxShortStringLength = 22 };
+
   union VariantUnion
   {
     int64_t integer;
@@ -147,8 +161,14 @@ private:
     std::wstring *wstring;
     VariantArray *array;
     VariantMap *map;
+    struct
+    {
+      char data[MaxShortStringLength + 1];
+      unsigned char length;
+    } shortString;
   };
 
   VariantType m_type;
+  bool m_isShortString; // strings of up to MaxShortStringLength chars are stored in m_data.shortString
   VariantUnion m_data;
 };
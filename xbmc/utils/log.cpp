@@ -20,6 +20,7 @@
 
 #include "log.h"
 #include "system.h"
+#include "threads/Atomics.h"
 #include "threads/SingleLock.h"
 #include "threads/Thread.h"
 #include "utils/StringUtils.h"
@@ -35,19 +36,91 @@ static const char* const logLevelNames[] =
 // s_globals is used as static global with CLog global variables
 #define s_globals XBMC_GLOBAL_USE(CLog).m_globalInstance
 
+// number of lines the asynchronous queue can hold
+#define ASYNC_QUEUE_SIZE  4096
+// maximum number of lines written with a single write
+#define ASYNC_BATCH_SIZE  256
+// time after which the writer flushes lines that didn't trigger an immediate write
+#define ASYNC_FLUSH_MS    100
+
+class CLogWriter : public CThread
+{
+public:
+  CLogWriter() : CThread("LogWriter") {}
+
+protected:
+  virtual void Process()
+  {
+    while (!m_bStop)
+    {
+      AbortableWait(s_globals.m_queueEvent, ASYNC_FLUSH_MS);
+      CLog::FlushQueue();
+    }
+    CLog::FlushQueue();
+  }
+};
+
 CLog::CLog()
 {}
 
 CLog::~CLog()
 {}
 
+CLog::CLogGlobals::~CLogGlobals()
+{
+  if (m_writer)
+  {
+    m_async = false;
+    m_writer->StopThread();
+  }
+  delete m_writer;
+  delete m_queue;
+}
+
 void CLog::Close()
 {
+  SetAsync(false);
+
   CSingleLock waitLock(s_globals.critSec);
   s_globals.m_platform.CloseLogFile();
   s_globals.m_repeatLine.clear();
 }
 
+void CLog::SetAsync(bool async)
+{
+  CSingleLock asyncLock(s_globals.m_asyncSection);
+  if (async == s_globals.m_async)
+    return;
+
+  if (async)
+  {
+    if (!s_globals.m_queue)
+      s_globals.m_queue = new XbmcThreads::MPSCQueue<CLogRecord>(ASYNC_QUEUE_SIZE);
+    s_globals.m_writer = new CLogWriter();
+    s_globals.m_writer->Create();
+    s_globals.m_async = true;
+  }
+  else
+  {
+    // new lines are written directly from here on, the writer
+    // flushes everything that was queued before it exits
+    s_globals.m_async = false;
+    s_globals.m_writer->StopThread();
+    delete s_globals.m_writer;
+    s_globals.m_writer = NULL;
+  }
+}
+
+bool CLog::IsAsync()
+{
+  return s_globals.m_async;
+}
+
+unsigned int CLog::GetDroppedCount()
+{
+  return (unsigned int)AtomicAdd(&s_globals.m_dropped, 0);
+}
+
 void CLog::Log(int loglevel, const char *format, ...)
 {
   if (IsLogLevelLogged(loglevel))
@@ -75,32 +148,113 @@ void CLog::LogFunction(int loglevel, const char* functionName, const char* forma
 
 void CLog::LogString(int logLevel, const std::string& logString)
 {
+  CLogRecord record;
+  record.m_logLevel = logLevel;
+  s_globals.m_platform.GetCurrentLocalTime(record.m_hour, record.m_minute, record.m_second);
+  record.m_threadId = (uint64_t)CThread::GetCurrentThreadId();
+  record.m_line = logString;
+
+  if (s_globals.m_async)
+  {
+    XbmcThreads::MPSCQueue<CLogRecord> *queue = s_globals.m_queue;
+    if (!queue->Push(record))
+      AtomicIncrement(&s_globals.m_dropped);
+    // don't keep errors waiting, and write early before the queue overflows
+    else if (logLevel >= LOGERROR || queue->Size() >= queue->Capacity() / 2)
+      s_globals.m_queueEvent.Set();
+    return;
+  }
+
   CSingleLock waitLock(s_globals.critSec);
-  std::string strData(logString);
-  StringUtils::TrimRight(strData);
-  if (!strData.empty())
+  // lines queued while asynchronous logging was being disabled go first
+  if (s_globals.m_queue && s_globals.m_queue->Size() > 0)
+    FlushQueue();
+
+  std::string output;
+  FormatLogString(record, output);
+  if (!output.empty())
+    s_globals.m_platform.WriteStringToLog(output);
+}
+
+void CLog::FlushQueue()
+{
+  CSingleLock waitLock(s_globals.critSec);
+  if (!s_globals.m_queue)
+    return;
+
+  CLogRecord record;
+  std::string output;
+  bool more = true;
+  while (more)
   {
-    if (s_globals.m_repeatLogLevel == logLevel && s_globals.m_repeatLine == strData)
+    for (unsigned int i = 0; i < ASYNC_BATCH_SIZE && (more = s_globals.m_queue->Pop(record)); ++i)
+      FormatLogString(record, output);
+
+    long dropped = AtomicAdd(&s_globals.m_dropped, 0);
+    if (dropped != s_globals.m_droppedReported)
     {
-      s_globals.m_repeatCount++;
-      return;
+      record.m_logLevel = LOGWARNING;
+      s_globals.m_platform.GetCurrentLocalTime(record.m_hour, record.m_minute, record.m_second);
+      record.m_threadId = (uint64_t)CThread::GetCurrentThreadId();
+      record.m_line = StringUtils::Format("Log queue full, %ld lines dropped.", dropped - s_globals.m_droppedReported);
+      FormatLogString(record, output);
+      s_globals.m_droppedReported = dropped;
     }
-    else if (s_globals.m_repeatCount)
+
+    if (!output.empty())
     {
-      std::string strData2 = StringUtils::Format("Previous line repeats %d times.",
-                                                s_globals.m_repeatCount);
-      PrintDebugString(strData2);
-      WriteLogString(s_globals.m_repeatLogLevel, strData2);
-      s_globals.m_repeatCount = 0;
+      s_globals.m_platform.WriteStringToLog(output);
+      output.clear();
     }
-    
-    s_globals.m_repeatLine = strData;
-    s_globals.m_repeatLogLevel = logLevel;
+  }
+}
+
+void CLog::FormatLogString(const CLogRecord& record, std::string& output)
+{
+  static const char* prefixFormat = "%02.2d:%02.2d:%02.2d T:%" PRIu64" %7s: ";
 
-    PrintDebugString(strData);
+  std::string strData(record.m_line);
+  StringUtils::TrimRight(strData);
+  if (strData.empty())
+    return;
 
-    WriteLogString(logLevel, strData);
+  if (s_globals.m_repeatLogLevel == record.m_logLevel && s_globals.m_repeatLine == strData)
+  {
+    s_globals.m_repeatCount++;
+    return;
   }
+  else if (s_globals.m_repeatCount)
+  {
+    std::string strData2 = StringUtils::Format("Previous line repeats %d times.",
+                                              s_globals.m_repeatCount);
+    PrintDebugString(strData2);
+    if (!output.empty())
+      output += "\n";
+    output += StringUtils::Format(prefixFormat,
+                                  record.m_hour,
+                                  record.m_minute,
+                                  record.m_second,
+                                  record.m_threadId,
+                                  levelNames[s_globals.m_repeatLogLevel]) + strData2;
+    s_globals.m_repeatCount = 0;
+  }
+
+  s_globals.m_repeatLine = strData;
+  s_globals.m_repeatLogLevel = record.m_logLevel;
+
+  PrintDebugString(strData);
+
+  /* fixup newline alignment, number of spaces should equal prefix length */
+  StringUtils::Replace(strData, "\n", "\n                                            ");
+
+  if (!output.empty())
+    output += "\n";
+  output += StringUtils::Format(prefixFormat,
+                                record.m_hour,
+                                record.m_minute,
+                                record.m_second,
+                                record.m_threadId,
+                                levelNames[record.m_logLevel]) + strData;
 }
 
 bool CLog::Init(const std::string& path)
@@ -195,24 +349,3 @@ void CLog::PrintDebugString(const std::string& line)
   s_globals.m_platform.PrintDebugString(line);
 #endif // defined(_DEBUG) || defined(PROFILE)
 }
-
-bool CLog::WriteLogString(int logLevel, const std::string& logString)
-{
-  static const char* prefixFormat = "%02.2d:%02.2d:%02.2d T:%" PRIu64" %7s: ";
-
-  std::string strData(logString);
-  /* fixup newline alignment, number of spaces should equal prefix length */
-  StringUtils::Replace(strData, "\n", "\n                                            ");
-
-  int hour, minute, second;
-  s_globals.m_platform.GetCurrentLocalTime(hour, minute, second);
-  
-  strData = StringUtils::Format(prefixFormat,
-                                  hour,
-                                  minute,
-                                  second,
-                                  (uint64_t)CThread::GetCurrentThreadId(),
-                                  levelNames[logLevel]) + strData;
-
-  return s_globals.m_platform.WriteStringToLog(strData);
-}
@@ -21,6 +21,7 @@
  */
 
 #include <string>
+#include <stdint.h>
 
 #if defined(TARGET_POSIX)
 #include "posix/PosixInterfaceForCLog.h"
@@ -32,10 +33,14 @@ typedef class CWin32InterfaceForCLog PlatformInterfaceForCLog;
 
 #include "commons/ilog.h"
 #include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "threads/MPSCQueue.h"
 #include "utils/GlobalsHandling.h"
 
 #include "utils/params_check_macros.h"
 
+class CLogWriter;
+
 class CLog
 {
 public:
@@ -52,13 +57,41 @@ public:
   static int  GetLogLevel();
   static void SetExtraLogLevels(int level);
   static bool IsLogLevelLogged(int loglevel);
+  /*!
+   \brief Enable or disable asynchronous logging
+   In asynchronous mode log lines are only stamped with time and thread and queued
+   by the calling thread.  A dedicated writer thread writes them to the log file in
+   batches, so logging never blocks on the log lock or on file I/O.  If the queue
+   overflows lines are dropped and the writer logs how many got lost.
+   Disabling asynchronous mode writes out all queued lines before returning.
+   */
+  static void SetAsync(bool async);
+  static bool IsAsync();
+  /*!
+   \brief Number of log lines dropped because the asynchronous queue was full
+   */
+  static unsigned int GetDroppedCount();
 
 protected:
+  friend class CLogWriter;
+
+  class CLogRecord
+  {
+  public:
+    int         m_logLevel;
+    int         m_hour;
+    int         m_minute;
+    int         m_second;
+    uint64_t    m_threadId;
+    std::string m_line;
+  };
+
   class CLogGlobals
   {
   public:
-    CLogGlobals(void) : m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG), m_extraLogLevels(0) {}
-    ~CLogGlobals() {}
+    CLogGlobals(void) : m_repeatCount(0), m_repeatLogLevel(-1), m_logLevel(LOG_LEVEL_DEBUG), m_extraLogLevels(0),
+                        m_async(false), m_dropped(0), m_droppedReported(0), m_queue(NULL), m_writer(NULL) {}
+    ~CLogGlobals();
     PlatformInterfaceForCLog m_platform;
     int         m_repeatCount;
     int         m_repeatLogLevel;
@@ -66,10 +99,19 @@ protected:
     int         m_logLevel;
     int         m_extraLogLevels;
     CCriticalSection critSec;
+
+    volatile bool  m_async;
+    volatile long  m_dropped;
+    long           m_droppedReported;
+    XbmcThreads::MPSCQueue<CLogRecord> *m_queue; // allocated once on first use, producers may still hold it after SetAsync(false)
+    CLogWriter    *m_writer;
+    CEvent         m_queueEvent;
+    CCriticalSection m_asyncSection;             // serializes SetAsync(), must never be taken while holding critSec
   };
   class CLogGlobals m_globalInstance; // used as static global variable
   static void LogString(int logLevel, const std::string& logString);
-  static bool WriteLogString(int logLevel, const std::string& logString);
+  static void FormatLogString(const CLogRecord& record, std::string& output);
+  static void FlushQueue();
 };
 
 
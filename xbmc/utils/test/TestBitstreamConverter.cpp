@@ -0,0 +1,290 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/BitstreamConverter.h"
+#include "utils/TimeUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+typedef std::vector<uint8_t> Unit;
+typedef std::vector<Unit> AccessUnit;
+
+// the type of an access unit delimiter, which every picture starts with
+#define NAL_AUD_TYPE 9
+
+// payload without start code emulation, ending in a non zero byte like rbsp_trailing_bits
+static Unit MakeUnit(uint8_t type, size_t size)
+{
+  Unit unit(1, type);
+  while (unit.size() < size)
+  {
+    uint8_t byte = rand() % 16 ? rand() & 0xff : 0;
+    size_t n = unit.size();
+    if (n >= 2 && unit[n - 1] == 0 && unit[n - 2] == 0 && byte <= 3)
+      unit.push_back(3);
+    unit.push_back(byte);
+  }
+  unit.push_back(0x80);
+  return unit;
+}
+
+static std::vector<AccessUnit> MakeStream(int pictures, size_t idrSize, size_t sliceSize)
+{
+  std::vector<AccessUnit> stream;
+  for (int i = 0; i < pictures; i++)
+  {
+    AccessUnit au;
+    au.push_back(MakeUnit(NAL_AUD_TYPE, 2));
+    if (i % 25 == 0)
+      au.push_back(MakeUnit(6, 20 + rand() % 100));
+    au.push_back(i % 25 ? MakeUnit(1, sliceSize / 2 + rand() % sliceSize) : MakeUnit(5, idrSize / 2 + rand() % idrSize));
+    stream.push_back(au);
+  }
+  return stream;
+}
+
+static Unit ToAnnexB(const AccessUnit &au, int startCodes)
+{
+  Unit packet;
+  for (size_t i = 0; i < au.size(); i++)
+  {
+    // 3 and 4 byte start codes mixed when startCodes is 0
+    if (startCodes == 4 || (startCodes == 0 && rand() % 2))
+      packet.push_back(0);
+    packet.push_back(0);
+    packet.push_back(0);
+    packet.push_back(1);
+    packet.insert(packet.end(), au[i].begin(), au[i].end());
+  }
+  return packet;
+}
+
+static Unit ToBitstream(const AccessUnit &au, int lengthSize)
+{
+  Unit packet;
+  for (size_t i = 0; i < au.size(); i++)
+  {
+    for (int shift = (lengthSize - 1) * 8; shift >= 0; shift -= 8)
+      packet.push_back((uint8_t)(au[i].size() >> shift));
+    packet.insert(packet.end(), au[i].begin(), au[i].end());
+  }
+  return packet;
+}
+
+static AccessUnit ParseAnnexB(const uint8_t *data, int size)
+{
+  AccessUnit au;
+  Unit *unit = NULL;
+  for (int i = 0; i < size; i++)
+  {
+    if (i + 2 < size && data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+    {
+      if (unit)
+      {
+        // a 4 byte start code leaves a zero behind
+        while (!unit->empty() && unit->back() == 0)
+          unit->pop_back();
+      }
+      au.push_back(Unit());
+      unit = &au.back();
+      i += 2;
+    }
+    else if (unit)
+      unit->push_back(data[i]);
+  }
+  return au;
+}
+
+static AccessUnit ParseBitstream(const uint8_t *data, int size)
+{
+  AccessUnit au;
+  for (int i = 0; i + 4 <= size; )
+  {
+    int length = BS_RB32(data + i);
+    i += 4;
+    if (length > size - i)
+      return AccessUnit();
+    au.push_back(Unit(data + i, data + i + length));
+    i += length;
+  }
+  return au;
+}
+
+static Unit MakeAnnexBExtradata(const Unit &sps, const Unit &pps)
+{
+  AccessUnit au;
+  au.push_back(sps);
+  au.push_back(pps);
+  return ToAnnexB(au, 4);
+}
+
+static Unit MakeAvcC(const Unit &sps, const Unit &pps, int lengthSize)
+{
+  Unit avcc;
+  avcc.push_back(1);
+  avcc.push_back(sps[1]);
+  avcc.push_back(sps[2]);
+  avcc.push_back(sps[3]);
+  avcc.push_back(0xfc | (lengthSize - 1));
+  avcc.push_back(0xe1);
+  avcc.push_back(sps.size() >> 8);
+  avcc.push_back(sps.size() & 0xff);
+  avcc.insert(avcc.end(), sps.begin(), sps.end());
+  avcc.push_back(1);
+  avcc.push_back(pps.size() >> 8);
+  avcc.push_back(pps.size() & 0xff);
+  avcc.insert(avcc.end(), pps.begin(), pps.end());
+  return avcc;
+}
+
+TEST(TestBitstreamConverter, AnnexBToBitstream)
+{
+  Unit sps = MakeUnit(7, 12), pps = MakeUnit(8, 4);
+  Unit extradata = MakeAnnexBExtradata(sps, pps);
+  std::vector<AccessUnit> stream = MakeStream(50, 20000, 3000);
+
+  CBitstreamConverter converter;
+  ASSERT_TRUE(converter.Open(AV_CODEC_ID_H264, &extradata[0], extradata.size(), false));
+  EXPECT_FALSE(converter.NeedConvert());
+
+  // 4 byte start codes are converted in place, 3 byte ones in the buffer
+  for (int startCodes = 0; startCodes <= 4; startCodes++)
+  {
+    if (startCodes > 0 && startCodes < 3)
+      continue;
+    for (size_t i = 0; i < stream.size(); i++)
+    {
+      Unit packet = ToAnnexB(stream[i], startCodes);
+      ASSERT_TRUE(converter.Convert(&packet[0], packet.size()));
+      EXPECT_EQ(stream[i], ParseBitstream(converter.GetConvertBuffer(), converter.GetConvertSize())) << "picture " << i;
+    }
+  }
+}
+
+TEST(TestBitstreamConverter, StartCodeOffsets)
+{
+  Unit sps = MakeUnit(7, 12), pps = MakeUnit(8, 4);
+  Unit extradata = MakeAnnexBExtradata(sps, pps);
+  CBitstreamConverter converter;
+  ASSERT_TRUE(converter.Open(AV_CODEC_ID_H264, &extradata[0], extradata.size(), false));
+
+  // start codes at every offset from the start of the scan and up to its end
+  for (size_t size = 1; size < 80; size++)
+  {
+    for (int startCodes = 3; startCodes <= 4; startCodes++)
+    {
+      AccessUnit au;
+      au.push_back(MakeUnit(1, size));
+      au.push_back(MakeUnit(1, 80 - size));
+      au.push_back(MakeUnit(1, 1));
+      Unit packet = ToAnnexB(au, startCodes);
+      ASSERT_TRUE(converter.Convert(&packet[0], packet.size()));
+      EXPECT_EQ(au, ParseBitstream(converter.GetConvertBuffer(), converter.GetConvertSize())) << "size " << size;
+    }
+  }
+}
+
+TEST(TestBitstreamConverter, BitstreamToAnnexB)
+{
+  Unit sps = MakeUnit(7, 12), pps = MakeUnit(8, 4);
+  std::vector<AccessUnit> stream = MakeStream(50, 20000, 3000);
+
+  for (int lengthSize = 2; lengthSize <= 4; lengthSize++)
+  {
+    Unit extradata = MakeAvcC(sps, pps, lengthSize);
+    CBitstreamConverter converter;
+    ASSERT_TRUE(converter.Open(AV_CODEC_ID_H264, &extradata[0], extradata.size(), true));
+    ASSERT_TRUE(converter.NeedConvert());
+
+    for (size_t i = 0; i < stream.size(); i++)
+    {
+      // sps and pps go in front of the IDR slice
+      AccessUnit expected = stream[i];
+      if (i % 25 == 0)
+      {
+        expected.insert(expected.end() - 1, sps);
+        expected.insert(expected.end() - 1, pps);
+      }
+
+      Unit packet = ToBitstream(stream[i], lengthSize);
+      ASSERT_TRUE(converter.Convert(&packet[0], packet.size()));
+      EXPECT_EQ(expected, ParseAnnexB(converter.GetConvertBuffer(), converter.GetConvertSize())) << "picture " << i;
+    }
+
+    Unit broken = ToBitstream(stream[1], lengthSize);
+    broken.resize(broken.size() - 1);
+    EXPECT_FALSE(converter.Convert(&broken[0], broken.size()));
+  }
+}
+
+// prints MB/s, see --gtest_also_run_disabled_tests
+TEST(TestBitstreamConverter, DISABLED_Benchmark)
+{
+  // 10s of 1080p at about 8 Mbit/s
+  std::vector<AccessUnit> stream = MakeStream(250, 150000, 35000);
+  Unit sps = MakeUnit(7, 12), pps = MakeUnit(8, 4);
+  const int rounds = 10;
+
+  Unit annexb, bitstream;
+  std::vector<int> annexbSizes, bitstreamSizes;
+  for (size_t i = 0; i < stream.size(); i++)
+  {
+    Unit packet = ToAnnexB(stream[i], 4);
+    annexb.insert(annexb.end(), packet.begin(), packet.end());
+    annexbSizes.push_back(packet.size());
+    packet = ToBitstream(stream[i], 4);
+    bitstream.insert(bitstream.end(), packet.begin(), packet.end());
+    bitstreamSizes.push_back(packet.size());
+  }
+
+  Unit extradata = MakeAnnexBExtradata(sps, pps);
+  CBitstreamConverter toBitstream;
+  ASSERT_TRUE(toBitstream.Open(AV_CODEC_ID_H264, &extradata[0], extradata.size(), false));
+  extradata = MakeAvcC(sps, pps, 4);
+  CBitstreamConverter toAnnexB;
+  ASSERT_TRUE(toAnnexB.Open(AV_CODEC_ID_H264, &extradata[0], extradata.size(), true));
+
+  // packets are converted in place, so every round gets a fresh copy
+  int64_t annexbTime = 0, bitstreamTime = 0;
+  for (int round = 0; round < rounds; round++)
+  {
+    Unit data = annexb;
+    int64_t start = CurrentHostCounter();
+    for (size_t i = 0, offset = 0; i < annexbSizes.size(); offset += annexbSizes[i++])
+      toBitstream.Convert(&data[offset], annexbSizes[i]);
+    annexbTime += CurrentHostCounter() - start;
+
+    data = bitstream;
+    start = CurrentHostCounter();
+    for (size_t i = 0, offset = 0; i < bitstreamSizes.size(); offset += bitstreamSizes[i++])
+      toAnnexB.Convert(&data[offset], bitstreamSizes[i]);
+    bitstreamTime += CurrentHostCounter() - start;
+  }
+
+  double frequency = CurrentHostFrequency();
+  printf("Annex B to bitstream %.0f MB/s, bitstream to Annex B %.0f MB/s\n",
+         (double)annexb.size() * rounds / (1024 * 1024) * frequency / annexbTime,
+         (double)bitstream.size() * rounds / (1024 * 1024) * frequency / bitstreamTime);
+}
@@ -19,6 +19,8 @@
  */
 
 #include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
+#include "threads/SystemClock.h"
 
 #include "gtest/gtest.h"
 
@@ -30,3 +32,92 @@ TEST(TestJSONVariantWriter, Write)
   str = CJSONVariantWriter::Write(variant, false);
   EXPECT_STREQ("null\n", str.c_str());
 }
+
+// timing only, see --gtest_also_run_disabled_tests
+TEST(TestJSONVariantWriter, DISABLED_GetMoviesBenchmark)
+{
+  static const unsigned int movies = 10000;
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  CVariant result;
+  for (unsigned int i = 0; i < movies; i++)
+  {
+    CVariant movie;
+    movie["movieid"] = i + 1;
+    movie["label"] = StringUtils::Format("Movie %u", i);
+    movie["title"] = StringUtils::Format("Movie %u", i);
+    movie["originaltitle"] = StringUtils::Format("The Original Title Of Movie %u", i);
+    movie["file"] = StringUtils::Format("smb://server/share/movies/Movie %u (2014)/Movie %u.mkv", i, i);
+    movie["year"] = 2014;
+    movie["rating"] = 7.5;
+    movie["runtime"] = 6300;
+    movie["playcount"] = 0;
+    movie["dateadded"] = "2014-05-01 20:15:00";
+    movie["lastplayed"] = "";
+    movie["mpaa"] = "Rated PG-13";
+    movie["imdbnumber"] = "tt0123456";
+    movie["thumbnail"] = StringUtils::Format("image://smb%%3a%%2f%%2fserver%%2fshare%%2fmovies%%2fMovie%%20%u-poster.jpg/", i);
+    movie["genre"].push_back("Action");
+    movie["genre"].push_back("Drama");
+    movie["resume"]["position"] = 0;
+    movie["resume"]["total"] = 0;
+    result["movies"].push_back(movie);
+  }
+  result["limits"]["start"] = 0;
+  result["limits"]["end"] = movies;
+  result["limits"]["total"] = movies;
+  unsigned int built = XbmcThreads::SystemClockMillis();
+
+  std::string json = CJSONVariantWriter::Write(result, true);
+  unsigned int written = XbmcThreads::SystemClockMillis();
+
+  EXPECT_EQ(movies, result["movies"].size());
+  EXPECT_FALSE(json.empty());
+  std::cout << "Movies: " << testing::PrintToString(movies) <<
+    " build: " << testing::PrintToString(built - start) << " ms" <<
+    " write: " << testing::PrintToString(written - built) << " ms" <<
+    " json: " << testing::PrintToString(json.size()) << " bytes" << std::endl;
+}
+
+class CCountingSink : public IJSONOutputSink
+{
+public:
+  CCountingSink() : writes(0) { }
+  virtual bool Write(const char *data, size_t length) { output.append(data, length); writes++; return true; }
+
+  std::string output;
+  unsigned int writes;
+};
+
+TEST(TestJSONVariantWriter, StreamWriter)
+{
+  CVariant items(CVariant::VariantTypeArray);
+  for (unsigned int i = 0; i < 100; i++)
+  {
+    CVariant item;
+    item["id"] = i;
+    item["label"] = StringUtils::Format("Item number %u", i);
+    items.push_back(item);
+  }
+
+  CVariant result;
+  result["items"] = items;
+  result["limits"]["total"] = items.size();
+
+  CCountingSink sink;
+  CJSONStreamWriter writer(sink, true, 256);
+  writer.StartObject();
+  writer.Key("items");
+  writer.StartArray();
+  for (CVariant::const_iterator_array it = items.begin_array(); it != items.end_array(); ++it)
+    writer.Value(*it);
+  writer.EndArray();
+  writer.Key("limits");
+  writer.Value(result["limits"]);
+  writer.EndObject();
+  EXPECT_TRUE(writer.Flush());
+  EXPECT_FALSE(writer.Failed());
+
+  EXPECT_STREQ(CJSONVariantWriter::Write(result, true).c_str(), sink.output.c_str());
+  EXPECT_LT(1u, sink.writes);
+}
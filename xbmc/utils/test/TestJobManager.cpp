@@ -20,8 +20,15 @@
 
 #include "utils/JobManager.h"
 #include "settings/Settings.h"
+#include "threads/Atomics.h"
+#include "threads/SystemClock.h"
+#include "utils/CPUInfo.h"
 #include "utils/SystemInfo.h"
 
+#ifdef TARGET_POSIX
+#include "../linux/XTimeUtils.h"
+#endif
+
 #include "gtest/gtest.h"
 
 /* CSysInfoJob::GetInternetState() will test for network connectivity. */
@@ -50,6 +57,7 @@ protected:
   {
     /* Always cancel jobs test completion */
     CJobManager::GetInstance().CancelJobs();
+    CJobManager::GetInstance().SetWorkStealing(false);
     CJobManager::GetInstance().Restart();
     CSettings::Get().Unload();
   }
@@ -177,3 +185,144 @@ TEST_F(TestJobManager, IsProcessing)
 
   job->FinishAndStopBlocking();
 }
+
+namespace
+{
+class CountingCallback : public IJobCallback
+{
+public:
+  CountingCallback() : m_completed(0) {}
+
+  void OnJobComplete(unsigned int jobID, bool success, CJob *job)
+  {
+    AtomicIncrement(&m_completed);
+  }
+
+  long Completed() { return AtomicAdd(&m_completed, 0); }
+
+  bool WaitForCompleted(long count, unsigned int timeoutMs)
+  {
+    XbmcThreads::EndTime timeout(timeoutMs);
+    while (Completed() < count && !timeout.IsTimePast())
+      Sleep(1);
+    return Completed() >= count;
+  }
+
+private:
+  volatile long m_completed;
+};
+
+class BusyJob : public CJob
+{
+public:
+  BusyJob(unsigned int iterations) : m_iterations(iterations), m_result(0) {}
+
+  const char * GetType() const
+  {
+    return "BusyJob";
+  }
+
+  bool DoWork()
+  {
+    unsigned int x = 1;
+    for (unsigned int i = 0; i < m_iterations; ++i)
+      x = x * 1664525 + 1013904223;
+    m_result = x;
+    return true;
+  }
+
+private:
+  unsigned int m_iterations;
+  volatile unsigned int m_result;
+};
+
+void SetWorkStealing(bool enable, unsigned int maxWorkers = 0)
+{
+  CJobManager::GetInstance().CancelJobs();
+  CJobManager::GetInstance().SetWorkStealing(enable, maxWorkers);
+  CJobManager::GetInstance().Restart();
+}
+
+/* Runs jobs of a fixed size and returns the throughput in jobs per second */
+double MeasureThroughput(unsigned int jobs, unsigned int iterations)
+{
+  CountingCallback callback;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (unsigned int i = 0; i < jobs; ++i)
+    CJobManager::GetInstance().AddJob(new BusyJob(iterations), &callback, CJob::PRIORITY_HIGH);
+  EXPECT_TRUE(callback.WaitForCompleted(jobs, 60000));
+  unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+  return jobs * 1000.0 / std::max(elapsed, 1U);
+}
+}
+
+TEST_F(TestJobManager, SetWorkStealingWhileRunning)
+{
+  EXPECT_THROW(CJobManager::GetInstance().SetWorkStealing(true), std::logic_error);
+  EXPECT_FALSE(CJobManager::GetInstance().IsWorkStealing());
+}
+
+TEST_F(TestJobManager, WorkStealingCompletesAllJobs)
+{
+  SetWorkStealing(true, 4);
+  EXPECT_TRUE(CJobManager::GetInstance().IsWorkStealing());
+
+  CountingCallback callback;
+  for (unsigned int i = 0; i < 1000; ++i)
+    CJobManager::GetInstance().AddJob(new BusyJob(100), &callback, CJob::PRIORITY(i % (CJob::PRIORITY_HIGH + 1)));
+  EXPECT_TRUE(callback.WaitForCompleted(1000, 30000));
+}
+
+TEST_F(TestJobManager, WorkStealingCancelJob)
+{
+  SetWorkStealing(true, 4);
+
+  CountingCallback callback;
+  std::vector<unsigned int> ids;
+  for (unsigned int i = 0; i < 100; ++i)
+    ids.push_back(CJobManager::GetInstance().AddJob(new BusyJob(10000), &callback));
+  for (unsigned int i = 0; i < ids.size(); ++i)
+    CJobManager::GetInstance().CancelJob(ids[i]);
+
+  /* no callbacks may arrive after the jobs have been cancelled */
+  long completed = callback.Completed();
+  Sleep(100);
+  EXPECT_EQ(completed, callback.Completed());
+}
+
+TEST_F(TestJobManager, WorkStealingPauseLowPriorityJob)
+{
+  SetWorkStealing(true, 4);
+
+  JobControlPackage package;
+  BroadcastingJob *job (WaitForJobToStartProcessing(CJob::PRIORITY_LOW_PAUSABLE, package));
+
+  EXPECT_TRUE(CJobManager::GetInstance().IsProcessing(CJob::PRIORITY_LOW_PAUSABLE));
+  EXPECT_EQ(1, CJobManager::GetInstance().IsProcessing("BroadcastingJob"));
+  CJobManager::GetInstance().PauseJobs();
+  EXPECT_FALSE(CJobManager::GetInstance().IsProcessing(CJob::PRIORITY_LOW_PAUSABLE));
+  CJobManager::GetInstance().UnPauseJobs();
+  EXPECT_TRUE(CJobManager::GetInstance().IsProcessing(CJob::PRIORITY_LOW_PAUSABLE));
+
+  job->FinishAndStopBlocking();
+}
+
+// prints jobs/s only, run it with --gtest_also_run_disabled_tests
+TEST_F(TestJobManager, DISABLED_WorkStealingThroughput)
+{
+  static const unsigned int jobs = 20000;
+  static const unsigned int iterations = 2000;
+
+  unsigned int cores = std::max(g_cpuInfo.getCPUCount(), 1);
+  for (unsigned int workers = 1; workers <= cores; workers *= 2)
+  {
+    SetWorkStealing(false, workers);
+    double shared = MeasureThroughput(jobs, iterations);
+    SetWorkStealing(true, workers);
+    double stealing = MeasureThroughput(jobs, iterations);
+
+    std::cout << "Workers: " << testing::PrintToString(workers) <<
+      " shared queue: " << testing::PrintToString((int)shared) << " jobs/s" <<
+      " work stealing: " << testing::PrintToString((int)stealing) << " jobs/s" << std::endl;
+  }
+}
@@ -0,0 +1,174 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/Profiler.h"
+#include "threads/Thread.h"
+
+#include "gtest/gtest.h"
+
+static const CProfiler::SectionStats* FindSection(const std::vector<CProfiler::SectionStats> &stats, const std::string &name)
+{
+  for (std::vector<CProfiler::SectionStats>::const_iterator it = stats.begin(); it != stats.end(); ++it)
+  {
+    if (it->name == name)
+      return &(*it);
+  }
+  return NULL;
+}
+
+TEST(TestProfilerHistogram, Percentiles)
+{
+  CProfilerHistogram histogram;
+  EXPECT_EQ(0U, histogram.GetPercentile(0.5));
+
+  for (unsigned int i = 1; i <= 1000; i++)
+    histogram.Add(i);
+
+  EXPECT_EQ(1000U, histogram.GetCount());
+  EXPECT_EQ(500500U, histogram.GetTotal());
+  EXPECT_EQ(1U, histogram.GetMin());
+  EXPECT_EQ(1000U, histogram.GetMax());
+  EXPECT_NEAR(500.0, histogram.GetPercentile(0.50), 500.0 * 0.07);
+  EXPECT_NEAR(950.0, histogram.GetPercentile(0.95), 950.0 * 0.07);
+  EXPECT_NEAR(990.0, histogram.GetPercentile(0.99), 990.0 * 0.07);
+  EXPECT_EQ(1000U, histogram.GetPercentile(1.0));
+
+  // small durations are exact
+  histogram.Reset();
+  for (unsigned int i = 0; i < 8; i++)
+    histogram.Add(i);
+  EXPECT_EQ(3U, histogram.GetPercentile(0.5));
+  EXPECT_EQ(0U, histogram.GetMin());
+
+  // huge durations end up in the last bucket
+  histogram.Reset();
+  histogram.Add(0xffffffff);
+  EXPECT_EQ(0xffffffffU, histogram.GetPercentile(0.99));
+}
+
+TEST(TestProfiler, Sections)
+{
+  CProfiler &profiler = CProfiler::Get();
+  profiler.Reset();
+
+  unsigned int a = profiler.RegisterSection("TestProfiler.A");
+  unsigned int b = profiler.RegisterSection("TestProfiler.B");
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, profiler.RegisterSection("TestProfiler.A"));
+
+  int64_t ms = CurrentHostFrequency() / 1000;
+  for (int i = 1; i <= 100; i++)
+    profiler.AddSample(a, i * ms);
+  {
+    PROFILE_SCOPE("TestProfiler.Scope");
+  }
+
+  std::vector<CProfiler::SectionStats> stats;
+  EXPECT_EQ(0U, profiler.GetStats(stats));
+
+  const CProfiler::SectionStats *section = FindSection(stats, "TestProfiler.A");
+  ASSERT_TRUE(section != NULL);
+  EXPECT_EQ(100U, section->count);
+  EXPECT_NEAR(5050000.0, (double)section->total, 100.0);
+  EXPECT_NEAR(1000.0, section->min, 1.0);
+  EXPECT_NEAR(100000.0, section->max, 1.0);
+  EXPECT_NEAR(50000.0, section->p50, 50000.0 * 0.07);
+  EXPECT_NEAR(95000.0, section->p95, 95000.0 * 0.07);
+  EXPECT_NEAR(99000.0, section->p99, 99000.0 * 0.07);
+
+  // sections without samples are left out
+  EXPECT_TRUE(FindSection(stats, "TestProfiler.B") == NULL);
+  section = FindSection(stats, "TestProfiler.Scope");
+  ASSERT_TRUE(section != NULL);
+  EXPECT_EQ(1U, section->count);
+
+  profiler.GetStats(stats, true);
+  EXPECT_FALSE(stats.empty());
+  profiler.GetStats(stats);
+  EXPECT_TRUE(FindSection(stats, "TestProfiler.A") == NULL);
+  EXPECT_EQ(a, profiler.RegisterSection("TestProfiler.A"));
+}
+
+TEST(TestProfiler, Disabled)
+{
+  CProfiler &profiler = CProfiler::Get();
+  profiler.Reset();
+
+  CProfiler::SetEnabled(false);
+  {
+    PROFILE_SCOPE("TestProfiler.Disabled");
+  }
+  CProfiler::SetEnabled(true);
+
+  std::vector<CProfiler::SectionStats> stats;
+  profiler.GetStats(stats);
+  EXPECT_TRUE(FindSection(stats, "TestProfiler.Disabled") == NULL);
+}
+
+class CProfilerTestThread : public IRunnable
+{
+public:
+  CProfilerTestThread(unsigned int section, unsigned int samples) : m_section(section), m_samples(samples) { }
+
+  virtual void Run()
+  {
+    for (unsigned int i = 0; i < m_samples; i++)
+    {
+      CProfiler::Get().AddSample(m_section, i);
+      // keep the rings from filling up
+      if (i % 256 == 0)
+        CProfiler::Get().Process();
+    }
+  }
+
+private:
+  unsigned int m_section;
+  unsigned int m_samples;
+};
+
+TEST(TestProfiler, Threads)
+{
+  CProfiler &profiler = CProfiler::Get();
+  profiler.Reset();
+
+  // more threads than there are rings
+  const unsigned int threadCount = 20;
+  const unsigned int samples = 10000;
+  unsigned int section = profiler.RegisterSection("TestProfiler.Threads");
+
+  CProfilerTestThread runnable(section, samples);
+  std::vector<CThread*> threads;
+  for (unsigned int i = 0; i < threadCount; i++)
+  {
+    threads.push_back(new CThread(&runnable, "TestProfiler"));
+    threads.back()->Create();
+  }
+  for (unsigned int i = 0; i < threadCount; i++)
+  {
+    threads[i]->StopThread(true);
+    delete threads[i];
+  }
+
+  std::vector<CProfiler::SectionStats> stats;
+  uint64_t dropped = profiler.GetStats(stats);
+  const CProfiler::SectionStats *result = FindSection(stats, "TestProfiler.Threads");
+  ASSERT_TRUE(result != NULL);
+  EXPECT_EQ((uint64_t)threadCount * samples, result->count + dropped);
+}
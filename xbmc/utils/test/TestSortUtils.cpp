@@ -18,11 +18,40 @@
  *
  */
 
+#include "settings/AdvancedSettings.h"
 #include "utils/SortUtils.h"
+#include "utils/StringUtils.h"
 #include "utils/Variant.h"
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <stdlib.h>
+
+static SortItemPtr CreateSortItem(int id, const std::string &label)
+{
+  SortItemPtr item(new SortItem());
+  (*item)[FieldId] = id;
+  (*item)[FieldLabel] = label;
+  return item;
+}
+
+static bool CompareId(const SortItemPtr &left, const SortItemPtr &right)
+{
+  return left->at(FieldId).asInteger() < right->at(FieldId).asInteger();
+}
+
+// the way SortUtils::Sort() used to compare the items
+static bool SortLabelLess(const SortItemPtr &left, const SortItemPtr &right)
+{
+  return StringUtils::AlphaNumericCompare(left->at(FieldSort).asWideString().c_str(), right->at(FieldSort).asWideString().c_str()) < 0;
+}
+
+static bool SortLabelGreater(const SortItemPtr &left, const SortItemPtr &right)
+{
+  return StringUtils::AlphaNumericCompare(left->at(FieldSort).asWideString().c_str(), right->at(FieldSort).asWideString().c_str()) > 0;
+}
+
 TEST(TestSortUtils, Sort_SortBy)
 {
   SortItems items;
@@ -131,3 +160,176 @@ TEST(TestSortUtils, GetFieldsForSorting)
   EXPECT_EQ(FieldTrackNumber, *it);
   EXPECT_EQ((unsigned int)4, fields.size());
 }
+
+TEST(TestSortUtils, Sort_NumericValues)
+{
+  SortItems items;
+  int64_t sizes[] = { 10, 9, 4294967296LL, 100, 9 };
+  for (int i = 0; i < 5; i++)
+  {
+    items.push_back(CreateSortItem(i, StringUtils::Format("Item %d", i)));
+    (*items.back())[FieldSize] = sizes[i];
+  }
+
+  SortUtils::Sort(SortBySize, SortOrderAscending, SortAttributeNone, items);
+
+  // equal values keep their order
+  int ascending[] = { 1, 4, 0, 3, 2 };
+  for (int i = 0; i < 5; i++)
+    EXPECT_EQ(ascending[i], (*items.at(i))[FieldId].asInteger());
+  EXPECT_STREQ(L"4294967296", (*items.at(4))[FieldSort].asWideString().c_str());
+
+  SortUtils::Sort(SortBySize, SortOrderDescending, SortAttributeNone, items);
+
+  int descending[] = { 2, 3, 0, 1, 4 };
+  for (int i = 0; i < 5; i++)
+    EXPECT_EQ(descending[i], (*items.at(i))[FieldId].asInteger());
+}
+
+TEST(TestSortUtils, Sort_NumericValuesAndLabels)
+{
+  SortItems items;
+  double ratings[] = { 7.5, 10.0, 7.5, 6.25 };
+  const char *labels[] = { "b movie", "Z movie", "A movie", "c movie" };
+  for (int i = 0; i < 4; i++)
+  {
+    items.push_back(CreateSortItem(i, labels[i]));
+    (*items.back())[FieldRating] = ratings[i];
+  }
+
+  SortUtils::Sort(SortByRating, SortOrderAscending, SortAttributeNone, items);
+
+  // items with the same rating are sorted by their label
+  int ascending[] = { 3, 2, 0, 1 };
+  for (int i = 0; i < 4; i++)
+    EXPECT_EQ(ascending[i], (*items.at(i))[FieldId].asInteger());
+}
+
+TEST(TestSortUtils, Sort_SortSpecialAndFolders)
+{
+  SortItems items;
+  items.push_back(CreateSortItem(0, "c file"));
+  items.push_back(CreateSortItem(1, "b folder"));
+  (*items.back())[FieldFolder] = true;
+  items.push_back(CreateSortItem(2, "z bottom"));
+  (*items.back())[FieldSortSpecial] = SortSpecialOnBottom;
+  items.push_back(CreateSortItem(3, "a file"));
+  items.push_back(CreateSortItem(4, "z top"));
+  (*items.back())[FieldSortSpecial] = SortSpecialOnTop;
+  items.push_back(CreateSortItem(5, "a folder"));
+  (*items.back())[FieldFolder] = true;
+  for (int i = 0; i < 6; i++)
+  {
+    if (!items[i]->count(FieldFolder))
+      (*items[i])[FieldFolder] = false;
+  }
+
+  SortUtils::Sort(SortByLabel, SortOrderAscending, SortAttributeNone, items);
+  int folders[] = { 4, 5, 1, 3, 0, 2 };
+  for (int i = 0; i < 6; i++)
+    EXPECT_EQ(folders[i], (*items.at(i))[FieldId].asInteger());
+
+  // folders stay on top and items sorted on top/bottom stay there
+  SortUtils::Sort(SortByLabel, SortOrderDescending, SortAttributeNone, items);
+  int descending[] = { 4, 1, 5, 0, 3, 2 };
+  for (int i = 0; i < 6; i++)
+    EXPECT_EQ(descending[i], (*items.at(i))[FieldId].asInteger());
+
+  SortUtils::Sort(SortByLabel, SortOrderAscending, SortAttributeIgnoreFolders, items);
+  int ignoreFolders[] = { 4, 3, 5, 1, 0, 2 };
+  for (int i = 0; i < 6; i++)
+    EXPECT_EQ(ignoreFolders[i], (*items.at(i))[FieldId].asInteger());
+}
+
+TEST(TestSortUtils, Sort_IgnoreArticle)
+{
+  std::vector<std::string> tokens = g_advancedSettings.m_vecTokens;
+  g_advancedSettings.m_vecTokens.clear();
+  g_advancedSettings.m_vecTokens.push_back("the ");
+
+  SortItems items;
+  const char *titles[] = { "The Abyss", "Brazil", "the Deer", "Cars" };
+  for (int i = 0; i < 4; i++)
+  {
+    items.push_back(CreateSortItem(i, titles[i]));
+    (*items.back())[FieldTitle] = titles[i];
+  }
+
+  SortUtils::Sort(SortByTitle, SortOrderAscending, SortAttributeNone, items);
+  int withArticle[] = { 1, 3, 0, 2 };
+  for (int i = 0; i < 4; i++)
+    EXPECT_EQ(withArticle[i], (*items.at(i))[FieldId].asInteger());
+
+  SortUtils::Sort(SortByTitle, SortOrderAscending, SortAttributeIgnoreArticle, items);
+  int ignoreArticle[] = { 0, 1, 3, 2 };
+  for (int i = 0; i < 4; i++)
+    EXPECT_EQ(ignoreArticle[i], (*items.at(i))[FieldId].asInteger());
+  EXPECT_STREQ(L"Abyss", (*items.at(0))[FieldSort].asWideString().c_str());
+
+  g_advancedSettings.m_vecTokens = tokens;
+}
+
+TEST(TestSortUtils, Sort_Limits)
+{
+  SortItems items;
+  for (int i = 0; i < 10; i++)
+  {
+    items.push_back(CreateSortItem(i, "item"));
+    (*items.back())[FieldTrackNumber] = 10 - i;
+  }
+
+  SortDescription desc;
+  desc.sortBy = SortByTrackNumber;
+  desc.limitStart = 2;
+  desc.limitEnd = 5;
+  SortUtils::Sort(desc, items);
+
+  ASSERT_EQ((size_t)3, items.size());
+  EXPECT_EQ(3, (*items.at(0))[FieldTrackNumber].asInteger());
+  EXPECT_EQ(4, (*items.at(1))[FieldTrackNumber].asInteger());
+  EXPECT_EQ(5, (*items.at(2))[FieldTrackNumber].asInteger());
+}
+
+TEST(TestSortUtils, Sort_LargeList)
+{
+  // big enough to be sorted by several threads
+  static const int count = 40000;
+
+  srand(0);
+  SortItems items;
+  DatabaseResults results;
+  for (int i = 0; i < count; i++)
+  {
+    SortItemPtr item = CreateSortItem(i, StringUtils::Format("%c%c Song %d", 'A' + rand() % 26, 'a' + rand() % 26, rand() % 100));
+    (*item)[FieldArtist] = StringUtils::Format("Artist %d", rand() % 500);
+    (*item)[FieldAlbum] = StringUtils::Format("Album %d", rand() % 50);
+    (*item)[FieldTrackNumber] = rand() % 20;
+    (*item)[FieldPlaycount] = rand() % 5;
+    items.push_back(item);
+    results.push_back(*item);
+  }
+
+  SortBy sortMethods[] = { SortByLabel, SortByArtist, SortByTrackNumber, SortByPlaycount };
+  for (unsigned int method = 0; method < sizeof(sortMethods) / sizeof(SortBy); method++)
+  {
+    for (int order = SortOrderAscending; order <= SortOrderDescending; order++)
+    {
+      SortItems sorted = items;
+      SortUtils::Sort(sortMethods[method], (SortOrder)order, SortAttributeNone, sorted);
+
+      // compare with a plain stable sort of the sort labels
+      SortItems expected = sorted;
+      std::sort(expected.begin(), expected.end(), CompareId);
+      std::stable_sort(expected.begin(), expected.end(), order == SortOrderAscending ? SortLabelLess : SortLabelGreater);
+
+      ASSERT_EQ(expected.size(), sorted.size());
+      for (int i = 0; i < count; i++)
+        ASSERT_EQ((*expected[i])[FieldId].asInteger(), (*sorted[i])[FieldId].asInteger()) << "method " << method << " order " << order << " position " << i;
+
+      DatabaseResults sortedResults = results;
+      SortUtils::Sort(sortMethods[method], (SortOrder)order, SortAttributeNone, sortedResults);
+      for (int i = 0; i < count; i++)
+        ASSERT_EQ((*sorted[i])[FieldId].asInteger(), sortedResults[i][FieldId].asInteger());
+    }
+  }
+}
@@ -348,3 +348,83 @@ TEST(TestVariant, isMember)
   EXPECT_TRUE(a.isMember("key1"));
   EXPECT_FALSE(a.isMember("key2"));
 }
+
+TEST(TestVariant, ShortAndLongString)
+{
+  std::string shortString(22, 's'), longString(23, 'l');
+  CVariant a(shortString), b(longString), c;
+
+  EXPECT_EQ((unsigned int)22, a.size());
+  EXPECT_EQ((unsigned int)23, b.size());
+  EXPECT_EQ(shortString, a.asString());
+  EXPECT_EQ(longString, b.asString());
+  EXPECT_STREQ(shortString.c_str(), a.c_str());
+
+  c = a;
+  EXPECT_TRUE(c == a);
+  EXPECT_FALSE(c == b);
+  c = b;
+  EXPECT_TRUE(c == b);
+
+  a.swap(b);
+  EXPECT_EQ(longString, a.asString());
+  EXPECT_EQ(shortString, b.asString());
+
+  a.clear();
+  EXPECT_TRUE(a.isString());
+  EXPECT_TRUE(a.empty());
+  EXPECT_STREQ("", a.c_str());
+
+  CVariant embedded("a\0b", 3);
+  EXPECT_EQ((unsigned int)3, embedded.size());
+  EXPECT_FALSE(embedded == CVariant("a"));
+}
+
+TEST(TestVariant, ObjectOrder)
+{
+  CVariant a;
+  a["key3"] = 3;
+  a["key1"] = 1;
+  a["key4"] = 4;
+  a["key2"] = 2;
+  a["key1"] = 5;
+
+  EXPECT_EQ((unsigned int)4, a.size());
+  const char *keys[] = { "key1", "key2", "key3", "key4" };
+  unsigned int index = 0;
+  for (CVariant::const_iterator_map it = a.begin_map(); it != a.end_map(); ++it, ++index)
+    EXPECT_STREQ(keys[index], it->first.c_str());
+  EXPECT_EQ(5, a["key1"].asInteger());
+
+  a.erase("key2");
+  EXPECT_EQ((unsigned int)3, a.size());
+  EXPECT_FALSE(a.isMember("key2"));
+  EXPECT_EQ(3, a["key3"].asInteger());
+
+  std::map<std::string, CVariant> variantMap;
+  variantMap["key1"] = 5;
+  variantMap["key3"] = 3;
+  variantMap["key4"] = 4;
+  EXPECT_TRUE(CVariant(variantMap) == a);
+}
+
+TEST(TestVariant, ArrayGrowth)
+{
+  CVariant a(CVariant::VariantTypeArray);
+  for (unsigned int i = 0; i < 1000; i++)
+  {
+    CVariant item;
+    item["id"] = i;
+    item["label"] = "a label which doesn't fit into a variant";
+    a.push_back(item);
+  }
+  a.push_back(a[0]);
+
+  EXPECT_EQ((unsigned int)1001, a.size());
+  for (unsigned int i = 0; i < 1000; i++)
+    EXPECT_EQ((uint64_t)i, a[i]["id"].asUnsignedInteger());
+  EXPECT_TRUE(a[1000] == a[0]);
+
+  a.erase(0);
+  EXPECT_EQ((uint64_t)1, a[0]["id"].asUnsignedInteger());
+}
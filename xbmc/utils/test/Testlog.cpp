@@ -151,3 +151,47 @@ TEST_F(Testlog, SetLogLevel)
   CLog::Close();
   EXPECT_TRUE(XFILE::CFile::Delete(logfile));
 }
+
+TEST_F(Testlog, AsyncLog)
+{
+  CStdString logfile, logstring;
+  char buf[100];
+  unsigned int bytesread;
+  XFILE::CFile file;
+  CRegExp regex;
+
+  std::string appName = CCompileInfo::GetAppName();
+  StringUtils::ToLower(appName);
+  logfile = CSpecialProtocol::TranslatePath("special://temp/") + appName + ".log";
+  EXPECT_TRUE(CLog::Init(CSpecialProtocol::TranslatePath("special://temp/").c_str()));
+  EXPECT_TRUE(XFILE::CFile::Exists(logfile));
+
+  CLog::SetAsync(true);
+  EXPECT_TRUE(CLog::IsAsync());
+  CLog::Log(LOGDEBUG, "async debug log message");
+  CLog::Log(LOGDEBUG, "async debug log message");
+  CLog::Log(LOGDEBUG, "async debug log message");
+  CLog::Log(LOGERROR, "async error log message\nsecond line");
+  CLog::SetAsync(false);
+  EXPECT_FALSE(CLog::IsAsync());
+  CLog::Log(LOGNOTICE, "sync notice log message");
+  CLog::Close();
+
+  EXPECT_TRUE(file.Open(logfile));
+  while ((bytesread = file.Read(buf, sizeof(buf) - 1)) > 0)
+  {
+    buf[bytesread] = '\0';
+    logstring.append(buf);
+  }
+  file.Close();
+  EXPECT_FALSE(logstring.empty());
+
+  EXPECT_STREQ("\xEF\xBB\xBF", logstring.substr(0, 3).c_str());
+
+  /* queued lines keep the on-disk format, including repeat folding and newline alignment */
+  EXPECT_TRUE(regex.RegComp(".*DEBUG: async debug log message\n.*DEBUG: Previous line repeats 2 times.\n.*ERROR: async error log message\n {44}second line\n.*NOTICE: sync notice log message.*"));
+  EXPECT_GE(regex.RegFind(logstring), 0);
+  EXPECT_EQ(0U, CLog::GetDroppedCount());
+
+  EXPECT_TRUE(XFILE::CFile::Delete(logfile));
+}
@@ -0,0 +1,97 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "KeyframeIndexJob.h"
+#include "cores/dvdplayer/DVDFileInfo.h"
+#include "filesystem/StackDirectory.h"
+#include "URL.h"
+#include "utils/log.h"
+#include "utils/URIUtils.h"
+#include "video/VideoDatabase.h"
+
+#include <vector>
+
+CKeyframeIndexJob::CKeyframeIndexJob(const std::string &path)
+  : m_path(path)
+{
+}
+
+CKeyframeIndexJob::~CKeyframeIndexJob()
+{
+}
+
+bool CKeyframeIndexJob::operator==(const CJob* job) const
+{
+  if (strcmp(job->GetType(), GetType()) == 0)
+  {
+    const CKeyframeIndexJob* indexJob = dynamic_cast<const CKeyframeIndexJob*>(job);
+    if (indexJob)
+      return m_path == indexJob->m_path;
+  }
+  return false;
+}
+
+bool CKeyframeIndexJob::DoWork()
+{
+  // the player keeps an index for each part of a stack
+  std::vector<std::string> paths;
+  if (URIUtils::IsStack(m_path))
+    XFILE::CStackDirectory::GetPaths(m_path, paths);
+  else
+    paths.push_back(m_path);
+
+  for (std::vector<std::string>::const_iterator it = paths.begin(); it != paths.end(); ++it)
+  {
+    if (ShouldCancel(it - paths.begin(), paths.size()))
+      return false;
+
+    CVideoDatabase db;
+    if (!db.Open())
+      return false;
+
+    std::string keyframes;
+    bool indexed = db.GetKeyframeIndex(*it, keyframes);
+    db.Close();
+    if (indexed)
+      continue;
+
+    // reading the whole file takes a while, so the database isn't kept open meanwhile
+    if (!CDVDFileInfo::BuildKeyframeIndex(*it, keyframes, this))
+      continue;
+
+    if (!db.Open())
+      return false;
+    db.SetKeyframeIndex(*it, keyframes);
+    db.Close();
+    CLog::Log(LOGDEBUG, "%s - stored keyframe index of %s", __FUNCTION__, CURL::GetRedacted(*it).c_str());
+  }
+  return true;
+}
+
+CKeyframeIndexQueue::CKeyframeIndexQueue()
+  : CJobQueue(false, 1, CJob::PRIORITY_LOW_PAUSABLE)
+{
+}
+
+CKeyframeIndexQueue &CKeyframeIndexQueue::Get()
+{
+  static CKeyframeIndexQueue keyframeIndexQueue;
+  return keyframeIndexQueue;
+}
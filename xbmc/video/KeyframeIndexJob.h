@@ -0,0 +1,52 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+
+#include "utils/Job.h"
+#include "utils/JobManager.h"
+
+/*!
+ \brief Builds the keyframe index of a file ahead of its first playback
+ \sa CDVDFileInfo::BuildKeyframeIndex
+ */
+class CKeyframeIndexJob : public CJob
+{
+public:
+  CKeyframeIndexJob(const std::string &path);
+  virtual ~CKeyframeIndexJob();
+  virtual const char *GetType() const { return "keyframeindex"; }
+  virtual bool operator==(const CJob* job) const;
+  virtual bool DoWork();
+private:
+  std::string m_path;
+};
+
+/*!
+ \brief Runs the keyframe index jobs one at a time, paused during playback
+ */
+class CKeyframeIndexQueue : public CJobQueue
+{
+public:
+  static CKeyframeIndexQueue &Get();
+private:
+  CKeyframeIndexQueue();
+};
@@ -71,9 +71,36 @@ using namespace XFILE;
 using namespace VIDEO;
 using namespace ADDON;
 
+// ids per IN (...) list when fetching details for many items at once
+#define VIDEODB_IDS_PER_QUERY 1000
+#define VIDEODB_SEARCH_RESULTS_LIMIT 1000
+
+static vector<string> SplitIdList(const set<int> &ids)
+{
+  vector<string> lists;
+  string list;
+  int count = 0;
+  for (set<int>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+  {
+    if (count == VIDEODB_IDS_PER_QUERY)
+    {
+      lists.push_back(list);
+      list.clear();
+      count = 0;
+    }
+    if (count++ > 0)
+      list += ",";
+    list += StringUtils::Format("%i", *it);
+  }
+  if (count > 0)
+    lists.push_back(list);
+  return lists;
+}
+
 //********************************************************************************************************************************
 CVideoDatabase::CVideoDatabase(void)
 {
+  m_searchIndex = -1;
 }
 
 //********************************************************************************************************************************
@@ -83,6 +110,7 @@ CVideoDatabase::~CVideoDatabase(void)
 //********************************************************************************************************************************
 bool CVideoDatabase::Open()
 {
+  m_searchIndex = -1;
   return CDatabase::Open(g_advancedSettings.m_databaseVideo);
 }
 
@@ -102,6 +130,10 @@ void CVideoDatabase::CreateTables()
   CLog::Log(LOGINFO, "create stacktimes table");
   m_pDS->exec("CREATE TABLE stacktimes (idFile integer, times text)\n");
 
+  CLog::Log(LOGINFO, "create keyframeindex table");
+  // a MySQL text column holds 64KB, less than the index of a long film
+  m_pDS->exec("CREATE TABLE keyframeindex (idFile integer, keyframes longtext)\n");
+
   CLog::Log(LOGINFO, "create genre table");
   m_pDS->exec("CREATE TABLE genre ( idGenre integer primary key, strGenre text)\n");
 
@@ -237,6 +269,8 @@ void CVideoDatabase::CreateTables()
 
   CLog::Log(LOGINFO, "create taglinks table");
   m_pDS->exec("CREATE TABLE taglinks (idTag integer, idMedia integer, media_type TEXT)");
+
+  CreateSearchTables();
 }
 
 void CVideoDatabase::CreateAnalytics()
@@ -256,6 +290,7 @@ void CVideoDatabase::CreateAnalytics()
   m_pDS->exec("CREATE INDEX ix_bookmark ON bookmark (idFile, type)");
   m_pDS->exec("CREATE UNIQUE INDEX ix_settings ON settings ( idFile )\n");
   m_pDS->exec("CREATE UNIQUE INDEX ix_stacktimes ON stacktimes ( idFile )\n");
+  m_pDS->exec("CREATE UNIQUE INDEX ix_keyframeindex ON keyframeindex ( idFile )\n");
   m_pDS->exec("CREATE INDEX ix_path ON path ( strPath(255) )");
   m_pDS->exec("CREATE INDEX ix_path2 ON path ( idParentPath )");
   m_pDS->exec("CREATE INDEX ix_files ON files ( idPath, strFilename(255) )");
@@ -376,9 +411,71 @@ void CVideoDatabase::CreateAnalytics()
               "DELETE FROM tag WHERE idTag=old.idTag AND idTag NOT IN (SELECT DISTINCT idTag FROM taglinks); "
               "END");
 
+  CreateSearchAnalytics();
+
   CreateViews();
 }
 
+bool CVideoDatabase::CreateSearchTables()
+{
+  CLog::Log(LOGINFO, "create search tables");
+  try
+  {
+    for (int i = 0; i < VIDEOSEARCH_COUNT; i++)
+      CFullTextSearch::CreateTable(*m_pDS, m_sqlite, VideoSearchIndexes[i]);
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGWARNING, "%s - full text search is not supported, searching without an index", __FUNCTION__);
+  }
+  return false;
+}
+
+void CVideoDatabase::CreateSearchAnalytics()
+{
+  try
+  {
+    for (int i = 0; i < VIDEOSEARCH_COUNT; i++)
+      CFullTextSearch::CreateIndex(*m_pDS, m_sqlite, VideoSearchIndexes[i]);
+  }
+  catch (...)
+  {
+    CLog::Log(LOGWARNING, "%s - full text indexes are not supported, searching without them", __FUNCTION__);
+  }
+
+  m_searchIndex = -1;
+  if (!HasSearchIndex())
+    return;
+
+  CLog::Log(LOGINFO, "%s - creating search triggers", __FUNCTION__);
+  CFullTextSearch::CreateTriggers(*m_pDS, m_sqlite, VideoSearchIndexes, VIDEOSEARCH_COUNT);
+}
+
+bool CVideoDatabase::HasSearchIndex()
+{
+  if (m_searchIndex < 0)
+  {
+    m_searchIndex = 0;
+    if (NULL != m_pDB.get() && NULL != m_pDS2.get() &&
+        CFullTextSearch::IsAvailable(*m_pDB, *m_pDS2, m_sqlite, VideoSearchIndexes[VIDEOSEARCH_MOVIES]))
+      m_searchIndex = 1;
+    CLog::Log(LOGDEBUG, "%s - searching %s the full text index", __FUNCTION__, m_searchIndex ? "with" : "without");
+  }
+  return m_searchIndex > 0;
+}
+
+std::string CVideoDatabase::GetSearchFilter(VideoSearchIndex index, const std::string &search)
+{
+  if (!HasSearchIndex())
+    return "";
+  std::string filter = CFullTextSearch::GetFilter(*m_pDB, m_sqlite, VideoSearchIndexes[index], search, true, false);
+  // the searches join tables sharing the id column, e.g. tvshowlinkpath
+  if (!filter.empty())
+    filter = std::string(VideoSearchIndexes[index].source) + "." + filter;
+  return filter;
+}
+
 void CVideoDatabase::CreateViews()
 {
   CLog::Log(LOGINFO, "create episodeview");
@@ -523,8 +620,8 @@ int CVideoDatabase::GetPathId(const CStdString& strPath)
 
     URIUtils::AddSlashAtEnd(strPath1);
 
-    strSQL=PrepareSQL("select idPath from path where strPath='%s'",strPath1.c_str());
-    m_pDS->query(strSQL.c_str());
+    strSQL = "select idPath from path where strPath=?";
+    m_pDS->query_bind(strSQL, BindParams().add(strPath1));
     if (!m_pDS->eof())
       idPath = m_pDS->fv("path.idPath").get_asInt();
 
@@ -667,6 +764,21 @@ int CVideoDatabase::RunQuery(const CStdString &sql)
   return rows;
 }
 
+int CVideoDatabase::RunQueryStream(const CStdString &sql)
+{
+  unsigned int time = XbmcThreads::SystemClockMillis();
+  int rows = -1;
+  if (m_pDS->query_stream(sql.c_str()))
+  {
+    // only tells whether there are rows at all
+    rows = m_pDS->num_rows();
+    if (rows == 0)
+      m_pDS->close();
+  }
+  CLog::Log(LOGDEBUG, "%s took %d ms to the first item, query: %s", __FUNCTION__, XbmcThreads::SystemClockMillis() - time, sql.c_str());
+  return rows;
+}
+
 bool CVideoDatabase::GetSubPaths(const CStdString &basepath, vector< pair<int,string> >& subpaths)
 {
   CStdString sql;
@@ -1089,9 +1201,7 @@ int CVideoDatabase::GetFileId(const CStdString& strFilenameAndPath)
     int idPath = GetPathId(strPath);
     if (idPath >= 0)
     {
-      CStdString strSQL;
-      strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
-      m_pDS->query(strSQL.c_str());
+      m_pDS->query_bind("select idFile from files where strFileName=? and idPath=?", BindParams().add(strFileName).add(idPath));
       if (m_pDS->num_rows() > 0)
       {
         int idFile = m_pDS->fv("files.idFile").get_asInt();
@@ -2770,34 +2880,34 @@ void CVideoDatabase::SetStreamDetailsForFileId(const CStreamDetails& details, in
   try
   {
     BeginTransaction();
-    m_pDS->exec(PrepareSQL("DELETE FROM streamdetails WHERE idFile = %i", idFile));
+    m_pDS->exec_bind("DELETE FROM streamdetails WHERE idFile = ?", BindParams().add(idFile));
 
     for (int i=1; i<=details.GetVideoStreamCount(); i++)
     {
-      m_pDS->exec(PrepareSQL("INSERT INTO streamdetails "
+      m_pDS->exec_bind("INSERT INTO streamdetails "
         "(idFile, iStreamType, strVideoCodec, fVideoAspect, iVideoWidth, iVideoHeight, iVideoDuration, strStereoMode) "
-        "VALUES (%i,%i,'%s',%f,%i,%i,%i,'%s')",
-        idFile, (int)CStreamDetail::VIDEO,
-        details.GetVideoCodec(i).c_str(), details.GetVideoAspect(i),
-        details.GetVideoWidth(i), details.GetVideoHeight(i), details.GetVideoDuration(i),
-        details.GetStereoMode(i).c_str()));
+        "VALUES (?,?,?,?,?,?,?,?)",
+        BindParams().add(idFile).add((int)CStreamDetail::VIDEO)
+                    .add(details.GetVideoCodec(i)).add(details.GetVideoAspect(i))
+                    .add(details.GetVideoWidth(i)).add(details.GetVideoHeight(i)).add(details.GetVideoDuration(i))
+                    .add(details.GetStereoMode(i)));
     }
     for (int i=1; i<=details.GetAudioStreamCount(); i++)
     {
-      m_pDS->exec(PrepareSQL("INSERT INTO streamdetails "
+      m_pDS->exec_bind("INSERT INTO streamdetails "
         "(idFile, iStreamType, strAudioCodec, iAudioChannels, strAudioLanguage) "
-        "VALUES (%i,%i,'%s',%i,'%s')",
-        idFile, (int)CStreamDetail::AUDIO,
-        details.GetAudioCodec(i).c_str(), details.GetAudioChannels(i),
-        details.GetAudioLanguage(i).c_str()));
+        "VALUES (?,?,?,?,?)",
+        BindParams().add(idFile).add((int)CStreamDetail::AUDIO)
+                    .add(details.GetAudioCodec(i)).add(details.GetAudioChannels(i))
+                    .add(details.GetAudioLanguage(i)));
     }
     for (int i=1; i<=details.GetSubtitleStreamCount(); i++)
     {
-      m_pDS->exec(PrepareSQL("INSERT INTO streamdetails "
+      m_pDS->exec_bind("INSERT INTO streamdetails "
         "(idFile, iStreamType, strSubtitleLanguage) "
-        "VALUES (%i,%i,'%s')",
-        idFile, (int)CStreamDetail::SUBTITLE,
-        details.GetSubtitleLanguage(i).c_str()));
+        "VALUES (?,?,?)",
+        BindParams().add(idFile).add((int)CStreamDetail::SUBTITLE)
+                    .add(details.GetSubtitleLanguage(i)));
     }
 
     // update the runtime information, if empty
@@ -3608,45 +3718,8 @@ bool CVideoDatabase::GetStreamDetails(CVideoInfoTag& tag) const
 
     while (!pDS->eof())
     {
-      CStreamDetail::StreamType e = (CStreamDetail::StreamType)pDS->fv(1).get_asInt();
-      switch (e)
-      {
-      case CStreamDetail::VIDEO:
-        {
-          CStreamDetailVideo *p = new CStreamDetailVideo();
-          p->m_strCodec = pDS->fv(2).get_asString();
-          p->m_fAspect = pDS->fv(3).get_asFloat();
-          p->m_iWidth = pDS->fv(4).get_asInt();
-          p->m_iHeight = pDS->fv(5).get_asInt();
-          p->m_iDuration = pDS->fv(10).get_asInt();
-          p->m_strStereoMode = pDS->fv(11).get_asString();
-          details.AddStream(p);
-          retVal = true;
-          break;
-        }
-      case CStreamDetail::AUDIO:
-        {
-          CStreamDetailAudio *p = new CStreamDetailAudio();
-          p->m_strCodec = pDS->fv(6).get_asString();
-          if (pDS->fv(7).get_isNull())
-            p->m_iChannels = -1;
-          else
-            p->m_iChannels = pDS->fv(7).get_asInt();
-          p->m_strLanguage = pDS->fv(8).get_asString();
-          details.AddStream(p);
-          retVal = true;
-          break;
-        }
-      case CStreamDetail::SUBTITLE:
-        {
-          CStreamDetailSubtitle *p = new CStreamDetailSubtitle();
-          p->m_strLanguage = pDS->fv(9).get_asString();
-          details.AddStream(p);
-          retVal = true;
-          break;
-        }
-      }
-
+      if (AddStreamDetail(details, pDS))
+        retVal = true;
       pDS->next();
     }
 
@@ -3663,6 +3736,46 @@ bool CVideoDatabase::GetStreamDetails(CVideoInfoTag& tag) const
 
   return retVal;
 }
+
+bool CVideoDatabase::AddStreamDetail(CStreamDetails& details, const auto_ptr<Dataset> &pDS)
+{
+  CStreamDetail::StreamType e = (CStreamDetail::StreamType)pDS->fv(1).get_asInt();
+  switch (e)
+  {
+  case CStreamDetail::VIDEO:
+    {
+      CStreamDetailVideo *p = new CStreamDetailVideo();
+      p->m_strCodec = pDS->fv(2).get_asString();
+      p->m_fAspect = pDS->fv(3).get_asFloat();
+      p->m_iWidth = pDS->fv(4).get_asInt();
+      p->m_iHeight = pDS->fv(5).get_asInt();
+      p->m_iDuration = pDS->fv(10).get_asInt();
+      p->m_strStereoMode = pDS->fv(11).get_asString();
+      details.AddStream(p);
+      return true;
+    }
+  case CStreamDetail::AUDIO:
+    {
+      CStreamDetailAudio *p = new CStreamDetailAudio();
+      p->m_strCodec = pDS->fv(6).get_asString();
+      if (pDS->fv(7).get_isNull())
+        p->m_iChannels = -1;
+      else
+        p->m_iChannels = pDS->fv(7).get_asInt();
+      p->m_strLanguage = pDS->fv(8).get_asString();
+      details.AddStream(p);
+      return true;
+    }
+  case CStreamDetail::SUBTITLE:
+    {
+      CStreamDetailSubtitle *p = new CStreamDetailSubtitle();
+      p->m_strLanguage = pDS->fv(9).get_asString();
+      details.AddStream(p);
+      return true;
+    }
+  }
+  return false;
+}
  
 bool CVideoDatabase::GetResumePoint(CVideoInfoTag& tag)
 {
@@ -3953,6 +4066,154 @@ CVideoInfoTag CVideoDatabase::GetDetailsForMusicVideo(const dbiplus::sql_record*
   return details;
 }
 
+bool CVideoDatabase::GetDetailsForItems(CFileItemList &items)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS2.get()) return false;
+
+    // an id may be in the list more than once
+    VideoInfoTagMap movies, episodes, musicVideos, files;
+    set<int> showIds;
+    for (int i = 0; i < items.Size(); i++)
+    {
+      if (!items[i]->HasVideoInfoTag())
+        continue;
+      CVideoInfoTag *tag = items[i]->GetVideoInfoTag();
+      if (tag->m_iDbId < 0)
+        continue;
+
+      if (tag->m_type == MediaTypeMovie)
+        movies.insert(make_pair(tag->m_iDbId, tag));
+      else if (tag->m_type == MediaTypeEpisode)
+      {
+        episodes.insert(make_pair(tag->m_iDbId, tag));
+        if (tag->m_iIdShow >= 0)
+          showIds.insert(tag->m_iIdShow);
+      }
+      else if (tag->m_type == MediaTypeMusicVideo)
+        musicVideos.insert(make_pair(tag->m_iDbId, tag));
+      else
+        continue;
+
+      tag->m_cast.clear();
+      tag->m_tags.clear();
+      tag->m_showLink.clear();
+      tag->m_streamDetails.Reset();
+      tag->m_strPictureURL.Parse();
+      if (tag->m_iFileId >= 0)
+        files.insert(make_pair(tag->m_iFileId, tag));
+    }
+
+    // cast, episodes get the cast of their show after their own
+    map<int, vector<SActorInfo> > movieCast, episodeCast, showCast;
+    GetCast("movie", "idMovie", GetIds(movies), movieCast);
+    GetCast("episode", "idEpisode", GetIds(episodes), episodeCast);
+    GetCast("tvshow", "idShow", showIds, showCast);
+    for (VideoInfoTagMap::const_iterator it = movies.begin(); it != movies.end(); ++it)
+      it->second->m_cast = movieCast[it->first];
+    for (VideoInfoTagMap::const_iterator it = episodes.begin(); it != episodes.end(); ++it)
+    {
+      vector<SActorInfo> &itemCast = it->second->m_cast;
+      itemCast = episodeCast[it->first];
+      const vector<SActorInfo> &actors = showCast[it->second->m_iIdShow];
+      for (vector<SActorInfo>::const_iterator actor = actors.begin(); actor != actors.end(); ++actor)
+      {
+        if (!HasActor(itemCast, actor->strName))
+          itemCast.push_back(*actor);
+      }
+    }
+
+    GetTagsForItems(movies, MediaTypeMovie);
+    GetTagsForItems(musicVideos, MediaTypeMusicVideo);
+
+    vector<string> idLists = SplitIdList(GetIds(movies));
+    for (vector<string>::const_iterator list = idLists.begin(); list != idLists.end(); ++list)
+    {
+      CStdString strSQL = PrepareSQL("SELECT movielinktvshow.idMovie, tvshow.c%02d FROM movielinktvshow JOIN tvshow ON tvshow.idShow=movielinktvshow.idShow WHERE movielinktvshow.idMovie IN (%s)", VIDEODB_ID_TV_TITLE, list->c_str());
+      m_pDS2->query(strSQL.c_str());
+      while (!m_pDS2->eof())
+      {
+        pair<VideoInfoTagMap::const_iterator, VideoInfoTagMap::const_iterator> range = movies.equal_range(m_pDS2->fv(0).get_asInt());
+        for (VideoInfoTagMap::const_iterator it = range.first; it != range.second; ++it)
+          it->second->m_showLink.push_back(m_pDS2->fv(1).get_asString());
+        m_pDS2->next();
+      }
+      m_pDS2->close();
+    }
+
+    idLists = SplitIdList(GetIds(episodes));
+    for (vector<string>::const_iterator list = idLists.begin(); list != idLists.end(); ++list)
+    {
+      CStdString strSQL = PrepareSQL("SELECT episode.idEpisode, bookmark.timeInSeconds FROM bookmark JOIN episode ON episode.c%02d=bookmark.idBookmark WHERE bookmark.type=%i AND episode.idEpisode IN (%s)", VIDEODB_ID_EPISODE_BOOKMARK, CBookmark::EPISODE, list->c_str());
+      m_pDS2->query(strSQL.c_str());
+      while (!m_pDS2->eof())
+      {
+        pair<VideoInfoTagMap::const_iterator, VideoInfoTagMap::const_iterator> range = episodes.equal_range(m_pDS2->fv(0).get_asInt());
+        for (VideoInfoTagMap::const_iterator it = range.first; it != range.second; ++it)
+          it->second->m_fEpBookmark = m_pDS2->fv(1).get_asFloat();
+        m_pDS2->next();
+      }
+      m_pDS2->close();
+    }
+
+    idLists = SplitIdList(GetIds(files));
+    for (vector<string>::const_iterator list = idLists.begin(); list != idLists.end(); ++list)
+    {
+      CStdString strSQL = PrepareSQL("SELECT * FROM streamdetails WHERE idFile IN (%s)", list->c_str());
+      m_pDS2->query(strSQL.c_str());
+      while (!m_pDS2->eof())
+      {
+        pair<VideoInfoTagMap::const_iterator, VideoInfoTagMap::const_iterator> range = files.equal_range(m_pDS2->fv(0).get_asInt());
+        for (VideoInfoTagMap::const_iterator it = range.first; it != range.second; ++it)
+          AddStreamDetail(it->second->m_streamDetails, m_pDS2);
+        m_pDS2->next();
+      }
+      m_pDS2->close();
+    }
+    for (VideoInfoTagMap::const_iterator it = files.begin(); it != files.end(); ++it)
+    {
+      CStreamDetails &details = it->second->m_streamDetails;
+      details.DetermineBestStreams();
+      if (details.GetVideoDuration() > 0)
+        it->second->m_duration = details.GetVideoDuration();
+    }
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
+void CVideoDatabase::GetTagsForItems(const VideoInfoTagMap &tags, const MediaType &mediaType)
+{
+  vector<string> idLists = SplitIdList(GetIds(tags));
+  for (vector<string>::const_iterator list = idLists.begin(); list != idLists.end(); ++list)
+  {
+    CStdString strSQL = PrepareSQL("SELECT taglinks.idMedia, tag.strTag FROM tag, taglinks WHERE taglinks.media_type = '%s' AND taglinks.idTag = tag.idTag AND taglinks.idMedia IN (%s) ORDER BY taglinks.idMedia, tag.idTag", mediaType.c_str(), list->c_str());
+    m_pDS2->query(strSQL.c_str());
+    while (!m_pDS2->eof())
+    {
+      pair<VideoInfoTagMap::const_iterator, VideoInfoTagMap::const_iterator> range = tags.equal_range(m_pDS2->fv(0).get_asInt());
+      for (VideoInfoTagMap::const_iterator it = range.first; it != range.second; ++it)
+        it->second->m_tags.push_back(m_pDS2->fv(1).get_asString());
+      m_pDS2->next();
+    }
+    m_pDS2->close();
+  }
+}
+
+set<int> CVideoDatabase::GetIds(const VideoInfoTagMap &tags)
+{
+  set<int> ids;
+  for (VideoInfoTagMap::const_iterator it = tags.begin(); it != tags.end(); ++it)
+    ids.insert(it->first);
+  return ids;
+}
+
 void CVideoDatabase::GetCast(const CStdString &table, const CStdString &table_id, int type_id, vector<SActorInfo> &cast)
 {
   try
@@ -3977,16 +4238,7 @@ void CVideoDatabase::GetCast(const CStdString &table, const CStdString &table_id
     {
       SActorInfo info;
       info.strName = m_pDS2->fv(0).get_asString();
-      bool found = false;
-      for (vector<SActorInfo>::iterator i = cast.begin(); i != cast.end(); ++i)
-      {
-        if (i->strName == info.strName)
-        {
-          found = true;
-          break;
-        }
-      }
-      if (!found)
+      if (!HasActor(cast, info.strName))
       {
         info.strRole = m_pDS2->fv(1).get_asString();
         info.order = m_pDS2->fv(2).get_asInt();
@@ -4004,6 +4256,66 @@ void CVideoDatabase::GetCast(const CStdString &table, const CStdString &table_id
   }
 }
 
+void CVideoDatabase::GetCast(const CStdString &table, const CStdString &table_id, const set<int> &ids, map<int, vector<SActorInfo> > &cast)
+{
+  try
+  {
+    if (!m_pDB.get()) return;
+    if (!m_pDS2.get()) return;
+
+    vector<string> idLists = SplitIdList(ids);
+    for (vector<string>::const_iterator list = idLists.begin(); list != idLists.end(); ++list)
+    {
+      CStdString sql = PrepareSQL("SELECT actorlink%s.%s,"
+                                  "  actors.strActor,"
+                                  "  actorlink%s.strRole,"
+                                  "  actorlink%s.iOrder,"
+                                  "  actors.strThumb,"
+                                  "  art.url "
+                                  "FROM actorlink%s"
+                                  "  JOIN actors ON"
+                                  "    actorlink%s.idActor=actors.idActor"
+                                  "  LEFT JOIN art ON"
+                                  "    art.media_id=actors.idActor AND art.media_type='actor' AND art.type='thumb' "
+                                  "WHERE actorlink%s.%s IN (%s) "
+                                  "ORDER BY actorlink%s.%s, actorlink%s.iOrder",
+                                  table.c_str(), table_id.c_str(), table.c_str(), table.c_str(), table.c_str(), table.c_str(),
+                                  table.c_str(), table_id.c_str(), list->c_str(), table.c_str(), table_id.c_str(), table.c_str());
+      m_pDS2->query(sql.c_str());
+      while (!m_pDS2->eof())
+      {
+        vector<SActorInfo> &itemCast = cast[m_pDS2->fv(0).get_asInt()];
+        SActorInfo info;
+        info.strName = m_pDS2->fv(1).get_asString();
+        if (!HasActor(itemCast, info.strName))
+        {
+          info.strRole = m_pDS2->fv(2).get_asString();
+          info.order = m_pDS2->fv(3).get_asInt();
+          info.thumbUrl.ParseString(m_pDS2->fv(4).get_asString());
+          info.thumb = m_pDS2->fv(5).get_asString();
+          itemCast.push_back(info);
+        }
+        m_pDS2->next();
+      }
+      m_pDS2->close();
+    }
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s(%s,%s) failed", __FUNCTION__, table.c_str(), table_id.c_str());
+  }
+}
+
+bool CVideoDatabase::HasActor(const vector<SActorInfo> &cast, const string &name)
+{
+  for (vector<SActorInfo>::const_iterator i = cast.begin(); i != cast.end(); ++i)
+  {
+    if (i->strName == name)
+      return true;
+  }
+  return false;
+}
+
 /// \brief GetVideoSettings() obtains any saved video settings for the current file.
 /// \retval Returns true if the settings exist, false otherwise.
 bool CVideoDatabase::GetVideoSettings(const CStdString &strFilenameAndPath, CVideoSettings &settings)
@@ -4176,8 +4488,7 @@ bool CVideoDatabase::GetArtForItem(int mediaId, const MediaType &mediaType, map<
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS2.get()) return false; // using dataset 2 as we're likely called in loops on dataset 1
 
-    CStdString sql = PrepareSQL("SELECT type,url FROM art WHERE media_id=%i AND media_type='%s'", mediaId, mediaType.c_str());
-    m_pDS2->query(sql.c_str());
+    m_pDS2->query_bind("SELECT type,url FROM art WHERE media_id=? AND media_type=?", BindParams().add(mediaId).add(mediaType));
     while (!m_pDS2->eof())
     {
       art.insert(make_pair(m_pDS2->fv(0).get_asString(), m_pDS2->fv(1).get_asString()));
@@ -4195,8 +4506,50 @@ bool CVideoDatabase::GetArtForItem(int mediaId, const MediaType &mediaType, map<
 
 string CVideoDatabase::GetArtForItem(int mediaId, const MediaType &mediaType, const string &artType)
 {
-  std::string query = PrepareSQL("SELECT url FROM art WHERE media_id=%i AND media_type='%s' AND type='%s'", mediaId, mediaType.c_str(), artType.c_str());
-  return GetSingleValue(query, m_pDS2);
+  std::string url;
+  try
+  {
+    if (NULL == m_pDB.get()) return url;
+    if (NULL == m_pDS2.get()) return url;
+
+    m_pDS2->query_bind("SELECT url FROM art WHERE media_id=? AND media_type=? AND type=?", BindParams().add(mediaId).add(mediaType).add(artType));
+    if (!m_pDS2->eof())
+      url = m_pDS2->fv(0).get_asString();
+    m_pDS2->close();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s(%d, '%s', '%s') failed", __FUNCTION__, mediaId, mediaType.c_str(), artType.c_str());
+  }
+  return url;
+}
+
+bool CVideoDatabase::GetArtForItems(const set<int> &mediaIds, const MediaType &mediaType, map<int, map<string, string> > &art)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS2.get()) return false;
+
+    vector<string> idLists = SplitIdList(mediaIds);
+    for (vector<string>::const_iterator list = idLists.begin(); list != idLists.end(); ++list)
+    {
+      CStdString sql = PrepareSQL("SELECT media_id,type,url FROM art WHERE media_type='%s' AND media_id IN (%s)", mediaType.c_str(), list->c_str());
+      m_pDS2->query(sql.c_str());
+      while (!m_pDS2->eof())
+      {
+        art[m_pDS2->fv(0).get_asInt()].insert(make_pair(m_pDS2->fv(1).get_asString(), m_pDS2->fv(2).get_asString()));
+        m_pDS2->next();
+      }
+      m_pDS2->close();
+    }
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s('%s') failed", __FUNCTION__, mediaType.c_str());
+  }
+  return false;
 }
 
 bool CVideoDatabase::RemoveArtForItem(int mediaId, const MediaType &mediaType, const std::string &artType)
@@ -4310,6 +4663,48 @@ bool CVideoDatabase::GetStackTimes(const CStdString &filePath, vector<int> &time
   return false;
 }
 
+bool CVideoDatabase::GetKeyframeIndex(const std::string &filePath, std::string &keyframes)
+{
+  try
+  {
+    int idFile = GetFileId(filePath);
+    if (idFile < 0) return false;
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    m_pDS->query(PrepareSQL("select keyframes from keyframeindex where idFile=%i\n", idFile).c_str());
+    bool found = m_pDS->num_rows() > 0;
+    if (found)
+      keyframes = m_pDS->fv("keyframes").get_asString();
+    m_pDS->close();
+    return found;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, filePath.c_str());
+  }
+  return false;
+}
+
+void CVideoDatabase::SetKeyframeIndex(const std::string &filePath, const std::string &keyframes)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return ;
+    if (NULL == m_pDS.get()) return ;
+    int idFile = AddFile(filePath);
+    if (idFile < 0)
+      return;
+
+    m_pDS->exec(PrepareSQL("delete from keyframeindex where idFile=%i", idFile));
+    m_pDS->exec(PrepareSQL("insert into keyframeindex (idFile,keyframes) values (%i,'%s')\n", idFile, keyframes.c_str()));
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, filePath.c_str());
+  }
+}
+
 /// \brief Sets the stack times for a particular video file
 void CVideoDatabase::SetStackTimes(const CStdString& filePath, vector<int> &times)
 {
@@ -4793,11 +5188,22 @@ void CVideoDatabase::UpdateTables(int iVersion)
     m_pDS->exec("DELETE from art WHERE media_type='tvshow' AND NOT EXISTS (SELECT 1 FROM tvshow WHERE tvshow.idShow = art.media_id)");
     m_pDS->exec("DELETE from art WHERE media_type='season' AND NOT EXISTS (SELECT 1 FROM seasons WHERE seasons.idSeason = art.media_id)");
   }
+  if (iVersion < 91)
+    m_pDS->exec("CREATE TABLE keyframeindex (idFile integer, keyframes longtext)\n");
+  if (iVersion < 92)
+  {
+    if (CreateSearchTables())
+    {
+      CLog::Log(LOGINFO, "%s - filling search tables", __FUNCTION__);
+      for (int i = 0; i < VIDEOSEARCH_COUNT; i++)
+        CFullTextSearch::Fill(*m_pDS, VideoSearchIndexes[i]);
+    }
+  }
 }
 
 int CVideoDatabase::GetSchemaVersion() const
 {
-  return 90;
+  return 92;
 }
 
 bool CVideoDatabase::LookupByFolders(const CStdString &path, bool shows)
@@ -6281,28 +6687,29 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const Filter
 
     strSQL = PrepareSQL(strSQL, !extFilter.fields.empty() ? extFilter.fields.c_str() : "*") + strSQLExtra;
 
-    int iRowsFound = RunQuery(strSQL);
+    // without sorting the rows are used in the order they come in, so they
+    // are fetched one at a time rather than all held in memory
+    bool streaming = sortDescription.sortBy == SortByNone;
+
+    int iRowsFound = streaming ? RunQueryStream(strSQL) : RunQuery(strSQL);
     if (iRowsFound <= 0)
       return iRowsFound == 0;
 
-    // store the total value of items as a property
-    if (total < iRowsFound)
-      total = iRowsFound;
-    items.SetProperty("total", total);
-    
     DatabaseResults results;
-    results.reserve(iRowsFound);
-
-    if (!SortUtils::SortFromDataset(sortDescription, MediaTypeMovie, m_pDS, results))
-      return false;
+    if (!streaming)
+    {
+      results.reserve(iRowsFound);
+      if (!SortUtils::SortFromDataset(sortDescription, MediaTypeMovie, m_pDS, results))
+        return false;
+      items.Reserve(results.size());
+    }
 
     // get data from returned rows
-    items.Reserve(results.size());
     const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    DatabaseResults::const_iterator it = results.begin();
+    while (streaming ? !m_pDS->eof() : it != results.end())
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
-      const dbiplus::sql_record* const record = data.at(targetRow);
+      const dbiplus::sql_record* const record = streaming ? m_pDS->get_sql_record() : data.at((unsigned int)(it++)->at(FieldRow).asInteger());
 
       CVideoInfoTag movie = GetDetailsForMovie(record);
       if (CProfilesManager::Get().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
@@ -6319,8 +6726,17 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const Filter
         pItem->SetOverlayImage(CGUIListItem::ICON_OVERLAY_UNWATCHED,movie.m_playCount > 0);
         items.Add(pItem);
       }
+
+      if (streaming)
+        m_pDS->next();
     }
 
+    // store the total value of items as a property
+    iRowsFound = m_pDS->num_rows();
+    if (total < iRowsFound)
+      total = iRowsFound;
+    items.SetProperty("total", total);
+
     // cleanup
     m_pDS->close();
     return true;
@@ -7538,10 +7954,15 @@ void CVideoDatabase::GetMoviesByName(const CStdString& strSearch, CFileItemList&
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string where = GetSearchFilter(VIDEOSEARCH_MOVIES, strSearch);
+    if (!where.empty())
+      where += " and ";
+    where += PrepareSQL("(movie.c%02d like '%s%%' or movie.c%02d like '%% %s%%')",VIDEODB_ID_TITLE,strSearch.c_str(),VIDEODB_ID_TITLE,strSearch.c_str());
+
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d,path.strPath, movie.idSet from movie,files,path where files.idFile=movie.idFile and files.idPath=path.idPath and movie.c%02d like '%%%s%%'",VIDEODB_ID_TITLE,VIDEODB_ID_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d,path.strPath, movie.idSet from movie,files,path where files.idFile=movie.idFile and files.idPath=path.idPath and ",VIDEODB_ID_TITLE) + where;
     else
-      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d, movie.idSet from movie where movie.c%02d like '%%%s%%'",VIDEODB_ID_TITLE,VIDEODB_ID_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d, movie.idSet from movie where ",VIDEODB_ID_TITLE) + where;
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7583,10 +8004,15 @@ void CVideoDatabase::GetTvShowsByName(const CStdString& strSearch, CFileItemList
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string where = GetSearchFilter(VIDEOSEARCH_TVSHOWS, strSearch);
+    if (!where.empty())
+      where += " and ";
+    where += PrepareSQL("(tvshow.c%02d like '%s%%' or tvshow.c%02d like '%% %s%%')",VIDEODB_ID_TV_TITLE,strSearch.c_str(),VIDEODB_ID_TV_TITLE,strSearch.c_str());
+
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d,path.strPath from tvshow,path,tvshowlinkpath where tvshowlinkpath.idPath=path.idPath and tvshowlinkpath.idShow=tvshow.idShow and tvshow.c%02d like '%%%s%%'",VIDEODB_ID_TV_TITLE,VIDEODB_ID_TV_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d,path.strPath from tvshow,path,tvshowlinkpath where tvshowlinkpath.idPath=path.idPath and tvshowlinkpath.idShow=tvshow.idShow and ",VIDEODB_ID_TV_TITLE) + where;
     else
-      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d from tvshow where tvshow.c%02d like '%%%s%%'",VIDEODB_ID_TV_TITLE,VIDEODB_ID_TV_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d from tvshow where ",VIDEODB_ID_TV_TITLE) + where;
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7624,10 +8050,15 @@ void CVideoDatabase::GetEpisodesByName(const CStdString& strSearch, CFileItemLis
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string where = GetSearchFilter(VIDEOSEARCH_EPISODES, strSearch);
+    if (!where.empty())
+      where += " and ";
+    where += PrepareSQL("(episode.c%02d like '%s%%' or episode.c%02d like '%% %s%%')",VIDEODB_ID_EPISODE_TITLE,strSearch.c_str(),VIDEODB_ID_EPISODE_TITLE,strSearch.c_str());
+
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d,path.strPath from episode,files,path,tvshow where files.idFile=episode.idFile and episode.idShow=tvshow.idShow and files.idPath=path.idPath and episode.c%02d like '%%%s%%'",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE,VIDEODB_ID_EPISODE_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d,path.strPath from episode,files,path,tvshow where files.idFile=episode.idFile and episode.idShow=tvshow.idShow and files.idPath=path.idPath and ",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE) + where;
     else
-      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d from episode,tvshow where tvshow.idShow=episode.idShow and episode.c%02d like '%%%s%%'",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE,VIDEODB_ID_EPISODE_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d from episode,tvshow where tvshow.idShow=episode.idShow and ",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE) + where;
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7667,10 +8098,15 @@ void CVideoDatabase::GetMusicVideosByName(const CStdString& strSearch, CFileItem
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string where = GetSearchFilter(VIDEOSEARCH_MUSICVIDEOS, strSearch);
+    if (!where.empty())
+      where += " and ";
+    where += PrepareSQL("(musicvideo.c%02d like '%s%%' or musicvideo.c%02d like '%% %s%%')",VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str(),VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d,path.strPath from musicvideo,files,path where files.idFile=musicvideo.idFile and files.idPath=path.idPath and musicvideo.c%02d like '%%%s%%'",VIDEODB_ID_MUSICVIDEO_TITLE,VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d,path.strPath from musicvideo,files,path where files.idFile=musicvideo.idFile and files.idPath=path.idPath and ",VIDEODB_ID_MUSICVIDEO_TITLE) + where;
     else
-      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where musicvideo.c%02d like '%%%s%%'",VIDEODB_ID_MUSICVIDEO_TITLE,VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where ",VIDEODB_ID_MUSICVIDEO_TITLE) + where;
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7714,10 +8150,15 @@ void CVideoDatabase::GetEpisodesByPlot(const CStdString& strSearch, CFileItemLis
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string where = GetSearchFilter(VIDEOSEARCH_EPISODES, strSearch);
+    if (!where.empty())
+      where += " and ";
+    where += PrepareSQL("(episode.c%02d like '%s%%' or episode.c%02d like '%% %s%%')",VIDEODB_ID_EPISODE_PLOT,strSearch.c_str(),VIDEODB_ID_EPISODE_PLOT,strSearch.c_str());
+
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d,path.strPath from episode,files,path,tvshow where files.idFile=episode.idFile and files.idPath=path.idPath and tvshow.idShow=episode.idShow and episode.c%02d like '%%%s%%'",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE,VIDEODB_ID_EPISODE_PLOT,strSearch.c_str());
+      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d,path.strPath from episode,files,path,tvshow where files.idFile=episode.idFile and files.idPath=path.idPath and tvshow.idShow=episode.idShow and ",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE) + where;
     else
-      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d from episode,tvshow where tvshow.idShow=episode.idShow and episode.c%02d like '%%%s%%'",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE,VIDEODB_ID_EPISODE_PLOT,strSearch.c_str());
+      strSQL = PrepareSQL("select episode.idEpisode,episode.c%02d,episode.c%02d,episode.idShow,tvshow.c%02d from episode,tvshow where tvshow.idShow=episode.idShow and ",VIDEODB_ID_EPISODE_TITLE,VIDEODB_ID_EPISODE_SEASON,VIDEODB_ID_TV_TITLE) + where;
     m_pDS->query( strSQL.c_str() );
 
     while (!m_pDS->eof())
@@ -7753,10 +8194,18 @@ void CVideoDatabase::GetMoviesByPlot(const CStdString& strSearch, CFileItemList&
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::string where = GetSearchFilter(VIDEOSEARCH_MOVIES, strSearch);
+    if (!where.empty())
+      where += " and ";
+    where += PrepareSQL("(movie.c%02d like '%s%%' or movie.c%02d like '%% %s%%' or movie.c%02d like '%s%%' or movie.c%02d like '%% %s%%' or movie.c%02d like '%s%%' or movie.c%02d like '%% %s%%')",
+                        VIDEODB_ID_PLOT,strSearch.c_str(),VIDEODB_ID_PLOT,strSearch.c_str(),
+                        VIDEODB_ID_PLOTOUTLINE,strSearch.c_str(),VIDEODB_ID_PLOTOUTLINE,strSearch.c_str(),
+                        VIDEODB_ID_TAGLINE,strSearch.c_str(),VIDEODB_ID_TAGLINE,strSearch.c_str());
+
     if (CProfilesManager::Get().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("select movie.idMovie, movie.c%02d, path.strPath from movie,files,path where files.idFile=movie.idFile and files.idPath=path.idPath and (movie.c%02d like '%%%s%%' or movie.c%02d like '%%%s%%' or movie.c%02d like '%%%s%%')",VIDEODB_ID_TITLE,VIDEODB_ID_PLOT,strSearch.c_str(),VIDEODB_ID_PLOTOUTLINE,strSearch.c_str(),VIDEODB_ID_TAGLINE,strSearch.c_str());
+      strSQL = PrepareSQL("select movie.idMovie, movie.c%02d, path.strPath from movie,files,path where files.idFile=movie.idFile and files.idPath=path.idPath and ",VIDEODB_ID_TITLE) + where;
     else
-      strSQL = PrepareSQL("select movie.idMovie, movie.c%02d from movie where (movie.c%02d like '%%%s%%' or movie.c%02d like '%%%s%%' or movie.c%02d like '%%%s%%')",VIDEODB_ID_TITLE,VIDEODB_ID_PLOT,strSearch.c_str(),VIDEODB_ID_PLOTOUTLINE,strSearch.c_str(),VIDEODB_ID_TAGLINE,strSearch.c_str());
+      strSQL = PrepareSQL("select movie.idMovie, movie.c%02d from movie where ",VIDEODB_ID_TITLE) + where;
 
     m_pDS->query( strSQL.c_str() );
 
@@ -7786,6 +8235,67 @@ void CVideoDatabase::GetMoviesByPlot(const CStdString& strSearch, CFileItemList&
   }
 }
 
+// the items found by RankedSearch(), by search table
+static const struct
+{
+  const char *mediaType;
+  const char *path;
+} rankedSearches[VIDEOSEARCH_COUNT] =
+{
+  { MediaTypeMovie,      "videodb://movies/titles/%i" },
+  { MediaTypeTvShow,     "videodb://tvshows/titles/%i/" },
+  { MediaTypeEpisode,    "videodb://tvshows/titles/-1/-1/%i" },
+  { MediaTypeMusicVideo, "videodb://musicvideos/titles/%i" }
+};
+
+static bool RankBefore(const pair<int, CFileItemPtr> &left, const pair<int, CFileItemPtr> &right)
+{
+  return left.first < right.first;
+}
+
+bool CVideoDatabase::RankedSearch(const std::string& search, CFileItemList &items)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    unsigned int time = XbmcThreads::SystemClockMillis();
+    vector< pair<int, CFileItemPtr> > ranked;
+    for (int i = 0; i < VIDEOSEARCH_COUNT; i++)
+    {
+      // every word has to match, the titles are searched instead if the index can't match them all
+      std::string strSQL = CFullTextSearch::GetRankedQuery(*m_pDB, m_sqlite, VideoSearchIndexes[i], search, HasSearchIndex());
+      strSQL += PrepareSQL(" ORDER BY iRank, %s LIMIT %i", VideoSearchIndexes[i].nameColumn, VIDEODB_SEARCH_RESULTS_LIMIT);
+
+      if (!m_pDS->query(strSQL.c_str()))
+        return false;
+      while (!m_pDS->eof())
+      {
+        int id = m_pDS->fv(0).get_asInt();
+        CFileItemPtr item(new CFileItem(StringUtils::Format(rankedSearches[i].path, id), i == VIDEOSEARCH_TVSHOWS));
+        item->SetLabel(m_pDS->fv(1).get_asString());
+        item->GetVideoInfoTag()->m_iDbId = id;
+        item->GetVideoInfoTag()->m_type = rankedSearches[i].mediaType;
+        ranked.push_back(make_pair(m_pDS->fv(2).get_asInt(), item));
+        m_pDS->next();
+      }
+      m_pDS->close();
+    }
+
+    stable_sort(ranked.begin(), ranked.end(), RankBefore);
+    for (vector< pair<int, CFileItemPtr> >::const_iterator it = ranked.begin(); it != ranked.end(); ++it)
+      items.Add(it->second);
+    CLog::Log(LOGDEBUG, "%s found %u items in %u ms", __FUNCTION__, (unsigned int)ranked.size(), XbmcThreads::SystemClockMillis() - time);
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s(%s) failed", __FUNCTION__, search.c_str());
+  }
+  return false;
+}
+
 void CVideoDatabase::GetMovieDirectorsByName(const CStdString& strSearch, CFileItemList& items)
 {
   CStdString strSQL;
@@ -8069,6 +8579,10 @@ void CVideoDatabase::CleanDatabase(CGUIDialogProgressBarHandle* handle, const se
       CLog::Log(LOGDEBUG, "%s: Cleaning stacktimes table", __FUNCTION__);
       sql = "DELETE FROM stacktimes WHERE idFile IN " + filesToDelete;
       m_pDS->exec(sql.c_str());
+
+      CLog::Log(LOGDEBUG, "%s: Cleaning keyframeindex table", __FUNCTION__);
+      sql = "DELETE FROM keyframeindex WHERE idFile IN " + filesToDelete;
+      m_pDS->exec(sql.c_str());
     }
 
     if (!movieIDs.empty())
@@ -24,6 +24,7 @@
 #include "Bookmark.h"
 #include "utils/SortUtils.h"
 #include "video/VideoDbUrl.h"
+#include "video/VideoSearchIndex.h"
 
 #include <memory>
 #include <set>
@@ -36,8 +37,7 @@ class CGUIDialogProgressBarHandle;
 
 namespace dbiplus
 {
-  class field_value;
-  typedef std::vector<field_value> sql_record;
+  class sql_record;
 }
 
 #ifndef my_offsetof
@@ -449,6 +449,14 @@ public:
   bool GetSeasonInfo(int idSeason, CVideoInfoTag& details);
   bool GetEpisodeInfo(const CStdString& strFilenameAndPath, CVideoInfoTag& details, int idEpisode = -1);
   bool GetMusicVideoInfo(const CStdString& strFilenameAndPath, CVideoInfoTag& details, int idMVideo=-1);
+
+  /*! \brief Get what GetMovieInfo(), GetEpisodeInfo() and GetMusicVideoInfo() add to the details of a list of items
+   The items are expected to come from GetMoviesByWhere() etc., this fills in their cast, tags, links to tvshows,
+   episode bookmarks and stream details with a few queries for the whole list rather than a few per item.
+   \param items the items to fill in, items other than movies, episodes and music videos are left alone.
+   \return true if the details were fetched, false otherwise.
+   */
+  bool GetDetailsForItems(CFileItemList& items);
   bool GetSetInfo(int idSet, CVideoInfoTag& details);
   bool GetFileInfo(const CStdString& strFilenameAndPath, CVideoInfoTag& details, int idFile = -1);
 
@@ -517,6 +525,14 @@ public:
   bool GetStackTimes(const CStdString &filePath, std::vector<int> &times);
   void SetStackTimes(const CStdString &filePath, std::vector<int> &times);
 
+  /*!
+   \brief Get the keyframe index the player built for a file
+   \param keyframes the index as stored by CDVDDemuxKeyframeIndex::Serialize().
+   \return true if there's an index for the file.
+   */
+  bool GetKeyframeIndex(const std::string &filePath, std::string &keyframes);
+  void SetKeyframeIndex(const std::string &filePath, const std::string &keyframes);
+
   void GetBookMarksForFile(const CStdString& strFilenameAndPath, VECBOOKMARKS& bookmarks, CBookmark::EType type = CBookmark::STANDARD, bool bAppend=false, long partNumber=0);
   void AddBookMarkToFile(const CStdString& strFilenameAndPath, const CBookmark &bookmark, CBookmark::EType type = CBookmark::STANDARD);
   bool GetResumeBookMark(const CStdString& strFilenameAndPath, CBookmark &bookmark);
@@ -628,6 +644,18 @@ public:
   void GetEpisodesByPlot(const CStdString& strSearch, CFileItemList& items);
   void GetMoviesByPlot(const CStdString& strSearch, CFileItemList& items);
 
+  /*! \brief Search movies, tv shows, episodes and music videos, best matches first
+   Every word of the search has to start a word of the title, the plot or the cast of an item.
+   Items titled like the search come first, then those whose title starts with it, those with a word of the title
+   starting with it and last the ones matching on the other fields. Ties keep movies before tv shows before
+   episodes before music videos. Only the titles are searched without the full text index, or if it can't match
+   every word.
+   \param search the words to search for.
+   \param items [out] the items found, labelled with their title.
+   \return true if the search succeeded, false otherwise.
+   */
+  bool RankedSearch(const std::string& search, CFileItemList &items);
+
   bool LinkMovieToTvshow(int idMovie, int idShow, bool bRemove);
   bool IsLinkedToTvshow(int idMovie);
   bool GetLinksToTvShow(int idMovie, std::vector<int>& ids);
@@ -744,6 +772,14 @@ public:
   void SetArtForItem(int mediaId, const MediaType &mediaType, const std::map<std::string, std::string> &art);
   bool GetArtForItem(int mediaId, const MediaType &mediaType, std::map<std::string, std::string> &art);
   std::string GetArtForItem(int mediaId, const MediaType &mediaType, const std::string &artType);
+
+  /*! \brief Get the art of many items of one media type at once
+   \param mediaIds the ids of the items.
+   \param mediaType the type of the items.
+   \param art the art of each item by its id, items without art are left out.
+   \return true if the art was fetched, false otherwise.
+   */
+  bool GetArtForItems(const std::set<int> &mediaIds, const MediaType &mediaType, std::map<int, std::map<std::string, std::string> > &art);
   bool RemoveArtForItem(int mediaId, const MediaType &mediaType, const std::string &artType);
   bool RemoveArtForItem(int mediaId, const MediaType &mediaType, const std::set<std::string> &artTypes);
   bool GetTvShowSeasonArt(int mediaId, std::map<int, std::map<std::string, std::string> > &seasonArt);
@@ -845,6 +881,13 @@ protected:
   bool GetPeopleNav(const CStdString& strBaseDir, CFileItemList& items, const CStdString& type, int idContent=-1, const Filter &filter = Filter(), bool countOnly = false);
   bool GetNavCommon(const CStdString& strBaseDir, CFileItemList& items, const CStdString& type, int idContent=-1, const Filter &filter = Filter(), bool countOnly = false);
   void GetCast(const CStdString &table, const CStdString &table_id, int type_id, std::vector<SActorInfo> &cast);
+  void GetCast(const CStdString &table, const CStdString &table_id, const std::set<int> &ids, std::map<int, std::vector<SActorInfo> > &cast);
+  static bool HasActor(const std::vector<SActorInfo> &cast, const std::string &name);
+  static bool AddStreamDetail(CStreamDetails& details, const std::auto_ptr<dbiplus::Dataset> &pDS);
+
+  typedef std::multimap<int, CVideoInfoTag*> VideoInfoTagMap;
+  void GetTagsForItems(const VideoInfoTagMap &tags, const MediaType &mediaType);
+  static std::set<int> GetIds(const VideoInfoTagMap &tags);
 
   void GetDetailsFromDB(std::auto_ptr<dbiplus::Dataset> &pDS, int min, int max, const SDbTableOffsets *offsets, CVideoInfoTag &details, int idxOffset = 2);
   void GetDetailsFromDB(const dbiplus::sql_record* const record, int min, int max, const SDbTableOffsets *offsets, CVideoInfoTag &details, int idxOffset = 2);
@@ -855,6 +898,30 @@ private:
   virtual void CreateAnalytics();
   virtual void UpdateTables(int version);
 
+  /*! \brief Create the tables of the full text search index
+   \return false if the database doesn't support full text search, searches go without the index then.
+   */
+  bool CreateSearchTables();
+
+  /*! \brief Create the triggers keeping the full text search index up to date, and its FULLTEXT indexes on MySQL
+   */
+  void CreateSearchAnalytics();
+
+  /*! \brief Whether the full text search index can be used, checked once per connection
+   */
+  bool HasSearchIndex();
+
+  /*! \brief Get a condition narrowing down the movies, tv shows, episodes or music videos for a search with the full text index
+   Every word of the search has to start a word of the indexed columns, the items found are a superset of the
+   ones found by the LIKE conditions on their title or plot.
+   \param index the search table of the items.
+   \param search the words to search for.
+   \return the condition for the WHERE clause, qualified with the table of the items, empty if the index can't be used for the search.
+   */
+  std::string GetSearchFilter(VideoSearchIndex index, const std::string &search);
+
+  int m_searchIndex; ///< whether the full text search index can be used, -1 until checked
+
   /*! \brief (Re)Create the generic database views for movies, tvshows,
      episodes and music videos
    */
@@ -873,6 +940,7 @@ private:
    \return the number of rows, -1 for an error.
    */
   int RunQuery(const CStdString &sql);
+  int RunQueryStream(const CStdString &sql);
 
   /*! \brief Determine whether the path is using lookup using folders
    \param path the path to check
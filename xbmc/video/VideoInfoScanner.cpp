@@ -47,6 +47,7 @@
 #include "utils/URIUtils.h"
 #include "utils/Variant.h"
 #include "video/VideoThumbLoader.h"
+#include "video/KeyframeIndexJob.h"
 #include "TextureCache.h"
 #include "GUIUserMessages.h"
 #include "URL.h"
@@ -1241,6 +1242,9 @@ namespace VIDEO
 
     m_database.Close();
 
+    if (g_advancedSettings.m_bVideoLibraryKeyframeIndex && lResult >= 0 && !pItem->m_bIsFolder)
+      CKeyframeIndexQueue::Get().AddJob(new CKeyframeIndexJob(pItem->GetPath()));
+
     CFileItemPtr itemCopy = CFileItemPtr(new CFileItem(*pItem));
     CVariant data;
     if (IsScanning())
@@ -0,0 +1,100 @@
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "VideoSearchIndex.h"
+
+#include <stddef.h>
+
+// c00 is the title of the items (VIDEODB_ID_TITLE and so on), c01 the plot, c08 for music videos,
+// c02 and c03 the plot outline and tagline of movies
+// the cast of an item, by the table linking it to the actors and its id column there
+#define CAST(links, id) "(SELECT group_concat(actors.strActor) FROM " links " JOIN actors ON actors.idActor = " links ".idActor WHERE " links "." id " = new." id ")"
+
+static const FullTextColumn movieSearchColumns[] =
+{
+  { "strTitle",   "text", "new.c00" },
+  { "strPlot",    "text", "new.c01" },
+  { "strOutline", "text", "new.c02" },
+  { "strTagline", "text", "new.c03" },
+  { "strCast",    "text", CAST("actorlinkmovie", "idMovie") },
+  { NULL, NULL, NULL }
+};
+
+static const FullTextDependency movieSearchDependencies[] =
+{
+  { "actorlinkmovie", NULL, "new.idMovie", "strCast" },
+  { "actors", "strActor", "SELECT idMovie FROM actorlinkmovie WHERE actorlinkmovie.idActor = new.idActor", "strCast" },
+  { NULL, NULL, NULL, NULL }
+};
+
+static const FullTextColumn tvshowSearchColumns[] =
+{
+  { "strTitle", "text", "new.c00" },
+  { "strPlot",  "text", "new.c01" },
+  { "strCast",  "text", CAST("actorlinktvshow", "idShow") },
+  { NULL, NULL, NULL }
+};
+
+static const FullTextDependency tvshowSearchDependencies[] =
+{
+  { "actorlinktvshow", NULL, "new.idShow", "strCast" },
+  { "actors", "strActor", "SELECT idShow FROM actorlinktvshow WHERE actorlinktvshow.idActor = new.idActor", "strCast" },
+  { NULL, NULL, NULL, NULL }
+};
+
+static const FullTextColumn episodeSearchColumns[] =
+{
+  { "strTitle", "text", "new.c00" },
+  { "strPlot",  "text", "new.c01" },
+  { "strCast",  "text", CAST("actorlinkepisode", "idEpisode") },
+  { NULL, NULL, NULL }
+};
+
+static const FullTextDependency episodeSearchDependencies[] =
+{
+  { "actorlinkepisode", NULL, "new.idEpisode", "strCast" },
+  { "actors", "strActor", "SELECT idEpisode FROM actorlinkepisode WHERE actorlinkepisode.idActor = new.idActor", "strCast" },
+  { NULL, NULL, NULL, NULL }
+};
+
+// the artists of music videos are linked like the cast of the other items
+static const FullTextColumn musicvideoSearchColumns[] =
+{
+  { "strTitle", "text", "new.c00" },
+  { "strPlot",  "text", "new.c08" },
+  { "strCast",  "text", "(SELECT group_concat(actors.strActor) FROM artistlinkmusicvideo JOIN actors ON actors.idActor = artistlinkmusicvideo.idArtist "
+                        "WHERE artistlinkmusicvideo.idMVideo = new.idMVideo)" },
+  { NULL, NULL, NULL }
+};
+
+static const FullTextDependency musicvideoSearchDependencies[] =
+{
+  { "artistlinkmusicvideo", NULL, "new.idMVideo", "strCast" },
+  { "actors", "strActor", "SELECT idMVideo FROM artistlinkmusicvideo WHERE artistlinkmusicvideo.idArtist = new.idActor", "strCast" },
+  { NULL, NULL, NULL, NULL }
+};
+
+const FullTextIndex VideoSearchIndexes[VIDEOSEARCH_COUNT] =
+{
+  { "moviesearch",      "movie",      "idMovie",   "c00", "c00, c01, c02, c03", movieSearchColumns,      movieSearchDependencies },
+  { "tvshowsearch",     "tvshow",     "idShow",    "c00", "c00, c01",           tvshowSearchColumns,     tvshowSearchDependencies },
+  { "episodesearch",    "episode",    "idEpisode", "c00", "c00, c01",           episodeSearchColumns,    episodeSearchDependencies },
+  { "musicvideosearch", "musicvideo", "idMVideo",  "c00", "c00, c08",           musicvideoSearchColumns, musicvideoSearchDependencies }
+};
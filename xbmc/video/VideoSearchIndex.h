@@ -0,0 +1,36 @@
+#pragma once
+/*
+ *      Copyright (C) 2014 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/FullTextSearch.h"
+
+/*! \brief The full text search tables of the video database
+ Ranked searches list their items in this order on a tie.
+ */
+enum VideoSearchIndex
+{
+  VIDEOSEARCH_MOVIES = 0,
+  VIDEOSEARCH_TVSHOWS,
+  VIDEOSEARCH_EPISODES,
+  VIDEOSEARCH_MUSICVIDEOS,
+  VIDEOSEARCH_COUNT
+};
+
+extern const FullTextIndex VideoSearchIndexes[VIDEOSEARCH_COUNT];
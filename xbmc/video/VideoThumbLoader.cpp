@@ -456,6 +456,54 @@ bool CVideoThumbLoader::FillLibraryArt(CFileItem &item)
   return !item.GetArt().empty();
 }
 
+void CVideoThumbLoader::FillLibraryArt(CFileItemList &items, CVideoDatabase &database)
+{
+  vector<CFileItem*> libraryItems;
+  map<string, set<int> > ids;
+  for (int i = 0; i < items.Size(); i++)
+  {
+    const CVideoInfoTag *tag = items[i]->HasVideoInfoTag() ? items[i]->GetVideoInfoTag() : NULL;
+    if (tag && tag->m_iDbId > -1 && !tag->m_type.empty() && tag->m_type != MediaTypeArtist && tag->m_type != MediaTypeAlbum)
+    {
+      libraryItems.push_back(items[i].get());
+      ids[tag->m_type].insert(tag->m_iDbId);
+    }
+  }
+
+  map<string, ArtCache> art;
+  for (map<string, set<int> >::const_iterator it = ids.begin(); it != ids.end(); ++it)
+    database.GetArtForItems(it->second, it->first, art[it->first]);
+
+  // episodes and seasons without fanart of their own get the art of their show
+  vector<CFileItem*> showItems;
+  set<int> showIds;
+  for (vector<CFileItem*>::const_iterator it = libraryItems.begin(); it != libraryItems.end(); ++it)
+  {
+    CFileItem &item = **it;
+    const CVideoInfoTag *tag = item.GetVideoInfoTag();
+    const ArtCache &typeArt = art[tag->m_type];
+    ArtCache::const_iterator artwork = typeArt.find(tag->m_iDbId);
+    if (artwork != typeArt.end())
+      SetArt(item, artwork->second);
+    // items without (some) art are final too, FillLibraryArt(item) wouldn't find more
+    item.SetProperty("libraryartfilled", true);
+    if (!item.HasArt("fanart") && tag->m_iIdShow >= 0)
+    {
+      showItems.push_back(&item);
+      showIds.insert(tag->m_iIdShow);
+    }
+  }
+
+  ArtCache showArt;
+  database.GetArtForItems(showIds, MediaTypeTvShow, showArt);
+  for (vector<CFileItem*>::const_iterator it = showItems.begin(); it != showItems.end(); ++it)
+  {
+    (*it)->AppendArt(showArt[(*it)->GetVideoInfoTag()->m_iIdShow], "tvshow");
+    (*it)->SetArtFallback("fanart", "tvshow.fanart");
+    (*it)->SetArtFallback("tvshow.thumb", "tvshow.poster");
+  }
+}
+
 bool CVideoThumbLoader::FillThumb(CFileItem &item)
 {
   if (item.HasArt("thumb"))
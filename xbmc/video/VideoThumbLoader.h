@@ -107,6 +107,15 @@ public:
    */
  virtual bool FillLibraryArt(CFileItem &item);
 
+  /*! \brief helper function to fill the art for a list of video library items at once
+   Fills the items like FillLibraryArt() with a few queries for the whole list. Artists and
+   albums, which take their art from the music database, are left for FillLibraryArt().
+   Filled items get the "libraryartfilled" property.
+   \param items the items to fill
+   \param database an open video database
+   */
+  static void FillLibraryArt(CFileItemList &items, CVideoDatabase &database);
+
   /*!
    \brief Callback from CThumbExtractor on completion of a generated image
 